@@ -0,0 +1,109 @@
+/**
+ * @file AABBoxSoA.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#ifndef _KFL_AABBOXSOA_HPP
+#define _KFL_AABBOXSOA_HPP
+
+#pragma once
+
+#include <KFL/PreDeclare.hpp>
+#include <KFL/AlignedAllocator.hpp>
+
+#include <vector>
+
+namespace KlayGE
+{
+	// An array of AABBs stored as structure of arrays, for testing many boxes at once with SIMD. The storage is
+	//  aligned and padded to a multiple of BATCH_SIZE, so a batch can always be loaded as a whole.
+	class AABBoxSoA
+	{
+	public:
+		static uint32_t const BATCH_SIZE = 8;
+
+		AABBoxSoA();
+
+		uint32_t Size() const
+		{
+			return size_;
+		}
+		bool Empty() const
+		{
+			return 0 == size_;
+		}
+
+		void Resize(uint32_t size);
+		void Clear();
+
+		void Set(uint32_t index, AABBox const & aabb);
+		AABBox Get(uint32_t index) const;
+
+		void PushBack(AABBox const & aabb);
+		// Moves the last box to index and shrinks the array by one
+		void SwapRemove(uint32_t index);
+
+		float const * MinX() const
+		{
+			return min_x_.data();
+		}
+		float const * MinY() const
+		{
+			return min_y_.data();
+		}
+		float const * MinZ() const
+		{
+			return min_z_.data();
+		}
+		float const * MaxX() const
+		{
+			return max_x_.data();
+		}
+		float const * MaxY() const
+		{
+			return max_y_.data();
+		}
+		float const * MaxZ() const
+		{
+			return max_z_.data();
+		}
+
+	private:
+		typedef std::vector<float, aligned_allocator<float, 32>> FloatArray;
+
+		uint32_t size_;
+		FloatArray min_x_;
+		FloatArray min_y_;
+		FloatArray min_z_;
+		FloatArray max_x_;
+		FloatArray max_y_;
+		FloatArray max_z_;
+	};
+}
+
+#endif		// _KFL_AABBOXSOA_HPP
@@ -33,6 +33,7 @@
 
 #pragma once
 
+#include <memory>
 #include <streambuf>
 #include <vector>
 #include <string>
@@ -46,6 +47,16 @@ namespace KlayGE
 		MemInputStreamBuf(void const * p, std::streamsize num_bytes);
 		MemInputStreamBuf(void const * begin, void const * end);
 
+		// The whole buffer, for readers that can consume memory in place
+		void const * Data() const
+		{
+			return begin_;
+		}
+		std::streamsize Size() const
+		{
+			return end_ - begin_;
+		}
+
 	protected:
 		int_type uflow() override;
 		int_type underflow() override;
@@ -64,6 +75,19 @@ namespace KlayGE
 		char_type const * current_;
 	};
 
+	// A MemInputStreamBuf that keeps the owner of its memory alive, such as a MappedFile or a shared decoded buffer
+	class SharedMemInputStreamBuf : public MemInputStreamBuf
+	{
+	public:
+		SharedMemInputStreamBuf(void const * p, std::streamsize num_bytes, std::shared_ptr<void const> const & owner)
+			: MemInputStreamBuf(p, num_bytes), owner_(owner)
+		{
+		}
+
+	private:
+		std::shared_ptr<void const> owner_;
+	};
+
 	template <typename Callback>
 	class CallbackOutputStreamBuf : public std::streambuf, boost::noncopyable
 	{
@@ -0,0 +1,88 @@
+/**
+ * @file DualQuaternionSoA.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+
+#ifndef _KFL_DUALQUATERNIONSOA_HPP
+#define _KFL_DUALQUATERNIONSOA_HPP
+
+#pragma once
+
+#include <KFL/PreDeclare.hpp>
+#include <KFL/AlignedAllocator.hpp>
+
+#include <vector>
+
+namespace KlayGE
+{
+	// An array of dual quaternions stored as structure of arrays, for blending many of them at once with SIMD.
+	//  Component 0-3 are x, y, z, w of the real parts, 4-7 are x, y, z, w of the dual parts. The storage is aligned
+	//  and padded to a multiple of BATCH_SIZE with identity dual quaternions, so a batch can always be loaded as a whole.
+	class DualQuaternionSoA
+	{
+	public:
+		static uint32_t const BATCH_SIZE = 8;
+		static uint32_t const NUM_COMPONENTS = 8;
+
+		DualQuaternionSoA();
+
+		uint32_t Size() const
+		{
+			return size_;
+		}
+		bool Empty() const
+		{
+			return 0 == size_;
+		}
+
+		void Resize(uint32_t size);
+		void Clear();
+
+		void Set(uint32_t index, Quaternion const & real, Quaternion const & dual);
+		Quaternion GetReal(uint32_t index) const;
+		Quaternion GetDual(uint32_t index) const;
+
+		float* Component(uint32_t comp)
+		{
+			return comps_[comp].data();
+		}
+		float const * Component(uint32_t comp) const
+		{
+			return comps_[comp].data();
+		}
+
+	private:
+		typedef std::vector<float, aligned_allocator<float, 32>> FloatArray;
+
+		uint32_t size_;
+		FloatArray comps_[NUM_COMPONENTS];
+	};
+}
+
+#endif		// _KFL_DUALQUATERNIONSOA_HPP
@@ -114,6 +114,18 @@ namespace KlayGE
 		HashRange(seed, first, last);
 		return seed;
 	}
+
+	// 64-bit FNV-1a. Unlike the hashes above, the result is the same on every platform, so it can key data on disk.
+	inline uint64_t HashMemory64(void const * data, size_t size, uint64_t seed = 0xCBF29CE484222325ULL)
+	{
+		uint8_t const * p = static_cast<uint8_t const *>(data);
+		for (size_t i = 0; i < size; ++ i)
+		{
+			seed ^= p[i];
+			seed *= 0x100000001B3ULL;
+		}
+		return seed;
+	}
 }
 
 #endif		// _KFL_HASH_HPP
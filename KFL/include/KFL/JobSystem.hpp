@@ -0,0 +1,226 @@
+/**
+ * @file JobSystem.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#ifndef _KFL_JOBSYSTEM_HPP
+#define _KFL_JOBSYSTEM_HPP
+
+#pragma once
+
+#include <KFL/ArrayRef.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace KlayGE
+{
+	// A fine-grained unit of work. Jobs are cheap to create and are executed by the workers of a JobSystem.
+	//  A job starts when all its dependencies are finished. Continuations registered on a job are released
+	//  as soon as it finishes.
+	class Job
+	{
+		friend class JobSystem;
+
+	public:
+		explicit Job(std::function<void()> const & func);
+
+		bool Finished() const
+		{
+			return finished_.load(std::memory_order_acquire);
+		}
+
+	private:
+		std::function<void()> func_;
+		std::exception_ptr exception_;
+
+		// Number of unfinished dependencies, plus one while the job is being set up
+		std::atomic<uint32_t> pending_deps_;
+		std::atomic<bool> finished_;
+
+		std::mutex continuation_mutex_;
+		std::vector<JobPtr> continuations_;
+	};
+
+	// A work-stealing job scheduler. Every worker owns a deque. A worker pops from the back of its own deque,
+	//  and steals from the front of other workers' deques when it runs out of work. Jobs scheduled from
+	//  non-worker threads go to a shared injection queue. A thread waiting on a job helps executing other jobs
+	//  instead of blocking.
+	//
+	// Jobs are meant to be short. Long-lived loops (loading thread, scene update thread, audio streaming)
+	//  should stay on thread_pool.
+	class JobSystem
+	{
+	public:
+		// 0 means one worker per hardware thread, minus the calling thread
+		explicit JobSystem(uint32_t num_workers = 0);
+		~JobSystem();
+
+		uint32_t NumWorkers() const
+		{
+			return static_cast<uint32_t>(workers_.size());
+		}
+
+		JobPtr Schedule(std::function<void()> const & func);
+		JobPtr Schedule(std::function<void()> const & func, ArrayRef<JobPtr> deps);
+		// Runs func after job finishes
+		JobPtr Then(JobPtr const & job, std::function<void()> const & func);
+
+		// Waits until the job finishes, executing other jobs in the meantime. Rethrows the exception
+		//  thrown by the job, if any.
+		void Wait(JobPtr const & job);
+		// Waits until all the jobs finish, even if some of them fail, and rethrows the first exception
+		void WaitAll(ArrayRef<JobPtr> jobs);
+
+		// Calls func(chunk_begin, chunk_end) for every grain_size sized chunk of [begin, end). The calling thread
+		//  executes the first chunk itself. grain_size 0 picks a size that gives each worker a few chunks.
+		template <typename Func>
+		void ParallelFor(uint32_t begin, uint32_t end, uint32_t grain_size, Func const & func)
+		{
+			if (begin >= end)
+			{
+				return;
+			}
+
+			grain_size = this->GrainSize(end - begin, grain_size);
+			uint32_t const num_chunks = (end - begin + grain_size - 1) / grain_size;
+			if (num_chunks == 1)
+			{
+				func(begin, end);
+				return;
+			}
+
+			std::vector<JobPtr> jobs;
+			jobs.reserve(num_chunks - 1);
+			for (uint32_t i = 1; i < num_chunks; ++ i)
+			{
+				uint32_t const chunk_begin = begin + i * grain_size;
+				uint32_t const chunk_end = std::min(chunk_begin + grain_size, end);
+				jobs.push_back(this->Schedule([&func, chunk_begin, chunk_end] { func(chunk_begin, chunk_end); }));
+			}
+
+			// The jobs refer to func, so none of them can be left running when this returns or throws
+			std::exception_ptr exception;
+			try
+			{
+				func(begin, begin + grain_size);
+			}
+			catch (...)
+			{
+				exception = std::current_exception();
+			}
+			try
+			{
+				this->WaitAll(jobs);
+			}
+			catch (...)
+			{
+				if (!exception)
+				{
+					exception = std::current_exception();
+				}
+			}
+			if (exception)
+			{
+				std::rethrow_exception(exception);
+			}
+		}
+
+		// Computes map(chunk_begin, chunk_end) for every chunk in parallel, and folds the results with reduce
+		//  in chunk order. The result is deterministic as long as map is. If a map throws, the exception is
+		//  rethrown after all the chunks finish, like in ParallelFor.
+		template <typename T, typename MapFunc, typename ReduceFunc>
+		T ParallelReduce(uint32_t begin, uint32_t end, uint32_t grain_size, T const & identity,
+			MapFunc const & map, ReduceFunc const & reduce)
+		{
+			if (begin >= end)
+			{
+				return identity;
+			}
+
+			grain_size = this->GrainSize(end - begin, grain_size);
+			uint32_t const num_chunks = (end - begin + grain_size - 1) / grain_size;
+
+			std::vector<T> partials(num_chunks, identity);
+			this->ParallelFor(0, num_chunks, 1,
+				[begin, end, grain_size, &partials, &map](uint32_t chunk_begin, uint32_t chunk_end)
+				{
+					for (uint32_t i = chunk_begin; i < chunk_end; ++ i)
+					{
+						uint32_t const range_begin = begin + i * grain_size;
+						partials[i] = map(range_begin, std::min(range_begin + grain_size, end));
+					}
+				});
+
+			T ret = identity;
+			for (auto const & partial : partials)
+			{
+				ret = reduce(ret, partial);
+			}
+			return ret;
+		}
+
+	private:
+		struct WorkQueue
+		{
+			std::mutex mutex;
+			std::deque<JobPtr> jobs;
+		};
+
+		void WorkerFunc(uint32_t index);
+
+		void Enqueue(JobPtr const & job);
+		void Execute(JobPtr const & job);
+		void Release(JobPtr const & job);
+		JobPtr Pop(WorkQueue& queue);
+		JobPtr Steal(WorkQueue& queue);
+		JobPtr Grab();
+		bool HelpOnce();
+
+		uint32_t GrainSize(uint32_t count, uint32_t grain_size) const;
+
+	private:
+		std::vector<std::unique_ptr<WorkQueue>> queues_;
+		WorkQueue global_queue_;
+		std::vector<std::thread> workers_;
+
+		std::atomic<uint32_t> num_queued_jobs_;
+		std::atomic<bool> quit_;
+		std::mutex wake_mutex_;
+		std::condition_variable wake_cond_;
+	};
+}
+
+#endif		// _KFL_JOBSYSTEM_HPP
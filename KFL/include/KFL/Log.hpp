@@ -35,10 +35,29 @@
 
 namespace KlayGE
 {
+	enum LogLevel
+	{
+		LL_Debug,
+		LL_Info,
+		LL_Warn,
+		LL_Error
+	};
+
+	// Every thread formats into its own stream. A message ends at std::endl or std::flush, or at the next LogXXX()
+	//  on the same thread, and goes into a lock-free queue. A background thread writes the queue out, so logging
+	//  never waits for the console or the file.
 	std::ostream& LogDebug();
 	std::ostream& LogInfo();
 	std::ostream& LogWarn();
 	std::ostream& LogError();
+
+	// Messages below the level are dropped on the calling thread, before formatting
+	void LogLevelFilter(LogLevel level);
+	LogLevel LogLevelFilter();
+
+	// Blocks until all the messages ended before the call are written out. Called at exit, on std::terminate,
+	//  and by KFL_UNREACHABLE.
+	void LogFlush();
 }
 
 #endif		// _KFL_LOG_HPP
@@ -0,0 +1,75 @@
+/**
+ * @file MappedFile.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#ifndef _KFL_MAPPEDFILE_HPP
+#define _KFL_MAPPEDFILE_HPP
+
+#pragma once
+
+#include <KFL/KFL.hpp>
+
+#include <cstdint>
+#include <string>
+
+#include <boost/noncopyable.hpp>
+
+namespace KlayGE
+{
+	// Read-only memory mapping of a whole file
+	class MappedFile : boost::noncopyable
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		bool Open(std::string const & file_name);
+		void Close();
+
+		void const * Data() const
+		{
+			return data_;
+		}
+		uint64_t Size() const
+		{
+			return size_;
+		}
+
+	private:
+		void const * data_;
+		uint64_t size_;
+
+#ifdef KLAYGE_PLATFORM_WINDOWS
+		void* file_handle_;
+		void* mapping_handle_;
+#endif
+	};
+}
+
+#endif		// _KFL_MAPPEDFILE_HPP
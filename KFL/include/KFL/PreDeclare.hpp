@@ -43,16 +43,21 @@ namespace KlayGE
 
 	class XMLDocument;
 	typedef std::shared_ptr<XMLDocument> XMLDocumentPtr;
+	template <typename T>
+	class XMLHandle;
 	class XMLNode;
-	typedef std::shared_ptr<XMLNode> XMLNodePtr;
+	typedef XMLHandle<XMLNode> XMLNodePtr;
 	class XMLAttribute;
-	typedef std::shared_ptr<XMLAttribute> XMLAttributePtr;
+	typedef XMLHandle<XMLAttribute> XMLAttributePtr;
 
 	class bad_join;
 	template <typename ResultType>
 	class joiner;
 	class threader;
 	class thread_pool;
+	class Job;
+	typedef std::shared_ptr<Job> JobPtr;
+	class JobSystem;
 
 	class half;
 	template <typename T, int N>
@@ -0,0 +1,162 @@
+/**
+ * @file RadixSort.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+
+#ifndef _KFL_RADIXSORT_HPP
+#define _KFL_RADIXSORT_HPP
+
+#pragma once
+
+#include <KFL/JobSystem.hpp>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace KlayGE
+{
+	// Stable LSD radix sort of items on their 64-bit key member, 8 bits per pass. Passes on digits that are the same
+	//  in every key are skipped, so keys only using a few bits only take a few passes. scratch needs num elements.
+	//
+	// With a job system, every pass is split into chunks. Each chunk builds its histogram and scatters its items on
+	//  a worker. The offsets are laid out digit by digit, then chunk by chunk, so the sort stays stable.
+	template <typename T>
+	void RadixSort(T* items, T* scratch, uint32_t num, JobSystem* job_system = nullptr)
+	{
+		uint32_t const RADIX_BITS = 8;
+		uint32_t const RADIX = 1UL << RADIX_BITS;
+		uint32_t const NUM_PASSES = 64 / RADIX_BITS;
+		uint32_t const MIN_CHUNK_SIZE = 4096;
+
+		if (num < 2)
+		{
+			return;
+		}
+
+		uint32_t num_chunks = 1;
+		if (job_system != nullptr)
+		{
+			num_chunks = std::min((num + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE, job_system->NumWorkers() + 1);
+		}
+		uint32_t const chunk_size = (num + num_chunks - 1) / num_chunks;
+
+		auto for_each_chunk = [job_system, num_chunks](auto const & func)
+		{
+			if (num_chunks > 1)
+			{
+				job_system->ParallelFor(0, num_chunks, 1,
+					[&func](uint32_t chunk_begin, uint32_t chunk_end)
+					{
+						for (uint32_t c = chunk_begin; c < chunk_end; ++ c)
+						{
+							func(c);
+						}
+					});
+			}
+			else
+			{
+				func(0);
+			}
+		};
+
+		// Bits that differ between keys
+		std::vector<std::pair<uint64_t, uint64_t>> chunk_or_and(num_chunks);
+		for_each_chunk([items, num, chunk_size, &chunk_or_and](uint32_t c)
+			{
+				uint64_t key_or = 0;
+				uint64_t key_and = ~0ULL;
+				for (uint32_t i = c * chunk_size, end = std::min(i + chunk_size, num); i < end; ++ i)
+				{
+					key_or |= items[i].key;
+					key_and &= items[i].key;
+				}
+				chunk_or_and[c] = std::make_pair(key_or, key_and);
+			});
+		uint64_t key_or = 0;
+		uint64_t key_and = ~0ULL;
+		for (auto const & or_and : chunk_or_and)
+		{
+			key_or |= or_and.first;
+			key_and &= or_and.second;
+		}
+		uint64_t const varying_bits = key_or ^ key_and;
+
+		std::vector<std::array<uint32_t, RADIX>> histograms(num_chunks);
+		T* src = items;
+		T* dst = scratch;
+		for (uint32_t pass = 0; pass < NUM_PASSES; ++ pass)
+		{
+			uint32_t const shift = pass * RADIX_BITS;
+			if (0 == ((varying_bits >> shift) & (RADIX - 1)))
+			{
+				continue;
+			}
+
+			for_each_chunk([src, num, chunk_size, shift, &histograms](uint32_t c)
+				{
+					auto& histogram = histograms[c];
+					histogram.fill(0);
+					for (uint32_t i = c * chunk_size, end = std::min(i + chunk_size, num); i < end; ++ i)
+					{
+						++ histogram[(src[i].key >> shift) & (RADIX - 1)];
+					}
+				});
+
+			uint32_t offset = 0;
+			for (uint32_t d = 0; d < RADIX; ++ d)
+			{
+				for (auto& histogram : histograms)
+				{
+					uint32_t const count = histogram[d];
+					histogram[d] = offset;
+					offset += count;
+				}
+			}
+
+			for_each_chunk([src, dst, num, chunk_size, shift, &histograms](uint32_t c)
+				{
+					auto& offsets = histograms[c];
+					for (uint32_t i = c * chunk_size, end = std::min(i + chunk_size, num); i < end; ++ i)
+					{
+						dst[offsets[(src[i].key >> shift) & (RADIX - 1)]++] = src[i];
+					}
+				});
+
+			std::swap(src, dst);
+		}
+
+		if (src != items)
+		{
+			std::copy(src, src + num, items);
+		}
+	}
+}
+
+#endif		// _KFL_RADIXSORT_HPP
@@ -35,6 +35,7 @@
 
 #include <KFL/PreDeclare.hpp>
 #include <KFL/CXX17/string_view.hpp>
+#include <KFL/CustomizedStreamBuf.hpp>
 #include <istream>
 #include <vector>
 #include <string>
@@ -51,7 +52,8 @@ namespace KlayGE
 		}
 		ResIdentifier(std::string_view name, uint64_t timestamp,
 				std::shared_ptr<std::istream> const & is, std::shared_ptr<std::streambuf> const & streambuf)
-			: res_name_(name), timestamp_(timestamp), istream_(is), streambuf_(streambuf)
+			: res_name_(name), timestamp_(timestamp), istream_(is), streambuf_(streambuf),
+				mem_streambuf_(dynamic_cast<MemInputStreamBuf*>(streambuf.get()))
 		{
 		}
 
@@ -113,11 +115,39 @@ namespace KlayGE
 			return *istream_;
 		}
 
+		// The whole resource as one read-only block, if it lives in memory (memory mapped file, Android asset,
+		//  decoded package entry). nullptr otherwise.
+		void const * MappedData() const
+		{
+			return mem_streambuf_ ? mem_streambuf_->Data() : nullptr;
+		}
+		uint64_t MappedSize() const
+		{
+			return mem_streambuf_ ? static_cast<uint64_t>(mem_streambuf_->Size()) : 0;
+		}
+
+		// Returns the next size bytes in place and advances the read position, like read() without the copy.
+		//  Returns nullptr if the resource is not in memory or doesn't have size bytes left. Callers fall back to read().
+		void const * ReadView(size_t size)
+		{
+			if (mem_streambuf_)
+			{
+				int64_t const pos = this->tellg();
+				if ((pos >= 0) && (static_cast<uint64_t>(pos) + size <= this->MappedSize()))
+				{
+					this->seekg(static_cast<int64_t>(size), std::ios_base::cur);
+					return static_cast<uint8_t const *>(mem_streambuf_->Data()) + pos;
+				}
+			}
+			return nullptr;
+		}
+
 	private:
 		std::string res_name_;
 		uint64_t timestamp_;
 		std::shared_ptr<std::istream> istream_;
 		std::shared_ptr<std::streambuf> streambuf_;
+		MemInputStreamBuf* mem_streambuf_;
 	};
 }
 
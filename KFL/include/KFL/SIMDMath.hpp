@@ -34,6 +34,7 @@
 #pragma once
 
 #include <KFL/PreDeclare.hpp>
+#include <KFL/Math.hpp>
 
 #if defined(KLAYGE_SSE_SUPPORT) && !defined(KLAYGE_COMPILER_CLANGC2)
 	#define SIMD_MATH_SSE
@@ -46,6 +47,8 @@ namespace KlayGE
 {
 	class SIMDVectorF4;
 	class SIMDMatrixF4;
+	class AABBoxSoA;
+	class DualQuaternionSoA;
 
 	namespace SIMDMathLib
 	{
@@ -85,6 +88,9 @@ namespace KlayGE
 		void StoreVector2(float2& fs, SIMDVectorF4 const & v);
 		void StoreVector3(float3& fs, SIMDVectorF4 const & v);
 		void StoreVector4(float4& fs, SIMDVectorF4 const & v);
+		void StoreVector2(float* fs, SIMDVectorF4 const & v);
+		void StoreVector3(float* fs, SIMDVectorF4 const & v);
+		void StoreVector4(float* fs, SIMDVectorF4 const & v);
 		SIMDVectorF4 SetVector(float x, float y, float z, float w);
 		SIMDVectorF4 SetVector(float v);
 		float GetX(SIMDVectorF4 const & rhs);
@@ -234,6 +240,12 @@ namespace KlayGE
 		SIMDVectorF4 Squad(SIMDVectorF4 const & q1, SIMDVectorF4 const & a, SIMDVectorF4 const & b,
 			SIMDVectorF4 const & c, float t);
 
+		// Dual Quaternion
+		///////////////////////////////////////////////////////////////////////////////
+		// Same results as MathLib::sclerp on every pair of lhs and rhs, with factor s[i], 4 pairs at a time.
+		//  rhs and s need lhs.Size() elements. out is resized to lhs.Size().
+		void Sclerp(DualQuaternionSoA& out, DualQuaternionSoA const & lhs, DualQuaternionSoA const & rhs, float const * s);
+
 		// Plane
 		///////////////////////////////////////////////////////////////////////////////
 		SIMDVectorF4 DotPlane(SIMDVectorF4 const & lhs, SIMDVectorF4 const & rhs);
@@ -256,6 +268,13 @@ namespace KlayGE
 		///////////////////////////////////////////////////////////////////////////////
 		SIMDVectorF4 NegativeColor(SIMDVectorF4 const & rhs);
 		SIMDVectorF4 ModulateColor(SIMDVectorF4 const & lhs, SIMDVectorF4 const & rhs);
+
+
+		// Bound
+		///////////////////////////////////////////////////////////////////////////////
+		// Same results as MathLib::intersect_aabb_frustum on every box of aabbs, 8 (AVX) or 4 (SSE) boxes at a time.
+		//  results needs aabbs.Size() elements.
+		void IntersectAABBFrustum(BoundOverlap* results, AABBoxSoA const & aabbs, Frustum const & frustum);
 	}
 }
 
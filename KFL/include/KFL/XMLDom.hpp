@@ -33,9 +33,11 @@
 
 #pragma once
 
+#include <cstddef>
 #include <iosfwd>
 #include <vector>
 
+#include <boost/assert.hpp>
 #include <boost/noncopyable.hpp>
 
 namespace rapidxml
@@ -62,37 +64,79 @@ namespace KlayGE
 		XNT_PI
 	};
 
-	class XMLDocument : boost::noncopyable
+	// A non-owning handle to a node or an attribute in the arena of an XMLDocument. It's as cheap to copy as a raw
+	//  pointer, never allocates, and stays valid as long as the document. Behaves like a pointer to T, and is null
+	//  when there is no such node or attribute.
+	template <typename T>
+	class XMLHandle
 	{
 	public:
-		XMLDocument();
-
-		XMLNodePtr Parse(ResIdentifierPtr const & source);
-		void Print(std::ostream& os);
-
-		XMLNodePtr CloneNode(XMLNodePtr const & node);
-
-		XMLNodePtr AllocNode(XMLNodeType type, std::string_view name);
-		XMLAttributePtr AllocAttribInt(std::string_view name, int32_t value);
-		XMLAttributePtr AllocAttribUInt(std::string_view name, uint32_t value);
-		XMLAttributePtr AllocAttribFloat(std::string_view name, float value);
-		XMLAttributePtr AllocAttribString(std::string_view name, std::string_view value);
-
-		void RootNode(XMLNodePtr const & new_node);
+		XMLHandle() noexcept
+			: value_(nullptr)
+		{
+		}
+		XMLHandle(std::nullptr_t) noexcept
+			: value_(nullptr)
+		{
+		}
+		explicit XMLHandle(T const & value) noexcept
+			: value_(value)
+		{
+		}
+
+		T* operator->() const noexcept
+		{
+			BOOST_ASSERT(value_.Handle() != nullptr);
+			return &value_;
+		}
+		T& operator*() const noexcept
+		{
+			BOOST_ASSERT(value_.Handle() != nullptr);
+			return value_;
+		}
+		T* get() const noexcept
+		{
+			return value_.Handle() ? &value_ : nullptr;
+		}
+
+		explicit operator bool() const noexcept
+		{
+			return value_.Handle() != nullptr;
+		}
+
+		void reset() noexcept
+		{
+			value_ = T(nullptr);
+		}
+
+		friend bool operator==(XMLHandle const & lhs, XMLHandle const & rhs) noexcept
+		{
+			return lhs.value_.Handle() == rhs.value_.Handle();
+		}
+		friend bool operator!=(XMLHandle const & lhs, XMLHandle const & rhs) noexcept
+		{
+			return !(lhs == rhs);
+		}
+		friend bool operator==(XMLHandle const & lhs, std::nullptr_t) noexcept
+		{
+			return !lhs;
+		}
+		friend bool operator!=(XMLHandle const & lhs, std::nullptr_t) noexcept
+		{
+			return static_cast<bool>(lhs);
+		}
 
 	private:
-		std::shared_ptr<rapidxml::xml_document<char>> doc_;
-		std::vector<char> xml_src_;
-
-		XMLNodePtr root_;
+		// The mutators of T only touch the document, not the handle
+		mutable T value_;
 	};
 
-	class XMLNode : boost::noncopyable
+	class XMLNode
 	{
 		friend class XMLDocument;
 
 	public:
-		explicit XMLNode(rapidxml::xml_node<char>* node);
+		explicit XMLNode(rapidxml::xml_node<char>* node) noexcept;
 		XMLNode(rapidxml::xml_document<char>& doc, XMLNodeType type, std::string_view name);
 
 		std::string_view Name() const;
@@ -143,21 +187,22 @@ namespace KlayGE
 		float ValueFloat() const;
 		std::string_view ValueString() const;
 
+		rapidxml::xml_node<char>* Handle() const noexcept
+		{
+			return node_;
+		}
+
 	private:
 		rapidxml::xml_node<char>* node_;
-		std::string_view name_;
-
-		std::vector<XMLNodePtr> children_;
-		std::vector<XMLAttributePtr> attrs_;
 	};
 
-	class XMLAttribute : boost::noncopyable
+	class XMLAttribute
 	{
 		friend class XMLDocument;
 		friend class XMLNode;
 
 	public:
-		explicit XMLAttribute(rapidxml::xml_attribute<char>* attr);
+		explicit XMLAttribute(rapidxml::xml_attribute<char>* attr) noexcept;
 		XMLAttribute(rapidxml::xml_document<char>& doc, std::string_view name, std::string_view value);
 
 		std::string_view Name() const;
@@ -174,10 +219,59 @@ namespace KlayGE
 		float ValueFloat() const;
 		std::string_view ValueString() const;
 
+		rapidxml::xml_attribute<char>* Handle() const noexcept
+		{
+			return attr_;
+		}
+
 	private:
 		rapidxml::xml_attribute<char>* attr_;
-		std::string_view name_;
-		std::string_view value_;
+	};
+
+	// Version of the compiled form written by XMLDocument::Compile
+	uint32_t const XML_BIN_VERSION = 1;
+
+	class XMLDocument : boost::noncopyable
+	{
+	public:
+		XMLDocument();
+
+		// The source is either XML text, or the compiled form.
+		// XML text is copied once into a buffer owned by the document, and parsed in place. Names and values are
+		//  views into that buffer.
+		// The compiled form isn't parsed at all. The tree is rebuilt from its node table, and names and values are
+		//  views into its string table, which stays in the mapping of the source if there is one. A truncated or
+		//  corrupted compiled form throws std::runtime_error.
+		XMLNodePtr Parse(ResIdentifierPtr const & source);
+		void Print(std::ostream& os);
+
+		// Writes the document in the compiled form, a flat little endian image of the tree. Every distinct name and
+		//  value is stored once in a string table, so the element and attribute names that a schema repeats all over
+		//  the document cost an index each.
+		void Compile(std::ostream& os);
+		// Returns true if the source is in the compiled form of XML_BIN_VERSION. The read position is restored.
+		static bool IsCompiled(ResIdentifierPtr const & source);
+
+		XMLNodePtr CloneNode(XMLNodePtr const & node);
+
+		XMLNodePtr AllocNode(XMLNodeType type, std::string_view name);
+		XMLAttributePtr AllocAttribInt(std::string_view name, int32_t value);
+		XMLAttributePtr AllocAttribUInt(std::string_view name, uint32_t value);
+		XMLAttributePtr AllocAttribFloat(std::string_view name, float value);
+		XMLAttributePtr AllocAttribString(std::string_view name, std::string_view value);
+
+		void RootNode(XMLNodePtr const & new_node);
+
+	private:
+		XMLNodePtr ParseCompiled(char const * data, size_t size);
+
+	private:
+		std::shared_ptr<rapidxml::xml_document<char>> doc_;
+		std::vector<char> xml_src_;
+		// Keeps the mapping of a compiled source alive, the strings of the tree point into it
+		ResIdentifierPtr mapped_src_;
+
+		XMLNodePtr root_;
 	};
 }
 
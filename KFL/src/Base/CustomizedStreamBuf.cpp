@@ -120,9 +120,9 @@ namespace KlayGE
 			break;
 
 		case std::ios_base::end:
-			if (end_ - off >= begin_)
+			if ((off <= 0) && (end_ + off >= begin_))
 			{
-				current_ = end_ - off;
+				current_ = end_ + off;
 				off = current_ - begin_;
 			}
 			else
@@ -153,9 +153,9 @@ namespace KlayGE
 		BOOST_ASSERT(which == std::ios_base::in);
 		KFL_UNUSED(which);
 
-		if (sp < end_ - begin_)
+		if (sp <= end_ - begin_)
 		{
-			current_ = begin_ + static_cast<int>(sp);
+			current_ = begin_ + static_cast<std::ptrdiff_t>(sp);
 		}
 		else
 		{
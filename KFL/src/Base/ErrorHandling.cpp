@@ -66,6 +66,7 @@ namespace KlayGE
 		{
 			LogError() << "UNREACHABLE executed." << std::endl;
 		}
+		LogFlush();
 
 		TMSG("Unreachable.");
 	}
@@ -0,0 +1,320 @@
+/**
+ * @file JobSystem.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KFL/KFL.hpp>
+#include <KFL/CpuInfo.hpp>
+
+#include <KFL/JobSystem.hpp>
+
+namespace
+{
+	using namespace KlayGE;
+
+	// Identifies the worker the current thread belongs to, if any
+	thread_local JobSystem const * tls_job_system = nullptr;
+	thread_local uint32_t tls_worker_index = 0;
+}
+
+namespace KlayGE
+{
+	Job::Job(std::function<void()> const & func)
+		: func_(func), pending_deps_(1), finished_(false)
+	{
+	}
+
+
+	JobSystem::JobSystem(uint32_t num_workers)
+		: num_queued_jobs_(0), quit_(false)
+	{
+		if (0 == num_workers)
+		{
+			CPUInfo cpu;
+			num_workers = std::max(cpu.NumHWThreads() - 1, 1);
+		}
+
+		queues_.resize(num_workers);
+		for (auto& queue : queues_)
+		{
+			queue = MakeUniquePtr<WorkQueue>();
+		}
+
+		workers_.reserve(num_workers);
+		for (uint32_t i = 0; i < num_workers; ++ i)
+		{
+			workers_.emplace_back([this, i] { this->WorkerFunc(i); });
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(wake_mutex_);
+			quit_ = true;
+		}
+		wake_cond_.notify_all();
+
+		for (auto& worker : workers_)
+		{
+			worker.join();
+		}
+	}
+
+	JobPtr JobSystem::Schedule(std::function<void()> const & func)
+	{
+		return this->Schedule(func, ArrayRef<JobPtr>());
+	}
+
+	JobPtr JobSystem::Schedule(std::function<void()> const & func, ArrayRef<JobPtr> deps)
+	{
+		JobPtr job = MakeSharedPtr<Job>(func);
+		job->pending_deps_ += static_cast<uint32_t>(deps.size());
+		for (auto const & dep : deps)
+		{
+			bool dep_finished;
+			{
+				std::lock_guard<std::mutex> lock(dep->continuation_mutex_);
+				dep_finished = dep->Finished();
+				if (!dep_finished)
+				{
+					dep->continuations_.push_back(job);
+				}
+			}
+			if (dep_finished)
+			{
+				-- job->pending_deps_;
+			}
+		}
+
+		this->Release(job);
+		return job;
+	}
+
+	JobPtr JobSystem::Then(JobPtr const & job, std::function<void()> const & func)
+	{
+		return this->Schedule(func, job);
+	}
+
+	void JobSystem::Wait(JobPtr const & job)
+	{
+		while (!job->Finished())
+		{
+			if (!this->HelpOnce())
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		if (job->exception_)
+		{
+			std::rethrow_exception(job->exception_);
+		}
+	}
+
+	void JobSystem::WaitAll(ArrayRef<JobPtr> jobs)
+	{
+		std::exception_ptr exception;
+		for (auto const & job : jobs)
+		{
+			try
+			{
+				this->Wait(job);
+			}
+			catch (...)
+			{
+				if (!exception)
+				{
+					exception = std::current_exception();
+				}
+			}
+		}
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+	}
+
+	void JobSystem::WorkerFunc(uint32_t index)
+	{
+		tls_job_system = this;
+		tls_worker_index = index;
+
+		while (!quit_)
+		{
+			JobPtr job = this->Grab();
+			if (job)
+			{
+				this->Execute(job);
+			}
+			else
+			{
+				std::unique_lock<std::mutex> lock(wake_mutex_);
+				wake_cond_.wait(lock, [this] { return quit_ || (num_queued_jobs_ > 0); });
+			}
+		}
+
+		tls_job_system = nullptr;
+	}
+
+	// Called once per dependency finished, and once at the end of Schedule
+	void JobSystem::Release(JobPtr const & job)
+	{
+		if (1 == job->pending_deps_.fetch_sub(1))
+		{
+			this->Enqueue(job);
+		}
+	}
+
+	void JobSystem::Enqueue(JobPtr const & job)
+	{
+		WorkQueue& queue = (this == tls_job_system) ? *queues_[tls_worker_index] : global_queue_;
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.jobs.push_back(job);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(wake_mutex_);
+			++ num_queued_jobs_;
+		}
+		wake_cond_.notify_one();
+	}
+
+	void JobSystem::Execute(JobPtr const & job)
+	{
+		try
+		{
+			job->func_();
+		}
+		catch (...)
+		{
+			job->exception_ = std::current_exception();
+		}
+		job->func_ = std::function<void()>();
+
+		std::vector<JobPtr> continuations;
+		{
+			std::lock_guard<std::mutex> lock(job->continuation_mutex_);
+			job->finished_.store(true, std::memory_order_release);
+			continuations.swap(job->continuations_);
+		}
+		for (auto const & cont : continuations)
+		{
+			this->Release(cont);
+		}
+	}
+
+	JobPtr JobSystem::Pop(WorkQueue& queue)
+	{
+		JobPtr job;
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			-- num_queued_jobs_;
+		}
+		return job;
+	}
+
+	JobPtr JobSystem::Steal(WorkQueue& queue)
+	{
+		JobPtr job;
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			-- num_queued_jobs_;
+		}
+		return job;
+	}
+
+	// Own queue first (LIFO, cache friendly), then the injection queue, then steal from the others (FIFO)
+	JobPtr JobSystem::Grab()
+	{
+		if (0 == num_queued_jobs_)
+		{
+			return JobPtr();
+		}
+
+		uint32_t const num_queues = static_cast<uint32_t>(queues_.size());
+		uint32_t start = 0;
+		if (this == tls_job_system)
+		{
+			JobPtr job = this->Pop(*queues_[tls_worker_index]);
+			if (job)
+			{
+				return job;
+			}
+			start = tls_worker_index + 1;
+		}
+
+		JobPtr job = this->Steal(global_queue_);
+		if (job)
+		{
+			return job;
+		}
+
+		for (uint32_t i = 0; i < num_queues; ++ i)
+		{
+			job = this->Steal(*queues_[(start + i) % num_queues]);
+			if (job)
+			{
+				return job;
+			}
+		}
+
+		return JobPtr();
+	}
+
+	bool JobSystem::HelpOnce()
+	{
+		JobPtr job = this->Grab();
+		if (job)
+		{
+			this->Execute(job);
+			return true;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	uint32_t JobSystem::GrainSize(uint32_t count, uint32_t grain_size) const
+	{
+		if (0 == grain_size)
+		{
+			uint32_t const num_chunks = (this->NumWorkers() + 1) * 4;
+			grain_size = (count + num_chunks - 1) / num_chunks;
+		}
+		return std::max(grain_size, 1U);
+	}
+}
@@ -29,16 +29,25 @@
  */
 
 #include <KFL/KFL.hpp>
-#include <KFL/ArrayRef.hpp>
-#include <KFL/CustomizedStreamBuf.hpp>
 
-#include <cstdarg>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <boost/noncopyable.hpp>
 
 #ifdef KLAYGE_PLATFORM_ANDROID
 #include <android/log.h>
-#include <cstring>
 #else
 #include <fstream>
 #endif
@@ -49,110 +58,438 @@ namespace
 {
 	using namespace KlayGE;
 
-#ifdef KLAYGE_PLATFORM_ANDROID
-	class AndroidLogStreamCallback : boost::noncopyable
+	// The records go through a bounded MPSC queue, Vyukov style. A record takes one or more consecutive slots. A
+	//  producer claims them with a CAS on the enqueue position, fills them, and publishes each one through its sequence
+	//  number. The writer thread is the only consumer. It frees the slots in order, so a producer only has to check the
+	//  last slot it claims.
+	class Logger
 	{
 	public:
-		explicit AndroidLogStreamCallback(int prio)
-			: prio_(prio)
+		static constexpr uint32_t NUM_SLOTS = 2048;
+		static constexpr uint32_t SLOT_PAYLOAD = 116;
+		// Longer messages are truncated
+		static constexpr uint32_t MAX_SLOTS_PER_RECORD = 64;
+		static constexpr uint32_t WRITER_IDLE_MS = 10;
+
+	public:
+		static Logger& Instance()
 		{
+			// Never destroyed, so the static destructors and the threads that log after exit still find it. Once stopped,
+			//  messages are written synchronously.
+			static Logger* logger = new Logger;
+			return *logger;
 		}
-		AndroidLogStreamCallback(AndroidLogStreamCallback&& rhs)
-			: prio_(rhs.prio_)
+
+		LogLevel Filter() const
+		{
+			return filter_.load(std::memory_order_relaxed);
+		}
+		void Filter(LogLevel level)
 		{
+			filter_.store(level, std::memory_order_relaxed);
 		}
 
-		std::streambuf::int_type operator()(void const * buff, std::streamsize count)
+		std::chrono::steady_clock::time_point StartTime() const
 		{
-			std::vector<char> tmp(count + 1);
-			std::memcpy(tmp.data(), buff, count);
-			tmp.back() = 0;
-			__android_log_write(prio_, "KlayGE", tmp.data());
-			return static_cast<std::streambuf::int_type>(count);
+			return start_time_;
+		}
+
+		void Publish(LogLevel level, char const * msg, size_t size)
+		{
+			// Pairs with Stop(). Either the writer waits for this record, or this record doesn't use the queue.
+			num_producers_.fetch_add(1);
+			if (!running_.load())
+			{
+				num_producers_.fetch_sub(1);
+
+				std::lock_guard<std::mutex> lock(sinks_mutex_);
+				this->Write(level, std::string(msg, size));
+				this->FlushSinks();
+				return;
+			}
+
+			size = std::min<size_t>(size, MAX_SLOTS_PER_RECORD * SLOT_PAYLOAD);
+			uint32_t const num_slots = std::max(static_cast<uint32_t>((size + SLOT_PAYLOAD - 1) / SLOT_PAYLOAD), 1U);
+
+			uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				uint64_t const last_pos = pos + num_slots - 1;
+				int64_t const diff = static_cast<int64_t>(slots_[last_pos % NUM_SLOTS].seq.load(std::memory_order_acquire) - last_pos);
+				if (0 == diff)
+				{
+					if (enqueue_pos_.compare_exchange_weak(pos, pos + num_slots, std::memory_order_relaxed))
+					{
+						break;
+					}
+				}
+				else
+				{
+					if (diff < 0)
+					{
+						// Full, the writer is behind
+						this->WakeWriter();
+						std::this_thread::yield();
+					}
+					pos = enqueue_pos_.load(std::memory_order_relaxed);
+				}
+			}
+
+			for (uint32_t i = 0; i < num_slots; ++ i)
+			{
+				Slot& slot = slots_[(pos + i) % NUM_SLOTS];
+				size_t const offset = i * SLOT_PAYLOAD;
+				size_t const chunk = std::min<size_t>(size - offset, SLOT_PAYLOAD);
+				slot.level = static_cast<uint8_t>(level);
+				slot.last = (i + 1 == num_slots);
+				slot.size = static_cast<uint16_t>(chunk);
+				std::memcpy(slot.data, msg + offset, chunk);
+				slot.seq.store(pos + i + 1, std::memory_order_release);
+			}
+
+			num_producers_.fetch_sub(1);
+
+			if (level >= LL_Error)
+			{
+				this->WakeWriter();
+			}
+		}
+
+		void Flush()
+		{
+			if (running_.load())
+			{
+				uint64_t const target = enqueue_pos_.load(std::memory_order_acquire);
+				this->WakeWriter();
+
+				std::unique_lock<std::mutex> lock(flush_mutex_);
+				flush_cv_.wait(lock, [this, target]
+					{
+						return (dequeue_pos_.load(std::memory_order_acquire) >= target) || !running_.load();
+					});
+			}
+			else
+			{
+				std::lock_guard<std::mutex> lock(sinks_mutex_);
+				this->FlushSinks();
+			}
+		}
+
+		void Stop()
+		{
+			if (running_.exchange(false))
+			{
+				wake_cv_.notify_one();
+				writer_.join();
+
+				{
+					std::lock_guard<std::mutex> lock(flush_mutex_);
+				}
+				flush_cv_.notify_all();
+			}
 		}
 
 	private:
-		int prio_;
-	};
+		struct alignas(64) Slot
+		{
+			std::atomic<uint64_t> seq;
+			uint8_t level;
+			bool last;
+			uint16_t size;
+			char data[SLOT_PAYLOAD];
+		};
 
-	template <int PRIO>
-	std::ostream& AndroidLog()
-	{
-		static CallbackOutputStreamBuf<AndroidLogStreamCallback> log_stream_buff((AndroidLogStreamCallback(PRIO)));
-		static std::ostream log_stream(&log_stream_buff);
-		return log_stream;
-	}
+	private:
+		Logger()
+			: filter_(
+#ifdef KLAYGE_DEBUG
+				LL_Debug
 #else
-	class MultiOStreamsCallback : boost::noncopyable
-	{
-	public:
-		explicit MultiOStreamsCallback(ArrayRef<std::ostream*> oss)
-			: oss_(oss)
+				LL_Info
+#endif
+				),
+				start_time_(std::chrono::steady_clock::now()),
+#if !defined(KLAYGE_PLATFORM_ANDROID) && defined(KLAYGE_DEBUG)
+				log_file_("KlayGE.log"),
+#endif
+				running_(true), num_producers_(0), enqueue_pos_(0), dequeue_pos_(0), writer_waiting_(false)
 		{
+			for (uint32_t i = 0; i < NUM_SLOTS; ++ i)
+			{
+				slots_[i].seq.store(i, std::memory_order_relaxed);
+			}
+
+			writer_ = std::thread([this] { this->WriterFunc(); });
+
+			std::atexit([] { Logger::Instance().Stop(); });
+			prev_terminate_ = std::set_terminate([]
+				{
+					Logger::Instance().Stop();
+					if (prev_terminate_)
+					{
+						prev_terminate_();
+					}
+					std::abort();
+				});
+		}
+
+		void WriterFunc()
+		{
+			while (running_.load())
+			{
+				if (!this->Drain())
+				{
+					std::unique_lock<std::mutex> lock(wake_mutex_);
+					writer_waiting_.store(true);
+					wake_cv_.wait_for(lock, std::chrono::milliseconds(WRITER_IDLE_MS));
+					writer_waiting_.store(false);
+				}
+			}
+
+			// No new producer uses the queue after running_ is cleared. The ones already in Publish are waited for.
+			for (;;)
+			{
+				bool const producing = (num_producers_.load() > 0);
+				if (!this->Drain())
+				{
+					if (!producing)
+					{
+						break;
+					}
+					std::this_thread::yield();
+				}
+			}
 		}
-		MultiOStreamsCallback(MultiOStreamsCallback&& rhs)
-			: oss_(std::move(rhs.oss_))
+
+		bool Drain()
 		{
+			bool any = false;
+			{
+				std::lock_guard<std::mutex> lock(sinks_mutex_);
+
+				uint64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+				for (;;)
+				{
+					Slot& slot = slots_[pos % NUM_SLOTS];
+					if (slot.seq.load(std::memory_order_acquire) != pos + 1)
+					{
+						break;
+					}
+
+					record_.append(slot.data, slot.size);
+					if (slot.last)
+					{
+						this->Write(static_cast<LogLevel>(slot.level), record_);
+						record_.clear();
+					}
+					slot.seq.store(pos + NUM_SLOTS, std::memory_order_release);
+					++ pos;
+					any = true;
+				}
+
+				if (any)
+				{
+					this->FlushSinks();
+					dequeue_pos_.store(pos, std::memory_order_release);
+				}
+			}
+
+			if (any)
+			{
+				{
+					std::lock_guard<std::mutex> lock(flush_mutex_);
+				}
+				flush_cv_.notify_all();
+			}
+
+			return any;
 		}
 
-		std::streambuf::int_type operator()(void const * buff, std::streamsize count)
+		void WakeWriter()
 		{
-			for (auto& os : oss_)
+			if (writer_waiting_.load())
 			{
-				os->write(static_cast<char const *>(buff), count);
+				wake_cv_.notify_one();
 			}
-			return static_cast<std::streambuf::int_type>(count);
 		}
 
-	private:
-		ArrayRef<std::ostream*> oss_;
-	};
+		void Write(LogLevel level, std::string const & record)
+		{
+#ifdef KLAYGE_PLATFORM_ANDROID
+			static int const prios[] = { ANDROID_LOG_DEBUG, ANDROID_LOG_INFO, ANDROID_LOG_WARN, ANDROID_LOG_ERROR };
+			__android_log_write(prios[level], "KlayGE", record.c_str());
+#else
+			KFL_UNUSED(level);
 
-	std::ostream& Log()
-	{
+			std::clog.write(record.data(), record.size());
 #ifdef KLAYGE_DEBUG
-		static std::ofstream log_file("KlayGE.log");
+			log_file_.write(record.data(), record.size());
 #endif
+#endif
+		}
 
-		static std::ostream* oss[] =
+		void FlushSinks()
 		{
+#ifndef KLAYGE_PLATFORM_ANDROID
+			std::clog.flush();
 #ifdef KLAYGE_DEBUG
-			&log_file,
+			log_file_.flush();
 #endif
-			&std::clog
-		};
-		static CallbackOutputStreamBuf<MultiOStreamsCallback> log_stream_buff((MultiOStreamsCallback(oss)));
-		static std::ostream log_stream(&log_stream_buff);
-		return log_stream;
-	}
 #endif
+		}
 
-#ifndef KLAYGE_DEBUG
-	class EmptyOStreamsCallback : boost::noncopyable
+	private:
+		std::atomic<LogLevel> filter_;
+		std::chrono::steady_clock::time_point const start_time_;
+
+		// The sinks, and the record being assembled by the writer
+		std::mutex sinks_mutex_;
+#if !defined(KLAYGE_PLATFORM_ANDROID) && defined(KLAYGE_DEBUG)
+		std::ofstream log_file_;
+#endif
+		std::string record_;
+
+		std::atomic<bool> running_;
+		std::atomic<uint32_t> num_producers_;
+		std::array<Slot, NUM_SLOTS> slots_;
+		alignas(64) std::atomic<uint64_t> enqueue_pos_;
+		alignas(64) std::atomic<uint64_t> dequeue_pos_;
+
+		std::thread writer_;
+		std::mutex wake_mutex_;
+		std::condition_variable wake_cv_;
+		std::atomic<bool> writer_waiting_;
+
+		std::mutex flush_mutex_;
+		std::condition_variable flush_cv_;
+
+		static std::terminate_handler prev_terminate_;
+	};
+
+	std::terminate_handler Logger::prev_terminate_;
+
+	// Collects a message on its thread. It's handed to the logger when it ends.
+	class LogStreamBuf : public std::streambuf
 	{
 	public:
-		EmptyOStreamsCallback()
+		LogStreamBuf()
+			: level_(LL_Info)
+		{
+		}
+
+		void Begin(LogLevel level)
 		{
+			this->Commit();
+			level_ = level;
 		}
-		EmptyOStreamsCallback(EmptyOStreamsCallback&& rhs)
+
+		void Commit()
 		{
-			KFL_UNUSED(rhs);
+			if (!record_.empty())
+			{
+				Logger::Instance().Publish(level_, record_.data(), record_.size());
+				record_.clear();
+			}
 		}
 
-		std::streambuf::int_type operator()(void const * buff, std::streamsize count)
+	protected:
+		std::streamsize xsputn(char_type const * s, std::streamsize count) override
 		{
-			KFL_UNUSED(buff);
-			return static_cast<std::streambuf::int_type>(count);
+			record_.append(s, static_cast<size_t>(count));
+			return count;
 		}
+
+		int_type overflow(int_type ch = traits_type::eof()) override
+		{
+			if (!traits_type::eq_int_type(ch, traits_type::eof()))
+			{
+				record_.push_back(traits_type::to_char_type(ch));
+			}
+			return traits_type::not_eof(ch);
+		}
+
+		int sync() override
+		{
+			this->Commit();
+			return 0;
+		}
+
+	private:
+		LogLevel level_;
+		std::string record_;
 	};
 
+	thread_local bool thread_log_stream_destroyed = false;
+
+	class ThreadLogStream : boost::noncopyable
+	{
+	public:
+		ThreadLogStream()
+			: stream_(&stream_buff_)
+		{
+		}
+		~ThreadLogStream()
+		{
+			stream_buff_.Commit();
+			thread_log_stream_destroyed = true;
+		}
+
+		std::ostream& Begin(LogLevel level)
+		{
+			stream_buff_.Begin(level);
+			return stream_;
+		}
+
+		void Commit()
+		{
+			stream_buff_.Commit();
+		}
+
+	private:
+		LogStreamBuf stream_buff_;
+		std::ostream stream_;
+	};
+
+	ThreadLogStream& ThisThreadLogStream()
+	{
+		if (thread_log_stream_destroyed)
+		{
+			// The static destructors run after the thread_local ones of the main thread. They are the only ones left
+			//  by then, so they share a stream. Never destroyed either.
+			static ThreadLogStream* late_stream = new ThreadLogStream;
+			return *late_stream;
+		}
+
+		thread_local ThreadLogStream stream;
+		return stream;
+	}
+
 	std::ostream& EmptyLog()
 	{
-		static CallbackOutputStreamBuf<EmptyOStreamsCallback> empty_stream_buff((EmptyOStreamsCallback()));
-		static std::ostream empty_stream(&empty_stream_buff);
+		// Without a stream buffer, the stream is bad, and skips all the formatting
+		thread_local std::ostream empty_stream(nullptr);
 		return empty_stream;
 	}
+
+	std::ostream& Log(LogLevel level, char const * tag)
+	{
+		Logger& logger = Logger::Instance();
+		if (level < logger.Filter())
+		{
+			return EmptyLog();
+		}
+
+		std::ostream& os = ThisThreadLogStream().Begin(level);
+#ifdef KLAYGE_PLATFORM_ANDROID
+		KFL_UNUSED(tag);
+#else
+		std::chrono::duration<double> const time = std::chrono::steady_clock::now() - logger.StartTime();
+		char prefix[64];
+		int const len = std::snprintf(prefix, sizeof(prefix), "[%10.3f] (%s) KlayGE: ", time.count(), tag);
+		os.write(prefix, std::min(len, static_cast<int>(sizeof(prefix) - 1)));
 #endif
+		return os;
+	}
 }
 
 namespace KlayGE
@@ -160,11 +497,7 @@ namespace KlayGE
 	std::ostream& LogDebug()
 	{
 #ifdef KLAYGE_DEBUG
-#ifdef KLAYGE_PLATFORM_ANDROID
-		return AndroidLog<ANDROID_LOG_DEBUG>();
-#else
-		return Log() << "(DEBUG) KlayGE: ";
-#endif
+		return Log(LL_Debug, "DEBUG");
 #else
 		return EmptyLog();
 #endif
@@ -172,28 +505,32 @@ namespace KlayGE
 
 	std::ostream& LogInfo()
 	{
-#ifdef KLAYGE_PLATFORM_ANDROID
-		return AndroidLog<ANDROID_LOG_INFO>();
-#else
-		return Log() << "(INFO) KlayGE: ";
-#endif
+		return Log(LL_Info, "INFO");
 	}
 
 	std::ostream& LogWarn()
 	{
-#ifdef KLAYGE_PLATFORM_ANDROID
-		return AndroidLog<ANDROID_LOG_WARN>();
-#else
-		return Log() << "(WARN) KlayGE: ";
-#endif
+		return Log(LL_Warn, "WARN");
 	}
 
 	std::ostream& LogError()
 	{
-#ifdef KLAYGE_PLATFORM_ANDROID
-		return AndroidLog<ANDROID_LOG_ERROR>();
-#else
-		return Log() << "(ERROR) KlayGE: ";
-#endif
+		return Log(LL_Error, "ERROR");
+	}
+
+	void LogLevelFilter(LogLevel level)
+	{
+		Logger::Instance().Filter(level);
+	}
+
+	LogLevel LogLevelFilter()
+	{
+		return Logger::Instance().Filter();
+	}
+
+	void LogFlush()
+	{
+		ThisThreadLogStream().Commit();
+		Logger::Instance().Flush();
 	}
 }
@@ -0,0 +1,156 @@
+/**
+ * @file MappedFile.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KFL/KFL.hpp>
+
+#ifdef KLAYGE_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <KFL/MappedFile.hpp>
+
+namespace KlayGE
+{
+	MappedFile::MappedFile()
+		: data_(nullptr), size_(0)
+#ifdef KLAYGE_PLATFORM_WINDOWS
+			, file_handle_(INVALID_HANDLE_VALUE), mapping_handle_(nullptr)
+#endif
+	{
+	}
+
+	MappedFile::~MappedFile()
+	{
+		this->Close();
+	}
+
+	// Empty files can't be mapped. Callers fall back to stream reading when this returns false.
+	bool MappedFile::Open(std::string const & file_name)
+	{
+		this->Close();
+
+#if defined(KLAYGE_PLATFORM_WINDOWS_DESKTOP)
+		// Doesn't lock the file against writers, renames and deletes. Files that get replaced in place aren't mapped
+		//  by ResLoader anyway, since a mapped file can't be replaced.
+		file_handle_ = ::CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (INVALID_HANDLE_VALUE == file_handle_)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER file_size;
+		if (!::GetFileSizeEx(file_handle_, &file_size) || (0 == file_size.QuadPart))
+		{
+			this->Close();
+			return false;
+		}
+
+		mapping_handle_ = ::CreateFileMappingA(file_handle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (nullptr == mapping_handle_)
+		{
+			this->Close();
+			return false;
+		}
+
+		data_ = ::MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0);
+		if (nullptr == data_)
+		{
+			this->Close();
+			return false;
+		}
+		size_ = static_cast<uint64_t>(file_size.QuadPart);
+
+		return true;
+#elif defined(KLAYGE_PLATFORM_WINDOWS)
+		KFL_UNUSED(file_name);
+		return false;
+#else
+		int const fd = ::open(file_name.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return false;
+		}
+
+		struct stat file_stat;
+		if ((::fstat(fd, &file_stat) != 0) || (file_stat.st_size <= 0))
+		{
+			::close(fd);
+			return false;
+		}
+
+		void* p = ::mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		// The mapping stays valid after the descriptor is closed
+		::close(fd);
+		if (MAP_FAILED == p)
+		{
+			return false;
+		}
+
+		data_ = p;
+		size_ = static_cast<uint64_t>(file_stat.st_size);
+
+		return true;
+#endif
+	}
+
+	void MappedFile::Close()
+	{
+#ifdef KLAYGE_PLATFORM_WINDOWS
+		if (data_ != nullptr)
+		{
+			::UnmapViewOfFile(data_);
+		}
+		if (mapping_handle_ != nullptr)
+		{
+			::CloseHandle(mapping_handle_);
+			mapping_handle_ = nullptr;
+		}
+		if (file_handle_ != INVALID_HANDLE_VALUE)
+		{
+			::CloseHandle(file_handle_);
+			file_handle_ = INVALID_HANDLE_VALUE;
+		}
+#else
+		if (data_ != nullptr)
+		{
+			::munmap(const_cast<void*>(data_), static_cast<size_t>(size_));
+		}
+#endif
+
+		data_ = nullptr;
+		size_ = 0;
+	}
+}
@@ -29,10 +29,14 @@
  */
 
 #include <KFL/KFL.hpp>
+#include <KFL/ErrorHandling.hpp>
 #include <KFL/Util.hpp>
 #include <KFL/ResIdentifier.hpp>
 
+#include <cstring>
+#include <ostream>
 #include <string>
+#include <unordered_map>
 
 #if defined(KLAYGE_COMPILER_CLANGC2)
 #pragma clang diagnostic push
@@ -48,6 +52,142 @@
 
 #include <KFL/XMLDom.hpp>
 
+namespace
+{
+	using namespace KlayGE;
+
+	// Compiled form, all little endian
+	//  BinHeader
+	//  uint32_t string_offsets[num_strings + 1], the strings are zero terminated
+	//  BinNode nodes[num_nodes], in document order, so a parent always comes before its children
+	//  BinAttrib attribs[num_attribs], the attributes of a node are contiguous
+	//  char string_data[string_data_size]
+	uint32_t const XML_BIN_FOURCC = MakeFourCC<'K', 'X', 'M', 'L'>::value;
+	uint32_t const XML_BIN_NO_PARENT = 0xFFFFFFFF;
+
+	struct BinHeader
+	{
+		uint32_t fourcc;
+		uint32_t version;
+		uint32_t num_nodes;
+		uint32_t num_attribs;
+		uint32_t num_strings;
+		uint32_t string_data_size;
+	};
+
+	struct BinNode
+	{
+		uint32_t parent;
+		uint32_t type;
+		uint32_t name;
+		uint32_t value;
+		uint32_t first_attrib;
+		uint32_t num_attribs;
+	};
+
+	struct BinAttrib
+	{
+		uint32_t name;
+		uint32_t value;
+	};
+
+	class XMLCompiler
+	{
+	public:
+		void AddNode(rapidxml::xml_node<char> const & node, uint32_t parent)
+		{
+			BinNode bin_node;
+			bin_node.parent = parent;
+			bin_node.type = static_cast<uint32_t>(node.type());
+			bin_node.name = this->AddString(node.name(), node.name_size());
+			bin_node.value = this->AddString(node.value(), node.value_size());
+			bin_node.first_attrib = static_cast<uint32_t>(attribs_.size());
+			bin_node.num_attribs = 0;
+			for (auto const * attr = node.first_attribute(); attr; attr = attr->next_attribute())
+			{
+				BinAttrib bin_attr;
+				bin_attr.name = this->AddString(attr->name(), attr->name_size());
+				bin_attr.value = this->AddString(attr->value(), attr->value_size());
+				attribs_.push_back(bin_attr);
+				++ bin_node.num_attribs;
+			}
+
+			uint32_t const index = static_cast<uint32_t>(nodes_.size());
+			nodes_.push_back(bin_node);
+
+			for (auto const * child = node.first_node(); child; child = child->next_sibling())
+			{
+				this->AddNode(*child, index);
+			}
+		}
+
+		void Write(std::ostream& os) const
+		{
+			BinHeader header;
+			header.fourcc = Native2LE(XML_BIN_FOURCC);
+			header.version = Native2LE(XML_BIN_VERSION);
+			header.num_nodes = Native2LE(static_cast<uint32_t>(nodes_.size()));
+			header.num_attribs = Native2LE(static_cast<uint32_t>(attribs_.size()));
+			header.num_strings = Native2LE(static_cast<uint32_t>(string_offsets_.size()));
+			header.string_data_size = Native2LE(static_cast<uint32_t>(string_data_.size()));
+			os.write(reinterpret_cast<char const *>(&header), sizeof(header));
+
+			for (uint32_t offset : string_offsets_)
+			{
+				offset = Native2LE(offset);
+				os.write(reinterpret_cast<char const *>(&offset), sizeof(offset));
+			}
+			uint32_t const end = Native2LE(static_cast<uint32_t>(string_data_.size()));
+			os.write(reinterpret_cast<char const *>(&end), sizeof(end));
+
+			for (auto const & node : nodes_)
+			{
+				BinNode le_node;
+				le_node.parent = Native2LE(node.parent);
+				le_node.type = Native2LE(node.type);
+				le_node.name = Native2LE(node.name);
+				le_node.value = Native2LE(node.value);
+				le_node.first_attrib = Native2LE(node.first_attrib);
+				le_node.num_attribs = Native2LE(node.num_attribs);
+				os.write(reinterpret_cast<char const *>(&le_node), sizeof(le_node));
+			}
+			for (auto const & attr : attribs_)
+			{
+				BinAttrib le_attr;
+				le_attr.name = Native2LE(attr.name);
+				le_attr.value = Native2LE(attr.value);
+				os.write(reinterpret_cast<char const *>(&le_attr), sizeof(le_attr));
+			}
+
+			os.write(string_data_.data(), string_data_.size());
+		}
+
+	private:
+		uint32_t AddString(char const * str, size_t size)
+		{
+			// The keys are views into the document, which outlives the compiler
+			std::string_view const key(size > 0 ? str : "", size);
+			auto iter = string_ids_.find(key);
+			if (iter == string_ids_.end())
+			{
+				uint32_t const id = static_cast<uint32_t>(string_offsets_.size());
+				string_offsets_.push_back(static_cast<uint32_t>(string_data_.size()));
+				string_data_.insert(string_data_.end(), key.begin(), key.end());
+				string_data_.push_back('\0');
+				iter = string_ids_.emplace(key, id).first;
+			}
+			return iter->second;
+		}
+
+	private:
+		std::vector<BinNode> nodes_;
+		std::vector<BinAttrib> attribs_;
+		std::vector<uint32_t> string_offsets_;
+		std::vector<char> string_data_;
+		std::unordered_map<std::string_view, uint32_t> string_ids_;
+	};
+}
+
 namespace KlayGE
 {
 	XMLDocument::XMLDocument()
@@ -57,14 +197,48 @@ namespace KlayGE
 
 	XMLNodePtr XMLDocument::Parse(ResIdentifierPtr const & source)
 	{
-		source->seekg(0, std::ios_base::end);
-		int len = static_cast<int>(source->tellg());
-		source->seekg(0, std::ios_base::beg);
-		xml_src_.resize(len + 1, 0);
-		source->read(&xml_src_[0], len);
+		mapped_src_.reset();
 
-		doc_->parse<0>(&xml_src_[0]);
-		root_ = MakeSharedPtr<XMLNode>(doc_->first_node());
+		if (IsCompiled(source))
+		{
+			if (auto const * mapped = source->MappedData())
+			{
+				// Nothing is written into the compiled form, so the tree can point straight into the mapping
+				mapped_src_ = source;
+				return this->ParseCompiled(static_cast<char const *>(mapped), static_cast<size_t>(source->MappedSize()));
+			}
+			else
+			{
+				source->seekg(0, std::ios_base::end);
+				size_t const len = static_cast<size_t>(source->tellg());
+				source->seekg(0, std::ios_base::beg);
+				xml_src_.resize(len);
+				source->read(xml_src_.data(), len);
+				return this->ParseCompiled(xml_src_.data(), len);
+			}
+		}
+
+		// rapidxml writes the string terminators and the translated entities into the source, so a read-only mapping
+		//  can't be parsed directly. One memcpy from it is still much cheaper than going through the stream.
+		size_t len;
+		if (auto const * mapped = source->MappedData())
+		{
+			len = static_cast<size_t>(source->MappedSize());
+			xml_src_.resize(len + 1);
+			std::memcpy(xml_src_.data(), mapped, len);
+		}
+		else
+		{
+			source->seekg(0, std::ios_base::end);
+			len = static_cast<size_t>(source->tellg());
+			source->seekg(0, std::ios_base::beg);
+			xml_src_.resize(len + 1);
+			source->read(xml_src_.data(), len);
+		}
+		xml_src_[len] = 0;
+
+		doc_->parse<0>(xml_src_.data());
+		root_ = XMLNodePtr(XMLNode(doc_->first_node()));
 
 		return root_;
 	}
@@ -75,14 +249,158 @@ namespace KlayGE
 		os << *doc_;
 	}
 
+	void XMLDocument::Compile(std::ostream& os)
+	{
+		XMLCompiler compiler;
+		for (auto const * node = doc_->first_node(); node; node = node->next_sibling())
+		{
+			compiler.AddNode(*node, XML_BIN_NO_PARENT);
+		}
+		compiler.Write(os);
+	}
+
+	bool XMLDocument::IsCompiled(ResIdentifierPtr const & source)
+	{
+		if (auto const * mapped = source->MappedData())
+		{
+			if (source->MappedSize() < sizeof(BinHeader))
+			{
+				return false;
+			}
+
+			BinHeader header;
+			std::memcpy(&header, mapped, sizeof(header));
+			return (LE2Native(header.fourcc) == XML_BIN_FOURCC) && (LE2Native(header.version) == XML_BIN_VERSION);
+		}
+		else
+		{
+			auto const pos = source->tellg();
+			uint32_t fourcc_ver[2] = { 0, 0 };
+			source->read(fourcc_ver, sizeof(fourcc_ver));
+			bool const compiled = (source->gcount() == static_cast<int64_t>(sizeof(fourcc_ver)))
+				&& (LE2Native(fourcc_ver[0]) == XML_BIN_FOURCC) && (LE2Native(fourcc_ver[1]) == XML_BIN_VERSION);
+			source->clear();
+			source->seekg(pos, std::ios_base::beg);
+			return compiled;
+		}
+	}
+
+	XMLNodePtr XMLDocument::ParseCompiled(char const * data, size_t size)
+	{
+		doc_->clear();
+		root_.reset();
+
+		if (size < sizeof(BinHeader))
+		{
+			TMSG("Truncated compiled XML.");
+		}
+
+		BinHeader header;
+		std::memcpy(&header, data, sizeof(header));
+		uint32_t const num_nodes = LE2Native(header.num_nodes);
+		uint32_t const num_attribs = LE2Native(header.num_attribs);
+		uint32_t const num_strings = LE2Native(header.num_strings);
+		uint32_t const string_data_size = LE2Native(header.string_data_size);
+
+		size_t const offsets_pos = sizeof(BinHeader);
+		size_t const nodes_pos = offsets_pos + (static_cast<size_t>(num_strings) + 1) * sizeof(uint32_t);
+		size_t const attribs_pos = nodes_pos + static_cast<size_t>(num_nodes) * sizeof(BinNode);
+		size_t const strings_pos = attribs_pos + static_cast<size_t>(num_attribs) * sizeof(BinAttrib);
+		if (strings_pos + string_data_size > size)
+		{
+			TMSG("Truncated compiled XML.");
+		}
+
+		char const * string_data = data + strings_pos;
+		auto read_u32 = [data](size_t pos)
+		{
+			uint32_t v;
+			std::memcpy(&v, data + pos, sizeof(v));
+			return LE2Native(v);
+		};
+		auto string_at = [&](uint32_t id, char const *& str, size_t& len)
+		{
+			if (id >= num_strings)
+			{
+				return false;
+			}
+			uint32_t const begin = read_u32(offsets_pos + id * sizeof(uint32_t));
+			uint32_t const end = read_u32(offsets_pos + (id + 1) * sizeof(uint32_t));
+			if ((begin >= end) || (end > string_data_size))
+			{
+				return false;
+			}
+			str = string_data + begin;
+			len = end - begin - 1;
+			return true;
+		};
+
+		// rapidxml never writes through the name and value of a node, the const_casts only satisfy its interface
+		std::vector<rapidxml::xml_node<char>*> nodes(num_nodes);
+		for (uint32_t i = 0; i < num_nodes; ++ i)
+		{
+			BinNode bin_node;
+			std::memcpy(&bin_node, data + nodes_pos + i * sizeof(BinNode), sizeof(bin_node));
+			uint32_t const parent = LE2Native(bin_node.parent);
+			uint32_t const type = LE2Native(bin_node.type);
+			uint32_t const first_attrib = LE2Native(bin_node.first_attrib);
+			uint32_t const node_num_attribs = LE2Native(bin_node.num_attribs);
+
+			char const * name;
+			size_t name_len;
+			char const * value;
+			size_t value_len;
+			if (((parent != XML_BIN_NO_PARENT) && (parent >= i)) || (type == rapidxml::node_document) || (type > rapidxml::node_pi)
+				|| (first_attrib > num_attribs) || (node_num_attribs > num_attribs - first_attrib)
+				|| !string_at(LE2Native(bin_node.name), name, name_len) || !string_at(LE2Native(bin_node.value), value, value_len))
+			{
+				doc_->clear();
+				TMSG("Corrupted compiled XML.");
+			}
+
+			auto* node = doc_->allocate_node(static_cast<rapidxml::node_type>(type), const_cast<char*>(name),
+				const_cast<char*>(value), name_len, value_len);
+			for (uint32_t j = 0; j < node_num_attribs; ++ j)
+			{
+				BinAttrib bin_attr;
+				std::memcpy(&bin_attr, data + attribs_pos + (first_attrib + j) * sizeof(BinAttrib), sizeof(bin_attr));
+				char const * attr_name;
+				size_t attr_name_len;
+				char const * attr_value;
+				size_t attr_value_len;
+				if (!string_at(LE2Native(bin_attr.name), attr_name, attr_name_len)
+					|| !string_at(LE2Native(bin_attr.value), attr_value, attr_value_len))
+				{
+					doc_->clear();
+					TMSG("Corrupted compiled XML.");
+				}
+				node->append_attribute(doc_->allocate_attribute(const_cast<char*>(attr_name), const_cast<char*>(attr_value),
+					attr_name_len, attr_value_len));
+			}
+
+			if (parent == XML_BIN_NO_PARENT)
+			{
+				doc_->append_node(node);
+			}
+			else
+			{
+				nodes[parent]->append_node(node);
+			}
+			nodes[i] = node;
+		}
+
+		root_ = XMLNodePtr(XMLNode(doc_->first_node()));
+		return root_;
+	}
+
 	XMLNodePtr XMLDocument::CloneNode(XMLNodePtr const & node)
 	{
-		return MakeSharedPtr<XMLNode>(doc_->clone_node(node->node_));
+		return XMLNodePtr(XMLNode(doc_->clone_node(node->node_)));
 	}
 
 	XMLNodePtr XMLDocument::AllocNode(XMLNodeType type, std::string_view name)
 	{
-		return MakeSharedPtr<XMLNode>(*doc_, type, name);
+		return XMLNodePtr(XMLNode(*doc_, type, name));
 	}
 	
 	XMLAttributePtr XMLDocument::AllocAttribInt(std::string_view name, int32_t value)
@@ -102,8 +420,8 @@ namespace KlayGE
 
 	XMLAttributePtr XMLDocument::AllocAttribString(std::string_view name, std::string_view value)
 	{
-		return MakeSharedPtr<XMLAttribute>(*doc_, std::string_view(doc_->allocate_string(name.data(), name.size()), name.size()),
-			std::string_view(doc_->allocate_string(value.data(), value.size()), value.size()));
+		return XMLAttributePtr(XMLAttribute(*doc_, std::string_view(doc_->allocate_string(name.data(), name.size()), name.size()),
+			std::string_view(doc_->allocate_string(value.data(), value.size()), value.size())));
 	}
 
 	void XMLDocument::RootNode(XMLNodePtr const & new_node)
@@ -114,17 +432,12 @@ namespace KlayGE
 	}
 
 
-	XMLNode::XMLNode(rapidxml::xml_node<char>* node)
+	XMLNode::XMLNode(rapidxml::xml_node<char>* node) noexcept
 		: node_(node)
 	{
-		if (node_ != nullptr)
-		{
-			name_ = std::string_view(node_->name(), node_->name_size());
-		}
 	}
 
 	XMLNode::XMLNode(rapidxml::xml_document<char>& doc, XMLNodeType type, std::string_view name)
-		: name_(name)
 	{
 		rapidxml::node_type xtype;
 		switch (type)
@@ -168,7 +481,7 @@ namespace KlayGE
 
 	std::string_view XMLNode::Name() const
 	{
-		return name_;
+		return std::string_view(node_->name(), node_->name_size());
 	}
 
 	XMLNodeType XMLNode::Type() const
@@ -204,67 +517,27 @@ namespace KlayGE
 
 	XMLNodePtr XMLNode::Parent() const
 	{
-		auto* node = node_->parent();
-		if (node)
-		{
-			return MakeSharedPtr<XMLNode>(node);
-		}
-		else
-		{
-			return XMLNodePtr();
-		}
+		return XMLNodePtr(XMLNode(node_->parent()));
 	}
 
 	XMLAttributePtr XMLNode::FirstAttrib(std::string_view name) const
 	{
-		auto* attr = node_->first_attribute(name.data(), name.size());
-		if (attr)
-		{
-			return MakeSharedPtr<XMLAttribute>(attr);
-		}
-		else
-		{
-			return XMLAttributePtr();
-		}
+		return XMLAttributePtr(XMLAttribute(node_->first_attribute(name.data(), name.size())));
 	}
 	
 	XMLAttributePtr XMLNode::LastAttrib(std::string_view name) const
 	{
-		auto* attr = node_->last_attribute(name.data(), name.size());
-		if (attr)
-		{
-			return MakeSharedPtr<XMLAttribute>(attr);
-		}
-		else
-		{
-			return XMLAttributePtr();
-		}
+		return XMLAttributePtr(XMLAttribute(node_->last_attribute(name.data(), name.size())));
 	}
 
 	XMLAttributePtr XMLNode::FirstAttrib() const
 	{
-		auto* attr = node_->first_attribute();
-		if (attr)
-		{
-			return MakeSharedPtr<XMLAttribute>(attr);
-		}
-		else
-		{
-			return XMLAttributePtr();
-		}
+		return XMLAttributePtr(XMLAttribute(node_->first_attribute()));
 	}
 
 	XMLAttributePtr XMLNode::LastAttrib() const
 	{
-		auto* attr = node_->last_attribute();
-		if (attr)
-		{
-			return MakeSharedPtr<XMLAttribute>(attr);
-		}
-		else
-		{
-			return XMLAttributePtr();
-		}
+		return XMLAttributePtr(XMLAttribute(node_->last_attribute()));
 	}
 
 	XMLAttributePtr XMLNode::Attrib(std::string_view name) const
@@ -322,170 +595,72 @@ namespace KlayGE
 
 	XMLNodePtr XMLNode::FirstNode(std::string_view name) const
 	{
-		auto* node = node_->first_node(name.data(), name.size());
-		if (node)
-		{
-			return MakeSharedPtr<XMLNode>(node);
-		}
-		else
-		{
-			return XMLNodePtr();
-		}
+		return XMLNodePtr(XMLNode(node_->first_node(name.data(), name.size())));
 	}
 
 	XMLNodePtr XMLNode::LastNode(std::string_view name) const
 	{
-		auto* node = node_->last_node(name.data(), name.size());
-		if (node)
-		{
-			return MakeSharedPtr<XMLNode>(node);
-		}
-		else
-		{
-			return XMLNodePtr();
-		}
+		return XMLNodePtr(XMLNode(node_->last_node(name.data(), name.size())));
 	}
 
 	XMLNodePtr XMLNode::FirstNode() const
 	{
-		auto* node = node_->first_node();
-		if (node)
-		{
-			return MakeSharedPtr<XMLNode>(node);
-		}
-		else
-		{
-			return XMLNodePtr();
-		}
+		return XMLNodePtr(XMLNode(node_->first_node()));
 	}
 
 	XMLNodePtr XMLNode::LastNode() const
 	{
-		auto* node = node_->last_node();
-		if (node)
-		{
-			return MakeSharedPtr<XMLNode>(node);
-		}
-		else
-		{
-			return XMLNodePtr();
-		}
+		return XMLNodePtr(XMLNode(node_->last_node()));
 	}
 
 	XMLNodePtr XMLNode::PrevSibling(std::string_view name) const
 	{
-		auto* node = node_->previous_sibling(name.data(), name.size());
-		if (node)
-		{
-			return MakeSharedPtr<XMLNode>(node);
-		}
-		else
-		{
-			return XMLNodePtr();
-		}
+		return XMLNodePtr(XMLNode(node_->previous_sibling(name.data(), name.size())));
 	}
 
 	XMLNodePtr XMLNode::NextSibling(std::string_view name) const
 	{
-		auto* node = node_->next_sibling(name.data(), name.size());
-		if (node)
-		{
-			return MakeSharedPtr<XMLNode>(node);
-		}
-		else
-		{
-			return XMLNodePtr();
-		}
+		return XMLNodePtr(XMLNode(node_->next_sibling(name.data(), name.size())));
 	}
 
 	XMLNodePtr XMLNode::PrevSibling() const
 	{
-		auto* node = node_->previous_sibling();
-		if (node)
-		{
-			return MakeSharedPtr<XMLNode>(node);
-		}
-		else
-		{
-			return XMLNodePtr();
-		}
+		return XMLNodePtr(XMLNode(node_->previous_sibling()));
 	}
 
 	XMLNodePtr XMLNode::NextSibling() const
 	{
-		auto* node = node_->next_sibling();
-		if (node)
-		{
-			return MakeSharedPtr<XMLNode>(node);
-		}
-		else
-		{
-			return XMLNodePtr();
-		}
+		return XMLNodePtr(XMLNode(node_->next_sibling()));
 	}
 
 	void XMLNode::InsertNode(XMLNodePtr const & location, XMLNodePtr const & new_node)
 	{
 		node_->insert_node(location->node_, new_node->node_);
-		for (size_t i = 0; i < children_.size(); ++ i)
-		{
-			if (children_[i]->node_ == location->node_)
-			{
-				children_.insert(children_.begin() + i, new_node);
-				break;
-			}
-		}
 	}
 
 	void XMLNode::InsertAttrib(XMLAttributePtr const & location, XMLAttributePtr const & new_attr)
 	{
 		node_->insert_attribute(location->attr_, new_attr->attr_);
-		for (size_t i = 0; i < attrs_.size(); ++ i)
-		{
-			if (attrs_[i]->attr_ == location->attr_)
-			{
-				attrs_.insert(attrs_.begin() + i, new_attr);
-				break;
-			}
-		}
 	}
 
 	void XMLNode::AppendNode(XMLNodePtr const & new_node)
 	{
 		node_->append_node(new_node->node_);
-		children_.push_back(new_node);
 	}
 
 	void XMLNode::AppendAttrib(XMLAttributePtr const & new_attr)
 	{
 		node_->append_attribute(new_attr->attr_);
-		attrs_.push_back(new_attr);
 	}
 
 	void XMLNode::RemoveNode(XMLNodePtr const & node)
 	{
 		node_->remove_node(node->node_);
-		for (size_t i = 0; i < children_.size(); ++ i)
-		{
-			if (children_[i]->node_ == node->node_)
-			{
-				children_.erase(children_.begin() + i);
-				break;
-			}
-		}
 	}
 
 	void XMLNode::RemoveAttrib(XMLAttributePtr const & attr)
 	{
 		node_->remove_attribute(attr->attr_);
-		for (size_t i = 0; i < attrs_.size(); ++ i)
-		{
-			if (attrs_[i]->attr_ == attr->attr_)
-			{
-				attrs_.erase(attrs_.begin() + i);
-				break;
-			}
-		}
 	}
 
 	bool XMLNode::TryConvert(int32_t& val) const
@@ -524,86 +699,63 @@ namespace KlayGE
 	}
 
 
-	XMLAttribute::XMLAttribute(rapidxml::xml_attribute<char>* attr)
+	XMLAttribute::XMLAttribute(rapidxml::xml_attribute<char>* attr) noexcept
 		: attr_(attr)
 	{
-		if (attr_ != nullptr)
-		{
-			auto const * xml_attr = attr_;
-			name_ = std::string_view(xml_attr->name(), xml_attr->name_size());
-			value_ = std::string_view(xml_attr->value(), xml_attr->value_size());
-		}
 	}
 
 	XMLAttribute::XMLAttribute(rapidxml::xml_document<char>& doc, std::string_view name, std::string_view value)
-		: name_(name), value_(value)
+		: attr_(doc.allocate_attribute(name.data(), value.data(), name.size(), value.size()))
 	{
-		attr_ = doc.allocate_attribute(name.data(), value.data(), name.size(), value.size());
 	}
 
 	std::string_view XMLAttribute::Name() const
 	{
-		return name_;
+		return std::string_view(attr_->name(), attr_->name_size());
 	}
 
 	XMLAttributePtr XMLAttribute::NextAttrib(std::string_view name) const
 	{
-		auto* attr = attr_->next_attribute(name.data(), name.size());
-		if (attr)
-		{
-			return MakeSharedPtr<XMLAttribute>(attr);
-		}
-		else
-		{
-			return XMLAttributePtr();
-		}
+		return XMLAttributePtr(XMLAttribute(attr_->next_attribute(name.data(), name.size())));
 	}
 
 	XMLAttributePtr XMLAttribute::NextAttrib() const
 	{
-		auto* attr = attr_->next_attribute();
-		if (attr)
-		{
-			return MakeSharedPtr<XMLAttribute>(attr);
-		}
-		else
-		{
-			return XMLAttributePtr();
-		}
+		return XMLAttributePtr(XMLAttribute(attr_->next_attribute()));
 	}
 
 	bool XMLAttribute::TryConvert(int32_t& val) const
 	{
-		return boost::conversion::try_lexical_convert(value_, val);
+		return boost::conversion::try_lexical_convert(this->ValueString(), val);
 	}
 
 	bool XMLAttribute::TryConvert(uint32_t& val) const
 	{
-		return boost::conversion::try_lexical_convert(value_, val);
+		return boost::conversion::try_lexical_convert(this->ValueString(), val);
 	}
 
 	bool XMLAttribute::TryConvert(float& val) const
 	{
-		return boost::conversion::try_lexical_convert(value_, val);
+		return boost::conversion::try_lexical_convert(this->ValueString(), val);
 	}
 
 	int32_t XMLAttribute::ValueInt() const
 	{
-		return std::stol(std::string(value_));
+		return std::stol(std::string(this->ValueString()));
 	}
 
 	uint32_t XMLAttribute::ValueUInt() const
 	{
-		return std::stoul(std::string(value_));
+		return std::stoul(std::string(this->ValueString()));
 	}
 
 	float XMLAttribute::ValueFloat() const
 	{
-		return std::stof(std::string(value_));
+		return std::stof(std::string(this->ValueString()));
 	}
 
 	std::string_view XMLAttribute::ValueString() const
 	{
-		return value_;
+		return std::string_view(attr_->value(), attr_->value_size());
 	}
 }
@@ -0,0 +1,101 @@
+/**
+ * @file AABBoxSoA.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KFL/KFL.hpp>
+
+#include <KFL/AABBoxSoA.hpp>
+
+namespace KlayGE
+{
+	AABBoxSoA::AABBoxSoA()
+		: size_(0)
+	{
+	}
+
+	void AABBoxSoA::Resize(uint32_t size)
+	{
+		size_t const padded_size = (size + BATCH_SIZE - 1) & ~(BATCH_SIZE - 1);
+		min_x_.resize(padded_size, 0);
+		min_y_.resize(padded_size, 0);
+		min_z_.resize(padded_size, 0);
+		max_x_.resize(padded_size, 0);
+		max_y_.resize(padded_size, 0);
+		max_z_.resize(padded_size, 0);
+		size_ = size;
+	}
+
+	void AABBoxSoA::Clear()
+	{
+		this->Resize(0);
+	}
+
+	void AABBoxSoA::Set(uint32_t index, AABBox const & aabb)
+	{
+		BOOST_ASSERT(index < size_);
+
+		min_x_[index] = aabb.Min().x();
+		min_y_[index] = aabb.Min().y();
+		min_z_[index] = aabb.Min().z();
+		max_x_[index] = aabb.Max().x();
+		max_y_[index] = aabb.Max().y();
+		max_z_[index] = aabb.Max().z();
+	}
+
+	AABBox AABBoxSoA::Get(uint32_t index) const
+	{
+		BOOST_ASSERT(index < size_);
+
+		return AABBox(float3(min_x_[index], min_y_[index], min_z_[index]),
+			float3(max_x_[index], max_y_[index], max_z_[index]));
+	}
+
+	void AABBoxSoA::PushBack(AABBox const & aabb)
+	{
+		this->Resize(size_ + 1);
+		this->Set(size_ - 1, aabb);
+	}
+
+	void AABBoxSoA::SwapRemove(uint32_t index)
+	{
+		BOOST_ASSERT(index < size_);
+
+		uint32_t const last = size_ - 1;
+		if (index != last)
+		{
+			min_x_[index] = min_x_[last];
+			min_y_[index] = min_y_[last];
+			min_z_[index] = min_z_[last];
+			max_x_[index] = max_x_[last];
+			max_y_[index] = max_y_[last];
+			max_z_[index] = max_z_[last];
+		}
+		this->Resize(last);
+	}
+}
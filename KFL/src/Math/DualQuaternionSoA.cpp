@@ -0,0 +1,84 @@
+/**
+ * @file DualQuaternionSoA.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+
+#include <KFL/KFL.hpp>
+#include <KFL/Math.hpp>
+
+#include <KFL/DualQuaternionSoA.hpp>
+
+namespace KlayGE
+{
+	DualQuaternionSoA::DualQuaternionSoA()
+		: size_(0)
+	{
+	}
+
+	void DualQuaternionSoA::Resize(uint32_t size)
+	{
+		size_t const padded_size = (size + BATCH_SIZE - 1) & ~(BATCH_SIZE - 1);
+		for (uint32_t i = 0; i < NUM_COMPONENTS; ++ i)
+		{
+			// Only the w of the real part is 1 in an identity dual quaternion
+			comps_[i].resize(padded_size, (3 == i) ? 1.0f : 0.0f);
+		}
+		size_ = size;
+	}
+
+	void DualQuaternionSoA::Clear()
+	{
+		this->Resize(0);
+	}
+
+	void DualQuaternionSoA::Set(uint32_t index, Quaternion const & real, Quaternion const & dual)
+	{
+		BOOST_ASSERT(index < size_);
+
+		for (uint32_t i = 0; i < 4; ++ i)
+		{
+			comps_[i][index] = real[i];
+			comps_[i + 4][index] = dual[i];
+		}
+	}
+
+	Quaternion DualQuaternionSoA::GetReal(uint32_t index) const
+	{
+		BOOST_ASSERT(index < size_);
+
+		return Quaternion(comps_[0][index], comps_[1][index], comps_[2][index], comps_[3][index]);
+	}
+
+	Quaternion DualQuaternionSoA::GetDual(uint32_t index) const
+	{
+		BOOST_ASSERT(index < size_);
+
+		return Quaternion(comps_[4][index], comps_[5][index], comps_[6][index], comps_[7][index]);
+	}
+}
@@ -30,9 +30,38 @@
 
 #include <KFL/KFL.hpp>
 #include <KFL/SIMDMath.hpp>
+#include <KFL/AABBoxSoA.hpp>
+#include <KFL/DualQuaternionSoA.hpp>
 
 #ifdef SIMD_MATH_SSE
 	#include <emmintrin.h>
+	#ifdef KLAYGE_AVX_SUPPORT
+		#include <immintrin.h>
+	#endif
+#endif
+
+#if defined(SIMD_MATH_SSE)
+namespace
+{
+	// Same as MathLib::mul on 4 quaternions stored as x, y, z, w vectors
+	void MultiplyQuatSoA(__m128* ret, __m128 const * lhs, __m128 const * rhs)
+	{
+		ret[0] = _mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(lhs[0], rhs[3]), _mm_mul_ps(lhs[1], rhs[2])),
+			_mm_mul_ps(lhs[2], rhs[1])), _mm_mul_ps(lhs[3], rhs[0]));
+		ret[1] = _mm_add_ps(_mm_sub_ps(_mm_add_ps(_mm_mul_ps(lhs[0], rhs[2]), _mm_mul_ps(lhs[1], rhs[3])),
+			_mm_mul_ps(lhs[2], rhs[0])), _mm_mul_ps(lhs[3], rhs[1]));
+		ret[2] = _mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(lhs[1], rhs[0]), _mm_mul_ps(lhs[0], rhs[1])),
+			_mm_mul_ps(lhs[2], rhs[3])), _mm_mul_ps(lhs[3], rhs[2]));
+		ret[3] = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(lhs[3], rhs[3]), _mm_mul_ps(lhs[0], rhs[0])),
+			_mm_mul_ps(lhs[1], rhs[1])), _mm_mul_ps(lhs[2], rhs[2]));
+	}
+
+	__m128 DotQuatSoA(__m128 const * lhs, __m128 const * rhs)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(lhs[0], rhs[0]), _mm_mul_ps(lhs[1], rhs[1])),
+			_mm_mul_ps(lhs[2], rhs[2])), _mm_mul_ps(lhs[3], rhs[3]));
+	}
+}
 #endif
 
 namespace KlayGE
@@ -309,6 +338,21 @@ namespace KlayGE
 
 		void StoreVector2(float2& fs, SIMDVectorF4 const & v)
 		{
+			StoreVector2(&fs[0], v);
+		}
+
+		void StoreVector3(float3& fs, SIMDVectorF4 const & v)
+		{
+			StoreVector3(&fs[0], v);
+		}
+
+		void StoreVector4(float4& fs, SIMDVectorF4 const & v)
+		{
+			StoreVector4(&fs[0], v);
+		}
+
+		void StoreVector2(float* fs, SIMDVectorF4 const & v)
+		{
 #if defined(SIMD_MATH_SSE)
 			__m128 x = v.Vec();
 			__m128 y = _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 1, 1));
@@ -322,7 +366,7 @@ namespace KlayGE
 #endif
 		}
 
-		void StoreVector3(float3& fs, SIMDVectorF4 const & v)
+		void StoreVector3(float* fs, SIMDVectorF4 const & v)
 		{
 #if defined(SIMD_MATH_SSE)
 			__m128 x = v.Vec();
@@ -339,7 +383,7 @@ namespace KlayGE
 #endif
 		}
 
-		void StoreVector4(float4& fs, SIMDVectorF4 const & v)
+		void StoreVector4(float* fs, SIMDVectorF4 const & v)
 		{
 #if defined(SIMD_MATH_SSE)
 			_mm_store_ps(&fs[0], v.Vec());
@@ -2088,6 +2132,122 @@ namespace KlayGE
 			return Slerp(Slerp(q1, c, t), Slerp(a, b, t), 2 * t * (1 - t));
 		}
 
+		// Dual Quaternion
+		///////////////////////////////////////////////////////////////////////////////
+		void Sclerp(DualQuaternionSoA& out, DualQuaternionSoA const & lhs, DualQuaternionSoA const & rhs, float const * s)
+		{
+			uint32_t const size = lhs.Size();
+			BOOST_ASSERT(rhs.Size() == size);
+
+			out.Resize(size);
+
+#if defined(SIMD_MATH_SSE)
+			__m128 const zero = _mm_setzero_ps();
+			__m128 const sign_mask = _mm_set1_ps(-0.0f);
+
+			// The storage is padded to DualQuaternionSoA::BATCH_SIZE, so the last batch can be loaded as a whole
+			for (uint32_t i = 0; i < size; i += 4)
+			{
+				uint32_t const num = std::min(4U, size - i);
+
+				__m128 lhs_real[4];
+				__m128 lhs_dual[4];
+				__m128 rhs_real[4];
+				__m128 rhs_dual[4];
+				for (uint32_t c = 0; c < 4; ++ c)
+				{
+					lhs_real[c] = _mm_load_ps(lhs.Component(c) + i);
+					lhs_dual[c] = _mm_load_ps(lhs.Component(c + 4) + i);
+					rhs_real[c] = _mm_load_ps(rhs.Component(c) + i);
+					rhs_dual[c] = _mm_load_ps(rhs.Component(c + 4) + i);
+				}
+
+				// Make sure dot product is >= 0
+				__m128 const flip = _mm_and_ps(_mm_cmplt_ps(DotQuatSoA(lhs_real, rhs_real), zero), sign_mask);
+				for (uint32_t c = 0; c < 4; ++ c)
+				{
+					rhs_real[c] = _mm_xor_ps(rhs_real[c], flip);
+					rhs_dual[c] = _mm_xor_ps(rhs_dual[c], flip);
+				}
+
+				// inverse(lhs_real, lhs_dual)
+				__m128 const sqr_len_0 = DotQuatSoA(lhs_real, lhs_real);
+				__m128 const sqr_len_e = _mm_add_ps(DotQuatSoA(lhs_real, lhs_dual), DotQuatSoA(lhs_real, lhs_dual));
+				__m128 const inv_sqr_len_0 = _mm_div_ps(_mm_set1_ps(1.0f), sqr_len_0);
+				__m128 const inv_sqr_len_e = _mm_div_ps(_mm_xor_ps(sqr_len_e, sign_mask), _mm_mul_ps(sqr_len_0, sqr_len_0));
+				__m128 inv_real[4];
+				__m128 inv_dual[4];
+				for (uint32_t c = 0; c < 4; ++ c)
+				{
+					// conjugate negates x, y, z
+					__m128 const conj_real = (c < 3) ? _mm_xor_ps(lhs_real[c], sign_mask) : lhs_real[c];
+					__m128 const conj_dual = (c < 3) ? _mm_xor_ps(lhs_dual[c], sign_mask) : lhs_dual[c];
+					inv_real[c] = _mm_mul_ps(inv_sqr_len_0, conj_real);
+					inv_dual[c] = _mm_add_ps(_mm_mul_ps(inv_sqr_len_0, conj_dual), _mm_mul_ps(inv_sqr_len_e, conj_real));
+				}
+
+				__m128 dif_real[4];
+				__m128 dif_dual[4];
+				__m128 tmp[4];
+				MultiplyQuatSoA(dif_dual, inv_real, rhs_dual);
+				MultiplyQuatSoA(tmp, inv_dual, rhs_real);
+				for (uint32_t c = 0; c < 4; ++ c)
+				{
+					dif_dual[c] = _mm_add_ps(dif_dual[c], tmp[c]);
+				}
+				MultiplyQuatSoA(dif_real, inv_real, rhs_real);
+
+				// The screw parameters need acos and sincos, which are done lane by lane
+				alignas(16) float dif[8][4];
+				for (uint32_t c = 0; c < 4; ++ c)
+				{
+					_mm_store_ps(dif[c], dif_real[c]);
+					_mm_store_ps(dif[c + 4], dif_dual[c]);
+				}
+				for (uint32_t j = 0; j < num; ++ j)
+				{
+					float angle, pitch;
+					float3 direction, moment;
+					MathLib::udq_to_screw(angle, pitch, direction, moment,
+						Quaternion(dif[0][j], dif[1][j], dif[2][j], dif[3][j]),
+						Quaternion(dif[4][j], dif[5][j], dif[6][j], dif[7][j]));
+
+					angle *= s[i + j];
+					pitch *= s[i + j];
+					std::pair<Quaternion, Quaternion> const dq = MathLib::udq_from_screw(angle, pitch, direction, moment);
+					for (uint32_t c = 0; c < 4; ++ c)
+					{
+						dif[c][j] = dq.first[c];
+						dif[c + 4][j] = dq.second[c];
+					}
+				}
+				for (uint32_t c = 0; c < 4; ++ c)
+				{
+					dif_real[c] = _mm_load_ps(dif[c]);
+					dif_dual[c] = _mm_load_ps(dif[c + 4]);
+				}
+
+				__m128 ret_real[4];
+				__m128 ret_dual[4];
+				MultiplyQuatSoA(ret_dual, lhs_real, dif_dual);
+				MultiplyQuatSoA(tmp, lhs_dual, dif_real);
+				MultiplyQuatSoA(ret_real, lhs_real, dif_real);
+				for (uint32_t c = 0; c < 4; ++ c)
+				{
+					_mm_store_ps(out.Component(c) + i, ret_real[c]);
+					_mm_store_ps(out.Component(c + 4) + i, _mm_add_ps(ret_dual[c], tmp[c]));
+				}
+			}
+#else
+			for (uint32_t i = 0; i < size; ++ i)
+			{
+				std::pair<Quaternion, Quaternion> const dq = MathLib::sclerp(lhs.GetReal(i), lhs.GetDual(i),
+					rhs.GetReal(i), rhs.GetDual(i), s[i]);
+				out.Set(i, dq.first, dq.second);
+			}
+#endif
+		}
+
 		// Plane
 		///////////////////////////////////////////////////////////////////////////////
 		SIMDVectorF4 DotPlane(SIMDVectorF4 const & lhs, SIMDVectorF4 const & rhs)
@@ -2169,5 +2329,132 @@ namespace KlayGE
 		{
 			return lhs * rhs;
 		}
+
+
+		// Bound
+		///////////////////////////////////////////////////////////////////////////////
+		void IntersectAABBFrustum(BoundOverlap* results, AABBoxSoA const & aabbs, Frustum const & frustum)
+		{
+			uint32_t const size = aabbs.Size();
+
+			// Per plane, v0 is the corner furthest along the normal, and v1 is the one diagonally opposed to it.
+			//  The signs of the plane are the same for every box, so the corners are picked per plane, not per box.
+			float const * v0_x[6];
+			float const * v0_y[6];
+			float const * v0_z[6];
+			float const * v1_x[6];
+			float const * v1_y[6];
+			float const * v1_z[6];
+			for (int p = 0; p < 6; ++ p)
+			{
+				Plane const & plane = frustum.FrustumPlane(p);
+				v0_x[p] = (plane.a() < 0) ? aabbs.MinX() : aabbs.MaxX();
+				v0_y[p] = (plane.b() < 0) ? aabbs.MinY() : aabbs.MaxY();
+				v0_z[p] = (plane.c() < 0) ? aabbs.MinZ() : aabbs.MaxZ();
+				v1_x[p] = (plane.a() < 0) ? aabbs.MaxX() : aabbs.MinX();
+				v1_y[p] = (plane.b() < 0) ? aabbs.MaxY() : aabbs.MinY();
+				v1_z[p] = (plane.c() < 0) ? aabbs.MaxZ() : aabbs.MinZ();
+			}
+
+#if defined(SIMD_MATH_SSE)
+#if defined(KLAYGE_AVX_SUPPORT)
+			uint32_t const batch = 8;
+
+			__m256 planes[6][4];
+			for (int p = 0; p < 6; ++ p)
+			{
+				Plane const & plane = frustum.FrustumPlane(p);
+				planes[p][0] = _mm256_set1_ps(plane.a());
+				planes[p][1] = _mm256_set1_ps(plane.b());
+				planes[p][2] = _mm256_set1_ps(plane.c());
+				planes[p][3] = _mm256_set1_ps(plane.d());
+			}
+			__m256 const zero = _mm256_setzero_ps();
+#else
+			uint32_t const batch = 4;
+
+			__m128 planes[6][4];
+			for (int p = 0; p < 6; ++ p)
+			{
+				Plane const & plane = frustum.FrustumPlane(p);
+				planes[p][0] = _mm_set1_ps(plane.a());
+				planes[p][1] = _mm_set1_ps(plane.b());
+				planes[p][2] = _mm_set1_ps(plane.c());
+				planes[p][3] = _mm_set1_ps(plane.d());
+			}
+			__m128 const zero = _mm_setzero_ps();
+#endif
+
+			// The storage is padded to AABBoxSoA::BATCH_SIZE, so the last batch can be loaded as a whole
+			for (uint32_t i = 0; i < size; i += batch)
+			{
+#if defined(KLAYGE_AVX_SUPPORT)
+				__m256 outside = zero;
+				__m256 intersect = zero;
+				for (int p = 0; p < 6; ++ p)
+				{
+					__m256 d0 = _mm256_mul_ps(planes[p][0], _mm256_load_ps(v0_x[p] + i));
+					d0 = _mm256_add_ps(d0, _mm256_mul_ps(planes[p][1], _mm256_load_ps(v0_y[p] + i)));
+					d0 = _mm256_add_ps(d0, _mm256_mul_ps(planes[p][2], _mm256_load_ps(v0_z[p] + i)));
+					d0 = _mm256_add_ps(d0, planes[p][3]);
+					outside = _mm256_or_ps(outside, _mm256_cmp_ps(d0, zero, _CMP_LT_OQ));
+
+					__m256 d1 = _mm256_mul_ps(planes[p][0], _mm256_load_ps(v1_x[p] + i));
+					d1 = _mm256_add_ps(d1, _mm256_mul_ps(planes[p][1], _mm256_load_ps(v1_y[p] + i)));
+					d1 = _mm256_add_ps(d1, _mm256_mul_ps(planes[p][2], _mm256_load_ps(v1_z[p] + i)));
+					d1 = _mm256_add_ps(d1, planes[p][3]);
+					intersect = _mm256_or_ps(intersect, _mm256_cmp_ps(d1, zero, _CMP_LT_OQ));
+				}
+				int const outside_mask = _mm256_movemask_ps(outside);
+				int const intersect_mask = _mm256_movemask_ps(intersect);
+#else
+				__m128 outside = zero;
+				__m128 intersect = zero;
+				for (int p = 0; p < 6; ++ p)
+				{
+					__m128 d0 = _mm_mul_ps(planes[p][0], _mm_load_ps(v0_x[p] + i));
+					d0 = _mm_add_ps(d0, _mm_mul_ps(planes[p][1], _mm_load_ps(v0_y[p] + i)));
+					d0 = _mm_add_ps(d0, _mm_mul_ps(planes[p][2], _mm_load_ps(v0_z[p] + i)));
+					d0 = _mm_add_ps(d0, planes[p][3]);
+					outside = _mm_or_ps(outside, _mm_cmplt_ps(d0, zero));
+
+					__m128 d1 = _mm_mul_ps(planes[p][0], _mm_load_ps(v1_x[p] + i));
+					d1 = _mm_add_ps(d1, _mm_mul_ps(planes[p][1], _mm_load_ps(v1_y[p] + i)));
+					d1 = _mm_add_ps(d1, _mm_mul_ps(planes[p][2], _mm_load_ps(v1_z[p] + i)));
+					d1 = _mm_add_ps(d1, planes[p][3]);
+					intersect = _mm_or_ps(intersect, _mm_cmplt_ps(d1, zero));
+				}
+				int const outside_mask = _mm_movemask_ps(outside);
+				int const intersect_mask = _mm_movemask_ps(intersect);
+#endif
+
+				uint32_t const num = std::min(batch, size - i);
+				for (uint32_t j = 0; j < num; ++ j)
+				{
+					if (outside_mask & (1UL << j))
+					{
+						results[i + j] = BO_No;
+					}
+					else
+					{
+						results[i + j] = (intersect_mask & (1UL << j)) ? BO_Partial : BO_Yes;
+					}
+				}
+			}
+#else
+			for (uint32_t i = 0; i < size; ++ i)
+			{
+				bool outside = false;
+				bool intersect = false;
+				for (int p = 0; p < 6; ++ p)
+				{
+					Plane const & plane = frustum.FrustumPlane(p);
+					outside |= (plane.a() * v0_x[p][i] + plane.b() * v0_y[p][i] + plane.c() * v0_z[p][i] + plane.d() < 0);
+					intersect |= (plane.a() * v1_x[p][i] + plane.b() * v1_y[p][i] + plane.c() * v1_z[p][i] + plane.d() < 0);
+				}
+				results[i] = outside ? BO_No : (intersect ? BO_Partial : BO_Yes);
+			}
+#endif
+		}
 	}
 }
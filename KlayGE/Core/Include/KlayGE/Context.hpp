@@ -57,6 +57,9 @@ namespace KlayGE
 
 		bool perf_profiler;
 		bool location_sensor;
+
+		// A directory shared by all effects to cache compiled .kfx by content hash. Empty means no shared cache.
+		std::string effect_cache_dir;
 	};
 
 	class KLAYGE_CORE_API Context : boost::noncopyable
@@ -158,6 +161,11 @@ namespace KlayGE
 			return *gtp_instance_;
 		}
 
+		JobSystem& JobSystemInstance()
+		{
+			return *job_system_;
+		}
+
 	private:
 		void DestroyAll();
 
@@ -191,6 +199,7 @@ namespace KlayGE
 		DllLoader ads_loader_;
 
 		std::unique_ptr<thread_pool> gtp_instance_;
+		std::unique_ptr<JobSystem> job_system_;
 	};
 }
 
@@ -37,6 +37,7 @@
 #pragma once
 
 #include <KlayGE/PreDeclare.hpp>
+#include <KlayGE/ResLoader.hpp>
 
 #include <KFL/Rect.hpp>
 #include <KlayGE/Renderable.hpp>
@@ -91,7 +92,8 @@ namespace KlayGE
 	};
 
 	KLAYGE_CORE_API FontPtr SyncLoadFont(std::string_view font_name, uint32_t flags = 0);
-	KLAYGE_CORE_API FontPtr ASyncLoadFont(std::string_view font_name, uint32_t flags = 0);
+	KLAYGE_CORE_API FontPtr ASyncLoadFont(std::string_view font_name, uint32_t flags = 0,
+		ResLoader::LoadingPriority priority = ResLoader::LP_Normal);
 }
 
 #endif		// _FONT_HPP
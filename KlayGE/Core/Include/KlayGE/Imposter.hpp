@@ -34,6 +34,7 @@
 #pragma once
 
 #include <KlayGE/PreDeclare.hpp>
+#include <KlayGE/ResLoader.hpp>
 
 namespace KlayGE
 {
@@ -84,7 +85,8 @@ namespace KlayGE
 	};
 
 	KLAYGE_CORE_API ImposterPtr SyncLoadImposter(std::string_view impml_name);
-	KLAYGE_CORE_API ImposterPtr ASyncLoadImposter(std::string_view impml_name);
+	KLAYGE_CORE_API ImposterPtr ASyncLoadImposter(std::string_view impml_name,
+		ResLoader::LoadingPriority priority = ResLoader::LP_Normal);
 }
 
 #endif		// _IMPOSTER_HPP
@@ -39,6 +39,10 @@ namespace KlayGE
 {
 	class KLAYGE_CORE_API LZMACodec : boost::noncopyable
 	{
+	public:
+		// Uncompressed size of a chunk in chunked payloads
+		static uint32_t const DEFAULT_CHUNK_SIZE = 1UL << 20;
+
 	public:
 		LZMACodec();
 		~LZMACodec();
@@ -53,6 +57,17 @@ namespace KlayGE
 		void Decode(std::vector<uint8_t>& output, ResIdentifierPtr const & res, uint64_t len, uint64_t original_len);
 		void Decode(std::vector<uint8_t>& output, void const * input, uint64_t len, uint64_t original_len);
 		void Decode(void* output, void const * input, uint64_t len, uint64_t original_len);
+
+		// Chunked payloads are made of independently compressed chunks behind an index, so they can be encoded
+		//  and decoded in parallel on the JobSystem. Every Decode accepts both chunked and plain payloads.
+		uint64_t EncodeChunked(std::ostream& os, void const * input, uint64_t len, uint32_t chunk_size = DEFAULT_CHUNK_SIZE);
+		void EncodeChunked(std::vector<uint8_t>& output, void const * input, uint64_t len,
+			uint32_t chunk_size = DEFAULT_CHUNK_SIZE);
+		static bool IsChunked(void const * input, uint64_t len);
+
+		// Starts decoding and returns a stream of the decoded data right away. Chunks are decoded in parallel in
+		//  the background, a read only waits for the chunks it touches, so parsing overlaps with decoding.
+		ResIdentifierPtr DecodeIncremental(ResIdentifierPtr const & res, uint64_t len, uint64_t original_len);
 	};
 }
 
@@ -18,8 +18,11 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <unordered_map>
 #include <vector>
-#include <list>
+#include <KlayGE/NetChannel.hpp>
 #include <KlayGE/Socket.hpp>
 
 #ifndef KLAYGE_PLATFORM_WINDOWS_STORE
@@ -55,7 +58,7 @@ namespace KlayGE
 
 		uint32_t		time;
 
-		std::list<std::vector<char>> msgs;
+		NetChannel		channel;
 	};
 
 	class KLAYGE_CORE_API Lobby : boost::noncopyable
@@ -67,20 +70,32 @@ namespace KlayGE
 		Lobby();
 		~Lobby();
 
-		void Create(std::string const & Name, char maxPlayers, uint16_t port, Processor const & pro);
+		// Create + Run
+		void Create(std::string const & Name, uint16_t maxPlayers, uint16_t port, Processor const & pro);
+		// Binds the lobby. Port 0 picks a free port, see SockAddr().
+		void Create(std::string const & Name, uint16_t maxPlayers, uint16_t port);
+		// Serves the players until Close() is called from another thread
+		void Run(Processor const & pro);
 		void Close();
 
 		void LobbyName(std::string const & Name);
 		std::string const & LobbyName() const;
 
-		char NumPlayer() const;
+		uint16_t NumPlayer() const;
 
-		void MaxPlayers(char maxPlayers);
-		char MaxPlayers() const;
+		void MaxPlayers(uint16_t maxPlayers);
+		uint16_t MaxPlayers() const;
 
 		int Receive(void* buf, int maxSize, sockaddr_in& from);
 		int Send(void const * buf, int maxSize, sockaddr_in const & to);
 
+		// Queue messages to the channel of a player. They are coalesced into packets, and sent on the next tick of
+		//  the lobby. Returns false if there is no such player or the channel refuses the message. Call them from the
+		//  Processor, on the thread running the lobby.
+		bool SendReliable(uint32_t id, void const * buf, int size);
+		bool SendUnreliable(uint32_t id, void const * buf, int size);
+		bool SendState(uint32_t id, uint32_t slot, void const * buf, int size);
+
 		void TimeOut(uint32_t timeOut)
 			{ this->socket_.TimeOut(timeOut); }
 		uint32_t TimeOut()
@@ -90,21 +105,43 @@ namespace KlayGE
 			{ return this->sockAddr_; }
 
 	private:
-		void OnJoin(char* revbuf, char* sendbuf, int& sendnum, sockaddr_in& From, Processor const & pro);
-		void OnQuit(PlayerAddrsIter iter, char* sendbuf, int& sendnum, Processor const & pro);
+		void Dispatch(char const * msg, int size, sockaddr_in const & from, Processor const & pro);
+
+		void OnJoin(char const * revbuf, int size, sockaddr_in const & from, Processor const & pro);
+		void OnQuit(PlayerAddrsIter iter, sockaddr_in const & from, Processor const & pro);
 
-		void OnGetLobbyInfo(char* sendbuf, int& sendnum, Processor const & pro);
+		void OnGetLobbyInfo(sockaddr_in const & from);
 		void OnNop(PlayerAddrsIter iter);
 
+		void OnPacket(PlayerAddrsIter iter, char const * revbuf, int size, sockaddr_in const & from, Processor const & pro);
+		// The reply goes through the channel if the message came from one
+		void OnDefault(char const * revbuf, int size, sockaddr_in const & from, Processor const & pro, NetChannel* channel);
+
+		void RemovePlayer(PlayerAddrsIter iter, Processor const & pro);
+		void CheckTimeOut(Processor const & pro);
+
+		// Replies are batched, and sent by FlushReplies or when the batch is full
+		void Reply(void const * buf, int size, sockaddr_in const & to);
+		void FlushReplies();
+		void FlushChannels();
+
 		PlayerAddrsIter ID(sockaddr_in const & Addr);
+		PlayerAddrsIter ID(uint32_t id);
 
 	private:
 		Socket			socket_;
 		PlayerAddrs		players_;
+		// Address -> index in players_
+		std::unordered_map<uint64_t, uint32_t> player_indices_;
 
 		sockaddr_in		sockAddr_;
 
 		std::string		name_;
+
+		std::atomic<bool>	running_;
+
+		std::vector<std::array<char, NET_MTU>> reply_bufs_;
+		std::vector<Socket::Datagram> replies_;
 	};
 }
 
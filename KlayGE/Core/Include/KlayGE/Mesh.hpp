@@ -28,11 +28,16 @@
 #pragma once
 
 #include <KlayGE/PreDeclare.hpp>
+#include <KlayGE/ResLoader.hpp>
 #include <KlayGE/Renderable.hpp>
 #include <KlayGE/RenderLayout.hpp>
 #include <KFL/Math.hpp>
+#include <KFL/ArrayRef.hpp>
+#include <KFL/DualQuaternionSoA.hpp>
 #include <KlayGE/SceneObject.hpp>
 
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -271,12 +276,37 @@ namespace KlayGE
 
 	struct KLAYGE_CORE_API KeyFrameSet
 	{
+		// Number of uint16_t per quantized key: 48-bit smallest three real part, 48-bit translation, 16-bit scale
+		static uint32_t const QUANTIZED_KEY_SIZE = 7;
+
 		std::vector<uint32_t> frame_id;
 		std::vector<Quaternion> bind_real;
 		std::vector<Quaternion> bind_dual;
 		std::vector<float> bind_scale;
 
+		// Quantized keys replace bind_real, bind_dual and bind_scale when not empty. Translations and scales are
+		//  relative to the ranges of the set.
+		std::vector<uint16_t> quantized_keys;
+		float3 trans_min;
+		float3 trans_extent;
+		float scale_min;
+		float scale_extent;
+
+		bool Quantized() const
+		{
+			return !quantized_keys.empty();
+		}
+		void Quantize();
+		void Dequantize();
+
+		void Key(uint32_t index, Quaternion& real, Quaternion& dual, float& scale) const;
+
 		std::tuple<Quaternion, Quaternion, float> Frame(float frame) const;
+		// The two keys around frame, and the blending factor between them
+		void FrameKeys(float frame, uint32_t& key0, uint32_t& key1, float& factor) const;
+		// Same, but starts searching from cursor, and stores key0 back to it. Playing forward finds the keys in
+		//  constant time.
+		void FrameKeys(float frame, uint32_t& cursor, uint32_t& key0, uint32_t& key1, float& factor) const;
 	};
 
 	struct KLAYGE_CORE_API AABBKeyFrameSet
@@ -285,6 +315,7 @@ namespace KlayGE
 		std::vector<AABBox> bb;
 
 		AABBox Frame(float frame) const;
+		AABBox Frame(float frame, uint32_t& cursor) const;
 	};
 
 	struct KLAYGE_CORE_API AnimationAction
@@ -324,6 +355,7 @@ namespace KlayGE
 		void AssignJoints(ForwardIterator first, ForwardIterator last)
 		{
 			joints_.assign(first, last);
+			this->UpdateJointOrder();
 			this->UpdateBinds();
 		}
 		std::vector<float4> const & GetBindRealParts() const
@@ -361,6 +393,14 @@ namespace KlayGE
 
 		float GetFrame() const;
 		void SetFrame(float frame);
+		// Same as calling models[i]->SetFrame(frames[i]) on every model, with the models spread over the job system.
+		//  The models must be different objects.
+		static void SetFrames(ArrayRef<SkinnedModel*> models, ArrayRef<float> frames);
+		// SetFrame in two steps. PrepareFrame samples the pose without touching the bind parts, so it can run while
+		//  the model is rendered, but not together with SetFrame or RebindJoints. CommitFrame makes the last prepared
+		//  pose the current one, and is cheap enough for the main thread.
+		void PrepareFrame(float frame);
+		void CommitFrame();
 
 		void RebindJoints();
 		void UnbindJoints();
@@ -378,12 +418,39 @@ namespace KlayGE
 	protected:
 		void BuildBones(float frame);
 		void UpdateBinds();
+		void UpdateBinds(std::vector<float4>& bind_reals, std::vector<float4>& bind_duals) const;
+		void UpdateJointOrder();
+		void SampleLocalPoses(float frame);
 
 	protected:
 		std::vector<Joint> joints_;
 		std::vector<float4> bind_reals_;
 		std::vector<float4> bind_duals_;
 
+		// Bind parts of PrepareFrame. They are built into the next ones, then swapped with the prepared ones under
+		//  the mutex, so CommitFrame never waits for the sampling.
+		std::vector<float4> next_bind_reals_;
+		std::vector<float4> next_bind_duals_;
+		std::vector<float4> prepared_bind_reals_;
+		std::vector<float4> prepared_bind_duals_;
+		float prepared_frame_;
+		bool frame_prepared_;
+		std::mutex prepared_mutex_;
+
+		// Joint indices sorted parents first
+		std::vector<uint16_t> joint_order_;
+
+		// Local poses of the current frame. Joints between two keys are blended in one batch.
+		std::vector<Quaternion> local_reals_;
+		std::vector<Quaternion> local_duals_;
+		std::vector<float> local_scales_;
+		std::vector<uint32_t> key_cursors_;
+		std::vector<uint32_t> blend_joints_;
+		std::vector<float> blend_factors_;
+		DualQuaternionSoA blend_from_;
+		DualQuaternionSoA blend_to_;
+		DualQuaternionSoA blend_result_;
+
 		std::shared_ptr<std::vector<KeyFrameSet>> key_frame_sets_;
 		float last_frame_;
 
@@ -410,6 +477,8 @@ namespace KlayGE
 
 	private:
 		std::shared_ptr<AABBKeyFrameSet> frame_pos_aabbs_;
+		// Only a search hint, so concurrent callers don't need to agree on it
+		mutable std::atomic<uint32_t> frame_pos_cursor_;
 	};
 
 
@@ -445,7 +514,8 @@ namespace KlayGE
 		std::function<StaticMeshPtr(RenderModelPtr const &, std::wstring const &)> CreateMeshFactoryFunc = CreateMeshFactory<StaticMesh>());
 	KLAYGE_CORE_API RenderModelPtr ASyncLoadModel(std::string_view model_name, uint32_t access_hint,
 		std::function<RenderModelPtr(std::wstring const &)> CreateModelFactoryFunc = CreateModelFactory<RenderModel>(),
-		std::function<StaticMeshPtr(RenderModelPtr const &, std::wstring const &)> CreateMeshFactoryFunc = CreateMeshFactory<StaticMesh>());
+		std::function<StaticMeshPtr(RenderModelPtr const &, std::wstring const &)> CreateMeshFactoryFunc = CreateMeshFactory<StaticMesh>(),
+		ResLoader::LoadingPriority priority = ResLoader::LP_Normal);
 	KLAYGE_CORE_API RenderModelPtr LoadSoftwareModel(std::string_view model_name);
 
 	KLAYGE_CORE_API void SaveModel(RenderModelPtr const & model, std::string const & model_name);
@@ -0,0 +1,207 @@
+/**
+ * @file NetChannel.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#ifndef _NETCHANNEL_HPP
+#define _NETCHANNEL_HPP
+
+#pragma once
+
+#include <KlayGE/NetMsg.hpp>
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+namespace KlayGE
+{
+	// Largest packet a channel sends. Stays below the usual path MTU, so packets are never fragmented.
+	uint32_t const NET_MTU = 1200;
+	// [MSG_PACKET][sequence, 2 bytes][ack, 2 bytes][ack bits, 4 bytes]
+	uint32_t const NET_PACKET_HEADER_SIZE = 9;
+	// Largest message that fits in a packet with its record header
+	uint32_t const NET_MAX_MESSAGE_SIZE = NET_MTU - NET_PACKET_HEADER_SIZE - 10;
+
+	// A connection to one peer over an unconnected UDP socket. Messages are queued, and coalesced by Flush into
+	//  packets of at most NET_MTU bytes. Every packet has a sequence number, and acks the latest 33 packets received
+	//  from the peer with a sequence number and a bitfield, so a lost ack is repeated by the next packets for free.
+	//  The channel doesn't own a socket, packets go in through OnPacket and out through the emit function of Flush.
+	//
+	// Three kinds of messages:
+	//  Reliable, delivered exactly once, in any order. A message is retransmitted only when the packets carrying it
+	//   aren't acked within the retransmit time out, which comes from the measured round trip time, and backs off
+	//   exponentially on repeated losses.
+	//  Unreliable, sent once.
+	//  State, the latest value of a slot. Unreliable, and never delivered older than what was delivered before. It's
+	//   sent as a delta against the latest value the peer has acked, if that's smaller.
+	class KLAYGE_CORE_API NetChannel
+	{
+	public:
+		typedef std::chrono::steady_clock::time_point TimePoint;
+		typedef std::function<void(char const * packet, uint32_t size)> EmitFunc;
+		typedef std::function<void(char const * msg, uint32_t size)> DeliverFunc;
+
+		static uint32_t const MAX_RELIABLE_IN_FLIGHT = 64;
+		static uint32_t const NUM_STATE_SLOTS = 16;
+
+		struct Stats
+		{
+			uint32_t packets_sent;
+			uint32_t bytes_sent;
+			uint32_t retransmits;
+			uint32_t packets_received;
+		};
+
+	public:
+		NetChannel();
+
+		void Reset();
+
+		// Returns false if the message is too large, or MAX_RELIABLE_IN_FLIGHT messages are waiting for acks
+		bool SendReliable(void const * msg, uint32_t size);
+		bool SendUnreliable(void const * msg, uint32_t size);
+		// Replaces the value of a state slot. Only the latest value is sent by the next Flush.
+		bool SendState(uint32_t slot, void const * msg, uint32_t size);
+
+		// Sends the queued messages, the retransmits that are due, and the acks the peer is waiting for
+		void Flush(TimePoint now, EmitFunc const & emit);
+		// Returns false if the packet is malformed. The messages that are new to this side are delivered.
+		bool OnPacket(char const * packet, uint32_t size, TimePoint now, DeliverFunc const & deliver);
+
+		bool Idle() const
+		{
+			return (0 == num_reliable_) && unreliable_.empty() && (0 == num_acks_pending_);
+		}
+
+		// Smoothed round trip time, and the retransmit time out derived from it
+		std::chrono::milliseconds Rtt() const;
+		std::chrono::milliseconds Rto() const;
+
+		Stats const & Statistics() const
+		{
+			return stats_;
+		}
+
+	private:
+		struct ReliableMsg
+		{
+			uint16_t id;
+			bool acked;
+			bool sent;
+			uint32_t num_sends;
+			TimePoint last_send;
+			std::vector<char> data;
+		};
+
+		struct SentPacket
+		{
+			uint16_t seq;
+			bool valid;
+			TimePoint send_time;
+			std::vector<uint16_t> reliable_ids;
+			std::vector<std::pair<uint8_t, uint16_t>> states;
+		};
+
+		struct StateValue
+		{
+			uint16_t seq;
+			bool valid;
+			std::vector<char> data;
+		};
+
+		static uint32_t const NUM_SENT_PACKETS = 256;
+		static uint32_t const STATE_HISTORY = 32;
+
+		struct SendStateSlot
+		{
+			std::vector<char> latest;
+			bool dirty;
+			uint16_t next_seq;
+			bool acked_valid;
+			uint16_t acked_seq;
+			std::array<StateValue, STATE_HISTORY> history;
+		};
+
+		struct RecvStateSlot
+		{
+			bool delivered_valid;
+			uint16_t delivered_seq;
+			std::array<StateValue, STATE_HISTORY> history;
+		};
+
+	private:
+		void BeginPacket();
+		void EndPacket(TimePoint now, EmitFunc const & emit);
+		void ReserveRecord(uint32_t size, TimePoint now, EmitFunc const & emit);
+
+		void OnAck(uint16_t seq, TimePoint now, bool sample_rtt);
+		bool AcceptReliable(uint16_t id);
+		void OnState(uint32_t slot, uint16_t seq, std::vector<char> const & value, DeliverFunc const & deliver);
+
+	private:
+		// Sender
+		uint16_t next_seq_;
+		std::array<SentPacket, NUM_SENT_PACKETS> sent_packets_;
+		std::array<char, NET_MTU> packet_;
+		uint32_t packet_size_;
+
+		uint16_t next_reliable_id_;
+		std::array<ReliableMsg, MAX_RELIABLE_IN_FLIGHT> reliable_;
+		uint32_t reliable_head_;
+		uint32_t num_reliable_;
+
+		// [size, 2 bytes][message]...
+		std::vector<char> unreliable_;
+
+		std::array<SendStateSlot, NUM_STATE_SLOTS> send_states_;
+		std::vector<char> delta_;
+
+		bool rtt_valid_;
+		float srtt_;
+		float rttvar_;
+
+		// Receiver
+		uint16_t remote_seq_;
+		uint32_t remote_bits_;
+		uint32_t num_acks_pending_;
+
+		// Reliable ids not received yet start at recv_base_. The sender never has more than MAX_RELIABLE_IN_FLIGHT
+		//  messages in flight, so a bitmask of that size is enough to filter out the duplicates.
+		uint16_t recv_base_;
+		uint64_t recv_mask_;
+
+		std::array<RecvStateSlot, NUM_STATE_SLOTS> recv_states_;
+		std::vector<char> state_value_;
+
+		Stats stats_;
+	};
+}
+
+#endif			// _NETCHANNEL_HPP
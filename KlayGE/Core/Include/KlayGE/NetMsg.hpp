@@ -26,6 +26,9 @@ namespace KlayGE
 		MSG_GETLOBBYINFO,
 
 		MSG_NOP,
+
+		// A packet of a NetChannel. Carries the reliable, unreliable and state messages of a joined player.
+		MSG_PACKET,
 	};
 }
 
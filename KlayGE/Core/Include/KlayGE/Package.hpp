@@ -36,6 +36,11 @@
 #include <KlayGE/PreDeclare.hpp>
 #include <KFL/CXX17/string_view.hpp>
 
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 struct IInArchive;
 
 namespace KlayGE
@@ -54,8 +59,26 @@ namespace KlayGE
 			return archive_is_.get();
 		}
 
+		// Budget in bytes of the decoded entry cache. 0 disables the cache.
+		size_t DecodedCacheSize() const
+		{
+			return max_decoded_size_;
+		}
+		void DecodedCacheSize(size_t size);
+
 	private:
+		struct DecodedEntry
+		{
+			uint32_t index;
+			uint64_t timestamp;
+			std::shared_ptr<std::vector<char>> data;
+		};
+
 		uint32_t Find(std::string_view extract_file_path);
+		bool IsExtractable(uint32_t index);
+		uint64_t ItemTimestamp(uint32_t index);
+		void CacheDecoded(uint32_t index, uint64_t timestamp, std::shared_ptr<std::vector<char>> const & data);
+		void TrimDecodedCache(size_t max_size);
 
 	private:
 		ResIdentifierPtr archive_is_;
@@ -64,6 +87,17 @@ namespace KlayGE
 		std::string password_;
 
 		uint32_t num_items_;
+
+		// Lower case item path to item index, built when the archive is opened. Items that can't be extracted
+		//  are mapped to 0xFFFFFFFF.
+		std::unordered_map<std::string, uint32_t> path_index_;
+
+		// Recently extracted entries, most recently used first. The buffers are immutable and shared with
+		//  the ResIdentifiers returned by Extract, so evicting an entry never invalidates a reader.
+		std::list<DecodedEntry> decoded_lru_;
+		std::unordered_map<uint32_t, std::list<DecodedEntry>::iterator> decoded_index_;
+		size_t decoded_size_;
+		size_t max_decoded_size_;
 	};
 }
 
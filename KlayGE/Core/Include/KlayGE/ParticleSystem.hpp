@@ -34,9 +34,12 @@
 #pragma once
 
 #include <KlayGE/PreDeclare.hpp>
+#include <KlayGE/ResLoader.hpp>
 #include <KFL/Math.hpp>
+#include <KFL/AlignedAllocator.hpp>
 #include <KlayGE/SceneObjectHelper.hpp>
 
+#include <array>
 #include <mutex>
 #include <random>
 #include <vector>
@@ -55,6 +58,78 @@ namespace KlayGE
 		float init_life;
 	};
 
+	// Particles stored as structure of arrays, so updaters can process them with SIMD. Live particles are kept packed
+	//  at [0, Size()). Every stream is aligned and padded to a multiple of BATCH_SIZE.
+	class KLAYGE_CORE_API ParticleSoA
+	{
+	public:
+		static uint32_t const BATCH_SIZE = 4;
+
+		enum StreamType
+		{
+			PS_PosX = 0,
+			PS_PosY,
+			PS_PosZ,
+			PS_VelX,
+			PS_VelY,
+			PS_VelZ,
+			PS_Life,
+			PS_Spin,
+			PS_Size,
+			PS_Alpha,
+			PS_InitLife,
+
+			PS_NumStreams
+		};
+
+		explicit ParticleSoA(uint32_t capacity);
+
+		uint32_t Capacity() const
+		{
+			return capacity_;
+		}
+		uint32_t Size() const
+		{
+			return size_;
+		}
+		bool Empty() const
+		{
+			return 0 == size_;
+		}
+		bool Full() const
+		{
+			return capacity_ == size_;
+		}
+
+		void Clear()
+		{
+			size_ = 0;
+		}
+
+		Particle Get(uint32_t index) const;
+		void Set(uint32_t index, Particle const & par);
+
+		void PushBack(Particle const & par);
+		// Moves the last particle to index and shrinks the array by one
+		void SwapRemove(uint32_t index);
+
+		float* Stream(StreamType type)
+		{
+			return streams_[type].data();
+		}
+		float const * Stream(StreamType type) const
+		{
+			return streams_[type].data();
+		}
+
+	private:
+		typedef std::vector<float, aligned_allocator<float, 16>> FloatArray;
+
+		uint32_t capacity_;
+		uint32_t size_;
+		std::array<FloatArray, PS_NumStreams> streams_;
+	};
+
 	class KLAYGE_CORE_API ParticleEmitter
 	{
 	public:
@@ -215,7 +290,8 @@ namespace KlayGE
 		virtual std::string const & Type() const = 0;
 		virtual ParticleUpdaterPtr Clone() = 0;
 
-		virtual void Update(Particle& par, float elapse_time) = 0;
+		// Updates the particles [begin, end). Can be called on disjoint ranges from several threads at once.
+		virtual void Update(ParticleSoA& particles, uint32_t begin, uint32_t end, float elapse_time) = 0;
 
 	protected:
 		void DoClone(ParticleUpdaterPtr const & rhs);
@@ -290,19 +366,14 @@ namespace KlayGE
 
 		uint32_t NumParticles() const
 		{
-			return static_cast<uint32_t>(particles_.size());
+			return particles_.Capacity();
 		}
 		uint32_t NumActiveParticles() const;
+		// Index of the i-th active particle, back to front
 		uint32_t GetActiveParticleIndex(uint32_t i) const;
-		Particle const & GetParticle(uint32_t i) const
-		{
-			BOOST_ASSERT(i < particles_.size());
-			return particles_[i];
-		}
-		Particle& GetParticle(uint32_t i)
+		Particle GetParticle(uint32_t i) const
 		{
-			BOOST_ASSERT(i < particles_.size());
-			return particles_[i];
+			return particles_.Get(i);
 		}
 		void ClearParticles();
 
@@ -330,15 +401,24 @@ namespace KlayGE
 		void SceneDepthTexture(TexturePtr const & depth_tex);
 
 	private:
-		void UpdateParticlesNoLock(float elapsed_time, std::vector<std::pair<uint32_t, float>>& active_particles);
-		void UpdateParticleBufferNoLock(std::vector<std::pair<uint32_t, float>> const & active_particles);
+		// Sorted by key, which orders the particles back to front
+		struct ActiveParticle
+		{
+			uint64_t key;
+			uint32_t index;
+		};
+
+		void UpdateParticlesNoLock(float elapsed_time, std::vector<ActiveParticle>& active_particles);
+		void UpdateParticleBufferNoLock(std::vector<ActiveParticle> const & active_particles);
 
 	protected:
 		std::vector<ParticleEmitterPtr> emitters_;
 		std::vector<ParticleUpdaterPtr> updaters_;
 
-		std::vector<Particle> particles_;
-		std::vector<std::pair<uint32_t, float>> actived_particles_;
+		ParticleSoA particles_;
+		std::vector<ActiveParticle> actived_particles_;
+		std::vector<ActiveParticle> actived_particles_scratch_;
+		AABBox pos_bound_;
 		mutable std::mutex actived_particles_mutex_;
 
 		float gravity_;
@@ -354,7 +434,8 @@ namespace KlayGE
 	};
 
 	KLAYGE_CORE_API ParticleSystemPtr SyncLoadParticleSystem(std::string_view psml_name);
-	KLAYGE_CORE_API ParticleSystemPtr ASyncLoadParticleSystem(std::string_view psml_name);
+	KLAYGE_CORE_API ParticleSystemPtr ASyncLoadParticleSystem(std::string_view psml_name,
+		ResLoader::LoadingPriority priority = ResLoader::LP_Normal);
 
 	KLAYGE_CORE_API void SaveParticleSystem(ParticleSystemPtr const & ps, std::string const & psml_name);
 
@@ -389,6 +470,7 @@ namespace KlayGE
 		{
 			std::lock_guard<std::mutex> lock(update_mutex_);
 			size_over_life_ = size_over_life;
+			this->BuildCurvesNoLock();
 		}
 		std::vector<float2> const & SizeOverLife() const
 		{
@@ -398,6 +480,7 @@ namespace KlayGE
 		{
 			std::lock_guard<std::mutex> lock(update_mutex_);
 			mass_over_life_ = mass_over_life;
+			this->BuildCurvesNoLock();
 		}
 		std::vector<float2> const & MassOverLife() const
 		{
@@ -407,19 +490,28 @@ namespace KlayGE
 		{
 			std::lock_guard<std::mutex> lock(update_mutex_);
 			opacity_over_life_ = opacity_over_life;
+			this->BuildCurvesNoLock();
 		}
 		std::vector<float2> const & OpacityOverLife() const
 		{
 			return opacity_over_life_;
 		}
 
-		virtual void Update(Particle& par, float elapse_time) override;
+		virtual void Update(ParticleSoA& particles, uint32_t begin, uint32_t end, float elapse_time) override;
+
+	private:
+		struct Curves;
+
+		void BuildCurvesNoLock();
 
 	private:
 		std::mutex update_mutex_;
 		std::vector<float2> size_over_life_;
 		std::vector<float2> mass_over_life_;
 		std::vector<float2> opacity_over_life_;
+
+		// Immutable once built. Update takes a reference under the lock, and evaluates without it.
+		std::shared_ptr<Curves const> curves_;
 	};
 }
 
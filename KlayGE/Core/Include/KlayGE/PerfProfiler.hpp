@@ -36,16 +36,22 @@
 #include <KlayGE/PreDeclare.hpp>
 #include <KFL/Timer.hpp>
 
+#include <atomic>
+#include <chrono>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <tuple>
+#include <vector>
 
 namespace KlayGE
 {
+	// A pair of CPU and GPU timers around a part of a frame. Every Begin/End is also recorded as a zone in the trace.
 	class KLAYGE_CORE_API PerfRange : boost::noncopyable
 	{
 	public:
-		PerfRange();
+		explicit PerfRange(std::string const & name);
 
 		void Begin();
 		void End();
@@ -57,6 +63,9 @@ namespace KlayGE
 		bool Dirty() const;
 
 	private:
+		std::string name_;
+		uint64_t zone_begin_;
+
 		Timer cpu_timer_;
 		QueryPtr gpu_timer_query_;
 
@@ -66,10 +75,31 @@ namespace KlayGE
 		bool dirty_;
 	};
 
+	// A scoped CPU zone. Zones nest, and can be opened on any thread. The name isn't copied, it has to outlive
+	//  the profiler. Usually it's a string literal.
+	class KLAYGE_CORE_API PerfZone : boost::noncopyable
+	{
+	public:
+		explicit PerfZone(char const * name);
+		~PerfZone();
+
+	private:
+		char const * name_;
+		uint64_t begin_;
+		bool recording_;
+	};
+
 	class KLAYGE_CORE_API PerfProfiler : boost::noncopyable
 	{
+		struct ThreadEvents;
+
+	public:
+		// Each thread keeps its latest zones and frame markers, up to this many. Older ones are dropped from the trace.
+		static uint32_t constexpr MAX_EVENTS_PER_THREAD = 128 * 1024;
+
 	public:
 		PerfProfiler();
+		~PerfProfiler();
 
 		static PerfProfiler& Instance();
 		static void Destroy();
@@ -78,9 +108,25 @@ namespace KlayGE
 		void Resume();
 
 		PerfRangePtr CreatePerfRange(int category, std::string const & name);
+		// Collects the GPU timings, and puts a frame marker in the trace
 		void CollectData();
 
+		// Nanoseconds since the profiler is created
+		uint64_t Now() const;
+		// Records a zone on the calling thread. Lock-free except for the first event of a thread, and for dropping its
+		//  oldest events once it has MAX_EVENTS_PER_THREAD of them.
+		void AddZone(char const * name, uint64_t begin, uint64_t end);
+		// Names the calling thread in the trace
+		void SetThreadName(std::string const & name);
+
 		void ExportToCSV(std::string const & file_name) const;
+		// Writes the zones and frame markers of all threads in Chrome trace event format. The file can be opened
+		//  in chrome://tracing or Perfetto.
+		void ExportToChromeTrace(std::string const & file_name) const;
+
+	private:
+		ThreadEvents& CurrentThreadEvents();
+		void AddEvent(char const * name, uint64_t begin, uint64_t end);
 
 	private:
 		static std::unique_ptr<PerfProfiler> perf_profiler_instance_;
@@ -88,6 +134,12 @@ namespace KlayGE
 		std::vector<std::tuple<int, std::string, PerfRangePtr,
 			std::vector<std::tuple<uint32_t, double, double>>>> perf_ranges_;
 		uint32_t frame_id_;
+
+		uint32_t const profiler_id_;
+		std::chrono::steady_clock::time_point const start_time_;
+
+		mutable std::mutex threads_mutex_;
+		std::vector<std::unique_ptr<ThreadEvents>> threads_;
 	};
 }
 
@@ -18,10 +18,13 @@
 
 #pragma once
 
-#include <list>
+#include <atomic>
+#include <deque>
+#include <mutex>
 #include <vector>
 
 #include <KFL/Thread.hpp>
+#include <KlayGE/NetChannel.hpp>
 #include <KlayGE/Socket.hpp>
 
 #ifndef KLAYGE_PLATFORM_WINDOWS_STORE
@@ -30,8 +33,8 @@ namespace KlayGE
 {
 	struct LobbyDes
 	{
-		char			numPlayer;
-		char			maxPlayers;
+		uint16_t		numPlayer;
+		uint16_t		maxPlayers;
 		std::string		name;
 		sockaddr_in		addr;
 	};
@@ -51,21 +54,37 @@ namespace KlayGE
 		std::string const & Name()
 			{ return this->name_; }
 
+		// After joining, returns the messages received by the receive thread, or -1 if there is none
 		int Receive(void* buf, int maxSize, sockaddr_in& from);
 		int Send(void const * buf, int size);
+		// Queue messages to the channel to the lobby. They are coalesced into packets, and sent on the next tick of
+		//  the receive thread. Returns false if the channel refuses the message.
+		bool SendReliable(void const * buf, int size);
+		bool SendUnreliable(void const * buf, int size);
+		bool SendState(uint32_t slot, void const * buf, int size);
 
 		void ReceiveFunc();
 
+	private:
+		void OnMessage(char const * msg, int size);
+		void FlushChannel();
+
 	private:
 		Socket		socket_;
+		sockaddr_in	lobbyAddr_;
 
-		char		playerID_;
+		uint16_t	playerID_;
 		std::string	name_;
 
-		joiner<void>	receiveThread_;
-		bool			receiveLoop_;
+		joiner<void>		receiveThread_;
+		bool				joined_;
+		std::atomic<bool>	receiveLoop_;
+
+		std::mutex		channelMutex_;
+		NetChannel		channel_;
 
-		std::list<std::vector<char>> sendQueue_;
+		std::mutex		recvMutex_;
+		std::deque<std::vector<char>> recvQueue_;
 	};
 }
 
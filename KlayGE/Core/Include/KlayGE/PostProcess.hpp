@@ -28,6 +28,7 @@
 #include <vector>
 
 #include <KlayGE/PreDeclare.hpp>
+#include <KlayGE/ResLoader.hpp>
 #include <KFL/CXX17/string_view.hpp>
 #include <KFL/ArrayRef.hpp>
 #include <KlayGE/RenderFactory.hpp>
@@ -192,7 +193,8 @@ namespace KlayGE
 	};
 
 	KLAYGE_CORE_API PostProcessPtr SyncLoadPostProcess(std::string_view ppml_name, std::string_view pp_name);
-	KLAYGE_CORE_API PostProcessPtr ASyncLoadPostProcess(std::string_view ppml_name, std::string_view pp_name);
+	KLAYGE_CORE_API PostProcessPtr ASyncLoadPostProcess(std::string_view ppml_name, std::string_view pp_name,
+		ResLoader::LoadingPriority priority = ResLoader::LP_Normal);
 
 
 	class KLAYGE_CORE_API PostProcessChain : public PostProcess
@@ -55,6 +55,7 @@
 #pragma once
 
 #include <KlayGE/PreDeclare.hpp>
+#include <KlayGE/ResLoader.hpp>
 #include <vector>
 #include <string>
 #include <algorithm>
@@ -879,7 +880,8 @@ namespace KlayGE
 		std::string res_name_;
 		size_t res_name_hash_;
 #if KLAYGE_IS_DEV_PLATFORM
-		uint64_t timestamp_;
+		// Hash of the .fxml sources, their includes, and the shader platform
+		uint64_t content_hash_;
 #endif
 
 		std::vector<std::unique_ptr<RenderTechnique>> techniques_;
@@ -1261,8 +1263,10 @@ namespace KlayGE
 
 	KLAYGE_CORE_API RenderEffectPtr SyncLoadRenderEffect(std::string_view effect_names);
 	KLAYGE_CORE_API RenderEffectPtr SyncLoadRenderEffects(ArrayRef<std::string> effect_names);
-	KLAYGE_CORE_API RenderEffectPtr ASyncLoadRenderEffect(std::string_view effect_name);
-	KLAYGE_CORE_API RenderEffectPtr ASyncLoadRenderEffects(ArrayRef<std::string> effect_names);
+	KLAYGE_CORE_API RenderEffectPtr ASyncLoadRenderEffect(std::string_view effect_name,
+		ResLoader::LoadingPriority priority = ResLoader::LP_Normal);
+	KLAYGE_CORE_API RenderEffectPtr ASyncLoadRenderEffects(ArrayRef<std::string> effect_names,
+		ResLoader::LoadingPriority priority = ResLoader::LP_Normal);
 }
 
 #endif		// _RENDEREFFECT_HPP
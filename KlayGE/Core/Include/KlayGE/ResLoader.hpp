@@ -34,18 +34,14 @@
 #pragma once
 
 #include <KlayGE/PreDeclare.hpp>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <istream>
 #include <string>
+#include <unordered_map>
 #include <vector>
-#if defined(KLAYGE_COMPILER_CLANGC2)
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wunused-parameter" // Ignore unused parameter 'x', 'alloc'
-#pragma clang diagnostic ignored "-Wunused-variable" // Ignore unused variable (mpl_assertion_in_line_xxx) in boost
-#endif
-#include <boost/lockfree/spsc_queue.hpp>
-#if defined(KLAYGE_COMPILER_CLANGC2)
-#pragma clang diagnostic pop
-#endif
 
 #include <KFL/ResIdentifier.hpp>
 #include <KFL/Thread.hpp>
@@ -77,6 +73,8 @@ namespace KlayGE
 		virtual bool HasSubThreadStage() const = 0;
 
 		virtual bool Match(ResLoadingDesc const & rhs) const = 0;
+		// Descs that Match must have the same Hash
+		virtual size_t Hash() const = 0;
 		virtual void CopyDataFrom(ResLoadingDesc const & rhs) = 0;
 		virtual std::shared_ptr<void> CloneResourceFrom(std::shared_ptr<void> const & resource) = 0;
 
@@ -85,6 +83,17 @@ namespace KlayGE
 
 	class KLAYGE_CORE_API ResLoader : boost::noncopyable
 	{
+	public:
+		// Order of the sub thread stage of async requests. Requests with the same priority are served in FIFO order.
+		enum LoadingPriority
+		{
+			LP_High = 0,	// Needed by what's visible now
+			LP_Normal,
+			LP_Low,			// Prefetching
+
+			LP_NumPriorities
+		};
+
 	public:
 		ResLoader();
 		~ResLoader();
@@ -107,12 +116,16 @@ namespace KlayGE
 		void Unmount(std::string_view virtual_path, std::string_view phy_path);
 
 		ResIdentifierPtr Open(std::string_view name);
+		// Opens an XML asset. Prefers its compiled form, name + ".kxml", made by PlatformDeployer, unless it's older
+		//  than the XML. On dev platforms a missing or stale compiled form is rebuilt next to the XML, for the next
+		//  run. Otherwise falls back to the XML. XMLDocument::Parse takes both.
+		ResIdentifierPtr OpenXML(std::string_view name);
 		std::string Locate(std::string_view name);
 		uint64_t Timestamp(std::string_view name);
 		std::string AbsPath(std::string_view path);
 
 		std::shared_ptr<void> SyncQuery(ResLoadingDescPtr const & res_desc);
-		std::shared_ptr<void> ASyncQuery(ResLoadingDescPtr const & res_desc);
+		std::shared_ptr<void> ASyncQuery(ResLoadingDescPtr const & res_desc, LoadingPriority priority = LP_Normal);
 		void Unload(std::shared_ptr<void> const & res);
 
 		template <typename T>
@@ -122,9 +135,9 @@ namespace KlayGE
 		}
 
 		template <typename T>
-		std::shared_ptr<T> ASyncQueryT(ResLoadingDescPtr const & res_desc)
+		std::shared_ptr<T> ASyncQueryT(ResLoadingDescPtr const & res_desc, LoadingPriority priority = LP_Normal)
 		{
-			return std::static_pointer_cast<T>(this->ASyncQuery(res_desc));
+			return std::static_pointer_cast<T>(this->ASyncQuery(res_desc, priority));
 		}
 
 		template <typename T>
@@ -135,6 +148,13 @@ namespace KlayGE
 
 		void Update();
 
+		// Number of threads running the sub thread stage of async requests. 0 means choosing from the number of cores.
+		uint32_t NumLoadingThreads() const
+		{
+			return num_loading_threads_;
+		}
+		void NumLoadingThreads(uint32_t num);
+
 	private:
 		std::string RealPath(std::string_view path);
 		std::string RealPath(std::string_view path,
@@ -146,7 +166,9 @@ namespace KlayGE
 		std::shared_ptr<void> FindMatchLoadedResource(ResLoadingDescPtr const & res_desc);
 		void RemoveUnrefResources();
 
-		void LoadingThreadFunc();
+		void StartLoadingThreads();
+		void StopLoadingThreads();
+		void LoadingThreadFunc(uint32_t generation);
 
 #if defined(KLAYGE_PLATFORM_ANDROID)
 		AAsset* LocateFileAndroid(std::string_view name);
@@ -170,16 +192,24 @@ namespace KlayGE
 		std::string local_path_;
 		std::vector<std::tuple<uint64_t, uint32_t, std::string, PackagePtr>> paths_;
 		std::mutex paths_mutex_;
+		std::mutex xml_jit_mutex_;
 
 		std::mutex loaded_mutex_;
 		std::mutex loading_mutex_;
-		std::vector<std::pair<ResLoadingDescPtr, std::weak_ptr<void>>> loaded_res_;
-		std::vector<std::pair<ResLoadingDescPtr, std::shared_ptr<volatile LoadingStatus>>> loading_res_;
-		boost::lockfree::spsc_queue<std::pair<ResLoadingDescPtr, std::shared_ptr<volatile LoadingStatus>>,
-			boost::lockfree::capacity<1024>> loading_res_queue_;
-
-		std::unique_ptr<joiner<void>> loading_thread_;
-		volatile bool quit_;
+		// Keyed by ResLoadingDesc::Hash. Match is only called inside a bucket.
+		std::unordered_multimap<size_t, std::pair<ResLoadingDescPtr, std::weak_ptr<void>>> loaded_res_;
+		std::unordered_multimap<size_t, std::pair<ResLoadingDescPtr, std::shared_ptr<volatile LoadingStatus>>> loading_res_;
+		size_t num_loaded_res_after_sweep_;
+
+		std::mutex loading_queue_mutex_;
+		std::condition_variable loading_queue_cond_;
+		std::array<std::deque<std::pair<ResLoadingDescPtr, std::shared_ptr<volatile LoadingStatus>>>, LP_NumPriorities>
+			loading_res_queues_;
+
+		std::atomic<uint32_t> num_loading_threads_;
+		// Both guarded by loading_queue_mutex_. A loading thread quits when the generation it started with is over.
+		std::vector<std::unique_ptr<joiner<void>>> loading_threads_;
+		uint32_t loading_generation_;
 	};
 }
 
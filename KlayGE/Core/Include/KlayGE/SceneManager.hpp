@@ -25,6 +25,7 @@
 
 #include <KlayGE/Renderable.hpp>
 #include <KFL/Frustum.hpp>
+#include <KFL/AABBoxSoA.hpp>
 #include <KFL/Thread.hpp>
 
 #include <vector>
@@ -79,6 +80,9 @@ namespace KlayGE
 		virtual void ClearObject();
 
 		void Update();
+		// One step of the update thread. Objects with SOA_ParallelUpdate are updated on the job system after the
+		//  scene lock is released, the others in order under the lock.
+		void UpdateSceneObjects(float app_time, float frame_time);
 
 		uint32_t NumObjectsRendered() const;
 		uint32_t NumRenderablesRendered() const;
@@ -113,16 +117,35 @@ namespace KlayGE
 
 		std::unordered_map<size_t, std::shared_ptr<std::vector<BoundOverlap>>> visible_marks_map_;
 
+		// World space bounds of scene_objs_, culled in batches
+		AABBoxSoA scene_obj_bounds_;
+		std::vector<BoundOverlap> scene_obj_overlaps_;
+
 		float small_obj_threshold_;
 		float update_elapse_;
 
 	private:
 		void FlushScene();
+		void BuildRenderQueueKeys(Camera const & camera);
 
 	private:
 		uint32_t urt_;
 
-		std::vector<std::pair<RenderTechnique const *, std::vector<Renderable*>>> render_queue_;
+		// 64-bit sort key, from high to low bits:
+		//  16 bits: rank of the technique, by weight
+		//  32 bits: view depth for opaque techniques without discard, material for the others, 0 for transparent ones
+		//  16 bits: material for opaque techniques without discard, layout for the others, 0 for transparent ones
+		//  The sort is stable, so transparent renderables keep the order they were added in.
+		struct RenderQueueItem
+		{
+			uint64_t key;
+			Renderable* renderable;
+		};
+		std::vector<RenderQueueItem> render_queue_;
+		std::vector<RenderQueueItem> render_queue_scratch_;
+		// Techniques of this flush, in the order they are first added. Items hold the index until keys are built.
+		std::vector<RenderTechnique const *> render_techs_;
+		std::unordered_map<RenderTechnique const *, uint32_t> render_tech_indices_;
 
 		uint32_t num_objects_rendered_;
 		uint32_t num_renderables_rendered_;
@@ -132,6 +155,7 @@ namespace KlayGE
 		uint32_t num_dispatch_calls_;
 
 		std::mutex update_mutex_;
+		std::vector<SceneObjectPtr> parallel_update_objs_;
 		std::unique_ptr<joiner<void>> update_thread_;
 		volatile bool quit_;
 
@@ -35,7 +35,10 @@ namespace KlayGE
 			SOA_Moveable = 1UL << 2,
 			SOA_Invisible = 1UL << 3,
 			SOA_NotCastShadow = 1UL << 4,
-			SOA_SSS = 1UL << 5
+			SOA_SSS = 1UL << 5,
+			// SubThreadUpdate only touches the object itself, and synchronizes with rendering on its own. Such objects
+			//  are updated in parallel and outside the scene lock, so they must not add or remove scene objects there.
+			SOA_ParallelUpdate = 1UL << 6
 		};
 
 	public:
@@ -97,6 +97,17 @@ namespace KlayGE
 
 		CameraPtr camera_;
 	};
+
+	// Plays the animation of a loaded skinned model. The pose is sampled in SubThreadUpdate, in parallel with the
+	//  other characters and outside the scene lock, and is shown from the next MainThreadUpdate on.
+	class KLAYGE_CORE_API SceneObjectSkinnedModel : public SceneObjectHelper
+	{
+	public:
+		SceneObjectSkinnedModel(SkinnedModelPtr const & model, uint32_t attrib);
+
+		virtual void SubThreadUpdate(float app_time, float elapsed_time) override;
+		virtual bool MainThreadUpdate(float app_time, float elapsed_time) override;
+	};
 }
 
 #endif		// _RENDERABLEHELPER_HPP
@@ -25,6 +25,7 @@
 #include <KlayGE/RenderLayout.hpp>
 
 #include <array>
+#include <unordered_map>
 
 namespace KlayGE
 {
@@ -163,6 +164,57 @@ namespace KlayGE
 		bool has_tessellation_;
 		uint32_t cs_block_size_x_, cs_block_size_y_, cs_block_size_z_;
 	};
+
+#if KLAYGE_IS_DEV_PLATFORM
+	// Compiles the HLSL shaders of an effect in parallel. An effect is loaded twice while a batch is alive on
+	//  the loading thread. In the recording round, CompileToDXBC only records the request and throws Recorded
+	//  to abort the AttachShader. Compile() then runs all unique requests on the job system. In the replay
+	//  round, CompileToDXBC picks up the results, so the API specific parts of AttachShader stay on the
+	//  loading thread.
+	class KLAYGE_CORE_API DXBCCompileBatch : boost::noncopyable
+	{
+	public:
+		struct Recorded
+		{
+		};
+
+	public:
+		DXBCCompileBatch();
+		~DXBCCompileBatch();
+
+		// The batch alive on the current thread, or nullptr
+		static DXBCCompileBatch* Current();
+
+		bool Recording() const
+		{
+			return recording_;
+		}
+		void Compile();
+
+		void Record(uint64_t key, std::string const & hlsl, std::vector<std::pair<std::string, std::string>> const & macros,
+			char const * func_name, char const * profile, uint32_t flags);
+		bool Fetch(uint64_t key, std::vector<uint8_t>& code, std::string& err_msg) const;
+
+	private:
+		struct Request
+		{
+			std::string const * hlsl;
+			std::vector<std::pair<std::string, std::string>> macros;
+			std::string func_name;
+			std::string profile;
+			uint32_t flags;
+
+			std::vector<uint8_t> code;
+			std::string err_msg;
+		};
+
+		bool recording_;
+		std::vector<Request> requests_;
+		std::unordered_map<uint64_t, uint32_t> request_indices_;
+
+		DXBCCompileBatch* prev_batch_;
+	};
+#endif
 }
 
 #endif			// _SHADEROBJECT_HPP
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #ifndef KLAYGE_PLATFORM_WINDOWS_STORE
 #if defined KLAYGE_PLATFORM_WINDOWS
@@ -44,6 +45,9 @@ namespace KlayGE
 	KLAYGE_CORE_API std::string TransAddr(sockaddr_in const & sockAddr, uint16_t& port);
 	KLAYGE_CORE_API in_addr Host();
 
+	// true if the last socket call failed only because a non-blocking socket had nothing to do
+	KLAYGE_CORE_API bool SocketWouldBlock();
+
 	// ͬ׽
 	///////////////////////////////////////////////////////////////////////////////
 	class KLAYGE_CORE_API Socket : boost::noncopyable
@@ -95,9 +99,73 @@ namespace KlayGE
 		void TimeOut(uint32_t microSecs);
 		uint32_t TimeOut();
 
+		// One datagram of a batched receive or send. On receive, len is the capacity of buf on input and the
+		//  size of the datagram on output.
+		struct Datagram
+		{
+			void*		buf;
+			int			len;
+			sockaddr_in	addr;
+		};
+
+		// Batched ReceiveFrom/SendTo, one system call for the whole batch where the platform supports it
+		//  (recvmmsg/sendmmsg). Return the number of datagrams received/sent, which is less than count when
+		//  a non-blocking socket runs dry or the send buffer is full, or -1 if nothing was transferred.
+		int ReceiveFromMany(Datagram* datagrams, int count);
+		int SendToMany(Datagram const * datagrams, int count);
+
+		SOCKET Handle() const
+		{
+			return socket_;
+		}
+
 	private:
 		SOCKET		socket_;
 	};
+
+	// Waits for a set of non-blocking sockets to become ready. Uses epoll on Linux and Android, poll() on other
+	//  POSIX platforms, and select() on Windows.
+	///////////////////////////////////////////////////////////////////////////////
+	class KLAYGE_CORE_API SocketPoller : boost::noncopyable
+	{
+	public:
+		enum PollEvent
+		{
+			PE_Readable = 1UL << 0,
+			PE_Writable = 1UL << 1
+		};
+
+		struct Event
+		{
+			void*		user_data;
+			uint32_t	events;
+		};
+
+	public:
+		SocketPoller();
+		~SocketPoller();
+
+		void Add(Socket const & socket, uint32_t events, void* user_data);
+		void Modify(Socket const & socket, uint32_t events, void* user_data);
+		void Remove(Socket const & socket);
+
+		// Waits at most timeout_ms milliseconds (-1 for infinite) and returns the number of ready sockets written
+		//  to events
+		int Wait(Event* events, int max_events, int timeout_ms);
+
+	private:
+#if defined(KLAYGE_PLATFORM_LINUX) || defined(KLAYGE_PLATFORM_ANDROID)
+		int epoll_fd_;
+#else
+		struct Entry
+		{
+			SOCKET		socket;
+			uint32_t	events;
+			void*		user_data;
+		};
+		std::vector<Entry> entries_;
+#endif
+	};
 }
 #endif
 
@@ -67,18 +67,33 @@ namespace KlayGE
 
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) = 0;
 		virtual void DecodeBlock(void* output, void const * input) = 0;
+		// A new codec of the same format. Codecs keep states while encoding a block, so each thread needs its own.
+		virtual TexCompressionPtr Clone() const = 0;
 
+		// Encodes the block rows in parallel on the job system, in at most num_threads chunks, so no more than num_threads
+		//  threads encode at a time. 0 means all the workers of the job system, 1 encodes on the calling thread alone.
+		//  The result doesn't depend on the number of threads.
 		virtual void EncodeMem(uint32_t width, uint32_t height, 
 			void* output, uint32_t out_row_pitch, uint32_t out_slice_pitch,
 			void const * input, uint32_t in_row_pitch, uint32_t in_slice_pitch,
-			TexCompressionMethod method);
+			TexCompressionMethod method, uint32_t num_threads = 0);
+		// Decodes the whole blocks of each block row with DecodeBlockRow, straight into the output.
 		virtual void DecodeMem(uint32_t width, uint32_t height,
 			void* output, uint32_t out_row_pitch, uint32_t out_slice_pitch,
 			void const * input, uint32_t in_row_pitch, uint32_t in_slice_pitch);
+		// Decodes num_blocks consecutive blocks into a row of blocks of output. The default implementation goes through
+		//  DecodeBlock. Codecs with a vectorized kernel override it.
+		virtual void DecodeBlockRow(void* output, uint32_t out_row_pitch, void const * input, uint32_t num_blocks);
 
 		virtual void EncodeTex(TexturePtr const & out_tex, TexturePtr const & in_tex, TexCompressionMethod method);
 		virtual void DecodeTex(TexturePtr const & out_tex, TexturePtr const & in_tex);
 
+	protected:
+		// Writes a 4x4 block of 32-bit texels, texel i being palette[indices[i]]. palette has 8 entries. If alpha_palette
+		//  is not null, the alpha channel of texel i is replaced by alpha_palette[alpha_indices[i]].
+		static void DecodePaletteBlock(void* output, uint32_t out_row_pitch, uint32_t const * palette, uint8_t const * indices,
+			uint8_t const * alpha_palette = nullptr, uint8_t const * alpha_indices = nullptr);
+
 	protected:
 		ElementFormat compression_format_;
 	};
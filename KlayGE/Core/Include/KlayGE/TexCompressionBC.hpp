@@ -82,6 +82,8 @@ namespace KlayGE
 
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
+		virtual void DecodeBlockRow(void* output, uint32_t out_row_pitch, void const * input, uint32_t num_blocks) override;
+		virtual TexCompressionPtr Clone() const override;
 
 		void EncodeBC1Internal(BC1Block& bc1, ARGBColor32 const * argb, bool alpha, TexCompressionMethod method) const;
 
@@ -100,6 +102,7 @@ namespace KlayGE
 
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
+		virtual TexCompressionPtr Clone() const override;
 
 	private:
 		TexCompressionBC1 bc1_codec_;
@@ -112,6 +115,8 @@ namespace KlayGE
 
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
+		virtual void DecodeBlockRow(void* output, uint32_t out_row_pitch, void const * input, uint32_t num_blocks) override;
+		virtual TexCompressionPtr Clone() const override;
 	};
 
 	class KLAYGE_CORE_API TexCompressionBC3 : public TexCompression
@@ -121,6 +126,8 @@ namespace KlayGE
 
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
+		virtual void DecodeBlockRow(void* output, uint32_t out_row_pitch, void const * input, uint32_t num_blocks) override;
+		virtual TexCompressionPtr Clone() const override;
 
 	private:
 		TexCompressionBC1 bc1_codec_;
@@ -134,6 +141,8 @@ namespace KlayGE
 
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
+		virtual void DecodeBlockRow(void* output, uint32_t out_row_pitch, void const * input, uint32_t num_blocks) override;
+		virtual TexCompressionPtr Clone() const override;
 
 	private:
 		TexCompressionBC4 bc4_codec_;
@@ -146,6 +155,7 @@ namespace KlayGE
 
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
+		virtual TexCompressionPtr Clone() const override;
 
 		void DecodeBC6Internal(void* output, void const * input, bool signed_fmt);
 
@@ -207,6 +217,7 @@ namespace KlayGE
 
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
+		virtual TexCompressionPtr Clone() const override;
 
 	private:
 		TexCompressionBC6U bc6u_codec_;
@@ -272,6 +283,7 @@ namespace KlayGE
 
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
+		virtual TexCompressionPtr Clone() const override;
 
 	private:
 		void PackBC7UniformBlock(void* output, ARGBColor32 const & pixel);
@@ -131,10 +131,13 @@ namespace KlayGE
 
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
+		virtual void DecodeBlockRow(void* output, uint32_t out_row_pitch, void const * input, uint32_t num_blocks) override;
+		virtual TexCompressionPtr Clone() const override;
 
 		uint64_t EncodeETC1BlockInternal(ETC1Block& output, ARGBColor32 const * argb, TexCompressionMethod method);
 		void DecodeETCIndividualModeInternal(ARGBColor32* argb, ETC1Block const & etc1) const;
 		void DecodeETCDifferentialModeInternal(ARGBColor32* argb, ETC1Block const & etc1, bool alpha) const;
+		void ETC1Palette(uint32_t* palette, ETC1Block const & etc1, bool alpha) const;
 
 		static int GetModifier(int cw, int selector);
 
@@ -208,6 +211,8 @@ namespace KlayGE
 
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
+		virtual void DecodeBlockRow(void* output, uint32_t out_row_pitch, void const * input, uint32_t num_blocks) override;
+		virtual TexCompressionPtr Clone() const override;
 
 		void DecodeETCTModeInternal(ARGBColor32* argb, ETC2TModeBlock const & etc2, bool alpha);
 		void DecodeETCHModeInternal(ARGBColor32* argb, ETC2HModeBlock const & etc2, bool alpha);
@@ -224,6 +229,8 @@ namespace KlayGE
 
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
+		virtual void DecodeBlockRow(void* output, uint32_t out_row_pitch, void const * input, uint32_t num_blocks) override;
+		virtual TexCompressionPtr Clone() const override;
 
 	private:
 		TexCompressionETC1Ptr etc1_codec_;
@@ -51,6 +51,7 @@
 #pragma once
 
 #include <KlayGE/PreDeclare.hpp>
+#include <KlayGE/ResLoader.hpp>
 #include <KlayGE/ElementFormat.hpp>
 #include <KFL/ArrayRef.hpp>
 
@@ -367,15 +368,17 @@ namespace KlayGE
 	KLAYGE_CORE_API TexturePtr LoadSoftwareTexture(std::string_view tex_name);
 	KLAYGE_CORE_API TexturePtr LoadSoftwareTexture(ResIdentifierPtr const & tex_res);
 	KLAYGE_CORE_API TexturePtr SyncLoadTexture(std::string_view tex_name, uint32_t access_hint);
-	KLAYGE_CORE_API TexturePtr ASyncLoadTexture(std::string_view tex_name, uint32_t access_hint);
+	KLAYGE_CORE_API TexturePtr ASyncLoadTexture(std::string_view tex_name, uint32_t access_hint,
+		ResLoader::LoadingPriority priority = ResLoader::LP_Normal);
 
 	KLAYGE_CORE_API void SaveTexture(TexturePtr const & texture, std::string const & tex_name);
 
+	// num_threads caps the threads that encode a compressed dst_format, as in TexCompression::EncodeMem
 	KLAYGE_CORE_API void ResizeTexture(void* dst_data, uint32_t dst_row_pitch, uint32_t dst_slice_pitch, ElementFormat dst_format,
 		uint32_t dst_width, uint32_t dst_height, uint32_t dst_depth,
 		void const * src_data, uint32_t src_row_pitch, uint32_t src_slice_pitch, ElementFormat src_format,
 		uint32_t src_width, uint32_t src_height, uint32_t src_depth,
-		bool linear);
+		bool linear, uint32_t num_threads = 0);
 
 	// return the lookat and up vector in cubemap view
 	//////////////////////////////////////////////////////////////////////////////////
@@ -35,8 +35,10 @@
 
 #include <KlayGE/PreDeclare.hpp>
 
+#include <array>
+#include <atomic>
+#include <mutex>
 #include <vector>
-#include <list>
 
 namespace KlayGE
 {
@@ -55,21 +57,24 @@ namespace KlayGE
 		}
 	};
 
+	// A ring buffer for geometry that lives for one frame. Alloc bumps the head of the ring, and OnPresent
+	//  retires everything allocated before it once the GPU is num_pre_frames_ frames past that point. Data is
+	//  written into a CPU copy and uploaded in EnsureDataReady, so Alloc never touches the GPU buffer.
+	//
+	// Alloc is lock-free and can be called from multiple threads at the same time, unless the ring is full and
+	//  has to grow. EnsureDataReady and OnPresent must not overlap with Alloc.
 	class KLAYGE_CORE_API TransientBuffer : boost::noncopyable
 	{
-		// Frames that have ended
-		struct RetiredFrame
+		// Marks where the allocations made after a present begin in the ring
+		struct FrameFence
 		{
-			// Sub allocs that are unuseful and will be freed at the end of the frame
-			std::list<SubAlloc> pending_frees_;
+			uint64_t begin_pos;
+			// The frame the allocations are rendered in, set when the fence is closed
 			uint32_t frame_id;
-
-			explicit RetiredFrame(uint32_t id)
-				: frame_id(id)
-			{
-			}
 		};
 
+		static uint32_t constexpr MAX_FRAME_FENCES = 8;
+
 	public:
 		enum BindFlag
 		{
@@ -82,8 +87,6 @@ namespace KlayGE
 
 		// Allocate a sub space from transient buffer
 		SubAlloc Alloc(uint32_t size_in_byte, void const * data);
-		// Knowtify transient buffer that this alloc is unused and will be freed at the end of the frame.
-		void Dealloc(SubAlloc const & alloc);
 		void EnsureDataReady();
 		// Do with retired frames
 		void OnPresent();
@@ -95,21 +98,31 @@ namespace KlayGE
 
 	private:
 		GraphicsBufferPtr DoCreateBuffer(BindFlag bind_flag, uint32_t size_in_byte);
-		// Free the sub alloc and return the space allocated back to transient buffer.
-		void DoFree(SubAlloc const & alloc);
+		bool TryBump(uint32_t size_in_byte, uint64_t& pos, uint64_t& new_pos, uint32_t& offset) const;
+		void Grow(uint32_t size_in_byte);
+		void CopyRange(uint8_t* dst, uint64_t begin_pos, uint64_t end_pos) const;
 
 	private:
 		bool use_no_overwrite_;
 		uint32_t num_pre_frames_;
 
 		GraphicsBufferPtr buffer_;
-		std::list<SubAlloc> free_list_;
-		std::list<RetiredFrame> retired_frames_;
 		BindFlag bind_flag_;
+		uint32_t capacity_;
+		std::vector<uint8_t> cpu_buffer_;
+
+		// Positions grow monotonically, the offset in the buffer is pos % capacity_
+		std::atomic<uint64_t> head_pos_;
+		uint64_t tail_pos_;
+		uint64_t upload_pos_;
+
+		std::array<FrameFence, MAX_FRAME_FENCES> fences_;
+		uint32_t first_fence_;
+		uint32_t num_fences_;
 
-		std::vector<uint8_t> simulate_buffer_;
-		uint32_t valid_min_;
-		uint32_t valid_max_;
+		std::atomic<uint32_t> num_writers_;
+		std::atomic<bool> growing_;
+		std::mutex grow_mutex_;
 	};
 }
 
@@ -37,6 +37,7 @@
 #include <KlayGE/PerfProfiler.hpp>
 #include <KlayGE/UI.hpp>
 #include <KFL/Hash.hpp>
+#include <KFL/JobSystem.hpp>
 
 #include <fstream>
 #include <mutex>
@@ -128,6 +129,7 @@ namespace KlayGE
 #endif
 
 		gtp_instance_ = MakeUniquePtr<thread_pool>(1, 16);
+		job_system_ = MakeUniquePtr<JobSystem>();
 	}
 
 	Context::~Context()
@@ -152,6 +154,7 @@ namespace KlayGE
 
 		app_ = nullptr;
 
+		job_system_.reset();
 		gtp_instance_.reset();
 	}
 
@@ -330,6 +333,7 @@ namespace KlayGE
 		std::vector<std::pair<std::string, std::string>> graphics_options;
 		bool perf_profiler = false;
 		bool location_sensor = false;
+		std::string effect_cache_dir;
 
 		std::string rf_name;
 		std::string af_name;
@@ -402,6 +406,12 @@ namespace KlayGE
 				location_sensor = location_sensor_node->Attrib("enabled")->ValueInt() ? true : false;
 			}
 
+			XMLNodePtr effect_cache_node = context_node->FirstNode("effect_cache");
+			if (effect_cache_node)
+			{
+				effect_cache_dir = std::string(effect_cache_node->Attrib("path")->ValueString());
+			}
+
 			XMLNodePtr frame_node = graphics_node->FirstNode("frame");
 			XMLAttributePtr attr;
 			attr = frame_node->Attrib("width");
@@ -721,6 +731,7 @@ namespace KlayGE
 		cfg_.deferred_rendering = false;
 		cfg_.perf_profiler = perf_profiler;
 		cfg_.location_sensor = location_sensor;
+		cfg_.effect_cache_dir = std::move(effect_cache_dir);
 	}
 
 	void Context::SaveCfg(std::string const & cfg_file)
@@ -766,6 +777,13 @@ namespace KlayGE
 			XMLNodePtr location_sensor_node = cfg_doc.AllocNode(XNT_Element, "location_sensor");
 			location_sensor_node->AppendAttrib(cfg_doc.AllocAttribInt("enabled", cfg_.location_sensor));
 			context_node->AppendNode(location_sensor_node);
+
+			if (!cfg_.effect_cache_dir.empty())
+			{
+				XMLNodePtr effect_cache_node = cfg_doc.AllocNode(XNT_Element, "effect_cache");
+				effect_cache_node->AppendAttrib(cfg_doc.AllocAttribString("path", cfg_.effect_cache_dir));
+				context_node->AppendNode(effect_cache_node);
+			}
 		}
 		root->AppendNode(context_node);
 
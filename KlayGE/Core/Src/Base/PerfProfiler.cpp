@@ -33,7 +33,9 @@
 #include <KlayGE/RenderEngine.hpp>
 #include <KlayGE/Query.hpp>
 
+#include <array>
 #include <fstream>
+#include <iomanip>
 #include <mutex>
 
 #include <KlayGE/PerfProfiler.hpp>
@@ -41,14 +43,95 @@
 namespace
 {
 	std::mutex singleton_mutex;
+
+	// Tells the profiler that registered the calling thread's events, in case the profiler is destroyed and
+	//  created again
+	std::atomic<uint32_t> next_profiler_id(1);
+	thread_local uint32_t tls_profiler_id = 0;
+	thread_local void* tls_thread_events = nullptr;
+
+	void WriteJSONString(std::ostream& os, std::string_view str)
+	{
+		os << '"';
+		for (char ch : str)
+		{
+			switch (ch)
+			{
+			case '"':
+				os << "\\\"";
+				break;
+
+			case '\\':
+				os << "\\\\";
+				break;
+
+			case '\n':
+				os << "\\n";
+				break;
+
+			case '\t':
+				os << "\\t";
+				break;
+
+			default:
+				if (static_cast<uint8_t>(ch) < 0x20)
+				{
+					os << "\\u00" << "0123456789abcdef"[ch >> 4] << "0123456789abcdef"[ch & 0xF];
+				}
+				else
+				{
+					os << ch;
+				}
+				break;
+			}
+		}
+		os << '"';
+	}
+
+	// A zone, or a frame marker if name is nullptr. For frame markers, end is the frame id.
+	struct PerfEvent
+	{
+		char const * name;
+		uint64_t begin;
+		uint64_t end;
+	};
+
+	// Events of a thread are stored in a linked list of fixed size chunks. Only the owner thread appends, and it
+	//  publishes an event by increasing num_events. So the exporter can read them without locking.
+	// When a thread has MAX_CHUNKS chunks, it reuses the oldest one. Unlinking it is done under threads_mutex_, which
+	//  the exporter holds while walking the lists.
+	struct PerfEventChunk
+	{
+		static uint32_t constexpr CAPACITY = 4096;
+		static uint32_t constexpr MAX_CHUNKS = KlayGE::PerfProfiler::MAX_EVENTS_PER_THREAD / CAPACITY;
+
+		std::array<PerfEvent, CAPACITY> events;
+		std::atomic<uint32_t> num_events;
+		std::atomic<PerfEventChunk*> next;
+
+		PerfEventChunk()
+			: num_events(0), next(nullptr)
+		{
+		}
+	};
 }
 
 namespace KlayGE
 {
+	struct PerfProfiler::ThreadEvents
+	{
+		uint32_t tid;
+		std::string name;
+
+		std::vector<std::unique_ptr<PerfEventChunk>> chunks;
+		PerfEventChunk* head;
+		PerfEventChunk* tail;
+	};
+
 	std::unique_ptr<PerfProfiler> PerfProfiler::perf_profiler_instance_;
 
-	PerfRange::PerfRange()
-		: cpu_time_(0), gpu_time_(0), dirty_(false)
+	PerfRange::PerfRange(std::string const & name)
+		: name_(name), zone_begin_(0), cpu_time_(0), gpu_time_(0), dirty_(false)
 	{
 		if (Context::Instance().Config().perf_profiler)
 		{
@@ -62,6 +145,7 @@ namespace KlayGE
 		if (Context::Instance().Config().perf_profiler)
 		{
 			dirty_ = true;
+			zone_begin_ = PerfProfiler::Instance().Now();
 			cpu_timer_.restart();
 			if (gpu_timer_query_)
 			{
@@ -79,6 +163,9 @@ namespace KlayGE
 			{
 				gpu_timer_query_->End();
 			}
+
+			PerfProfiler& profiler = PerfProfiler::Instance();
+			profiler.AddZone(name_.c_str(), zone_begin_, profiler.Now());
 		}
 	}
 
@@ -110,8 +197,32 @@ namespace KlayGE
 	}
 
 
+	PerfZone::PerfZone(char const * name)
+		: name_(name), begin_(0), recording_(Context::Instance().Config().perf_profiler)
+	{
+		if (recording_)
+		{
+			begin_ = PerfProfiler::Instance().Now();
+		}
+	}
+
+	PerfZone::~PerfZone()
+	{
+		if (recording_)
+		{
+			PerfProfiler& profiler = PerfProfiler::Instance();
+			profiler.AddZone(name_, begin_, profiler.Now());
+		}
+	}
+
+
 	PerfProfiler::PerfProfiler()
-		: frame_id_(0)
+		: frame_id_(0),
+			profiler_id_(next_profiler_id.fetch_add(1)), start_time_(std::chrono::steady_clock::now())
+	{
+	}
+
+	PerfProfiler::~PerfProfiler()
 	{
 	}
 
@@ -144,7 +255,7 @@ namespace KlayGE
 
 	PerfRangePtr PerfProfiler::CreatePerfRange(int category, std::string const & name)
 	{
-		PerfRangePtr range = MakeSharedPtr<PerfRange>();
+		PerfRangePtr range = MakeSharedPtr<PerfRange>(name);
 		typedef std::remove_reference<decltype(std::get<3>(perf_ranges_[0]))>::type PerfDataType;
 		perf_ranges_.push_back(std::make_tuple(category, name, range, PerfDataType()));
 		return range;
@@ -168,10 +279,87 @@ namespace KlayGE
 				}
 			}
 
+			this->AddEvent(nullptr, this->Now(), frame_id_);
+
 			++ frame_id_;
 		}
 	}
 
+	uint64_t PerfProfiler::Now() const
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time_).count();
+	}
+
+	void PerfProfiler::AddZone(char const * name, uint64_t begin, uint64_t end)
+	{
+		BOOST_ASSERT(name != nullptr);
+		this->AddEvent(name, begin, end);
+	}
+
+	void PerfProfiler::AddEvent(char const * name, uint64_t begin, uint64_t end)
+	{
+		ThreadEvents& thread_events = this->CurrentThreadEvents();
+
+		PerfEventChunk* chunk = thread_events.tail;
+		uint32_t const index = chunk->num_events.load(std::memory_order_relaxed);
+		if (index == PerfEventChunk::CAPACITY)
+		{
+			PerfEventChunk* new_chunk;
+			if (thread_events.chunks.size() < PerfEventChunk::MAX_CHUNKS)
+			{
+				thread_events.chunks.push_back(MakeUniquePtr<PerfEventChunk>());
+				new_chunk = thread_events.chunks.back().get();
+			}
+			else
+			{
+				std::lock_guard<std::mutex> lock(threads_mutex_);
+				new_chunk = thread_events.head;
+				thread_events.head = new_chunk->next.load(std::memory_order_relaxed);
+				new_chunk->next.store(nullptr, std::memory_order_relaxed);
+				new_chunk->num_events.store(0, std::memory_order_relaxed);
+			}
+			new_chunk->events[0] = { name, begin, end };
+			new_chunk->num_events.store(1, std::memory_order_release);
+			chunk->next.store(new_chunk, std::memory_order_release);
+			thread_events.tail = new_chunk;
+		}
+		else
+		{
+			chunk->events[index] = { name, begin, end };
+			chunk->num_events.store(index + 1, std::memory_order_release);
+		}
+	}
+
+	void PerfProfiler::SetThreadName(std::string const & name)
+	{
+		if (Context::Instance().Config().perf_profiler)
+		{
+			ThreadEvents& thread_events = this->CurrentThreadEvents();
+
+			std::lock_guard<std::mutex> lock(threads_mutex_);
+			thread_events.name = name;
+		}
+	}
+
+	PerfProfiler::ThreadEvents& PerfProfiler::CurrentThreadEvents()
+	{
+		if (tls_profiler_id != profiler_id_)
+		{
+			auto thread_events = MakeUniquePtr<ThreadEvents>();
+			thread_events->chunks.push_back(MakeUniquePtr<PerfEventChunk>());
+			thread_events->head = thread_events->chunks.back().get();
+			thread_events->tail = thread_events->head;
+
+			std::lock_guard<std::mutex> lock(threads_mutex_);
+			thread_events->tid = static_cast<uint32_t>(threads_.size());
+			thread_events->name = "Thread " + std::to_string(thread_events->tid);
+			tls_thread_events = thread_events.get();
+			tls_profiler_id = profiler_id_;
+			threads_.push_back(std::move(thread_events));
+		}
+		return *static_cast<ThreadEvents*>(tls_thread_events);
+	}
+
 	void PerfProfiler::ExportToCSV(std::string const & file_name) const
 	{
 		if (Context::Instance().Config().perf_profiler)
@@ -197,4 +385,58 @@ namespace KlayGE
 			ofs << std::endl;
 		}
 	}
+
+	void PerfProfiler::ExportToChromeTrace(std::string const & file_name) const
+	{
+		if (Context::Instance().Config().perf_profiler)
+		{
+			std::ofstream ofs(file_name.c_str());
+			ofs << std::fixed << std::setprecision(3);
+			ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+			bool first = true;
+			auto begin_event = [&ofs, &first](char const * ph, uint32_t tid)
+			{
+				ofs << (first ? "\n" : ",\n");
+				first = false;
+				ofs << "{\"ph\":\"" << ph << "\",\"pid\":0,\"tid\":" << tid << ",";
+			};
+
+			std::lock_guard<std::mutex> lock(threads_mutex_);
+			for (auto const & thread_events : threads_)
+			{
+				uint32_t const tid = thread_events->tid;
+
+				begin_event("M", tid);
+				ofs << "\"name\":\"thread_name\",\"args\":{\"name\":";
+				WriteJSONString(ofs, thread_events->name);
+				ofs << "}}";
+
+				// Timestamps in the trace are in microseconds
+				for (PerfEventChunk const * chunk = thread_events->head; chunk != nullptr;
+					chunk = chunk->next.load(std::memory_order_acquire))
+				{
+					uint32_t const num_events = chunk->num_events.load(std::memory_order_acquire);
+					for (uint32_t i = 0; i < num_events; ++ i)
+					{
+						PerfEvent const & event = chunk->events[i];
+						if (event.name != nullptr)
+						{
+							begin_event("X", tid);
+							ofs << "\"name\":";
+							WriteJSONString(ofs, event.name);
+							ofs << ",\"ts\":" << event.begin / 1000.0 << ",\"dur\":" << (event.end - event.begin) / 1000.0 << "}";
+						}
+						else
+						{
+							begin_event("i", tid);
+							ofs << "\"name\":\"Frame " << event.end << "\",\"s\":\"g\",\"ts\":" << event.begin / 1000.0 << "}";
+						}
+					}
+				}
+			}
+
+			ofs << "\n]}" << std::endl;
+		}
+	}
 }
@@ -29,9 +29,14 @@
  */
 
 #include <KlayGE/KlayGE.hpp>
+#include <KFL/CpuInfo.hpp>
+#include <KFL/CustomizedStreamBuf.hpp>
 #include <KFL/Hash.hpp>
+#include <KFL/MappedFile.hpp>
 #include <KFL/Util.hpp>
+#include <KFL/XMLDom.hpp>
 #include <KlayGE/Package.hpp>
+#include <KlayGE/PerfProfiler.hpp>
 #include <KFL/CXX17/filesystem.hpp>
 
 #if defined KLAYGE_PLATFORM_LINUX
@@ -61,7 +66,6 @@
 #elif defined KLAYGE_PLATFORM_ANDROID
 #include <android_native_app_glue.h>
 #include <android/asset_manager.h>
-#include <KFL/CustomizedStreamBuf.hpp>
 #elif defined KLAYGE_PLATFORM_DARWIN
 #include <mach-o/dyld.h>
 #elif defined KLAYGE_PLATFORM_IOS
@@ -74,6 +78,46 @@ namespace
 {
 	std::mutex singleton_mutex;
 
+#if KLAYGE_IS_DEV_PLATFORM
+	// Compiled forms that are rebuilt in place when they get stale. A mapped file can't be replaced on Windows,
+	//  even by a rename, so these are read through streams.
+	bool IsRebuiltInPlace(std::string_view res_name)
+	{
+		for (std::string_view const ext : { std::string_view(".kxml"), std::string_view(".kfx"), std::string_view(".model_bin") })
+		{
+			if ((res_name.size() >= ext.size()) && (res_name.substr(res_name.size() - ext.size()) == ext))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+#endif
+
+	// Loose files are memory mapped, so that loaders can consume them in place with ResIdentifier::ReadView.
+	//  Falls back to a file stream if the file can't be mapped.
+	KlayGE::ResIdentifierPtr OpenLooseFile(std::string_view name, std::string const & res_name, uint64_t timestamp)
+	{
+		using namespace KlayGE;
+
+		auto file = MakeSharedPtr<MappedFile>();
+#if KLAYGE_IS_DEV_PLATFORM
+		if (!IsRebuiltInPlace(res_name) && file->Open(res_name))
+#else
+		if (file->Open(res_name))
+#endif
+		{
+			auto buf = MakeSharedPtr<SharedMemInputStreamBuf>(file->Data(), static_cast<std::streamsize>(file->Size()), file);
+			return MakeSharedPtr<ResIdentifier>(name, timestamp, MakeSharedPtr<std::istream>(buf.get()), buf);
+		}
+		else
+		{
+			// The static_cast is a workaround for a bug in clang/c2
+			return MakeSharedPtr<ResIdentifier>(name, timestamp,
+				MakeSharedPtr<std::ifstream>(res_name.c_str(), static_cast<std::ios_base::openmode>(std::ios_base::binary)));
+		}
+	}
+
 #ifdef KLAYGE_PLATFORM_ANDROID
 	class AAssetStreamBuf : public KlayGE::MemInputStreamBuf
 	{
@@ -101,7 +145,7 @@ namespace KlayGE
 	std::unique_ptr<ResLoader> ResLoader::res_loader_instance_;
 
 	ResLoader::ResLoader()
-		: quit_(false)
+		: num_loaded_res_after_sweep_(0), num_loading_threads_(0), loading_generation_(0)
 	{
 #if defined KLAYGE_PLATFORM_WINDOWS
 #if defined KLAYGE_PLATFORM_WINDOWS_DESKTOP
@@ -228,15 +272,11 @@ namespace KlayGE
 		this->AddPath("../../media/PostProcessors");
 #endif
 #endif
-
-		loading_thread_ = MakeUniquePtr<joiner<void>>(Context::Instance().ThreadPool()(
-			[this] { this->LoadingThreadFunc(); }));
 	}
 
 	ResLoader::~ResLoader()
 	{
-		quit_ = true;
-		(*loading_thread_)();
+		this->StopLoadingThreads();
 	}
 
 	ResLoader& ResLoader::Instance()
@@ -512,10 +552,7 @@ namespace KlayGE
 #else
 						uint64_t timestamp = std::filesystem::last_write_time(package_path);
 #endif
-						// The static_cast is a workaround for a bug in clang/c2
-						auto package_res = MakeSharedPtr<ResIdentifier>(package_path, timestamp,
-							MakeSharedPtr<std::ifstream>(package_path.c_str(),
-								static_cast<std::ios_base::openmode>(std::ios_base::binary)));
+						auto package_res = OpenLooseFile(package_path, package_path, timestamp);
 
 						package = MakeSharedPtr<Package>(package_res, password);
 					}
@@ -649,8 +686,7 @@ namespace KlayGE
 			uint64_t timestamp = std::filesystem::last_write_time(res_path);
 #endif
 
-			return MakeSharedPtr<ResIdentifier>(name, timestamp,
-				MakeSharedPtr<std::ifstream>(res_name.c_str(), std::ios_base::binary));
+			return OpenLooseFile(name, res_name, timestamp);
 		}
 #else
 		{
@@ -677,9 +713,7 @@ namespace KlayGE
 #else
 						uint64_t timestamp = std::filesystem::last_write_time(res_path);
 #endif
-						// The static_cast is a workaround for a bug in clang/c2
-						return MakeSharedPtr<ResIdentifier>(name, timestamp,
-							MakeSharedPtr<std::ifstream>(res_name.c_str(), static_cast<std::ios_base::openmode>(std::ios_base::binary)));
+						return OpenLooseFile(name, res_name, timestamp);
 					}
 					else
 					{
@@ -717,6 +751,91 @@ namespace KlayGE
 		return ResIdentifierPtr();
 	}
 
+	ResIdentifierPtr ResLoader::OpenXML(std::string_view name)
+	{
+		std::string const compiled_name = std::string(name) + ".kxml";
+		uint64_t const xml_timestamp = this->Timestamp(name);
+		auto open_up_to_date = [this, &compiled_name, xml_timestamp]
+		{
+			ResIdentifierPtr compiled = this->Open(compiled_name);
+			if (!compiled || !XMLDocument::IsCompiled(compiled) || (compiled->Timestamp() < xml_timestamp))
+			{
+				// A stale one could still map the file, and a mapped file can't be replaced on Windows
+				compiled.reset();
+			}
+			return compiled;
+		};
+
+		ResIdentifierPtr compiled = open_up_to_date();
+		if (compiled)
+		{
+			return compiled;
+		}
+
+		// Loading threads may ask for the same stale asset at the same time. Only one of them rebuilds it, and the
+		//  others check again once it's done.
+		std::lock_guard<std::mutex> lock(xml_jit_mutex_);
+		compiled = open_up_to_date();
+		if (compiled)
+		{
+			return compiled;
+		}
+
+		ResIdentifierPtr source = this->Open(name);
+#if KLAYGE_IS_DEV_PLATFORM
+		if (source)
+		{
+			// Only loose files get a compiled form here, a package is read-only
+			std::string const xml_path = this->Locate(name);
+			std::filesystem::path const compiled_path(xml_path + ".kxml");
+			std::filesystem::path const tmp_path(xml_path + ".kxml.tmp");
+#if defined(KLAYGE_CXX17_LIBRARY_FILESYSTEM_SUPPORT) || defined(KLAYGE_TS_LIBRARY_FILESYSTEM_SUPPORT)
+			std::error_code ec;
+			if (std::filesystem::exists(std::filesystem::path(xml_path), ec))
+#else
+			boost::system::error_code ec;
+			if (std::filesystem::exists(std::filesystem::path(xml_path)))
+#endif
+			{
+				XMLDocument doc;
+				doc.Parse(source);
+
+				// Written aside and renamed into place, so a reader never opens a partly written compiled form
+				bool written;
+				{
+					std::ofstream ofs(tmp_path.string().c_str(), std::ios_base::binary | std::ios_base::out);
+					if (ofs)
+					{
+						doc.Compile(ofs);
+					}
+					ofs.close();
+					written = !ofs.fail();
+				}
+				if (written)
+				{
+					std::filesystem::rename(tmp_path, compiled_path, ec);
+					written = !ec;
+				}
+				if (!written)
+				{
+					std::filesystem::remove(tmp_path, ec);
+					LogWarn() << "Could NOT write " << compiled_path.string() << '.' << std::endl;
+				}
+
+				source->clear();
+				source->seekg(0, std::ios_base::beg);
+			}
+		}
+#else
+		if (source)
+		{
+			LogWarn() << "Could NOT locate " << compiled_name << ", falling back to the XML." << std::endl;
+		}
+#endif
+
+		return source;
+	}
+
 	uint64_t ResLoader::Timestamp(std::string_view name)
 	{
 		uint64_t timestamp = 0;
@@ -761,8 +880,10 @@ namespace KlayGE
 			{
 				std::lock_guard<std::mutex> lock(loading_mutex_);
 
-				for (auto const & lrq : loading_res_)
+				auto const range = loading_res_.equal_range(res_desc->Hash());
+				for (auto iter = range.first; iter != range.second; ++ iter)
 				{
+					auto const & lrq = iter->second;
 					if (lrq.first->Match(*res_desc))
 					{
 						res_desc->CopyDataFrom(*lrq.first);
@@ -796,7 +917,7 @@ namespace KlayGE
 		return res;
 	}
 
-	std::shared_ptr<void> ResLoader::ASyncQuery(ResLoadingDescPtr const & res_desc)
+	std::shared_ptr<void> ResLoader::ASyncQuery(ResLoadingDescPtr const & res_desc, LoadingPriority priority)
 	{
 		this->RemoveUnrefResources();
 
@@ -824,8 +945,10 @@ namespace KlayGE
 			{
 				std::lock_guard<std::mutex> lock(loading_mutex_);
 
-				for (auto const & lrq : loading_res_)
+				auto const range = loading_res_.equal_range(res_desc->Hash());
+				for (auto iter = range.first; iter != range.second; ++ iter)
 				{
+					auto const & lrq = iter->second;
 					if (lrq.first->Match(*res_desc))
 					{
 						res_desc->CopyDataFrom(*lrq.first);
@@ -837,15 +960,9 @@ namespace KlayGE
 				}
 			}
 
-			if (found)
-			{
-				if (!res_desc->StateLess())
-				{
-					std::lock_guard<std::mutex> lock(loading_mutex_);
-					loading_res_.emplace_back(res_desc, async_is_done);
-				}
-			}
-			else
+			// If found, the request in flight shares its status with this one. Its main thread stage in Update covers
+			//  both, so there is nothing to queue.
+			if (!found)
 			{
 				if (res_desc->HasSubThreadStage())
 				{
@@ -855,9 +972,17 @@ namespace KlayGE
 
 					{
 						std::lock_guard<std::mutex> lock(loading_mutex_);
-						loading_res_.emplace_back(res_desc, async_is_done);
+						loading_res_.emplace(res_desc->Hash(), std::make_pair(res_desc, async_is_done));
 					}
-					loading_res_queue_.push(std::make_pair(res_desc, async_is_done));
+					{
+						std::lock_guard<std::mutex> lock(loading_queue_mutex_);
+						if (loading_threads_.empty())
+						{
+							this->StartLoadingThreads();
+						}
+						loading_res_queues_[priority].emplace_back(res_desc, async_is_done);
+					}
+					loading_queue_cond_.notify_one();
 				}
 				else
 				{
@@ -876,7 +1001,7 @@ namespace KlayGE
 
 		for (auto iter = loaded_res_.begin(); iter != loaded_res_.end(); ++ iter)
 		{
-			if (res == iter->second.lock())
+			if (res == iter->second.second.lock())
 			{
 				loaded_res_.erase(iter);
 				break;
@@ -888,9 +1013,12 @@ namespace KlayGE
 	{
 		std::lock_guard<std::mutex> lock(loaded_mutex_);
 
+		size_t const hash = res_desc->Hash();
 		bool found = false;
-		for (auto& c_desc : loaded_res_)
+		auto const range = loaded_res_.equal_range(hash);
+		for (auto iter = range.first; iter != range.second; ++ iter)
 		{
+			auto& c_desc = iter->second;
 			if (c_desc.first == res_desc)
 			{
 				c_desc.second = std::weak_ptr<void>(res);
@@ -900,7 +1028,7 @@ namespace KlayGE
 		}
 		if (!found)
 		{
-			loaded_res_.emplace_back(res_desc, std::weak_ptr<void>(res));
+			loaded_res_.emplace(hash, std::make_pair(res_desc, std::weak_ptr<void>(res)));
 		}
 	}
 
@@ -909,32 +1037,55 @@ namespace KlayGE
 		std::lock_guard<std::mutex> lock(loaded_mutex_);
 
 		std::shared_ptr<void> loaded_res;
-		for (auto const & lr : loaded_res_)
+		auto const range = loaded_res_.equal_range(res_desc->Hash());
+		for (auto iter = range.first; iter != range.second;)
 		{
+			auto const & lr = iter->second;
 			if (lr.first->Match(*res_desc))
 			{
 				loaded_res = lr.second.lock();
-				break;
+				if (loaded_res)
+				{
+					break;
+				}
+				else
+				{
+					// Drop dead entries of this bucket while we are here
+					iter = loaded_res_.erase(iter);
+				}
+			}
+			else
+			{
+				++ iter;
 			}
 		}
 		return loaded_res;
 	}
 
+	// Dead entries are dropped lazily by FindMatchLoadedResource. A full sweep only happens when the cache has doubled
+	//  since the last one, so the cost is amortized over the insertions instead of paid on every query.
 	void ResLoader::RemoveUnrefResources()
 	{
 		std::lock_guard<std::mutex> lock(loaded_mutex_);
 
+		if (loaded_res_.size() < std::max(num_loaded_res_after_sweep_ * 2, static_cast<size_t>(256)))
+		{
+			return;
+		}
+
 		for (auto iter = loaded_res_.begin(); iter != loaded_res_.end();)
 		{
-			if (iter->second.lock())
+			if (iter->second.second.expired())
 			{
-				++ iter;
+				iter = loaded_res_.erase(iter);
 			}
 			else
 			{
-				iter = loaded_res_.erase(iter);
+				++ iter;
 			}
 		}
+
+		num_loaded_res_after_sweep_ = loaded_res_.size();
 	}
 
 	void ResLoader::Update()
@@ -942,7 +1093,13 @@ namespace KlayGE
 		std::vector<std::pair<ResLoadingDescPtr, std::shared_ptr<volatile LoadingStatus>>> tmp_loading_res;
 		{
 			std::lock_guard<std::mutex> lock(loading_mutex_);
-			tmp_loading_res = loading_res_;
+			for (auto const & lrq : loading_res_)
+			{
+				if (LS_Complete == *lrq.second.second)
+				{
+					tmp_loading_res.push_back(lrq.second);
+				}
+			}
 		}
 
 		for (auto& lrq : tmp_loading_res)
@@ -979,7 +1136,7 @@ namespace KlayGE
 			std::lock_guard<std::mutex> lock(loading_mutex_);
 			for (auto iter = loading_res_.begin(); iter != loading_res_.end();)
 			{
-				if (LS_CanBeRemoved == *(iter->second))
+				if (LS_CanBeRemoved == *(iter->second.second))
 				{
 					iter = loading_res_.erase(iter);
 				}
@@ -991,21 +1148,102 @@ namespace KlayGE
 		}
 	}
 
-	void ResLoader::LoadingThreadFunc()
+	void ResLoader::NumLoadingThreads(uint32_t num)
 	{
-		while (!quit_)
+		bool running;
+		{
+			std::lock_guard<std::mutex> lock(loading_queue_mutex_);
+			running = !loading_threads_.empty();
+		}
+		this->StopLoadingThreads();
+
+		std::lock_guard<std::mutex> lock(loading_queue_mutex_);
+		num_loading_threads_ = num;
+		if (running && loading_threads_.empty())
+		{
+			this->StartLoadingThreads();
+		}
+	}
+
+	// Called with loading_queue_mutex_ locked
+	void ResLoader::StartLoadingThreads()
+	{
+		uint32_t num_threads = num_loading_threads_;
+		if (0 == num_threads)
+		{
+			CPUInfo cpu;
+			num_threads = MathLib::clamp(cpu.NumCores() / 2, 1, 4);
+		}
+
+		uint32_t const generation = loading_generation_;
+		for (uint32_t i = 0; i < num_threads; ++ i)
+		{
+			loading_threads_.push_back(MakeUniquePtr<joiner<void>>(Context::Instance().ThreadPool()(
+				[this, generation] { this->LoadingThreadFunc(generation); })));
+		}
+	}
+
+	void ResLoader::StopLoadingThreads()
+	{
+		// The threads are joined outside of the lock they need to quit. A request coming in meanwhile may start
+		//  new ones, in a new generation, without keeping these alive.
+		std::vector<std::unique_ptr<joiner<void>>> threads;
+		{
+			std::lock_guard<std::mutex> lock(loading_queue_mutex_);
+			++ loading_generation_;
+			threads.swap(loading_threads_);
+		}
+		loading_queue_cond_.notify_all();
+
+		for (auto& thread : threads)
+		{
+			(*thread)();
+		}
+	}
+
+	void ResLoader::LoadingThreadFunc(uint32_t generation)
+	{
+#ifndef KLAYGE_SHIP
+		PerfProfiler::Instance().SetThreadName("Resource loading");
+#endif
+
+		for (;;)
 		{
 			std::pair<ResLoadingDescPtr, std::shared_ptr<volatile LoadingStatus>> res_pair;
-			while (loading_res_queue_.pop(res_pair))
 			{
-				if (LS_Loading == *res_pair.second)
+				std::unique_lock<std::mutex> lock(loading_queue_mutex_);
+				loading_queue_cond_.wait(lock, [this, generation]
+					{
+						return (generation != loading_generation_) || std::any_of(loading_res_queues_.begin(), loading_res_queues_.end(),
+							[](std::deque<std::pair<ResLoadingDescPtr, std::shared_ptr<volatile LoadingStatus>>> const & queue)
+							{
+								return !queue.empty();
+							});
+					});
+				if (generation != loading_generation_)
+				{
+					break;
+				}
+
+				for (auto& queue : loading_res_queues_)
 				{
-					res_pair.first->SubThreadStage();
-					*res_pair.second = LS_Complete;
+					if (!queue.empty())
+					{
+						res_pair = std::move(queue.front());
+						queue.pop_front();
+						break;
+					}
 				}
 			}
 
-			Sleep(10);
+			if (LS_Loading == *res_pair.second)
+			{
+#ifndef KLAYGE_SHIP
+				PerfZone zone("ResLoadingDesc::SubThreadStage");
+#endif
+				res_pair.first->SubThreadStage();
+				*res_pair.second = LS_Complete;
+			}
 		}
 	}
 
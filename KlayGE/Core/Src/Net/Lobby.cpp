@@ -14,6 +14,7 @@
 #include <KlayGE/Player.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <ctime>
 #include <cstring>
 
@@ -22,12 +23,32 @@
 
 #ifndef KLAYGE_PLATFORM_WINDOWS_STORE
 
+namespace
+{
+	using namespace KlayGE;
+
+	int const RECEIVE_BATCH = 64;
+	int const REPLY_BATCH = 64;
+	// Acks and retransmits are flushed at least this often
+	int const CHANNEL_TICK_MS = 10;
+	uint32_t const PLAYER_TIME_OUT = 20;
+
+	uint64_t AddrKey(sockaddr_in const & addr)
+	{
+		return (static_cast<uint64_t>(addr.sin_addr.s_addr) << 16) | addr.sin_port;
+	}
+}
+
 namespace KlayGE
 {
 	// 캯
 	/////////////////////////////////////////////////////////////////////////////////
 	Lobby::Lobby()
+		: running_(false),
+			reply_bufs_(REPLY_BATCH)
 	{
+		replies_.reserve(REPLY_BATCH);
+
 		this->socket_.Create(SOCK_DGRAM);
 	}
 
@@ -40,12 +61,20 @@ namespace KlayGE
 
 	Lobby::PlayerAddrsIter Lobby::ID(sockaddr_in const & addr)
 	{
-		for (auto iter = players_.begin(); iter != players_.end(); ++ iter)
+		auto iter = player_indices_.find(AddrKey(addr));
+		if (iter != player_indices_.end())
 		{
-			if (0 == std::memcmp(&addr, &(iter->second.addr), sizeof(addr)))
-			{
-				return iter;
-			}
+			return players_.begin() + iter->second;
+		}
+
+		return players_.end();
+	}
+
+	Lobby::PlayerAddrsIter Lobby::ID(uint32_t id)
+	{
+		if ((id != 0) && (id <= players_.size()) && (players_[id - 1].first == id))
+		{
+			return players_.begin() + (id - 1);
 		}
 
 		return players_.end();
@@ -53,95 +82,171 @@ namespace KlayGE
 
 	// Ϸ
 	/////////////////////////////////////////////////////////////////////////////////
-	void Lobby::Create(std::string const & Name, char maxPlayers, uint16_t port, Processor const & pro)
+	void Lobby::Create(std::string const & Name, uint16_t maxPlayers, uint16_t port, Processor const & pro)
+	{
+		this->Create(Name, maxPlayers, port);
+		this->Run(pro);
+	}
+
+	void Lobby::Create(std::string const & Name, uint16_t maxPlayers, uint16_t port)
 	{
+		if (INVALID_SOCKET == this->socket_.Handle())
+		{
+			this->socket_.Create(SOCK_DGRAM);
+		}
+
 		this->LobbyName(Name);
 
 		this->MaxPlayers(maxPlayers);
 
-		this->socket_.Bind(TransAddr("", port));
+		// Room for the bursts of thousands of players between two polls
+		int const rcv_buf_size = 1024 * 1024;
+		this->socket_.SetSockOpt(SO_RCVBUF, &rcv_buf_size, sizeof(rcv_buf_size));
 
-		sockaddr_in from;
-		char revBuf[Max_Buffer];
-		char sendBuf[Max_Buffer];
-		int numSend = 0;
-		for (;;)
-		{
-			this->Receive(revBuf, sizeof(revBuf), from);
+		this->socket_.Bind(TransAddr("", port));
 
-			// ÿϢǰ涼1ֽڵϢ
-			char* revPtr(&revBuf[1]);
-			char* sendPtr(&sendBuf[1]);
-			sendBuf[0] = revBuf[0];
+		socklen_t len = sizeof(sockAddr_);
+		this->socket_.SockName(sockAddr_, len);
 
-			switch (revBuf[0])
-			{
-			case MSG_JOIN:
-				this->OnJoin(revPtr, sendPtr, numSend, from, pro);
-				break;
+		// Set here instead of in Run, so a Close() racing with the start of Run() isn't lost
+		running_ = true;
+	}
 
-			case MSG_QUIT:
-				this->OnQuit(this->ID(from), sendPtr, numSend, pro);
-				break;
+	// A reactor on a non-blocking socket. Wakes up when datagrams arrive, drains them in batches, and batches the
+	//  replies. Everything queued to a player's channel during a batch is coalesced into as few packets as possible.
+	//  Retransmits and time outs are driven by timers instead of by incoming traffic.
+	void Lobby::Run(Processor const & pro)
+	{
+		this->socket_.NonBlock(true);
 
-			case MSG_GETLOBBYINFO:
-				this->OnGetLobbyInfo(sendPtr, numSend, pro);
-				break;
+		SocketPoller poller;
+		poller.Add(this->socket_, SocketPoller::PE_Readable, nullptr);
 
-			case MSG_NOP:
-				this->OnNop(this->ID(from));
-				break;
+		std::vector<std::array<char, NET_MTU>> rev_bufs(RECEIVE_BATCH);
+		std::vector<Socket::Datagram> rev_datagrams(RECEIVE_BATCH);
 
-			default:
-				pro.OnDefault(revBuf, sizeof(revBuf), sendBuf, numSend, from);
-				break;
-			}
+		auto last_time_out_check = std::chrono::steady_clock::now();
 
-			if (numSend != 0)
-			{
-				this->Send(sendBuf, numSend + 1, from);
-			}
-
-			// Ϣ
-			for (auto const & player : players_)
+		while (running_)
+		{
+			SocketPoller::Event event;
+			if (poller.Wait(&event, 1, CHANNEL_TICK_MS) > 0)
 			{
-				auto const & msgs = player.second.msgs;
-				for (auto const & msg : msgs)
+				for (;;)
 				{
-					socket_.SendTo(&msg[0], static_cast<int>(msg.size()), player.second.addr);
+					for (int i = 0; i < RECEIVE_BATCH; ++ i)
+					{
+						rev_datagrams[i].buf = rev_bufs[i].data();
+						rev_datagrams[i].len = NET_MTU;
+					}
+
+					int const num_received = this->socket_.ReceiveFromMany(rev_datagrams.data(), RECEIVE_BATCH);
+					if (num_received <= 0)
+					{
+						break;
+					}
+
+					for (int i = 0; i < num_received; ++ i)
+					{
+						if (rev_datagrams[i].len > 0)
+						{
+							this->Dispatch(static_cast<char const *>(rev_datagrams[i].buf), rev_datagrams[i].len,
+								rev_datagrams[i].addr, pro);
+						}
+					}
+
+					if (num_received < RECEIVE_BATCH)
+					{
+						break;
+					}
 				}
 			}
 
-			// Ƿûʱ
-			for (auto iter = players_.begin(); iter != players_.end();)
+			this->FlushChannels();
+			this->FlushReplies();
+
+			auto const now = std::chrono::steady_clock::now();
+			if (now - last_time_out_check >= std::chrono::seconds(1))
 			{
-				// 20
-				if (std::time(nullptr) - iter->second.time >= 20 * 1000)
-				{
-					iter = players_.erase(iter);
-				}
-				else
-				{
-					++ iter;
-				}
+				this->CheckTimeOut(pro);
+				last_time_out_check = now;
 			}
 		}
+
+		poller.Remove(this->socket_);
+		this->socket_.Close();
 	}
 
-	// 
-	/////////////////////////////////////////////////////////////////////////////////
-	char Lobby::NumPlayer() const
+	void Lobby::Dispatch(char const * msg, int size, sockaddr_in const & from, Processor const & pro)
 	{
-		char n = 0;
-		for (auto const & player : players_)
+		auto iter = this->ID(from);
+		if (iter != players_.end())
 		{
-			if (player.first != 0)
+			iter->second.time = static_cast<uint32_t>(std::time(nullptr));
+		}
+
+		// ÿϢǰ涼1ֽڵϢ
+		switch (msg[0])
+		{
+		case MSG_JOIN:
+			this->OnJoin(&msg[1], size - 1, from, pro);
+			break;
+
+		case MSG_QUIT:
+			this->OnQuit(iter, from, pro);
+			break;
+
+		case MSG_GETLOBBYINFO:
+			this->OnGetLobbyInfo(from);
+			break;
+
+		case MSG_NOP:
+			this->OnNop(iter);
+			break;
+
+		case MSG_PACKET:
+			this->OnPacket(iter, msg, size, from, pro);
+			break;
+
+		default:
+			this->OnDefault(msg, size, from, pro, nullptr);
+			break;
+		}
+	}
+
+	void Lobby::OnDefault(char const * msg, int size, sockaddr_in const & from, Processor const & pro,
+		NetChannel* channel)
+	{
+		if ((size <= 0) || (size > static_cast<int>(Max_Buffer)))
+		{
+			return;
+		}
+
+		char rev_buf[Max_Buffer];
+		char send_buf[Max_Buffer];
+		std::memcpy(rev_buf, msg, size);
+		send_buf[0] = msg[0];
+		int num_send = 0;
+		sockaddr_in from_addr = from;
+		pro.OnDefault(rev_buf, size, send_buf, num_send, from_addr);
+		if (num_send != 0)
+		{
+			if (channel != nullptr)
+			{
+				channel->SendUnreliable(send_buf, num_send + 1);
+			}
+			else
 			{
-				++ n;
+				this->Reply(send_buf, num_send + 1, from);
 			}
 		}
+	}
 
-		return n;
+	// ȡ
+	/////////////////////////////////////////////////////////////////////////////////
+	uint16_t Lobby::NumPlayer() const
+	{
+		return static_cast<uint16_t>(player_indices_.size());
 	}
 
 	// ô
@@ -167,10 +272,10 @@ namespace KlayGE
 
 	// 
 	/////////////////////////////////////////////////////////////////////////////////
-	void Lobby::MaxPlayers(char maxPlayers)
+	void Lobby::MaxPlayers(uint16_t maxPlayers)
 	{
-		players_.resize(maxPlayers);
-		PlayerAddrs(players_).swap(players_);
+		PlayerAddrs(maxPlayers).swap(players_);
+		player_indices_.clear();
 
 		for (auto& player : players_)
 		{
@@ -180,105 +285,139 @@ namespace KlayGE
 
 	// ȡ
 	/////////////////////////////////////////////////////////////////////////////////
-	char Lobby::MaxPlayers() const
+	uint16_t Lobby::MaxPlayers() const
 	{
-		return static_cast<char>(this->players_.size());
+		return static_cast<uint16_t>(this->players_.size());
 	}
 
 	// رϷ
 	/////////////////////////////////////////////////////////////////////////////////
 	void Lobby::Close()
 	{
-		this->socket_.Close();
+		// A running lobby closes its socket when Run returns
+		if (!running_.exchange(false))
+		{
+			this->socket_.Close();
+		}
 	}
 
-	// 
+	// 
 	/////////////////////////////////////////////////////////////////////////////////
 	int Lobby::Receive(void* buf, int maxSize, sockaddr_in& from)
 	{
 		return this->socket_.ReceiveFrom(buf, maxSize, from);
 	}
 
-	// 
+	// 
 	/////////////////////////////////////////////////////////////////////////////////
 	int Lobby::Send(void const * buf, int maxSize, sockaddr_in const & to)
 	{
 		return this->socket_.SendTo(buf, maxSize, to);
 	}
 
+	bool Lobby::SendReliable(uint32_t id, void const * buf, int size)
+	{
+		auto iter = this->ID(id);
+		return (iter != players_.end()) && (size >= 0) && iter->second.channel.SendReliable(buf, size);
+	}
+
+	bool Lobby::SendUnreliable(uint32_t id, void const * buf, int size)
+	{
+		auto iter = this->ID(id);
+		return (iter != players_.end()) && (size >= 0) && iter->second.channel.SendUnreliable(buf, size);
+	}
+
+	bool Lobby::SendState(uint32_t id, uint32_t slot, void const * buf, int size)
+	{
+		auto iter = this->ID(id);
+		return (iter != players_.end()) && (size >= 0) && iter->second.channel.SendState(slot, buf, size);
+	}
+
 
-	void Lobby::OnJoin(char* revBuf, char* sendBuf, int& numSend,
-							sockaddr_in& from, Processor const & pro)
+	void Lobby::OnJoin(char const * revBuf, int size, sockaddr_in const & from, Processor const & pro)
 	{
 		// ʽ:
 		//			Player		16 ֽ
 
-		char id = 1;
-		auto iter = players_.begin();
-		for (; iter != this->players_.end(); ++ iter, ++ id)
+		// A resent join gets the same ID
+		auto iter = this->ID(from);
+		if (iter == players_.end())
 		{
-			if (0 == iter->first)
+			uint32_t id = 1;
+			for (iter = players_.begin(); iter != players_.end(); ++ iter, ++ id)
 			{
-				size_t i(0);
-				while (revBuf[i] != 0)
+				if (0 == iter->first)
 				{
-					++ i;
+					int i = 0;
+					while ((i < size) && (i < 16) && (revBuf[i] != 0))
+					{
+						++ i;
+					}
+
+					iter->first = id;
+					iter->second.name = std::string(revBuf, i);
+					iter->second.addr = from;
+					iter->second.time = static_cast<uint32_t>(std::time(nullptr));
+					iter->second.channel.Reset();
+					player_indices_.emplace(AddrKey(from), static_cast<uint32_t>(iter - players_.begin()));
+
+					pro.OnJoin(iter->first);
+					break;
 				}
-				std::string name(&revBuf[0], i);
-				iter->first			= id;
-				iter->second.name	= name;
-				iter->second.addr	= from;
-
-				pro.OnJoin(iter->first);
-				break;
 			}
 		}
 
 		// ظʽ:
-		//			Player ID		1 ֽ
+		//			Player ID		2 ֽ
 
+		char sendBuf[3];
+		sendBuf[0] = MSG_JOIN;
 		// Ѿ
-		if (iter == players_.end())
-		{
-			sendBuf[0] = 1;
-		}
-		else
+		uint16_t id = 0;
+		if (iter != players_.end())
 		{
-			sendBuf[0] = 0;
+			id = static_cast<uint16_t>(iter->first);
 		}
+		id = Native2LE(id);
+		std::memcpy(&sendBuf[1], &id, sizeof(id));
 
-		numSend = 1;
+		this->Reply(sendBuf, sizeof(sendBuf), from);
 	}
 
-	void Lobby::OnQuit(PlayerAddrsIter iter, char* sendBuf,
-							int& numSend, Processor const & pro)
+	void Lobby::OnQuit(PlayerAddrsIter iter, sockaddr_in const & from, Processor const & pro)
 	{
+		char sendBuf[2];
+		sendBuf[0] = MSG_QUIT;
 		if (iter != this->players_.end())
 		{
-			pro.OnQuit(iter->first);
-			iter->first = 0;
-			sendBuf[0] = 0;
+			this->RemovePlayer(iter, pro);
+			sendBuf[1] = 0;
 		}
 		else
 		{
-			sendBuf[0] = 1;
+			sendBuf[1] = 1;
 		}
 
-		numSend = 1;
+		this->Reply(sendBuf, sizeof(sendBuf), from);
 	}
 
-	void Lobby::OnGetLobbyInfo(char* sendBuf, int& numSend, Processor const & /*pro*/)
+	void Lobby::OnGetLobbyInfo(sockaddr_in const & from)
 	{
 		// ظʽ:
-		//			ǰPlayers	1 ֽ
-		//			Players	1 ֽ
+		//			ǰPlayers	2 ֽ
+		//			Players	2 ֽ
 		//			Lobby		16 ֽ
 
-		memset(sendBuf, 0, 18);
-		sendBuf[0] = this->NumPlayer();
-		sendBuf[1] = this->MaxPlayers();
-		this->LobbyName().copy(&sendBuf[2], this->LobbyName().length());
-		numSend = 18;
+		char sendBuf[21];
+		std::memset(sendBuf, 0, sizeof(sendBuf));
+		sendBuf[0] = MSG_GETLOBBYINFO;
+		uint16_t const num_players = Native2LE(this->NumPlayer());
+		uint16_t const max_players = Native2LE(this->MaxPlayers());
+		std::memcpy(&sendBuf[1], &num_players, sizeof(num_players));
+		std::memcpy(&sendBuf[3], &max_players, sizeof(max_players));
+		this->LobbyName().copy(&sendBuf[5], this->LobbyName().length());
+
+		this->Reply(sendBuf, sizeof(sendBuf), from);
 	}
 
 	void Lobby::OnNop(PlayerAddrsIter iter)
@@ -288,6 +427,85 @@ namespace KlayGE
 			iter->second.time = static_cast<uint32_t>(std::time(nullptr));
 		}
 	}
+
+	void Lobby::OnPacket(PlayerAddrsIter iter, char const * revBuf, int size, sockaddr_in const & from,
+		Processor const & pro)
+	{
+		if (iter == this->players_.end())
+		{
+			return;
+		}
+
+		NetChannel& channel = iter->second.channel;
+		channel.OnPacket(revBuf, size, std::chrono::steady_clock::now(),
+			[this, &channel, &from, &pro](char const * msg, uint32_t msg_size)
+			{
+				this->OnDefault(msg, static_cast<int>(msg_size), from, pro, &channel);
+			});
+	}
+
+	void Lobby::RemovePlayer(PlayerAddrsIter iter, Processor const & pro)
+	{
+		pro.OnQuit(iter->first);
+		player_indices_.erase(AddrKey(iter->second.addr));
+		iter->first = 0;
+		iter->second.name.clear();
+		iter->second.channel.Reset();
+	}
+
+	void Lobby::CheckTimeOut(Processor const & pro)
+	{
+		// Ƿûʱ
+		uint32_t const now = static_cast<uint32_t>(std::time(nullptr));
+		for (auto iter = players_.begin(); iter != players_.end(); ++ iter)
+		{
+			// 20
+			if ((iter->first != 0) && (now - iter->second.time >= PLAYER_TIME_OUT))
+			{
+				this->RemovePlayer(iter, pro);
+			}
+		}
+	}
+
+	void Lobby::Reply(void const * buf, int size, sockaddr_in const & to)
+	{
+		BOOST_ASSERT(size <= static_cast<int>(NET_MTU));
+
+		if (replies_.size() == reply_bufs_.size())
+		{
+			this->FlushReplies();
+		}
+
+		char* reply_buf = reply_bufs_[replies_.size()].data();
+		std::memcpy(reply_buf, buf, size);
+		replies_.push_back({ reply_buf, size, to });
+	}
+
+	void Lobby::FlushReplies()
+	{
+		if (!replies_.empty())
+		{
+			// UDP semantic. What doesn't fit in the send buffer is dropped, the channels retransmit what matters.
+			this->socket_.SendToMany(replies_.data(), static_cast<int>(replies_.size()));
+			replies_.clear();
+		}
+	}
+
+	void Lobby::FlushChannels()
+	{
+		auto const now = std::chrono::steady_clock::now();
+		for (auto& player : players_)
+		{
+			if (player.first != 0)
+			{
+				sockaddr_in const & addr = player.second.addr;
+				player.second.channel.Flush(now, [this, &addr](char const * packet, uint32_t size)
+					{
+						this->Reply(packet, static_cast<int>(size), addr);
+					});
+			}
+		}
+	}
 }
 
 #endif
@@ -0,0 +1,718 @@
+/**
+ * @file NetChannel.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/Util.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <KlayGE/NetChannel.hpp>
+
+namespace
+{
+	using namespace KlayGE;
+
+	// Records in a packet, each starts with its kind
+	enum RecordKind
+	{
+		// [kind][size, 2 bytes][message]
+		RK_Unreliable,
+		// [kind][id, 2 bytes][size, 2 bytes][message]
+		RK_Reliable,
+		// [kind][slot][seq, 2 bytes][size, 2 bytes][message]
+		RK_State,
+		// [kind][slot][seq, 2 bytes][base seq, 2 bytes][size, 2 bytes][delta size, 2 bytes][delta]
+		RK_StateDelta
+	};
+
+	uint32_t const UNRELIABLE_RECORD_HEADER_SIZE = 3;
+	uint32_t const RELIABLE_RECORD_HEADER_SIZE = 5;
+	uint32_t const STATE_RECORD_HEADER_SIZE = 6;
+	uint32_t const STATE_DELTA_RECORD_HEADER_SIZE = 10;
+
+	uint32_t const ACK_BITS = 32;
+	// A lost ack costs a retransmit of everything in the packet it acks, a repeated ack only its header
+	uint32_t const ACK_REPEAT = 2;
+	uint32_t const MAX_UNRELIABLE_QUEUE = 64 * NET_MTU;
+
+	float const INITIAL_RTO_MS = 100;
+	float const MIN_RTO_MS = 30;
+	float const MAX_RTO_MS = 1000;
+	// Lower bound of the variance term. Leaves time for the ack in the next packet of the peer if one is lost.
+	float const RTO_GRANULARITY_MS = 20;
+	uint32_t const MAX_BACKOFF_SHIFT = 4;
+
+	void WriteU16(char* p, uint16_t v)
+	{
+		v = Native2LE(v);
+		std::memcpy(p, &v, sizeof(v));
+	}
+
+	void WriteU32(char* p, uint32_t v)
+	{
+		v = Native2LE(v);
+		std::memcpy(p, &v, sizeof(v));
+	}
+
+	uint16_t ReadU16(char const * p)
+	{
+		uint16_t v;
+		std::memcpy(&v, p, sizeof(v));
+		return LE2Native(v);
+	}
+
+	uint32_t ReadU32(char const * p)
+	{
+		uint32_t v;
+		std::memcpy(&v, p, sizeof(v));
+		return LE2Native(v);
+	}
+
+	// Sequence numbers wrap around, a is newer if it's less than half the range ahead of b
+	bool SeqNewer(uint16_t a, uint16_t b)
+	{
+		return static_cast<int16_t>(a - b) > 0;
+	}
+
+	// XOR against the base, as runs of [number of zero bytes][number of literal bytes][literal bytes]. The zeros
+	//  after the last literal are implied by the size of the value.
+	void EncodeDelta(std::vector<char>& delta, std::vector<char> const & value, std::vector<char> const & base)
+	{
+		auto diff = [&value, &base](size_t i)
+		{
+			return static_cast<char>(value[i] ^ ((i < base.size()) ? base[i] : 0));
+		};
+
+		delta.clear();
+		size_t i = 0;
+		while (i < value.size())
+		{
+			uint32_t num_zeros = 0;
+			while ((i < value.size()) && (num_zeros < 255) && (0 == diff(i)))
+			{
+				++ num_zeros;
+				++ i;
+			}
+			if (i == value.size())
+			{
+				break;
+			}
+
+			size_t const literal_start = i;
+			uint32_t num_literals = 0;
+			while ((i < value.size()) && (num_literals < 255) && (diff(i) != 0))
+			{
+				++ num_literals;
+				++ i;
+			}
+
+			delta.push_back(static_cast<char>(num_zeros));
+			delta.push_back(static_cast<char>(num_literals));
+			for (size_t j = literal_start; j < i; ++ j)
+			{
+				delta.push_back(diff(j));
+			}
+		}
+	}
+
+	bool DecodeDelta(std::vector<char>& value, uint32_t size, std::vector<char> const & base,
+		char const * delta, uint32_t delta_size)
+	{
+		value.assign(base.begin(), base.end());
+		value.resize(size, 0);
+
+		uint32_t pos = 0;
+		uint32_t i = 0;
+		while (i < delta_size)
+		{
+			if (i + 2 > delta_size)
+			{
+				return false;
+			}
+
+			uint32_t const num_zeros = static_cast<uint8_t>(delta[i]);
+			uint32_t const num_literals = static_cast<uint8_t>(delta[i + 1]);
+			i += 2;
+			pos += num_zeros;
+			if ((pos + num_literals > size) || (i + num_literals > delta_size))
+			{
+				return false;
+			}
+
+			for (uint32_t j = 0; j < num_literals; ++ j)
+			{
+				value[pos + j] ^= delta[i + j];
+			}
+			pos += num_literals;
+			i += num_literals;
+		}
+
+		return true;
+	}
+}
+
+namespace KlayGE
+{
+	NetChannel::NetChannel()
+	{
+		this->Reset();
+	}
+
+	void NetChannel::Reset()
+	{
+		next_seq_ = 0;
+		for (auto& packet : sent_packets_)
+		{
+			packet.valid = false;
+			packet.reliable_ids.clear();
+			packet.states.clear();
+		}
+		packet_size_ = 0;
+
+		next_reliable_id_ = 0;
+		reliable_head_ = 0;
+		num_reliable_ = 0;
+
+		unreliable_.clear();
+
+		for (auto& state : send_states_)
+		{
+			state.latest.clear();
+			state.dirty = false;
+			state.next_seq = 0;
+			state.acked_valid = false;
+			state.acked_seq = 0;
+			for (auto& value : state.history)
+			{
+				value.valid = false;
+			}
+		}
+
+		rtt_valid_ = false;
+		srtt_ = 0;
+		rttvar_ = 0;
+
+		// Nothing is received yet. The first packet from the peer has sequence number 0.
+		remote_seq_ = 0xFFFF;
+		remote_bits_ = 0;
+		num_acks_pending_ = 0;
+
+		recv_base_ = 0;
+		recv_mask_ = 0;
+
+		for (auto& state : recv_states_)
+		{
+			state.delivered_valid = false;
+			state.delivered_seq = 0;
+			for (auto& value : state.history)
+			{
+				value.valid = false;
+			}
+		}
+
+		std::memset(&stats_, 0, sizeof(stats_));
+	}
+
+	bool NetChannel::SendReliable(void const * msg, uint32_t size)
+	{
+		if ((size > NET_MAX_MESSAGE_SIZE) || (MAX_RELIABLE_IN_FLIGHT == num_reliable_))
+		{
+			return false;
+		}
+
+		ReliableMsg& reliable = reliable_[(reliable_head_ + num_reliable_) % MAX_RELIABLE_IN_FLIGHT];
+		reliable.id = next_reliable_id_;
+		reliable.acked = false;
+		reliable.sent = false;
+		reliable.num_sends = 0;
+		reliable.data.assign(static_cast<char const *>(msg), static_cast<char const *>(msg) + size);
+
+		++ next_reliable_id_;
+		++ num_reliable_;
+		return true;
+	}
+
+	bool NetChannel::SendUnreliable(void const * msg, uint32_t size)
+	{
+		if ((size > NET_MAX_MESSAGE_SIZE) || (unreliable_.size() + 2 + size > MAX_UNRELIABLE_QUEUE))
+		{
+			return false;
+		}
+
+		size_t const offset = unreliable_.size();
+		unreliable_.resize(offset + 2 + size);
+		WriteU16(&unreliable_[offset], static_cast<uint16_t>(size));
+		std::memcpy(&unreliable_[offset + 2], msg, size);
+		return true;
+	}
+
+	bool NetChannel::SendState(uint32_t slot, void const * msg, uint32_t size)
+	{
+		if ((slot >= NUM_STATE_SLOTS) || (size > NET_MAX_MESSAGE_SIZE))
+		{
+			return false;
+		}
+
+		SendStateSlot& state = send_states_[slot];
+		state.latest.assign(static_cast<char const *>(msg), static_cast<char const *>(msg) + size);
+		state.dirty = true;
+		return true;
+	}
+
+	void NetChannel::Flush(TimePoint now, EmitFunc const & emit)
+	{
+		this->BeginPacket();
+
+		float const rto = static_cast<float>(this->Rto().count());
+		for (uint32_t i = 0; i < num_reliable_; ++ i)
+		{
+			ReliableMsg& reliable = reliable_[(reliable_head_ + i) % MAX_RELIABLE_IN_FLIGHT];
+			if (reliable.acked)
+			{
+				continue;
+			}
+
+			if (reliable.sent)
+			{
+				// Backs off on repeated losses, instead of flooding a congested link
+				float const time_out = std::min(rto * (1U << std::min(reliable.num_sends - 1, MAX_BACKOFF_SHIFT)),
+					MAX_RTO_MS);
+				if (now - reliable.last_send < std::chrono::milliseconds(static_cast<int>(time_out)))
+				{
+					continue;
+				}
+				++ stats_.retransmits;
+			}
+
+			uint32_t const size = static_cast<uint32_t>(reliable.data.size());
+			this->ReserveRecord(RELIABLE_RECORD_HEADER_SIZE + size, now, emit);
+			char* p = &packet_[packet_size_];
+			p[0] = RK_Reliable;
+			WriteU16(&p[1], reliable.id);
+			WriteU16(&p[3], static_cast<uint16_t>(size));
+			std::memcpy(&p[RELIABLE_RECORD_HEADER_SIZE], reliable.data.data(), size);
+			packet_size_ += RELIABLE_RECORD_HEADER_SIZE + size;
+			sent_packets_[next_seq_ % NUM_SENT_PACKETS].reliable_ids.push_back(reliable.id);
+
+			reliable.sent = true;
+			++ reliable.num_sends;
+			reliable.last_send = now;
+		}
+
+		for (uint32_t slot = 0; slot < NUM_STATE_SLOTS; ++ slot)
+		{
+			SendStateSlot& state = send_states_[slot];
+			if (!state.dirty)
+			{
+				continue;
+			}
+
+			uint16_t const seq = state.next_seq;
+			++ state.next_seq;
+			StateValue& value = state.history[seq % STATE_HISTORY];
+			value.seq = seq;
+			value.valid = true;
+			value.data = state.latest;
+			uint32_t const size = static_cast<uint32_t>(value.data.size());
+
+			bool use_delta = false;
+			if (state.acked_valid && (static_cast<uint16_t>(seq - state.acked_seq) < STATE_HISTORY))
+			{
+				StateValue const & base = state.history[state.acked_seq % STATE_HISTORY];
+				if (base.valid && (base.seq == state.acked_seq))
+				{
+					EncodeDelta(delta_, value.data, base.data);
+					use_delta = (delta_.size() + STATE_DELTA_RECORD_HEADER_SIZE < size + STATE_RECORD_HEADER_SIZE);
+				}
+			}
+
+			if (use_delta)
+			{
+				uint32_t const delta_size = static_cast<uint32_t>(delta_.size());
+				this->ReserveRecord(STATE_DELTA_RECORD_HEADER_SIZE + delta_size, now, emit);
+				char* p = &packet_[packet_size_];
+				p[0] = RK_StateDelta;
+				p[1] = static_cast<char>(slot);
+				WriteU16(&p[2], seq);
+				WriteU16(&p[4], state.acked_seq);
+				WriteU16(&p[6], static_cast<uint16_t>(size));
+				WriteU16(&p[8], static_cast<uint16_t>(delta_size));
+				std::memcpy(&p[STATE_DELTA_RECORD_HEADER_SIZE], delta_.data(), delta_size);
+				packet_size_ += STATE_DELTA_RECORD_HEADER_SIZE + delta_size;
+			}
+			else
+			{
+				this->ReserveRecord(STATE_RECORD_HEADER_SIZE + size, now, emit);
+				char* p = &packet_[packet_size_];
+				p[0] = RK_State;
+				p[1] = static_cast<char>(slot);
+				WriteU16(&p[2], seq);
+				WriteU16(&p[4], static_cast<uint16_t>(size));
+				std::memcpy(&p[STATE_RECORD_HEADER_SIZE], value.data.data(), size);
+				packet_size_ += STATE_RECORD_HEADER_SIZE + size;
+			}
+			sent_packets_[next_seq_ % NUM_SENT_PACKETS].states.emplace_back(static_cast<uint8_t>(slot), seq);
+
+			state.dirty = false;
+		}
+
+		for (size_t offset = 0; offset < unreliable_.size();)
+		{
+			uint32_t const size = ReadU16(&unreliable_[offset]);
+			this->ReserveRecord(UNRELIABLE_RECORD_HEADER_SIZE + size, now, emit);
+			char* p = &packet_[packet_size_];
+			p[0] = RK_Unreliable;
+			std::memcpy(&p[1], &unreliable_[offset], 2 + size);
+			packet_size_ += UNRELIABLE_RECORD_HEADER_SIZE + size;
+
+			offset += 2 + size;
+		}
+		unreliable_.clear();
+
+		// An empty packet is sent only to ack
+		if ((packet_size_ > NET_PACKET_HEADER_SIZE) || (num_acks_pending_ > 0))
+		{
+			this->EndPacket(now, emit);
+		}
+	}
+
+	bool NetChannel::OnPacket(char const * packet, uint32_t size, TimePoint now, DeliverFunc const & deliver)
+	{
+		if ((size < NET_PACKET_HEADER_SIZE) || (packet[0] != MSG_PACKET))
+		{
+			return false;
+		}
+
+		++ stats_.packets_received;
+
+		uint16_t const seq = ReadU16(&packet[1]);
+		uint16_t const ack = ReadU16(&packet[3]);
+		uint32_t const ack_bits = ReadU32(&packet[5]);
+
+		// Only the latest packet gives a RTT sample, the older ones are acked late on purpose
+		this->OnAck(ack, now, true);
+		for (uint32_t i = 0; i < ACK_BITS; ++ i)
+		{
+			if (ack_bits & (1U << i))
+			{
+				this->OnAck(static_cast<uint16_t>(ack - 1 - i), now, false);
+			}
+		}
+
+		int const diff = static_cast<int16_t>(seq - remote_seq_);
+		if (diff > 0)
+		{
+			uint32_t const shift = static_cast<uint32_t>(diff);
+			remote_bits_ = (shift < ACK_BITS) ? (remote_bits_ << shift) : 0;
+			if (shift <= ACK_BITS)
+			{
+				remote_bits_ |= 1U << (shift - 1);
+			}
+			remote_seq_ = seq;
+		}
+		else
+		{
+			// Duplicated, or too old to be acked. The reliable messages in it are retransmitted in newer packets.
+			uint32_t const age = static_cast<uint32_t>(-diff);
+			if ((0 == age) || (age > ACK_BITS) || (remote_bits_ & (1U << (age - 1))))
+			{
+				return true;
+			}
+			remote_bits_ |= 1U << (age - 1);
+		}
+
+		uint32_t offset = NET_PACKET_HEADER_SIZE;
+		if (offset < size)
+		{
+			num_acks_pending_ = ACK_REPEAT;
+		}
+		while (offset < size)
+		{
+			char const * p = &packet[offset];
+			uint32_t const left = size - offset;
+			switch (p[0])
+			{
+			case RK_Unreliable:
+				{
+					if (left < UNRELIABLE_RECORD_HEADER_SIZE)
+					{
+						return false;
+					}
+					uint32_t const msg_size = ReadU16(&p[1]);
+					if (left < UNRELIABLE_RECORD_HEADER_SIZE + msg_size)
+					{
+						return false;
+					}
+
+					deliver(&p[UNRELIABLE_RECORD_HEADER_SIZE], msg_size);
+					offset += UNRELIABLE_RECORD_HEADER_SIZE + msg_size;
+				}
+				break;
+
+			case RK_Reliable:
+				{
+					if (left < RELIABLE_RECORD_HEADER_SIZE)
+					{
+						return false;
+					}
+					uint32_t const msg_size = ReadU16(&p[3]);
+					if (left < RELIABLE_RECORD_HEADER_SIZE + msg_size)
+					{
+						return false;
+					}
+
+					if (this->AcceptReliable(ReadU16(&p[1])))
+					{
+						deliver(&p[RELIABLE_RECORD_HEADER_SIZE], msg_size);
+					}
+					offset += RELIABLE_RECORD_HEADER_SIZE + msg_size;
+				}
+				break;
+
+			case RK_State:
+				{
+					if (left < STATE_RECORD_HEADER_SIZE)
+					{
+						return false;
+					}
+					uint32_t const slot = static_cast<uint8_t>(p[1]);
+					uint32_t const msg_size = ReadU16(&p[4]);
+					if ((slot >= NUM_STATE_SLOTS) || (left < STATE_RECORD_HEADER_SIZE + msg_size))
+					{
+						return false;
+					}
+
+					state_value_.assign(&p[STATE_RECORD_HEADER_SIZE], &p[STATE_RECORD_HEADER_SIZE + msg_size]);
+					this->OnState(slot, ReadU16(&p[2]), state_value_, deliver);
+					offset += STATE_RECORD_HEADER_SIZE + msg_size;
+				}
+				break;
+
+			case RK_StateDelta:
+				{
+					if (left < STATE_DELTA_RECORD_HEADER_SIZE)
+					{
+						return false;
+					}
+					uint32_t const slot = static_cast<uint8_t>(p[1]);
+					uint16_t const base_seq = ReadU16(&p[4]);
+					uint32_t const msg_size = ReadU16(&p[6]);
+					uint32_t const delta_size = ReadU16(&p[8]);
+					if ((slot >= NUM_STATE_SLOTS) || (msg_size > NET_MAX_MESSAGE_SIZE)
+						|| (left < STATE_DELTA_RECORD_HEADER_SIZE + delta_size))
+					{
+						return false;
+					}
+
+					// The base is always here, the sender only uses the values this side has acked
+					StateValue const & base = recv_states_[slot].history[base_seq % STATE_HISTORY];
+					if (base.valid && (base.seq == base_seq))
+					{
+						if (!DecodeDelta(state_value_, msg_size, base.data, &p[STATE_DELTA_RECORD_HEADER_SIZE], delta_size))
+						{
+							return false;
+						}
+						this->OnState(slot, ReadU16(&p[2]), state_value_, deliver);
+					}
+					offset += STATE_DELTA_RECORD_HEADER_SIZE + delta_size;
+				}
+				break;
+
+			default:
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	std::chrono::milliseconds NetChannel::Rtt() const
+	{
+		return std::chrono::milliseconds(static_cast<int>(srtt_ + 0.5f));
+	}
+
+	// Jacobson/Karels, as in RFC 6298. The retransmits go out in new packets with new sequence numbers, so every
+	//  sample is unambiguous, and there is no need for Karn's rule.
+	std::chrono::milliseconds NetChannel::Rto() const
+	{
+		float rto;
+		if (rtt_valid_)
+		{
+			rto = std::min(std::max(srtt_ + std::max(4 * rttvar_, RTO_GRANULARITY_MS), MIN_RTO_MS), MAX_RTO_MS);
+		}
+		else
+		{
+			rto = INITIAL_RTO_MS;
+		}
+		return std::chrono::milliseconds(static_cast<int>(rto + 0.5f));
+	}
+
+	void NetChannel::BeginPacket()
+	{
+		SentPacket& sent = sent_packets_[next_seq_ % NUM_SENT_PACKETS];
+		sent.seq = next_seq_;
+		sent.valid = false;
+		sent.reliable_ids.clear();
+		sent.states.clear();
+
+		packet_size_ = NET_PACKET_HEADER_SIZE;
+	}
+
+	void NetChannel::EndPacket(TimePoint now, EmitFunc const & emit)
+	{
+		packet_[0] = MSG_PACKET;
+		WriteU16(&packet_[1], next_seq_);
+		WriteU16(&packet_[3], remote_seq_);
+		WriteU32(&packet_[5], remote_bits_);
+
+		SentPacket& sent = sent_packets_[next_seq_ % NUM_SENT_PACKETS];
+		sent.valid = true;
+		sent.send_time = now;
+
+		emit(packet_.data(), packet_size_);
+
+		++ stats_.packets_sent;
+		stats_.bytes_sent += packet_size_;
+		++ next_seq_;
+		if (num_acks_pending_ > 0)
+		{
+			-- num_acks_pending_;
+		}
+	}
+
+	void NetChannel::ReserveRecord(uint32_t size, TimePoint now, EmitFunc const & emit)
+	{
+		BOOST_ASSERT(NET_PACKET_HEADER_SIZE + size <= NET_MTU);
+
+		if (packet_size_ + size > NET_MTU)
+		{
+			this->EndPacket(now, emit);
+			this->BeginPacket();
+		}
+	}
+
+	void NetChannel::OnAck(uint16_t seq, TimePoint now, bool sample_rtt)
+	{
+		SentPacket& sent = sent_packets_[seq % NUM_SENT_PACKETS];
+		if (!sent.valid || (sent.seq != seq))
+		{
+			return;
+		}
+		sent.valid = false;
+
+		if (sample_rtt)
+		{
+			float const sample = std::chrono::duration<float, std::milli>(now - sent.send_time).count();
+			if (rtt_valid_)
+			{
+				rttvar_ = 0.75f * rttvar_ + 0.25f * std::abs(srtt_ - sample);
+				srtt_ = 0.875f * srtt_ + 0.125f * sample;
+			}
+			else
+			{
+				srtt_ = sample;
+				rttvar_ = sample / 2;
+				rtt_valid_ = true;
+			}
+		}
+
+		if (num_reliable_ > 0)
+		{
+			for (auto const id : sent.reliable_ids)
+			{
+				uint32_t const offset = static_cast<uint16_t>(id - reliable_[reliable_head_].id);
+				if (offset < num_reliable_)
+				{
+					reliable_[(reliable_head_ + offset) % MAX_RELIABLE_IN_FLIGHT].acked = true;
+				}
+			}
+			while ((num_reliable_ > 0) && reliable_[reliable_head_].acked)
+			{
+				reliable_head_ = (reliable_head_ + 1) % MAX_RELIABLE_IN_FLIGHT;
+				-- num_reliable_;
+			}
+		}
+
+		for (auto const & state : sent.states)
+		{
+			SendStateSlot& slot = send_states_[state.first];
+			if (!slot.acked_valid || SeqNewer(state.second, slot.acked_seq))
+			{
+				slot.acked_valid = true;
+				slot.acked_seq = state.second;
+			}
+		}
+	}
+
+	bool NetChannel::AcceptReliable(uint16_t id)
+	{
+		uint32_t const offset = static_cast<uint16_t>(id - recv_base_);
+		if (offset >= MAX_RELIABLE_IN_FLIGHT)
+		{
+			return false;
+		}
+
+		uint64_t const bit = 1ULL << offset;
+		if (recv_mask_ & bit)
+		{
+			return false;
+		}
+
+		recv_mask_ |= bit;
+		while (recv_mask_ & 1)
+		{
+			recv_mask_ >>= 1;
+			++ recv_base_;
+		}
+		return true;
+	}
+
+	void NetChannel::OnState(uint32_t slot, uint16_t seq, std::vector<char> const & value, DeliverFunc const & deliver)
+	{
+		RecvStateSlot& state = recv_states_[slot];
+
+		StateValue& stored = state.history[seq % STATE_HISTORY];
+		if (!stored.valid || !SeqNewer(stored.seq, seq))
+		{
+			stored.seq = seq;
+			stored.valid = true;
+			stored.data = value;
+		}
+
+		if (!state.delivered_valid || SeqNewer(seq, state.delivered_seq))
+		{
+			state.delivered_valid = true;
+			state.delivered_seq = seq;
+			deliver(value.data(), static_cast<uint32_t>(value.size()));
+		}
+	}
+}
@@ -17,6 +17,7 @@
 #include <KlayGE/Lobby.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <ctime>
 #include <cstring>
 
@@ -27,6 +28,11 @@
 
 namespace
 {
+	// Acks and retransmits are flushed at least this often
+	int const CHANNEL_TICK_MS = 10;
+	int const NOP_INTERVAL = 10;
+	size_t const MAX_RECEIVE_QUEUE = 256;
+
 	class ReceiveThreadFunc
 	{
 	public:
@@ -47,6 +53,7 @@ namespace KlayGE
 	// 캯
 	/////////////////////////////////////////////////////////////////////////////////
 	Player::Player()
+		: playerID_(0), joined_(false), receiveLoop_(false)
 	{
 	}
 
@@ -61,58 +68,93 @@ namespace KlayGE
 	/////////////////////////////////////////////////////////////////////////////////
 	void Player::ReceiveFunc()
 	{
-		static time_t lastTime = std::time(nullptr);
+		socket_.NonBlock(true);
+
+		SocketPoller poller;
+		poller.Add(socket_, SocketPoller::PE_Readable, nullptr);
 
-		for (;;)
+		auto last_nop = std::chrono::steady_clock::now();
+		while (receiveLoop_)
 		{
-			if (std::time(nullptr) - lastTime >= 10 * 1000)
+			SocketPoller::Event event;
+			if (poller.Wait(&event, 1, CHANNEL_TICK_MS) > 0)
+			{
+				char revBuf[NET_MTU];
+				int size;
+				while (receiveLoop_ && ((size = socket_.Receive(revBuf, sizeof(revBuf))) > 0))
+				{
+					this->OnMessage(revBuf, size);
+				}
+			}
+
+			this->FlushChannel();
+
+			auto const now = std::chrono::steady_clock::now();
+			if (now - last_nop >= std::chrono::seconds(NOP_INTERVAL))
 			{
 				char msg(MSG_NOP);
 				socket_.Send(&msg, sizeof(msg));
-				lastTime = std::time(nullptr);
+				last_nop = now;
 			}
+		}
 
-			if (!sendQueue_.empty())
+		poller.Remove(socket_);
+	}
+
+	void Player::OnMessage(char const * msg, int size)
+	{
+		switch (msg[0])
+		{
+		case MSG_QUIT:
+			receiveLoop_ = false;
+			break;
+
+		case MSG_PACKET:
 			{
-				// ͶϢ
-				for (auto const & msg : sendQueue_)
+				bool full;
 				{
-					socket_.Send(&msg[0], static_cast<int>(msg.size()));
+					std::lock_guard<std::mutex> lock(recvMutex_);
+					full = (recvQueue_.size() >= MAX_RECEIVE_QUEUE);
 				}
-			}
-
-			char revBuf[Max_Buffer];
-			memset(revBuf, 0, sizeof(revBuf));
-			if (socket_.Receive(revBuf, sizeof(revBuf)) != -1)
-			{
-				uint32_t ID;
-				std::memcpy(&ID, &revBuf[1], 4);
 
-				// ɾѷ͵Ϣ
-				for (auto iter = sendQueue_.begin(); iter != sendQueue_.end();)
+				// Not acked if there is no room, the lobby retransmits the reliable messages later
+				if (!full)
 				{
-					std::vector<char>& msg = *iter;
-
-					uint32_t sendID;
-					std::memcpy(&sendID, &msg[1], 4);
-					if (sendID == ID)
-					{
-						iter = sendQueue_.erase(iter);
-					}
-					else
-					{
-						++ iter;
-					}
+					std::lock_guard<std::mutex> lock(channelMutex_);
+					channel_.OnPacket(msg, size, std::chrono::steady_clock::now(),
+						[this](char const * channel_msg, uint32_t channel_msg_size)
+						{
+							if (channel_msg_size > 0)
+							{
+								std::lock_guard<std::mutex> lock(recvMutex_);
+								recvQueue_.emplace_back(channel_msg, channel_msg + channel_msg_size);
+							}
+						});
 				}
+			}
+			break;
 
-				if (MSG_QUIT == revBuf[0])
+		default:
+			{
+				std::lock_guard<std::mutex> lock(recvMutex_);
+				if (recvQueue_.size() < MAX_RECEIVE_QUEUE)
 				{
-					break;
+					recvQueue_.emplace_back(msg, msg + size);
 				}
 			}
+			break;
 		}
 	}
 
+	void Player::FlushChannel()
+	{
+		std::lock_guard<std::mutex> lock(channelMutex_);
+		channel_.Flush(std::chrono::steady_clock::now(), [this](char const * packet, uint32_t size)
+			{
+				socket_.Send(packet, static_cast<int>(size));
+			});
+	}
+
 	// 
 	/////////////////////////////////////////////////////////////////////////////////
 	bool Player::Join(sockaddr_in const & lobbyAddr)
@@ -120,6 +162,7 @@ namespace KlayGE
 		socket_.Close();
 		socket_.Create(SOCK_DGRAM);
 		socket_.Connect(lobbyAddr);
+		lobbyAddr_ = lobbyAddr;
 
 		socket_.TimeOut(2000);
 
@@ -131,12 +174,27 @@ namespace KlayGE
 
 		socket_.Send(buf, sizeof(buf));
 
-		socket_.Receive(&playerID_, sizeof(playerID_));
-		if (0 == playerID_)
+		// ظʽ:
+		//			MSG_JOIN		1 ֽ
+		//			Player ID		2 ֽ
+		char revBuf[3] = { 0, 0, 0 };
+		if ((socket_.Receive(revBuf, sizeof(revBuf)) != static_cast<int>(sizeof(revBuf))) || (revBuf[0] != MSG_JOIN))
+		{
+			return false;
+		}
+		uint16_t id;
+		std::memcpy(&id, &revBuf[1], sizeof(id));
+		id = LE2Native(id);
+		if (0 == id)
 		{
 			return false;
 		}
+		playerID_ = id;
+
+		channel_.Reset();
+		recvQueue_.clear();
 
+		joined_ = true;
 		receiveLoop_ = true;
 		receiveThread_ = Context::Instance().ThreadPool()(ReceiveThreadFunc(this));
 
@@ -147,13 +205,14 @@ namespace KlayGE
 	/////////////////////////////////////////////////////////////////////////////////
 	void Player::Quit()
 	{
-		if (receiveLoop_)
+		if (joined_)
 		{
 			char msg(MSG_QUIT);
 			socket_.Send(&msg, sizeof(msg));
 
 			receiveLoop_ = false;
 			receiveThread_();
+			joined_ = false;
 		}
 	}
 
@@ -174,18 +233,19 @@ namespace KlayGE
 		char msg(MSG_GETLOBBYINFO);
 		socket_.Send(&msg, sizeof(msg));
 
-		char buf[18];
-		socket_.Receive(buf, sizeof(buf));
-		if (MSG_GETLOBBYINFO == buf[0])
+		char buf[21];
+		if ((socket_.Receive(buf, sizeof(buf)) == static_cast<int>(sizeof(buf))) && (MSG_GETLOBBYINFO == buf[0]))
 		{
-			lobbydes.numPlayer = buf[1];
-			lobbydes.maxPlayers = buf[2];
+			std::memcpy(&lobbydes.numPlayer, &buf[1], sizeof(lobbydes.numPlayer));
+			std::memcpy(&lobbydes.maxPlayers, &buf[3], sizeof(lobbydes.maxPlayers));
+			lobbydes.numPlayer = LE2Native(lobbydes.numPlayer);
+			lobbydes.maxPlayers = LE2Native(lobbydes.maxPlayers);
 			size_t i(0);
-			while (buf[3 + i] != 0)
+			while ((5 + i < sizeof(buf)) && (buf[5 + i] != 0))
 			{
 				++ i;
 			}
-			lobbydes.name = std::string(&buf[3], i);
+			lobbydes.name = std::string(&buf[5], i);
 		}
 
 		return lobbydes;
@@ -209,7 +269,26 @@ namespace KlayGE
 	/////////////////////////////////////////////////////////////////////////////////
 	int Player::Receive(void* buf, int maxSize, sockaddr_in& from)
 	{
-		return socket_.ReceiveFrom(buf, maxSize, from);
+		if (joined_)
+		{
+			// The receive thread owns the socket
+			std::lock_guard<std::mutex> lock(recvMutex_);
+			if (recvQueue_.empty())
+			{
+				return -1;
+			}
+
+			std::vector<char> const & msg = recvQueue_.front();
+			int const size = std::min(maxSize, static_cast<int>(msg.size()));
+			std::memcpy(buf, msg.data(), size);
+			recvQueue_.pop_front();
+			from = lobbyAddr_;
+			return size;
+		}
+		else
+		{
+			return socket_.ReceiveFrom(buf, maxSize, from);
+		}
 	}
 
 	// 
@@ -218,6 +297,24 @@ namespace KlayGE
 	{
 		return socket_.Send(buf, size);
 	}
+
+	bool Player::SendReliable(void const * buf, int size)
+	{
+		std::lock_guard<std::mutex> lock(channelMutex_);
+		return (size >= 0) && channel_.SendReliable(buf, size);
+	}
+
+	bool Player::SendUnreliable(void const * buf, int size)
+	{
+		std::lock_guard<std::mutex> lock(channelMutex_);
+		return (size >= 0) && channel_.SendUnreliable(buf, size);
+	}
+
+	bool Player::SendState(uint32_t slot, void const * buf, int size)
+	{
+		std::lock_guard<std::mutex> lock(channelMutex_);
+		return (size >= 0) && channel_.SendState(slot, buf, size);
+	}
 }
 
 #endif
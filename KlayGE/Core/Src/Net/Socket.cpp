@@ -16,6 +16,8 @@
 #include <KlayGE/KlayGE.hpp>
 #include <KFL/ErrorHandling.hpp>
 
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
 #include <system_error>
 #include <boost/assert.hpp>
@@ -24,6 +26,14 @@
 
 #ifndef KLAYGE_PLATFORM_WINDOWS_STORE
 
+#if defined(KLAYGE_PLATFORM_LINUX) || defined(KLAYGE_PLATFORM_ANDROID)
+#include <sys/epoll.h>
+#include <unistd.h>
+#elif !defined(KLAYGE_PLATFORM_WINDOWS)
+#include <poll.h>
+#include <unistd.h>
+#endif
+
 #ifdef KLAYGE_COMPILER_MSVC
 #ifndef KLAYGE_CPU_ARM
 #pragma comment(lib, "wsock32.lib")
@@ -115,6 +125,15 @@ namespace KlayGE
 		return addr;
 	}
 
+	bool SocketWouldBlock()
+	{
+#ifdef KLAYGE_PLATFORM_WINDOWS
+		return WSAEWOULDBLOCK == WSAGetLastError();
+#else
+		return (EAGAIN == errno) || (EWOULDBLOCK == errno);
+#endif
+	}
+
 
 	// 캯
 	/////////////////////////////////////////////////////////////////////////////////
@@ -293,6 +312,131 @@ namespace KlayGE
 			reinterpret_cast<sockaddr const *>(&sockTo), sizeof(sockTo));
 	}
 
+	// Batched receive
+	/////////////////////////////////////////////////////////////////////////////////
+	int Socket::ReceiveFromMany(Datagram* datagrams, int count)
+	{
+		BOOST_ASSERT(this->socket_ != INVALID_SOCKET);
+
+		int total = 0;
+#if defined(KLAYGE_PLATFORM_LINUX) || defined(KLAYGE_PLATFORM_ANDROID)
+		int const MAX_BATCH = 64;
+		mmsghdr msgs[MAX_BATCH];
+		iovec iovs[MAX_BATCH];
+		while (total < count)
+		{
+			int const batch = std::min(count - total, MAX_BATCH);
+			for (int i = 0; i < batch; ++ i)
+			{
+				Datagram& datagram = datagrams[total + i];
+				iovs[i].iov_base = datagram.buf;
+				iovs[i].iov_len = datagram.len;
+
+				std::memset(&msgs[i], 0, sizeof(msgs[i]));
+				msgs[i].msg_hdr.msg_name = &datagram.addr;
+				msgs[i].msg_hdr.msg_namelen = sizeof(datagram.addr);
+				msgs[i].msg_hdr.msg_iov = &iovs[i];
+				msgs[i].msg_hdr.msg_iovlen = 1;
+			}
+
+			// A blocking socket waits for the first datagram only
+			int const received = recvmmsg(this->socket_, msgs, batch, (0 == total) ? MSG_WAITFORONE : MSG_DONTWAIT, nullptr);
+			if (received <= 0)
+			{
+				break;
+			}
+
+			for (int i = 0; i < received; ++ i)
+			{
+				datagrams[total + i].len = static_cast<int>(msgs[i].msg_len);
+			}
+			total += received;
+
+			if (received < batch)
+			{
+				break;
+			}
+		}
+#else
+		for (; total < count; ++ total)
+		{
+			if (total > 0)
+			{
+				// Doesn't block after the first datagram
+				uint32_t pending = 0;
+				this->IOCtl(FIONREAD, &pending);
+				if (0 == pending)
+				{
+					break;
+				}
+			}
+
+			Datagram& datagram = datagrams[total];
+			int const received = this->ReceiveFrom(datagram.buf, datagram.len, datagram.addr);
+			if (received < 0)
+			{
+				break;
+			}
+			datagram.len = received;
+		}
+#endif
+
+		return (total > 0) ? total : -1;
+	}
+
+	// Batched send
+	/////////////////////////////////////////////////////////////////////////////////
+	int Socket::SendToMany(Datagram const * datagrams, int count)
+	{
+		BOOST_ASSERT(this->socket_ != INVALID_SOCKET);
+
+		int total = 0;
+#if defined(KLAYGE_PLATFORM_LINUX) || defined(KLAYGE_PLATFORM_ANDROID)
+		int const MAX_BATCH = 64;
+		mmsghdr msgs[MAX_BATCH];
+		iovec iovs[MAX_BATCH];
+		while (total < count)
+		{
+			int const batch = std::min(count - total, MAX_BATCH);
+			for (int i = 0; i < batch; ++ i)
+			{
+				Datagram const & datagram = datagrams[total + i];
+				iovs[i].iov_base = datagram.buf;
+				iovs[i].iov_len = datagram.len;
+
+				std::memset(&msgs[i], 0, sizeof(msgs[i]));
+				msgs[i].msg_hdr.msg_name = const_cast<sockaddr_in*>(&datagram.addr);
+				msgs[i].msg_hdr.msg_namelen = sizeof(datagram.addr);
+				msgs[i].msg_hdr.msg_iov = &iovs[i];
+				msgs[i].msg_hdr.msg_iovlen = 1;
+			}
+
+			int const sent = sendmmsg(this->socket_, msgs, batch, 0);
+			if (sent <= 0)
+			{
+				break;
+			}
+			total += sent;
+
+			if (sent < batch)
+			{
+				break;
+			}
+		}
+#else
+		for (; total < count; ++ total)
+		{
+			Datagram const & datagram = datagrams[total];
+			if (this->SendTo(datagram.buf, datagram.len, datagram.addr) < 0)
+			{
+				break;
+			}
+		}
+#endif
+
+		return (total > 0) ? total : -1;
+	}
+
 	// ӷ
 	/////////////////////////////////////////////////////////////////////////////////
 	void Socket::Connect(sockaddr_in const & sockAddr)
@@ -327,6 +471,173 @@ namespace KlayGE
 
 		return timeOut.tv_sec * 1000 + timeOut.tv_usec;
 	}
+
+
+	SocketPoller::SocketPoller()
+	{
+#if defined(KLAYGE_PLATFORM_LINUX) || defined(KLAYGE_PLATFORM_ANDROID)
+		epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+		Verify(epoll_fd_ != -1);
+#endif
+	}
+
+	SocketPoller::~SocketPoller()
+	{
+#if defined(KLAYGE_PLATFORM_LINUX) || defined(KLAYGE_PLATFORM_ANDROID)
+		close(epoll_fd_);
+#endif
+	}
+
+#if defined(KLAYGE_PLATFORM_LINUX) || defined(KLAYGE_PLATFORM_ANDROID)
+	void SocketPoller::Add(Socket const & socket, uint32_t events, void* user_data)
+	{
+		epoll_event ev;
+		ev.events = ((events & PE_Readable) ? static_cast<uint32_t>(EPOLLIN) : 0)
+			| ((events & PE_Writable) ? static_cast<uint32_t>(EPOLLOUT) : 0);
+		ev.data.ptr = user_data;
+		Verify(0 == epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, socket.Handle(), &ev));
+	}
+
+	void SocketPoller::Modify(Socket const & socket, uint32_t events, void* user_data)
+	{
+		epoll_event ev;
+		ev.events = ((events & PE_Readable) ? static_cast<uint32_t>(EPOLLIN) : 0)
+			| ((events & PE_Writable) ? static_cast<uint32_t>(EPOLLOUT) : 0);
+		ev.data.ptr = user_data;
+		Verify(0 == epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, socket.Handle(), &ev));
+	}
+
+	void SocketPoller::Remove(Socket const & socket)
+	{
+		epoll_event ev;
+		std::memset(&ev, 0, sizeof(ev));
+		epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, socket.Handle(), &ev);
+	}
+
+	int SocketPoller::Wait(Event* events, int max_events, int timeout_ms)
+	{
+		int const MAX_BATCH = 64;
+		epoll_event evs[MAX_BATCH];
+		int const num = epoll_wait(epoll_fd_, evs, std::min(max_events, MAX_BATCH), timeout_ms);
+		for (int i = 0; i < num; ++ i)
+		{
+			events[i].user_data = evs[i].data.ptr;
+			// Errors are reported as readable, the next receive returns them
+			events[i].events = ((evs[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) ? PE_Readable : 0)
+				| ((evs[i].events & EPOLLOUT) ? PE_Writable : 0);
+		}
+		return std::max(num, 0);
+	}
+#else
+	void SocketPoller::Add(Socket const & socket, uint32_t events, void* user_data)
+	{
+		entries_.push_back({ socket.Handle(), events, user_data });
+	}
+
+	void SocketPoller::Modify(Socket const & socket, uint32_t events, void* user_data)
+	{
+		for (auto& entry : entries_)
+		{
+			if (entry.socket == socket.Handle())
+			{
+				entry.events = events;
+				entry.user_data = user_data;
+				break;
+			}
+		}
+	}
+
+	void SocketPoller::Remove(Socket const & socket)
+	{
+		entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+			[&socket](Entry const & entry)
+			{
+				return entry.socket == socket.Handle();
+			}), entries_.end());
+	}
+
+#ifdef KLAYGE_PLATFORM_WINDOWS
+	int SocketPoller::Wait(Event* events, int max_events, int timeout_ms)
+	{
+		// select() handles at most FD_SETSIZE sockets
+		BOOST_ASSERT(entries_.size() <= FD_SETSIZE);
+
+		fd_set read_set;
+		fd_set write_set;
+		FD_ZERO(&read_set);
+		FD_ZERO(&write_set);
+		for (auto const & entry : entries_)
+		{
+			if (entry.events & PE_Readable)
+			{
+				FD_SET(entry.socket, &read_set);
+			}
+			if (entry.events & PE_Writable)
+			{
+				FD_SET(entry.socket, &write_set);
+			}
+		}
+
+		timeval timeout;
+		timeout.tv_sec = timeout_ms / 1000;
+		timeout.tv_usec = (timeout_ms % 1000) * 1000;
+		if (select(0, &read_set, &write_set, nullptr, (timeout_ms < 0) ? nullptr : &timeout) <= 0)
+		{
+			return 0;
+		}
+
+		int num = 0;
+		for (auto const & entry : entries_)
+		{
+			if (num == max_events)
+			{
+				break;
+			}
+
+			uint32_t const ready = (FD_ISSET(entry.socket, &read_set) ? PE_Readable : 0)
+				| (FD_ISSET(entry.socket, &write_set) ? PE_Writable : 0);
+			if (ready != 0)
+			{
+				events[num].user_data = entry.user_data;
+				events[num].events = ready;
+				++ num;
+			}
+		}
+		return num;
+	}
+#else
+	int SocketPoller::Wait(Event* events, int max_events, int timeout_ms)
+	{
+		std::vector<pollfd> fds(entries_.size());
+		for (size_t i = 0; i < entries_.size(); ++ i)
+		{
+			fds[i].fd = entries_[i].socket;
+			fds[i].events = ((entries_[i].events & PE_Readable) ? POLLIN : 0)
+				| ((entries_[i].events & PE_Writable) ? POLLOUT : 0);
+			fds[i].revents = 0;
+		}
+
+		if (poll(fds.data(), static_cast<nfds_t>(fds.size()), timeout_ms) <= 0)
+		{
+			return 0;
+		}
+
+		int num = 0;
+		for (size_t i = 0; (i < fds.size()) && (num < max_events); ++ i)
+		{
+			uint32_t const ready = ((fds[i].revents & (POLLIN | POLLERR | POLLHUP)) ? PE_Readable : 0)
+				| ((fds[i].revents & POLLOUT) ? PE_Writable : 0);
+			if (ready != 0)
+			{
+				events[num].user_data = entries_[i].user_data;
+				events[num].events = ready;
+				++ num;
+			}
+		}
+		return num;
+	}
+#endif
+#endif
 }
 
 #endif
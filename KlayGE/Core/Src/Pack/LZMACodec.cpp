@@ -30,11 +30,17 @@
 
 #include <KlayGE/KlayGE.hpp>
 #include <KFL/ErrorHandling.hpp>
+#include <KFL/CustomizedStreamBuf.hpp>
+#include <KFL/JobSystem.hpp>
+#include <KFL/ResIdentifier.hpp>
+#include <KlayGE/Context.hpp>
 #include <KlayGE/ResLoader.hpp>
 #include <KFL/DllLoader.hpp>
 
 #include <cstring>
+#include <istream>
 #include <mutex>
+#include <streambuf>
 
 #include <C/LzmaLib.h>
 
@@ -113,6 +119,210 @@ namespace
 		static std::unique_ptr<LZMALoader> instance_;
 	};
 	std::unique_ptr<LZMALoader> LZMALoader::instance_;
+
+	// Chunked payload layout, all little endian:
+	//   magic[4], uint32_t chunk_size, uint32_t num_chunks, uint64_t compressed_len[num_chunks], chunks
+	//  A plain payload starts with the lc/lp/pb byte of the LZMA props, which is always below 9 * 5 * 5, so a
+	//  magic starting with 0xFF can't be confused with it.
+	uint8_t const CHUNKED_MAGIC[] = { 0xFF, 'L', 'Z', 'C' };
+	uint32_t const CHUNKED_HEADER_SIZE = sizeof(CHUNKED_MAGIC) + sizeof(uint32_t) * 2;
+
+	struct ChunkIndex
+	{
+		uint32_t chunk_size;
+		std::vector<uint64_t> offsets;
+		std::vector<uint64_t> lens;
+	};
+
+	void ReadChunkIndex(ChunkIndex& index, uint8_t const * input, uint64_t len)
+	{
+		Verify(len >= CHUNKED_HEADER_SIZE);
+
+		uint32_t chunk_size;
+		std::memcpy(&chunk_size, input + sizeof(CHUNKED_MAGIC), sizeof(chunk_size));
+		index.chunk_size = LE2Native(chunk_size);
+		uint32_t num_chunks;
+		std::memcpy(&num_chunks, input + sizeof(CHUNKED_MAGIC) + sizeof(chunk_size), sizeof(num_chunks));
+		num_chunks = LE2Native(num_chunks);
+
+		Verify(len >= CHUNKED_HEADER_SIZE + num_chunks * sizeof(uint64_t));
+
+		index.offsets.resize(num_chunks);
+		index.lens.resize(num_chunks);
+		uint64_t offset = CHUNKED_HEADER_SIZE + num_chunks * sizeof(uint64_t);
+		for (uint32_t i = 0; i < num_chunks; ++ i)
+		{
+			uint64_t chunk_len;
+			std::memcpy(&chunk_len, input + CHUNKED_HEADER_SIZE + i * sizeof(uint64_t), sizeof(chunk_len));
+			index.offsets[i] = offset;
+			index.lens[i] = LE2Native(chunk_len);
+			offset += index.lens[i];
+		}
+		Verify(offset <= len);
+	}
+
+	// Every chunk but the last one is full
+	void VerifyChunkIndex(ChunkIndex const & index, uint64_t original_len)
+	{
+		uint64_t const num_chunks = index.offsets.size();
+		Verify((index.chunk_size > 0) && (num_chunks * index.chunk_size >= original_len)
+			&& ((0 == num_chunks) || ((num_chunks - 1) * index.chunk_size < original_len)));
+	}
+
+	uint64_t ChunkOriginalLen(ChunkIndex const & index, uint32_t chunk, uint64_t original_len)
+	{
+		uint64_t const begin = static_cast<uint64_t>(chunk) * index.chunk_size;
+		return std::min<uint64_t>(index.chunk_size, original_len - begin);
+	}
+
+	void DecodeLZMA(void* output, void const * input, uint64_t len, uint64_t original_len)
+	{
+		uint8_t const * p = static_cast<uint8_t const *>(input);
+
+		SizeT s_out_len = static_cast<SizeT>(original_len);
+
+		SizeT s_src_len = static_cast<SizeT>(len - LZMA_PROPS_SIZE);
+		int res = LZMALoader::Instance().LzmaUncompress(static_cast<Byte*>(output), &s_out_len, p + LZMA_PROPS_SIZE, &s_src_len,
+			p, LZMA_PROPS_SIZE);
+		Verify(0 == res);
+	}
+
+	// Serves a chunked payload while it's being decoded. One job per chunk is scheduled up front, the get area
+	//  grows over the prefix of finished chunks.
+	class ChunkedLZMAStreamBuf : public std::streambuf, boost::noncopyable
+	{
+	public:
+		ChunkedLZMAStreamBuf(ResIdentifierPtr const & res, uint64_t len, uint64_t original_len)
+			: job_system_(Context::Instance().JobSystemInstance()),
+				output_(static_cast<size_t>(original_len)), num_ready_chunks_(0)
+		{
+			input_ = static_cast<uint8_t const *>(res->ReadView(static_cast<size_t>(len)));
+			if (input_)
+			{
+				res_ = res;
+			}
+			else
+			{
+				in_data_.resize(static_cast<size_t>(len));
+				res->read(in_data_.data(), static_cast<std::streamsize>(len));
+				input_ = in_data_.data();
+			}
+
+			ReadChunkIndex(index_, input_, len);
+			VerifyChunkIndex(index_, original_len);
+
+			jobs_.resize(index_.offsets.size());
+			for (uint32_t i = 0; i < jobs_.size(); ++ i)
+			{
+				jobs_[i] = job_system_.Schedule([this, i]
+					{
+						DecodeLZMA(&output_[static_cast<size_t>(i) * index_.chunk_size], input_ + index_.offsets[i], index_.lens[i],
+							ChunkOriginalLen(index_, i, output_.size()));
+					});
+			}
+
+			this->setg(output_.data(), output_.data(), output_.data());
+		}
+
+		~ChunkedLZMAStreamBuf() override
+		{
+			// The jobs write to output_
+			for (auto const & job : jobs_)
+			{
+				try
+				{
+					job_system_.Wait(job);
+				}
+				catch (...)
+				{
+				}
+			}
+		}
+
+	protected:
+		int_type underflow() override
+		{
+			if (this->gptr() == this->egptr())
+			{
+				size_t const pos = this->gptr() - this->eback();
+				if (pos >= output_.size())
+				{
+					return traits_type::eof();
+				}
+				this->MakeReady(pos);
+			}
+
+			return traits_type::to_int_type(*this->gptr());
+		}
+
+		pos_type seekoff(off_type off, std::ios_base::seekdir way, std::ios_base::openmode which) override
+		{
+			off_type base;
+			switch (way)
+			{
+			case std::ios_base::beg:
+				base = 0;
+				break;
+
+			case std::ios_base::end:
+				base = static_cast<off_type>(output_.size());
+				break;
+
+			case std::ios_base::cur:
+			default:
+				base = this->gptr() - this->eback();
+				break;
+			}
+
+			return this->seekpos(base + off, which);
+		}
+
+		pos_type seekpos(pos_type sp, std::ios_base::openmode which) override
+		{
+			BOOST_ASSERT(which == std::ios_base::in);
+			KFL_UNUSED(which);
+
+			off_type const pos = sp;
+			if ((pos < 0) || (pos > static_cast<off_type>(output_.size())))
+			{
+				return pos_type(off_type(-1));
+			}
+
+			if (pos > this->egptr() - this->eback())
+			{
+				this->MakeReady(static_cast<size_t>(pos) - 1);
+			}
+			this->setg(this->eback(), this->eback() + pos, this->egptr());
+			return sp;
+		}
+
+	private:
+		// Waits until the byte at pos, and everything before it, is decoded
+		void MakeReady(size_t pos)
+		{
+			uint32_t const chunk = static_cast<uint32_t>(pos / index_.chunk_size);
+			while (num_ready_chunks_ <= chunk)
+			{
+				job_system_.Wait(jobs_[num_ready_chunks_]);
+				++ num_ready_chunks_;
+			}
+
+			size_t const ready = std::min<size_t>(static_cast<size_t>(num_ready_chunks_) * index_.chunk_size, output_.size());
+			this->setg(this->eback(), this->gptr(), this->eback() + ready);
+		}
+
+	private:
+		JobSystem& job_system_;
+
+		ResIdentifierPtr res_;
+		std::vector<uint8_t> in_data_;
+		uint8_t const * input_;
+		ChunkIndex index_;
+
+		std::vector<char> output_;
+		std::vector<JobPtr> jobs_;
+		uint32_t num_ready_chunks_;
+	};
 }
 
 namespace KlayGE
@@ -166,11 +376,8 @@ namespace KlayGE
 
 	uint64_t LZMACodec::Decode(std::ostream& os, ResIdentifierPtr const & is, uint64_t len, uint64_t original_len)
 	{
-		std::vector<uint8_t> in_data(static_cast<size_t>(len));
-		is->read(&in_data[0], static_cast<size_t>(len));
-
 		std::vector<uint8_t> output;
-		this->Decode(output, &in_data[0], len, original_len);
+		this->Decode(output, is, len, original_len);
 
 		os.write(reinterpret_cast<char*>(&output[0]), static_cast<std::streamsize>(output.size()));
 
@@ -189,30 +396,136 @@ namespace KlayGE
 
 	void LZMACodec::Decode(std::vector<uint8_t>& output, ResIdentifierPtr const & is, uint64_t len, uint64_t original_len)
 	{
-		std::vector<uint8_t> in_data(static_cast<size_t>(len));
-		is->read(&in_data[0], static_cast<size_t>(len));
+		// Memory mapped inputs are decoded in place
+		void const * in_view = is->ReadView(static_cast<size_t>(len));
+		if (in_view)
+		{
+			this->Decode(output, in_view, len, original_len);
+		}
+		else
+		{
+			std::vector<uint8_t> in_data(static_cast<size_t>(len));
+			is->read(&in_data[0], static_cast<size_t>(len));
 
-		this->Decode(output, &in_data[0], len, original_len);
+			this->Decode(output, &in_data[0], len, original_len);
+		}
 	}
 
 	void LZMACodec::Decode(std::vector<uint8_t>& output, void const * input, uint64_t len, uint64_t original_len)
 	{
 		output.resize(static_cast<uint32_t>(original_len));
-		this->Decode(&output[0], input, len, original_len);
+		this->Decode(output.data(), input, len, original_len);
 	}
 
 	void LZMACodec::Decode(void* output, void const * input, uint64_t len, uint64_t original_len)
 	{
+		if (IsChunked(input, len))
+		{
+			uint8_t const * p = static_cast<uint8_t const *>(input);
+
+			ChunkIndex index;
+			ReadChunkIndex(index, p, len);
+			VerifyChunkIndex(index, original_len);
+
+			uint8_t* out = static_cast<uint8_t*>(output);
+			Context::Instance().JobSystemInstance().ParallelFor(0, static_cast<uint32_t>(index.offsets.size()), 1,
+				[out, p, &index, original_len](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t i = begin; i < end; ++ i)
+					{
+						DecodeLZMA(out + static_cast<size_t>(i) * index.chunk_size, p + index.offsets[i], index.lens[i],
+							ChunkOriginalLen(index, i, original_len));
+					}
+				});
+		}
+		else
+		{
+			DecodeLZMA(output, input, len, original_len);
+		}
+	}
+
+	uint64_t LZMACodec::EncodeChunked(std::ostream& os, void const * input, uint64_t len, uint32_t chunk_size)
+	{
+		std::vector<uint8_t> output;
+		this->EncodeChunked(output, input, len, chunk_size);
+		os.write(reinterpret_cast<char*>(output.data()), output.size() * sizeof(output[0]));
+		return output.size();
+	}
+
+	void LZMACodec::EncodeChunked(std::vector<uint8_t>& output, void const * input, uint64_t len, uint32_t chunk_size)
+	{
+		BOOST_ASSERT(chunk_size > 0);
+
 		uint8_t const * p = static_cast<uint8_t const *>(input);
+		uint32_t const num_chunks = static_cast<uint32_t>((len + chunk_size - 1) / chunk_size);
 
-		std::vector<uint8_t> in_data(static_cast<size_t>(len));
-		std::memcpy(&in_data[0], p, static_cast<std::streamsize>(in_data.size()));
+		std::vector<std::vector<uint8_t>> chunks(num_chunks);
+		Context::Instance().JobSystemInstance().ParallelFor(0, num_chunks, 1,
+			[this, p, len, chunk_size, &chunks](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++ i)
+				{
+					uint64_t const offset = static_cast<uint64_t>(i) * chunk_size;
+					this->Encode(chunks[i], p + offset, std::min<uint64_t>(chunk_size, len - offset));
+				}
+			});
 
-		SizeT s_out_len = static_cast<SizeT>(original_len);
+		size_t total_len = CHUNKED_HEADER_SIZE + num_chunks * sizeof(uint64_t);
+		for (auto const & chunk : chunks)
+		{
+			total_len += chunk.size();
+		}
 
-		SizeT s_src_len = static_cast<SizeT>(len - LZMA_PROPS_SIZE);
-		int res = LZMALoader::Instance().LzmaUncompress(static_cast<Byte*>(output), &s_out_len, &in_data[LZMA_PROPS_SIZE], &s_src_len,
-			&in_data[0], LZMA_PROPS_SIZE);
-		Verify(0 == res);
+		output.resize(total_len);
+		uint8_t* out = output.data();
+		std::memcpy(out, CHUNKED_MAGIC, sizeof(CHUNKED_MAGIC));
+		out += sizeof(CHUNKED_MAGIC);
+		uint32_t const le_chunk_size = Native2LE(chunk_size);
+		std::memcpy(out, &le_chunk_size, sizeof(le_chunk_size));
+		out += sizeof(le_chunk_size);
+		uint32_t const le_num_chunks = Native2LE(num_chunks);
+		std::memcpy(out, &le_num_chunks, sizeof(le_num_chunks));
+		out += sizeof(le_num_chunks);
+		for (auto const & chunk : chunks)
+		{
+			uint64_t const le_len = Native2LE(static_cast<uint64_t>(chunk.size()));
+			std::memcpy(out, &le_len, sizeof(le_len));
+			out += sizeof(le_len);
+		}
+		for (auto const & chunk : chunks)
+		{
+			std::memcpy(out, chunk.data(), chunk.size());
+			out += chunk.size();
+		}
+	}
+
+	bool LZMACodec::IsChunked(void const * input, uint64_t len)
+	{
+		return (len >= CHUNKED_HEADER_SIZE) && (0 == std::memcmp(input, CHUNKED_MAGIC, sizeof(CHUNKED_MAGIC)));
+	}
+
+	ResIdentifierPtr LZMACodec::DecodeIncremental(ResIdentifierPtr const & res, uint64_t len, uint64_t original_len)
+	{
+		uint8_t magic[sizeof(CHUNKED_MAGIC)] = {};
+		if (len >= CHUNKED_HEADER_SIZE)
+		{
+			int64_t const pos = res->tellg();
+			res->read(magic, sizeof(magic));
+			res->seekg(pos, std::ios_base::beg);
+		}
+
+		std::shared_ptr<std::streambuf> buff;
+		if (0 == std::memcmp(magic, CHUNKED_MAGIC, sizeof(CHUNKED_MAGIC)))
+		{
+			buff = MakeSharedPtr<ChunkedLZMAStreamBuf>(res, len, original_len);
+		}
+		else
+		{
+			auto decoded = MakeSharedPtr<std::vector<uint8_t>>();
+			this->Decode(*decoded, res, len, original_len);
+			buff = MakeSharedPtr<SharedMemInputStreamBuf>(decoded->data(), static_cast<std::streamsize>(decoded->size()), decoded);
+		}
+
+		return MakeSharedPtr<ResIdentifier>(res->ResName(), res->Timestamp(), MakeSharedPtr<std::istream>(buff.get()), buff);
 	}
 }
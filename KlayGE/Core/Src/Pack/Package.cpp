@@ -31,6 +31,7 @@
 #include <KlayGE/KlayGE.hpp>
 #define INITGUID
 #include <KFL/COMPtr.hpp>
+#include <KFL/CustomizedStreamBuf.hpp>
 #include <KFL/ErrorHandling.hpp>
 #include <KFL/ResIdentifier.hpp>
 #include <KFL/Util.hpp>
@@ -40,7 +41,8 @@
 #include <KFL/DllLoader.hpp>
 
 #include <algorithm>
-#include <sstream>
+#include <istream>
+#include <ostream>
 #include <string>
 
 #include <boost/assert.hpp>
@@ -48,7 +50,7 @@
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wunused-variable" // Ignore unused variable (mpl_assertion_in_line_xxx) in boost
 #endif
-#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
 #if defined(KLAYGE_COMPILER_CLANGC2)
 #pragma clang diagnostic pop
 #endif
@@ -79,6 +81,8 @@ namespace
 
 	typedef KlayGE::uint32_t (WINAPI *CreateObjectFunc)(const GUID* clsID, const GUID* interfaceID, void** outObject);
 
+	size_t const DEFAULT_DECODED_CACHE_SIZE = 16 * 1024 * 1024;
+
 	HRESULT GetArchiveItemPath(std::shared_ptr<IInArchive> const & archive, uint32_t index, std::string& result)
 	{
 		PROPVARIANT prop;
@@ -157,7 +161,8 @@ namespace KlayGE
 	}
 
 	Package::Package(ResIdentifierPtr const & archive_is, std::string_view password)
-		: archive_is_(archive_is), password_(password)
+		: archive_is_(archive_is), password_(password),
+			decoded_size_(0), max_decoded_size_(DEFAULT_DECODED_CACHE_SIZE)
 	{
 		BOOST_ASSERT(archive_is);
 
@@ -172,6 +177,27 @@ namespace KlayGE
 		TIFHR(archive_->Open(file.get(), 0, ocb.get()));
 
 		TIFHR(archive_->GetNumberOfItems(&num_items_));
+
+		path_index_.reserve(num_items_);
+		for (uint32_t i = 0; i < num_items_; ++ i)
+		{
+			bool is_folder = true;
+			TIFHR(IsArchiveItemFolder(archive_, i, is_folder));
+			if (!is_folder)
+			{
+				std::string file_path;
+				TIFHR(GetArchiveItemPath(archive_, i, file_path));
+				std::replace(file_path.begin(), file_path.end(), '\\', '/');
+				boost::algorithm::to_lower(file_path);
+
+				// The first item with a given path wins
+				auto iter = path_index_.find(file_path);
+				if (iter == path_index_.end())
+				{
+					path_index_.emplace(std::move(file_path), this->IsExtractable(i) ? i : 0xFFFFFFFF);
+				}
+			}
+		}
 	}
 
 	bool Package::Locate(std::string_view extract_file_path)
@@ -185,75 +211,128 @@ namespace KlayGE
 		uint32_t real_index = this->Find(extract_file_path);
 		if (real_index != 0xFFFFFFFF)
 		{
-			auto decoded_file = MakeSharedPtr<std::stringstream>();
-			auto out_stream = MakeCOMPtr(new OutStream(decoded_file));
-			auto ecb = MakeCOMPtr(new ArchiveExtractCallback(password_, out_stream));
-			TIFHR(archive_->Extract(&real_index, 1, false, ecb.get()));
-
-			PROPVARIANT prop;
-			prop.vt = VT_EMPTY;
-			TIFHR(archive_->GetProperty(real_index, kpidMTime, &prop));
+			std::shared_ptr<std::vector<char>> decoded_data;
 			uint64_t mtime;
-			if (prop.vt == VT_FILETIME)
+
+			auto cached = decoded_index_.find(real_index);
+			if (cached != decoded_index_.end())
 			{
-				mtime = (static_cast<uint64_t>(prop.filetime.dwHighDateTime) << 32)
-					+ prop.filetime.dwLowDateTime;
-				mtime -= 116444736000000000ULL;
+				decoded_lru_.splice(decoded_lru_.begin(), decoded_lru_, cached->second);
+				decoded_data = cached->second->data;
+				mtime = cached->second->timestamp;
 			}
 			else
 			{
-				mtime = archive_is_->Timestamp();
+				decoded_data = MakeSharedPtr<std::vector<char>>();
+
+				PROPVARIANT prop;
+				prop.vt = VT_EMPTY;
+				TIFHR(archive_->GetProperty(real_index, kpidSize, &prop));
+				if (prop.vt == VT_UI8)
+				{
+					decoded_data->reserve(static_cast<size_t>(prop.uhVal.QuadPart));
+				}
+
+				{
+					VectorOutputStreamBuf decoded_buff(*decoded_data);
+					auto decoded_file = MakeSharedPtr<std::ostream>(&decoded_buff);
+					auto out_stream = MakeCOMPtr(new OutStream(decoded_file));
+					auto ecb = MakeCOMPtr(new ArchiveExtractCallback(password_, out_stream));
+					TIFHR(archive_->Extract(&real_index, 1, false, ecb.get()));
+				}
+
+				mtime = this->ItemTimestamp(real_index);
+				this->CacheDecoded(real_index, mtime, decoded_data);
 			}
 
-			return MakeSharedPtr<ResIdentifier>(res_name, mtime, decoded_file);
+			auto decoded_buff = MakeSharedPtr<SharedMemInputStreamBuf>(decoded_data->data(),
+				static_cast<std::streamsize>(decoded_data->size()), decoded_data);
+			return MakeSharedPtr<ResIdentifier>(res_name, mtime, MakeSharedPtr<std::istream>(decoded_buff.get()), decoded_buff);
 		}
 		return ResIdentifierPtr();
 	}
 
+	void Package::DecodedCacheSize(size_t size)
+	{
+		max_decoded_size_ = size;
+		this->TrimDecodedCache(max_decoded_size_);
+	}
+
 	uint32_t Package::Find(std::string_view extract_file_path)
 	{
-		uint32_t real_index = 0xFFFFFFFF;
+		std::string file_path(extract_file_path);
+		boost::algorithm::to_lower(file_path);
 
-		for (uint32_t i = 0; i < num_items_; ++ i)
+		auto iter = path_index_.find(file_path);
+		return (iter != path_index_.end()) ? iter->second : 0xFFFFFFFF;
+	}
+
+	bool Package::IsExtractable(uint32_t index)
+	{
+		PROPVARIANT prop;
+		prop.vt = VT_EMPTY;
+		TIFHR(archive_->GetProperty(index, kpidIsAnti, &prop));
+		if ((VT_BOOL == prop.vt) && (VARIANT_FALSE == prop.boolVal))
 		{
-			bool is_folder = true;
-			TIFHR(IsArchiveItemFolder(archive_, i, is_folder));
-			if (!is_folder)
+			prop.vt = VT_EMPTY;
+			TIFHR(archive_->GetProperty(index, kpidPosition, &prop));
+			if (prop.vt != VT_EMPTY)
 			{
-				std::string file_path;
-				TIFHR(GetArchiveItemPath(archive_, i, file_path));
-				std::replace(file_path.begin(), file_path.end(), '\\', '/');
-				if (!boost::algorithm::ilexicographical_compare(extract_file_path, file_path)
-					&& !boost::algorithm::ilexicographical_compare(file_path, extract_file_path))
+				if ((prop.vt != VT_UI8) || (prop.uhVal.QuadPart != 0))
 				{
-					real_index = i;
-					break;
+					return false;
 				}
 			}
+			return true;
 		}
-		if (real_index != 0xFFFFFFFF)
+		else
 		{
-			PROPVARIANT prop;
-			prop.vt = VT_EMPTY;
-			TIFHR(archive_->GetProperty(real_index, kpidIsAnti, &prop));
-			if ((VT_BOOL == prop.vt) && (VARIANT_FALSE == prop.boolVal))
-			{
-				prop.vt = VT_EMPTY;
-				TIFHR(archive_->GetProperty(real_index, kpidPosition, &prop));
-				if (prop.vt != VT_EMPTY)
-				{
-					if ((prop.vt != VT_UI8) || (prop.uhVal.QuadPart != 0))
-					{
-						real_index = 0xFFFFFFFF;
-					}
-				}
-			}
-			else
-			{
-				real_index = 0xFFFFFFFF;
-			}
+			return false;
+		}
+	}
+
+	uint64_t Package::ItemTimestamp(uint32_t index)
+	{
+		PROPVARIANT prop;
+		prop.vt = VT_EMPTY;
+		TIFHR(archive_->GetProperty(index, kpidMTime, &prop));
+		uint64_t mtime;
+		if (prop.vt == VT_FILETIME)
+		{
+			mtime = (static_cast<uint64_t>(prop.filetime.dwHighDateTime) << 32)
+				+ prop.filetime.dwLowDateTime;
+			mtime -= 116444736000000000ULL;
+		}
+		else
+		{
+			mtime = archive_is_->Timestamp();
+		}
+		return mtime;
+	}
+
+	// Big entries would flush everything else, and are usually read once. Only entries up to a quarter of the
+	//  budget are kept.
+	void Package::CacheDecoded(uint32_t index, uint64_t timestamp, std::shared_ptr<std::vector<char>> const & data)
+	{
+		size_t const size = data->size();
+		if ((max_decoded_size_ > 0) && (size <= max_decoded_size_ / 4))
+		{
+			this->TrimDecodedCache(max_decoded_size_ - size);
+
+			decoded_lru_.push_front(DecodedEntry{ index, timestamp, data });
+			decoded_index_.emplace(index, decoded_lru_.begin());
+			decoded_size_ += size;
 		}
+	}
 
-		return real_index;
+	void Package::TrimDecodedCache(size_t max_size)
+	{
+		while (!decoded_lru_.empty() && (decoded_size_ > max_size))
+		{
+			DecodedEntry const & entry = decoded_lru_.back();
+			decoded_size_ -= entry.data->size();
+			decoded_index_.erase(entry.index);
+			decoded_lru_.pop_back();
+		}
 	}
 }
@@ -48,6 +48,7 @@
 #include <KFL/Hash.hpp>
 #include <KlayGE/App3D.hpp>
 #include <KlayGE/Window.hpp>
+#include <KFL/JobSystem.hpp>
 
 #include <algorithm>
 #include <vector>
@@ -70,9 +71,9 @@ namespace KlayGE
 	public:
 		explicit FontRenderable(std::shared_ptr<KFont> const & kfl)
 				: RenderableHelper(L"Font"),
+					num_used_slots_(0), lru_head_(INVALID_SLOT), lru_tail_(INVALID_SLOT),
 					three_dim_(false),
-					kfont_loader_(kfl),
-					tick_(0)
+					kfont_loader_(kfl)
 		{
 			RenderFactory& rf = Context::Instance().RenderFactoryInstance();
 
@@ -94,9 +95,11 @@ namespace KlayGE
 			RenderDeviceCaps const & caps = renderEngine.DeviceCaps();
 			uint32_t size = std::min<uint32_t>(2048U, std::min<uint32_t>(caps.max_texture_width, caps.max_texture_height)) / kfont_char_size * kfont_char_size;
 			dist_texture_ = rf.MakeTexture2D(size, size, 1, 1, EF_R8, 1, 0, EAH_GPU_Read);
-			a_char_data_.resize(kfont_char_size * kfont_char_size);
+			dist_data_.resize(size * size, 0);
+			dirty_rect_ = UIRect(size, size, 0, 0);
 
-			char_free_list_.emplace_back(0, size * size / kfont_char_size / kfont_char_size);
+			GlyphSlot const empty_slot = { 0, INVALID_SLOT, INVALID_SLOT, INVALID_SLOT };
+			slots_.assign(size * size / kfont_char_size / kfont_char_size, empty_slot);
 
 			effect_ = SyncLoadRenderEffect("Font.fxml");
 			*(effect_->ParameterByName("distance_tex")) = dist_texture_;
@@ -143,6 +146,8 @@ namespace KlayGE
 				*dpi_scale_ep_ = Context::Instance().AppInstance().MainWnd()->DPIScale();
 			}
 
+			this->UploadDirtyRect();
+
 			tb_vb_->EnsureDataReady();
 			tb_ib_->EnsureDataReady();
 
@@ -191,12 +196,6 @@ namespace KlayGE
 				re.Render(*this->GetRenderEffect(), *this->GetRenderTechnique(), *rl_);
 			}
 
-			for (size_t i = 0; i < tb_vb_sub_allocs_.size(); ++ i)
-			{
-				tb_vb_->Dealloc(tb_vb_sub_allocs_[i]);
-				tb_ib_->Dealloc(tb_ib_sub_allocs_[i]);
-			}
-
 			this->OnRenderEnd();
 		}
 
@@ -530,143 +529,166 @@ namespace KlayGE
 		/////////////////////////////////////////////////////////////////////////////////
 		void UpdateTexture(std::wstring_view text)
 		{
-			++ tick_;
-
 			uint32_t const tex_size = dist_texture_->Width(0);
 
 			KFont& kl = *kfont_loader_;
 			auto& cim = char_info_map_;
 
 			uint32_t const kfont_char_size = kl.CharSize();
-
 			uint32_t const num_chars_a_row = tex_size / kfont_char_size;
-			uint32_t const num_total_chars = num_chars_a_row * num_chars_a_row;
 
+			// Hits and evictions are O(1). The misses are only recorded here, and decoded together afterwards.
+			misses_.clear();
 			for (auto const & ch : text)
 			{
-				int32_t offset = kl.CharIndex(ch);
+				int32_t const offset = kl.CharIndex(ch);
 				if (offset != -1)
 				{
 					auto cmiter = cim.find(ch);
 					if (cmiter != cim.end())
 					{
-						// ҵ
-
-						cmiter->second.tick = tick_;
+						this->UnlinkSlot(cmiter->second.slot);
+						this->LinkSlotFront(cmiter->second.slot);
 					}
 					else
 					{
-						// ҲԵ
+						uint32_t slot;
+						if (num_used_slots_ < slots_.size())
+						{
+							slot = num_used_slots_;
+							++ num_used_slots_;
+						}
+						else
+						{
+							slot = lru_tail_;
+							this->UnlinkSlot(slot);
+							cim.erase(slots_[slot].ch);
+						}
+						slots_[slot].ch = ch;
+						this->LinkSlotFront(slot);
 
 						KFont::font_info const & ci = kl.CharInfo(offset);
-
-						uint32_t width = ci.width;
-						uint32_t height = ci.height;
-
-						int2 char_pos;
-						CharInfo charInfo;
-						if (cim.size() < num_total_chars)
+						uint32_t const x = slot % num_chars_a_row * kfont_char_size;
+						uint32_t const y = slot / num_chars_a_row * kfont_char_size;
+
+						CharInfo char_info;
+						char_info.rc = Rect(static_cast<float>(x) / tex_size, static_cast<float>(y) / tex_size,
+							static_cast<float>(x + ci.width) / tex_size, static_cast<float>(y + ci.height) / tex_size);
+						char_info.slot = slot;
+						cim.emplace(ch, char_info);
+
+						// A slot is evicted twice in one text only if the text has more glyphs than the texture holds.
+						//  The last glyph wins.
+						if (slots_[slot].miss != INVALID_SLOT)
 						{
-							// пռ
-
-							uint32_t const s = char_free_list_.front().first;
-						
-							char_pos.y() = s / num_chars_a_row;
-							char_pos.x() = s - char_pos.y() * num_chars_a_row;
-
-							char_pos.x() *= kfont_char_size;
-							char_pos.y() *= kfont_char_size;
-
-							charInfo.rc.left() = static_cast<float>(char_pos.x()) / tex_size;
-							charInfo.rc.top() = static_cast<float>(char_pos.y()) / tex_size;
-
-							++ char_free_list_.front().first;
-							if (char_free_list_.front().first == char_free_list_.front().second)
-							{
-								char_free_list_.pop_front();
-							}
+							misses_[slots_[slot].miss].first = offset;
 						}
 						else
 						{
-							// ҵʹʱûʹõ
-
-							uint64_t min_tick = cim.begin()->second.tick;
-							auto min_chiter = cim.begin();
-							for (auto chiter = cim.begin(); chiter != cim.end(); ++ chiter)
-							{
-								if (chiter->second.tick < min_tick)
-								{
-									min_tick = chiter->second.tick;
-									min_chiter = chiter;
-								}
-							}
-
-							char_pos.x() = static_cast<int32_t>(min_chiter->second.rc.left() * tex_size);
-							char_pos.y() = static_cast<int32_t>(min_chiter->second.rc.top() * tex_size);
-							charInfo.rc.left() = min_chiter->second.rc.left();
-							charInfo.rc.top() = min_chiter->second.rc.top();
-
-							for (auto chiter = cim.begin(); chiter != cim.end(); ++ chiter)
-							{
-								if (chiter->second.tick == min_tick)
-								{
-									uint32_t const x = static_cast<int32_t>(chiter->second.rc.left() * tex_size);
-									uint32_t const y = static_cast<int32_t>(chiter->second.rc.top() * tex_size);
-									uint32_t const id = y * num_chars_a_row + x;
-									auto freeiter = char_free_list_.begin();
-									while ((freeiter != char_free_list_.end()) && (freeiter->second <= id))
-									{
-										++ freeiter;
-									}
-									char_free_list_.emplace(freeiter, id, id + 1);
-
-									cim.erase(chiter);
-									break;
-								}
-							}
-							for (auto freeiter = char_free_list_.begin(); freeiter != char_free_list_.end();)
-							{
-								auto nextiter = freeiter;
-								++ nextiter;
-
-								if (nextiter != char_free_list_.end())
-								{
-									if (freeiter->second == nextiter->first)
-									{
-										freeiter->second = nextiter->second;
-										char_free_list_.erase(nextiter);
-									}
-									else
-									{
-										++ freeiter;
-									}
-								}
-								else
-								{
-									break;
-								}
-							}
+							slots_[slot].miss = static_cast<uint32_t>(misses_.size());
+							misses_.emplace_back(offset, slot);
 						}
+					}
+				}
+			}
 
-						charInfo.rc.right()		= charInfo.rc.left() + static_cast<float>(width) / tex_size;
-						charInfo.rc.bottom()	= charInfo.rc.top() + static_cast<float>(height) / tex_size;
-						charInfo.tick			= tick_;
+			if (!misses_.empty())
+			{
+				// Glyphs are decoded into the CPU copy of the texture, on the job system if there are many of them.
+				//  The dirty region is uploaded once in OnRenderBegin.
+				Context::Instance().JobSystemInstance().ParallelFor(0, static_cast<uint32_t>(misses_.size()), GLYPH_DECODE_GRAIN_SIZE,
+					[this, &kl, tex_size, kfont_char_size, num_chars_a_row](uint32_t begin, uint32_t end)
+					{
+						for (uint32_t i = begin; i < end; ++ i)
+						{
+							uint32_t const slot = misses_[i].second;
+							uint32_t const x = slot % num_chars_a_row * kfont_char_size;
+							uint32_t const y = slot / num_chars_a_row * kfont_char_size;
+							kl.GetDistanceData(&dist_data_[y * tex_size + x], tex_size, misses_[i].first);
+						}
+					});
 
-						kl.GetDistanceData(&a_char_data_[0], kfont_char_size, offset);
-						dist_texture_->UpdateSubresource2D(0, 0, char_pos.x(), char_pos.y(), kfont_char_size, kfont_char_size,
-							&a_char_data_[0], kfont_char_size);
+				for (auto const & miss : misses_)
+				{
+					uint32_t const slot = miss.second;
+					uint32_t const x = slot % num_chars_a_row * kfont_char_size;
+					uint32_t const y = slot / num_chars_a_row * kfont_char_size;
+					dirty_rect_ |= UIRect(x, y, x + kfont_char_size, y + kfont_char_size);
 
-						cim.emplace(ch, charInfo);
-					}
+					slots_[slot].miss = INVALID_SLOT;
 				}
 			}
 		}
 
+		void UnlinkSlot(uint32_t slot)
+		{
+			GlyphSlot& gs = slots_[slot];
+			if (gs.prev != INVALID_SLOT)
+			{
+				slots_[gs.prev].next = gs.next;
+			}
+			else
+			{
+				lru_head_ = gs.next;
+			}
+			if (gs.next != INVALID_SLOT)
+			{
+				slots_[gs.next].prev = gs.prev;
+			}
+			else
+			{
+				lru_tail_ = gs.prev;
+			}
+			gs.prev = INVALID_SLOT;
+			gs.next = INVALID_SLOT;
+		}
+
+		void LinkSlotFront(uint32_t slot)
+		{
+			GlyphSlot& gs = slots_[slot];
+			gs.prev = INVALID_SLOT;
+			gs.next = lru_head_;
+			if (lru_head_ != INVALID_SLOT)
+			{
+				slots_[lru_head_].prev = slot;
+			}
+			else
+			{
+				lru_tail_ = slot;
+			}
+			lru_head_ = slot;
+		}
+
+		void UploadDirtyRect()
+		{
+			if (dirty_rect_.right() > dirty_rect_.left())
+			{
+				uint32_t const tex_size = dist_texture_->Width(0);
+				dist_texture_->UpdateSubresource2D(0, 0, dirty_rect_.left(), dirty_rect_.top(),
+					dirty_rect_.Width(), dirty_rect_.Height(),
+					&dist_data_[dirty_rect_.top() * tex_size + dirty_rect_.left()], tex_size);
+				dirty_rect_ = UIRect(tex_size, tex_size, 0, 0);
+			}
+		}
+
 	private:
+		static uint32_t const INVALID_SLOT = 0xFFFFFFFF;
+		static uint32_t const GLYPH_DECODE_GRAIN_SIZE = 16;
+
 		struct CharInfo
 		{
 			Rect rc;
-			uint64_t tick;
+			uint32_t slot;
+		};
+
+		// A cell of the distance texture. Cells in use form an intrusive LRU list, most recently used first.
+		struct GlyphSlot
+		{
+			wchar_t ch;
+			uint32_t prev;
+			uint32_t next;
+			// Index in misses_ while the glyph is waiting to be decoded
+			uint32_t miss;
 		};
 
 #ifdef KLAYGE_HAS_STRUCT_PACK
@@ -693,7 +715,11 @@ namespace KlayGE
 		bool restart_;
 
 		std::unordered_map<wchar_t, CharInfo> char_info_map_;
-		std::list<std::pair<uint32_t, uint32_t>> char_free_list_;
+		std::vector<GlyphSlot> slots_;
+		uint32_t num_used_slots_;
+		uint32_t lru_head_;
+		uint32_t lru_tail_;
+		std::vector<std::pair<int32_t, uint32_t>> misses_;
 
 		bool three_dim_;
 
@@ -703,15 +729,15 @@ namespace KlayGE
 		std::vector<SubAlloc> tb_ib_sub_allocs_;
 
 		TexturePtr		dist_texture_;
-		std::vector<uint8_t> a_char_data_;
+		// CPU copy of dist_texture_, and the region not uploaded yet
+		std::vector<uint8_t> dist_data_;
+		UIRect dirty_rect_;
 
 		RenderEffectParameter* half_width_height_ep_;
 		RenderEffectParameter* dpi_scale_ep_;
 		RenderEffectParameter* mvp_ep_;
 
 		std::shared_ptr<KFont> kfont_loader_;
-
-		uint64_t tick_;
 	};
 }
 
@@ -793,6 +819,13 @@ namespace
 			return false;
 		}
 
+		size_t Hash() const override
+		{
+			size_t seed = HashRange(font_desc_.res_name.begin(), font_desc_.res_name.end());
+			HashCombine(seed, font_desc_.flag);
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -918,9 +951,11 @@ namespace KlayGE
 		return ResLoader::Instance().SyncQueryT<Font>(MakeSharedPtr<FontLoadingDesc>(font_name, flags));
 	}
 
-	FontPtr ASyncLoadFont(std::string_view font_name, uint32_t flags)
+	FontPtr ASyncLoadFont(std::string_view font_name, uint32_t flags, ResLoader::LoadingPriority priority)
 	{
 		// TODO: Make it really async
+		KFL_UNUSED(priority);
+
 		return ResLoader::Instance().SyncQueryT<Font>(MakeSharedPtr<FontLoadingDesc>(font_name, flags));
 	}
 }
@@ -134,6 +134,11 @@ namespace KlayGE
 			return false;
 		}
 
+		size_t Hash() const override
+		{
+			return HashRange(imposter_desc_.res_name.begin(), imposter_desc_.res_name.end());
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -163,9 +168,9 @@ namespace KlayGE
 		return ResLoader::Instance().SyncQueryT<Imposter>(MakeSharedPtr<ImposterLoadingDesc>(tex_name));
 	}
 
-	ImposterPtr ASyncLoadImposter(std::string_view tex_name)
+	ImposterPtr ASyncLoadImposter(std::string_view tex_name, ResLoader::LoadingPriority priority)
 	{
-		return ResLoader::Instance().ASyncQueryT<Imposter>(MakeSharedPtr<ImposterLoadingDesc>(tex_name));
+		return ResLoader::Instance().ASyncQueryT<Imposter>(MakeSharedPtr<ImposterLoadingDesc>(tex_name), priority);
 	}
 
 
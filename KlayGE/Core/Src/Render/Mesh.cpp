@@ -36,6 +36,8 @@
 #include <KlayGE/RenderMaterial.hpp>
 #include <KlayGE/ToolCommonLoader.hpp>
 #include <KFL/Hash.hpp>
+#include <KFL/JobSystem.hpp>
+#include <KFL/SIMDMath.hpp>
 #include <KlayGE/DeferredRenderingLayer.hpp>
 
 #include <algorithm>
@@ -49,7 +51,140 @@ namespace
 {
 	using namespace KlayGE;
 
-	uint32_t const MODEL_BIN_VERSION = 15;
+	uint32_t const MODEL_BIN_VERSION = 17;
+	// Oldest version LoadSoftwareModel still reads. v15 stores joints and key frames per element instead of in SoA
+	//  sections, and v16 has no quantized key frames. Dev platforms rebuild older files anyway.
+	uint32_t const MODEL_BIN_MIN_VERSION = 15;
+
+	// Bulk sections of the model body (joint and key frame arrays) start on 16 byte boundaries, relative to
+	//  the start of the body.
+	uint32_t const MODEL_BIN_SECTION_ALIGNMENT = 16;
+
+	void WriteSectionPadding(std::ostream& os)
+	{
+		static char const zeros[MODEL_BIN_SECTION_ALIGNMENT] = {};
+		uint32_t const pos = static_cast<uint32_t>(os.tellp());
+		uint32_t const aligned_pos = (pos + MODEL_BIN_SECTION_ALIGNMENT - 1) & ~(MODEL_BIN_SECTION_ALIGNMENT - 1);
+		os.write(zeros, aligned_pos - pos);
+	}
+
+	void SkipSectionPadding(ResIdentifierPtr const & res)
+	{
+		uint32_t const pos = static_cast<uint32_t>(res->tellg());
+		uint32_t const aligned_pos = (pos + MODEL_BIN_SECTION_ALIGNMENT - 1) & ~(MODEL_BIN_SECTION_ALIGNMENT - 1);
+		res->seekg(aligned_pos - pos, std::ios_base::cur);
+	}
+
+	// Arrays of 2-byte and 4-byte scalars (uint16_t, uint32_t, float, or structs of floats) are stored as little endian. On little endian
+	//  hosts they are read and written in one call, without per-element conversion.
+	template <typename T>
+	void ReadLEArray(ResIdentifierPtr const & res, T* data, size_t num_scalars)
+	{
+		static_assert((sizeof(T) == 2) || (sizeof(T) == 4), "Only 2-byte and 4-byte scalars are supported.");
+
+		res->read(data, num_scalars * sizeof(T));
+		KLAYGE_IF_CONSTEXPR (std::endian::native == std::endian::big)
+		{
+			for (size_t i = 0; i < num_scalars; ++ i)
+			{
+				data[i] = LE2Native(data[i]);
+			}
+		}
+	}
+
+	template <typename T>
+	void WriteLEArray(std::ostream& os, T const * data, size_t num_scalars)
+	{
+		static_assert((sizeof(T) == 2) || (sizeof(T) == 4), "Only 2-byte and 4-byte scalars are supported.");
+
+		KLAYGE_IF_CONSTEXPR (std::endian::native == std::endian::little)
+		{
+			os.write(reinterpret_cast<char const *>(data), num_scalars * sizeof(T));
+		}
+		else
+		{
+			for (size_t i = 0; i < num_scalars; ++ i)
+			{
+				T const v = Native2LE(data[i]);
+				os.write(reinterpret_cast<char const *>(&v), sizeof(v));
+			}
+		}
+	}
+
+	// Same as std::upper_bound(frame_id.begin(), frame_id.end(), frame) - frame_id.begin(). Playback mostly moves forward
+	//  by less than a key, so hint and the index after it are checked before falling back to a binary search.
+	uint32_t UpperBoundKey(std::vector<uint32_t> const & frame_id, float frame, uint32_t hint)
+	{
+		uint32_t const num_keys = static_cast<uint32_t>(frame_id.size());
+		for (uint32_t index = hint; (index <= num_keys) && (index <= hint + 1); ++ index)
+		{
+			if (((0 == index) || !(frame < frame_id[index - 1])) && ((num_keys == index) || (frame < frame_id[index])))
+			{
+				return index;
+			}
+		}
+
+		return static_cast<uint32_t>(std::upper_bound(frame_id.begin(), frame_id.end(), frame) - frame_id.begin());
+	}
+
+	uint16_t QuantizeUNorm16(float v)
+	{
+		return static_cast<uint16_t>(MathLib::clamp(v, 0.0f, 1.0f) * 65535 + 0.5f);
+	}
+
+	float DequantizeUNorm16(uint16_t v)
+	{
+		return v / 65535.0f;
+	}
+
+	// Smallest three: the largest component is dropped and recovered from the unit length. The other three are
+	//  in [-1/sqrt(2), 1/sqrt(2)] and take 15 bits each. The index of the dropped one takes the remaining top bits.
+	//  q and -q are the same rotation, so the dropped component is made positive.
+	void PackSmallestThree(uint16_t* packed, Quaternion const & quat)
+	{
+		uint32_t largest = 0;
+		for (uint32_t i = 1; i < 4; ++ i)
+		{
+			if (MathLib::abs(quat[i]) > MathLib::abs(quat[largest]))
+			{
+				largest = i;
+			}
+		}
+		float const sign = (quat[largest] < 0) ? -1.0f : 1.0f;
+
+		uint32_t c = 0;
+		for (uint32_t i = 0; i < 4; ++ i)
+		{
+			if (i != largest)
+			{
+				float const v = MathLib::clamp(quat[i] * sign / SQRT_2 * 0.5f + 0.5f, 0.0f, 1.0f);
+				packed[c] = static_cast<uint16_t>(v * 32767 + 0.5f);
+				++ c;
+			}
+		}
+		packed[0] |= static_cast<uint16_t>((largest & 1) << 15);
+		packed[1] |= static_cast<uint16_t>((largest >> 1) << 15);
+	}
+
+	Quaternion UnpackSmallestThree(uint16_t const * packed)
+	{
+		uint32_t const largest = (packed[0] >> 15) | ((packed[1] >> 15) << 1);
+
+		Quaternion quat;
+		float sum_sq = 0;
+		uint32_t c = 0;
+		for (uint32_t i = 0; i < 4; ++ i)
+		{
+			if (i != largest)
+			{
+				quat[i] = ((packed[c] & 0x7FFF) / 32767.0f * 2 - 1) * SQRT_2;
+				sum_sq += quat[i] * quat[i];
+				++ c;
+			}
+		}
+		quat[largest] = MathLib::sqrt(std::max(1 - sum_sq, 0.0f));
+		return quat;
+	}
 
 	class RenderModelLoadingDesc : public ResLoadingDesc
 	{
@@ -138,6 +273,13 @@ namespace
 			return false;
 		}
 
+		size_t Hash() const override
+		{
+			size_t seed = HashRange(model_desc_.res_name.begin(), model_desc_.res_name.end());
+			HashCombine(seed, model_desc_.access_hint);
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -727,49 +869,170 @@ namespace KlayGE
 	}
 
 
+	void KeyFrameSet::Quantize()
+	{
+		if (this->Quantized() || frame_id.empty())
+		{
+			return;
+		}
+
+		uint32_t const num_keys = static_cast<uint32_t>(frame_id.size());
+
+		std::vector<float3> trans(num_keys);
+		for (uint32_t i = 0; i < num_keys; ++ i)
+		{
+			trans[i] = MathLib::udq_to_trans(bind_real[i], bind_dual[i]);
+		}
+
+		trans_min = trans[0];
+		float3 trans_max = trans[0];
+		scale_min = bind_scale[0];
+		float scale_max = bind_scale[0];
+		for (uint32_t i = 1; i < num_keys; ++ i)
+		{
+			trans_min = MathLib::minimize(trans_min, trans[i]);
+			trans_max = MathLib::maximize(trans_max, trans[i]);
+			scale_min = std::min(scale_min, bind_scale[i]);
+			scale_max = std::max(scale_max, bind_scale[i]);
+		}
+		trans_extent = trans_max - trans_min;
+		scale_extent = scale_max - scale_min;
+
+		quantized_keys.resize(num_keys * QUANTIZED_KEY_SIZE);
+		for (uint32_t i = 0; i < num_keys; ++ i)
+		{
+			uint16_t* key = &quantized_keys[i * QUANTIZED_KEY_SIZE];
+			PackSmallestThree(key, MathLib::normalize(bind_real[i]));
+			for (uint32_t c = 0; c < 3; ++ c)
+			{
+				key[3 + c] = QuantizeUNorm16((trans_extent[c] > 0) ? (trans[i][c] - trans_min[c]) / trans_extent[c] : 0);
+			}
+			key[6] = QuantizeUNorm16((scale_extent > 0) ? (bind_scale[i] - scale_min) / scale_extent : 0);
+		}
+
+		std::vector<Quaternion>().swap(bind_real);
+		std::vector<Quaternion>().swap(bind_dual);
+		std::vector<float>().swap(bind_scale);
+	}
+
+	void KeyFrameSet::Dequantize()
+	{
+		if (!this->Quantized())
+		{
+			return;
+		}
+
+		uint32_t const num_keys = static_cast<uint32_t>(frame_id.size());
+		bind_real.resize(num_keys);
+		bind_dual.resize(num_keys);
+		bind_scale.resize(num_keys);
+		for (uint32_t i = 0; i < num_keys; ++ i)
+		{
+			this->Key(i, bind_real[i], bind_dual[i], bind_scale[i]);
+		}
+
+		std::vector<uint16_t>().swap(quantized_keys);
+	}
+
+	void KeyFrameSet::Key(uint32_t index, Quaternion& real, Quaternion& dual, float& scale) const
+	{
+		if (this->Quantized())
+		{
+			uint16_t const * key = &quantized_keys[index * QUANTIZED_KEY_SIZE];
+			real = UnpackSmallestThree(key);
+			float3 const trans(trans_min.x() + DequantizeUNorm16(key[3]) * trans_extent.x(),
+				trans_min.y() + DequantizeUNorm16(key[4]) * trans_extent.y(),
+				trans_min.z() + DequantizeUNorm16(key[5]) * trans_extent.z());
+			dual = MathLib::quat_trans_to_udq(real, trans);
+			scale = scale_min + DequantizeUNorm16(key[6]) * scale_extent;
+		}
+		else
+		{
+			real = bind_real[index];
+			dual = bind_dual[index];
+			scale = bind_scale[index];
+		}
+	}
+
 	std::tuple<Quaternion, Quaternion, float> KeyFrameSet::Frame(float frame) const
 	{
 		std::tuple<Quaternion, Quaternion, float> ret;
 		if (frame_id.size() == 1)
 		{
-			ret = std::make_tuple(bind_real[0], bind_dual[0], bind_scale[0]);
+			this->Key(0, std::get<0>(ret), std::get<1>(ret), std::get<2>(ret));
+		}
+		else
+		{
+			uint32_t index0, index1;
+			float factor;
+			this->FrameKeys(frame, index0, index1, factor);
+
+			Quaternion real0, dual0, real1, dual1;
+			float scale0, scale1;
+			this->Key(index0, real0, dual0, scale0);
+			this->Key(index1, real1, dual1, scale1);
+			auto dq = MathLib::sclerp(real0, dual0, real1, dual1, factor);
+			ret = std::make_tuple(dq.first, dq.second, MathLib::lerp(scale0, scale1, factor));
+		}
+		return ret;
+	}
+
+	void KeyFrameSet::FrameKeys(float frame, uint32_t& key0, uint32_t& key1, float& factor) const
+	{
+		uint32_t cursor = 0;
+		this->FrameKeys(frame, cursor, key0, key1, factor);
+	}
+
+	void KeyFrameSet::FrameKeys(float frame, uint32_t& cursor, uint32_t& key0, uint32_t& key1, float& factor) const
+	{
+		if (frame_id.size() == 1)
+		{
+			key0 = 0;
+			key1 = 0;
+			factor = 0;
 		}
 		else
 		{
 			frame = std::fmod(frame, static_cast<float>(frame_id.back() + 1));
 
-			auto iter = std::upper_bound(frame_id.begin(), frame_id.end(), frame);
-			int index = static_cast<int>(iter - frame_id.begin());
+			uint32_t const index = UpperBoundKey(frame_id, frame, cursor + 1);
 
-			int index0 = index - 1;
-			int index1 = index % frame_id.size();
+			uint32_t const index0 = std::max(index, 1U) - 1;
+			uint32_t const index1 = index % frame_id.size();
 			int frame0 = frame_id[index0];
 			int frame1 = frame_id[index1];
-			float factor = (frame - frame0) / (frame1 - frame0);
-			auto dq = MathLib::sclerp(bind_real[index0], bind_dual[index0], bind_real[index1], bind_dual[index1], factor);
-			ret = std::make_tuple(dq.first, dq.second, MathLib::lerp(bind_scale[index0], bind_scale[index1], factor));
+			key0 = index0;
+			key1 = index1;
+			factor = (frame - frame0) / (frame1 - frame0);
 		}
-		return ret;
+		cursor = key0;
 	}
 
 	AABBox AABBKeyFrameSet::Frame(float frame) const
+	{
+		uint32_t cursor = 0;
+		return this->Frame(frame, cursor);
+	}
+
+	AABBox AABBKeyFrameSet::Frame(float frame, uint32_t& cursor) const
 	{
 		if (frame_id.size() == 1)
 		{
+			cursor = 0;
 			return bb[0];
 		}
 		else
 		{
 			frame = std::fmod(frame, static_cast<float>(frame_id.back() + 1));
 
-			auto iter = std::upper_bound(frame_id.begin(), frame_id.end(), frame);
-			int index = static_cast<int>(iter - frame_id.begin());
+			uint32_t const index = UpperBoundKey(frame_id, frame, cursor + 1);
 
-			int index0 = index - 1;
-			int index1 = index % frame_id.size();
+			uint32_t const index0 = std::max(index, 1U) - 1;
+			uint32_t const index1 = index % frame_id.size();
 			int frame0 = frame_id[index0];
 			int frame1 = frame_id[index1];
 			float factor = (frame - frame0) / (frame1 - frame0);
+			cursor = index0;
 			return AABBox(MathLib::lerp(bb[index0].Min(), bb[index1].Min(), factor),
 				MathLib::lerp(bb[index0].Max(), bb[index1].Max(), factor));
 		}
@@ -778,6 +1041,7 @@ namespace KlayGE
 
 	SkinnedModel::SkinnedModel(std::wstring const & name)
 		: RenderModel(name),
+			prepared_frame_(-1), frame_prepared_(false),
 			last_frame_(-1),
 			num_frames_(0), frame_rate_(0)
 	{
@@ -785,12 +1049,20 @@ namespace KlayGE
 	
 	void SkinnedModel::BuildBones(float frame)
 	{
-		for (size_t i = 0; i < joints_.size(); ++ i)
+		if (joint_order_.size() != joints_.size())
+		{
+			this->UpdateJointOrder();
+		}
+
+		this->SampleLocalPoses(frame);
+
+		// Parents are resolved before their children, whatever the order of joints_ is
+		for (auto const i : joint_order_)
 		{
 			Joint& joint = joints_[i];
-			KeyFrameSet const & kf = (*key_frame_sets_)[i];
 
-			std::tuple<Quaternion, Quaternion, float> key_dq = kf.Frame(frame);
+			std::tuple<Quaternion, Quaternion, float> key_dq
+				= std::make_tuple(local_reals_[i], local_duals_[i], local_scales_[i]);
 
 			if (joint.parent != -1)
 			{
@@ -848,14 +1120,104 @@ namespace KlayGE
 				joint.bind_scale = std::get<2>(key_dq);
 			}
 		}
+	}
 
-		this->UpdateBinds();
+	void SkinnedModel::UpdateJointOrder()
+	{
+		uint32_t const num_joints = static_cast<uint32_t>(joints_.size());
+
+		std::vector<uint32_t> depths(num_joints);
+		for (uint32_t i = 0; i < num_joints; ++ i)
+		{
+			uint32_t depth = 0;
+			for (int16_t parent = joints_[i].parent; parent != -1; parent = joints_[parent].parent)
+			{
+				++ depth;
+				BOOST_ASSERT(depth <= num_joints);
+			}
+			depths[i] = depth;
+		}
+
+		joint_order_.resize(num_joints);
+		for (uint32_t i = 0; i < num_joints; ++ i)
+		{
+			joint_order_[i] = static_cast<uint16_t>(i);
+		}
+		std::stable_sort(joint_order_.begin(), joint_order_.end(),
+			[&depths](uint16_t lhs, uint16_t rhs)
+			{
+				return depths[lhs] < depths[rhs];
+			});
+	}
+
+	// Samples the key frames of every joint. The joints between two keys are gathered into SoA arrays and blended
+	//  together with SIMD.
+	void SkinnedModel::SampleLocalPoses(float frame)
+	{
+		uint32_t const num_joints = static_cast<uint32_t>(joints_.size());
+		local_reals_.resize(num_joints);
+		local_duals_.resize(num_joints);
+		local_scales_.resize(num_joints);
+		key_cursors_.resize(num_joints, 0);
+		blend_joints_.clear();
+		blend_factors_.clear();
+
+		blend_from_.Resize(num_joints);
+		blend_to_.Resize(num_joints);
+		uint32_t num_blends = 0;
+		for (uint32_t i = 0; i < num_joints; ++ i)
+		{
+			KeyFrameSet const & kf = (*key_frame_sets_)[i];
+
+			uint32_t key0, key1;
+			float factor;
+			kf.FrameKeys(frame, key_cursors_[i], key0, key1, factor);
+
+			Quaternion real0, dual0;
+			float scale0;
+			kf.Key(key0, real0, dual0, scale0);
+			if (key0 == key1)
+			{
+				local_reals_[i] = real0;
+				local_duals_[i] = dual0;
+				local_scales_[i] = scale0;
+			}
+			else
+			{
+				Quaternion real1, dual1;
+				float scale1;
+				kf.Key(key1, real1, dual1, scale1);
+
+				local_scales_[i] = MathLib::lerp(scale0, scale1, factor);
+				blend_from_.Set(num_blends, real0, dual0);
+				blend_to_.Set(num_blends, real1, dual1);
+				blend_joints_.push_back(i);
+				blend_factors_.push_back(factor);
+				++ num_blends;
+			}
+		}
+		blend_from_.Resize(num_blends);
+		blend_to_.Resize(num_blends);
+
+		SIMDMathLib::Sclerp(blend_result_, blend_from_, blend_to_, blend_factors_.data());
+
+		for (uint32_t i = 0; i < num_blends; ++ i)
+		{
+			uint32_t const joint = blend_joints_[i];
+			local_reals_[joint] = blend_result_.GetReal(i);
+			local_duals_[joint] = blend_result_.GetDual(i);
+		}
 	}
 
 	void SkinnedModel::UpdateBinds()
 	{
-		bind_reals_.resize(joints_.size());
-		bind_duals_.resize(joints_.size());
+		this->UpdateBinds(bind_reals_, bind_duals_);
+	}
+
+	void SkinnedModel::UpdateBinds(std::vector<float4>& bind_reals, std::vector<float4>& bind_duals) const
+	{
+		bind_reals.resize(joints_.size());
+		bind_duals.resize(joints_.size());
 		for (size_t i = 0; i < joints_.size(); ++ i)
 		{
 			Joint const & joint = joints_[i];
@@ -912,8 +1274,8 @@ namespace KlayGE
 				}
 			}
 
-			bind_reals_[i] = float4(bind_real.x(), bind_real.y(), bind_real.z(), bind_real.w()) * bind_scale;
-			bind_duals_[i] = float4(bind_dual.x(), bind_dual.y(), bind_dual.z(), bind_dual.w());
+			bind_reals[i] = float4(bind_real.x(), bind_real.y(), bind_real.z(), bind_real.w()) * bind_scale;
+			bind_duals[i] = float4(bind_dual.x(), bind_dual.y(), bind_dual.z(), bind_dual.w());
 		}
 	}
 
@@ -929,12 +1291,53 @@ namespace KlayGE
 			last_frame_ = frame;
 
 			this->BuildBones(frame);
+			this->UpdateBinds();
+		}
+	}
+
+	void SkinnedModel::SetFrames(ArrayRef<SkinnedModel*> models, ArrayRef<float> frames)
+	{
+		BOOST_ASSERT(models.size() == frames.size());
+
+		// Each model only touches its own joints and scratch arrays, so the models are independent
+		Context::Instance().JobSystemInstance().ParallelFor(0, static_cast<uint32_t>(models.size()), 0,
+			[models, frames](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++ i)
+				{
+					models[i]->SetFrame(frames[i]);
+				}
+			});
+	}
+
+	void SkinnedModel::PrepareFrame(float frame)
+	{
+		this->BuildBones(frame);
+		this->UpdateBinds(next_bind_reals_, next_bind_duals_);
+
+		std::lock_guard<std::mutex> lock(prepared_mutex_);
+		prepared_bind_reals_.swap(next_bind_reals_);
+		prepared_bind_duals_.swap(next_bind_duals_);
+		prepared_frame_ = frame;
+		frame_prepared_ = true;
+	}
+
+	void SkinnedModel::CommitFrame()
+	{
+		std::lock_guard<std::mutex> lock(prepared_mutex_);
+		if (frame_prepared_)
+		{
+			bind_reals_.swap(prepared_bind_reals_);
+			bind_duals_.swap(prepared_bind_duals_);
+			last_frame_ = prepared_frame_;
+			frame_prepared_ = false;
 		}
 	}
 
 	void SkinnedModel::RebindJoints()
 	{
 		this->BuildBones(last_frame_);
+		this->UpdateBinds();
 	}
 
 	void SkinnedModel::UnbindJoints()
@@ -989,19 +1392,23 @@ namespace KlayGE
 
 
 	SkinnedMesh::SkinnedMesh(RenderModelPtr const & model, std::wstring const & name)
-		: StaticMesh(model, name)
+		: StaticMesh(model, name), frame_pos_cursor_(0)
 	{
 	}
 
 	AABBox SkinnedMesh::FramePosBound(uint32_t frame) const
 	{
 		BOOST_ASSERT(frame_pos_aabbs_);
-		return frame_pos_aabbs_->Frame(static_cast<float>(frame));
+		uint32_t cursor = frame_pos_cursor_.load(std::memory_order_relaxed);
+		AABBox const ret = frame_pos_aabbs_->Frame(static_cast<float>(frame), cursor);
+		frame_pos_cursor_.store(cursor, std::memory_order_relaxed);
+		return ret;
 	}
 	
 	void SkinnedMesh::AttachFramePosBounds(std::shared_ptr<AABBKeyFrameSet> const & frame_pos_aabbs)
 	{
 		frame_pos_aabbs_ = frame_pos_aabbs;
+		frame_pos_cursor_.store(0, std::memory_order_relaxed);
 	}
 
 
@@ -1026,10 +1433,16 @@ namespace KlayGE
 			uint32_t ver;
 			runtime_file->read(&ver, sizeof(ver));
 			ver = LE2Native(ver);
-			if ((fourcc != MakeFourCC<'K', 'L', 'M', ' '>::value) || (ver != MODEL_BIN_VERSION))
+			if ((fourcc != MakeFourCC<'K', 'L', 'M', ' '>::value) || (ver < MODEL_BIN_MIN_VERSION) || (ver > MODEL_BIN_VERSION))
+			{
+				jit = true;
+			}
+#if KLAYGE_IS_DEV_PLATFORM
+			else if (ver != MODEL_BIN_VERSION)
 			{
 				jit = true;
 			}
+#endif
 			else
 			{
 				uint64_t const runtime_file_timestamp = runtime_file->Timestamp();
@@ -1069,13 +1482,14 @@ namespace KlayGE
 
 	RenderModelPtr ASyncLoadModel(std::string_view model_name, uint32_t access_hint,
 		std::function<RenderModelPtr(std::wstring const &)> CreateModelFactoryFunc,
-		std::function<StaticMeshPtr(RenderModelPtr const &, std::wstring const &)> CreateMeshFactoryFunc)
+		std::function<StaticMeshPtr(RenderModelPtr const &, std::wstring const &)> CreateMeshFactoryFunc,
+		ResLoader::LoadingPriority priority)
 	{
 		BOOST_ASSERT(CreateModelFactoryFunc);
 		BOOST_ASSERT(CreateMeshFactoryFunc);
 
 		return ResLoader::Instance().ASyncQueryT<RenderModel>(MakeSharedPtr<RenderModelLoadingDesc>(model_name,
-			access_hint, CreateModelFactoryFunc, CreateMeshFactoryFunc));
+			access_hint, CreateModelFactoryFunc, CreateMeshFactoryFunc), priority);
 	}
 
 	RenderModelPtr LoadSoftwareModel(std::string_view model_name)
@@ -1123,9 +1537,7 @@ namespace KlayGE
 		uint32_t ver;
 		runtime_file->read(&ver, sizeof(ver));
 		ver = LE2Native(ver);
-		BOOST_ASSERT(MODEL_BIN_VERSION == ver);
-
-		std::shared_ptr<std::stringstream> ss = MakeSharedPtr<std::stringstream>();
+		BOOST_ASSERT((ver >= MODEL_BIN_MIN_VERSION) && (ver <= MODEL_BIN_VERSION));
 
 		uint64_t original_len, len;
 		runtime_file->read(&original_len, sizeof(original_len));
@@ -1133,10 +1545,10 @@ namespace KlayGE
 		runtime_file->read(&len, sizeof(len));
 		len = LE2Native(len);
 
+		// Bodies written by EncodeChunked are decoded in parallel while being parsed. Plain LZMA bodies, which v15
+		//  files have, are decoded up front.
 		LZMACodec lzma;
-		lzma.Decode(*ss, runtime_file, len, original_len);
-
-		ResIdentifierPtr decoded = MakeSharedPtr<ResIdentifier>(runtime_file->ResName(), runtime_file->Timestamp(), ss);
+		ResIdentifierPtr decoded = lzma.DecodeIncremental(runtime_file, len, original_len);
 
 		uint32_t num_mtls;
 		decoded->read(&num_mtls, sizeof(num_mtls));
@@ -1318,6 +1730,8 @@ namespace KlayGE
 		}
 
 		joints.resize(num_joints);
+		std::vector<Quaternion> joint_bind_reals(num_joints);
+		std::vector<Quaternion> joint_bind_duals(num_joints);
 		for (uint32_t joint_index = 0; joint_index < num_joints; ++ joint_index)
 		{
 			Joint& joint = joints[joint_index];
@@ -1326,16 +1740,26 @@ namespace KlayGE
 			decoded->read(&joint.parent, sizeof(joint.parent));
 			joint.parent = LE2Native(joint.parent);
 
-			decoded->read(&joint.bind_real, sizeof(joint.bind_real));
-			joint.bind_real[0] = LE2Native(joint.bind_real[0]);
-			joint.bind_real[1] = LE2Native(joint.bind_real[1]);
-			joint.bind_real[2] = LE2Native(joint.bind_real[2]);
-			joint.bind_real[3] = LE2Native(joint.bind_real[3]);
-			decoded->read(&joint.bind_dual, sizeof(joint.bind_dual));
-			joint.bind_dual[0] = LE2Native(joint.bind_dual[0]);
-			joint.bind_dual[1] = LE2Native(joint.bind_dual[1]);
-			joint.bind_dual[2] = LE2Native(joint.bind_dual[2]);
-			joint.bind_dual[3] = LE2Native(joint.bind_dual[3]);
+			if (ver < 16)
+			{
+				ReadLEArray(decoded, reinterpret_cast<float*>(&joint_bind_reals[joint_index]), 4);
+				ReadLEArray(decoded, reinterpret_cast<float*>(&joint_bind_duals[joint_index]), 4);
+			}
+		}
+
+		if ((ver >= 16) && (num_joints > 0))
+		{
+			SkipSectionPadding(decoded);
+			ReadLEArray(decoded, reinterpret_cast<float*>(joint_bind_reals.data()), num_joints * 4);
+			ReadLEArray(decoded, reinterpret_cast<float*>(joint_bind_duals.data()), num_joints * 4);
+		}
+
+		for (uint32_t joint_index = 0; joint_index < num_joints; ++ joint_index)
+		{
+			Joint& joint = joints[joint_index];
+
+			joint.bind_real = joint_bind_reals[joint_index];
+			joint.bind_dual = joint_bind_duals[joint_index];
 
 			float flip = MathLib::SignBit(joint.bind_real.w());
 
@@ -1378,76 +1802,171 @@ namespace KlayGE
 			num_frames = LE2Native(num_frames);
 			decoded->read(&frame_rate, sizeof(frame_rate));
 			frame_rate = LE2Native(frame_rate);
+			uint32_t quantized_kfs = 0;
+			if (ver >= 17)
+			{
+				decoded->read(&quantized_kfs, sizeof(quantized_kfs));
+				quantized_kfs = LE2Native(quantized_kfs);
+			}
 
 			kfs = MakeSharedPtr<std::vector<KeyFrameSet>>(joints.size());
-			for (uint32_t kf_index = 0; kf_index < num_kfs; ++ kf_index)
+			std::vector<KeyFrameSet> orphan_kfs(num_kfs > num_joints ? num_kfs - num_joints : 0);
+			auto kf_set = [&kfs, &orphan_kfs, num_joints](uint32_t kf_index) -> KeyFrameSet&
 			{
-				uint32_t joint_index = kf_index;
+				return (kf_index < num_joints) ? (*kfs)[kf_index] : orphan_kfs[kf_index - num_joints];
+			};
 
-				uint32_t num_kf;
-				decoded->read(&num_kf, sizeof(num_kf));
-				num_kf = LE2Native(num_kf);
+			if (ver >= 16)
+			{
+				// Key frames are stored as SoA sections: the counts of all sets, then all frame ids, all reals, all duals,
+				//  and all scales. The writer already normalized the reals and folded the flip into the scales,
+				//  so they are used as they are.
+				//  Quantized key frames have the ranges of all sets, and all quantized keys, instead of reals, duals and scales.
+				std::vector<uint32_t> num_kfs_per_set(num_kfs);
+				ReadLEArray(decoded, num_kfs_per_set.data(), num_kfs);
+
+				for (uint32_t kf_index = 0; kf_index < num_kfs; ++ kf_index)
+				{
+					KeyFrameSet& kf = kf_set(kf_index);
+					uint32_t const num_kf = num_kfs_per_set[kf_index];
+					kf.frame_id.resize(num_kf);
+					if (quantized_kfs)
+					{
+						kf.quantized_keys.resize(num_kf * KeyFrameSet::QUANTIZED_KEY_SIZE);
+					}
+					else
+					{
+						kf.bind_real.resize(num_kf);
+						kf.bind_dual.resize(num_kf);
+						kf.bind_scale.resize(num_kf);
+					}
+				}
 
-				KeyFrameSet kf;
-				kf.frame_id.resize(num_kf);
-				kf.bind_real.resize(num_kf);
-				kf.bind_dual.resize(num_kf);
-				kf.bind_scale.resize(num_kf);
-				for (uint32_t k_index = 0; k_index < num_kf; ++ k_index)
+				SkipSectionPadding(decoded);
+				for (uint32_t kf_index = 0; kf_index < num_kfs; ++ kf_index)
 				{
-					decoded->read(&kf.frame_id[k_index], sizeof(kf.frame_id[k_index]));
-					kf.frame_id[k_index] = LE2Native(kf.frame_id[k_index]);
-					decoded->read(&kf.bind_real[k_index], sizeof(kf.bind_real[k_index]));
-					kf.bind_real[k_index][0] = LE2Native(kf.bind_real[k_index][0]);
-					kf.bind_real[k_index][1] = LE2Native(kf.bind_real[k_index][1]);
-					kf.bind_real[k_index][2] = LE2Native(kf.bind_real[k_index][2]);
-					kf.bind_real[k_index][3] = LE2Native(kf.bind_real[k_index][3]);
-					decoded->read(&kf.bind_dual[k_index], sizeof(kf.bind_dual[k_index]));
-					kf.bind_dual[k_index][0] = LE2Native(kf.bind_dual[k_index][0]);
-					kf.bind_dual[k_index][1] = LE2Native(kf.bind_dual[k_index][1]);
-					kf.bind_dual[k_index][2] = LE2Native(kf.bind_dual[k_index][2]);
-					kf.bind_dual[k_index][3] = LE2Native(kf.bind_dual[k_index][3]);
-
-					float flip = MathLib::SignBit(kf.bind_real[k_index].w());
-
-					kf.bind_scale[k_index] = MathLib::length(kf.bind_real[k_index]);
-					kf.bind_real[k_index] /= kf.bind_scale[k_index];
-
-					kf.bind_scale[k_index] *= flip;
+					KeyFrameSet& kf = kf_set(kf_index);
+					ReadLEArray(decoded, kf.frame_id.data(), kf.frame_id.size());
 				}
+				SkipSectionPadding(decoded);
+				if (quantized_kfs)
+				{
+					for (uint32_t kf_index = 0; kf_index < num_kfs; ++ kf_index)
+					{
+						KeyFrameSet& kf = kf_set(kf_index);
+						float ranges[8];
+						ReadLEArray(decoded, ranges, std::size(ranges));
+						kf.trans_min = float3(ranges[0], ranges[1], ranges[2]);
+						kf.trans_extent = float3(ranges[3], ranges[4], ranges[5]);
+						kf.scale_min = ranges[6];
+						kf.scale_extent = ranges[7];
+					}
+					for (uint32_t kf_index = 0; kf_index < num_kfs; ++ kf_index)
+					{
+						KeyFrameSet& kf = kf_set(kf_index);
+						ReadLEArray(decoded, kf.quantized_keys.data(), kf.quantized_keys.size());
+					}
+					SkipSectionPadding(decoded);
+				}
+				else
+				{
+					for (uint32_t kf_index = 0; kf_index < num_kfs; ++ kf_index)
+					{
+						KeyFrameSet& kf = kf_set(kf_index);
+						ReadLEArray(decoded, reinterpret_cast<float*>(kf.bind_real.data()), kf.bind_real.size() * 4);
+					}
+					for (uint32_t kf_index = 0; kf_index < num_kfs; ++ kf_index)
+					{
+						KeyFrameSet& kf = kf_set(kf_index);
+						ReadLEArray(decoded, reinterpret_cast<float*>(kf.bind_dual.data()), kf.bind_dual.size() * 4);
+					}
+					for (uint32_t kf_index = 0; kf_index < num_kfs; ++ kf_index)
+					{
+						KeyFrameSet& kf = kf_set(kf_index);
+						ReadLEArray(decoded, kf.bind_scale.data(), kf.bind_scale.size());
+					}
+				}
+
+				std::vector<uint32_t> num_bb_kfs_per_mesh(num_meshes);
+				ReadLEArray(decoded, num_bb_kfs_per_mesh.data(), num_meshes);
 
-				if (joint_index < num_joints)
+				frame_pos_bbs.resize(num_meshes);
+				for (uint32_t mesh_index = 0; mesh_index < num_meshes; ++ mesh_index)
 				{
-					(*kfs)[joint_index] = kf;
+					frame_pos_bbs[mesh_index] = MakeSharedPtr<AABBKeyFrameSet>();
+					frame_pos_bbs[mesh_index]->frame_id.resize(num_bb_kfs_per_mesh[mesh_index]);
+					frame_pos_bbs[mesh_index]->bb.resize(num_bb_kfs_per_mesh[mesh_index]);
 				}
-			}
 
-			frame_pos_bbs.resize(num_meshes);
-			for (uint32_t mesh_index = 0; mesh_index < num_meshes; ++ mesh_index)
+				SkipSectionPadding(decoded);
+				for (uint32_t mesh_index = 0; mesh_index < num_meshes; ++ mesh_index)
+				{
+					auto& bb_kf = *frame_pos_bbs[mesh_index];
+					ReadLEArray(decoded, bb_kf.frame_id.data(), bb_kf.frame_id.size());
+				}
+				SkipSectionPadding(decoded);
+				std::vector<float3> bb_min_max;
+				for (uint32_t mesh_index = 0; mesh_index < num_meshes; ++ mesh_index)
+				{
+					auto& bb_kf = *frame_pos_bbs[mesh_index];
+					bb_min_max.resize(bb_kf.bb.size() * 2);
+					ReadLEArray(decoded, reinterpret_cast<float*>(bb_min_max.data()), bb_min_max.size() * 3);
+					for (size_t bb_k_index = 0; bb_k_index < bb_kf.bb.size(); ++ bb_k_index)
+					{
+						bb_kf.bb[bb_k_index] = AABBox(bb_min_max[bb_k_index * 2 + 0], bb_min_max[bb_k_index * 2 + 1]);
+					}
+				}
+			}
+			else
 			{
-				uint32_t num_bb_kf;
-				decoded->read(&num_bb_kf, sizeof(num_bb_kf));
-				num_bb_kf = LE2Native(num_bb_kf);
+				// v15 stores each key as frame id, real * scale and dual, one set after another, and the bounding box
+				//  key frames of each mesh as frame id, min and max.
+				for (uint32_t kf_index = 0; kf_index < num_kfs; ++ kf_index)
+				{
+					KeyFrameSet& kf = kf_set(kf_index);
 
-				frame_pos_bbs[mesh_index] = MakeSharedPtr<AABBKeyFrameSet>();
-				frame_pos_bbs[mesh_index]->frame_id.resize(num_bb_kf);
-				frame_pos_bbs[mesh_index]->bb.resize(num_bb_kf);
+					uint32_t num_kf;
+					decoded->read(&num_kf, sizeof(num_kf));
+					num_kf = LE2Native(num_kf);
 
-				for (uint32_t bb_k_index = 0; bb_k_index < num_bb_kf; ++ bb_k_index)
+					kf.frame_id.resize(num_kf);
+					kf.bind_real.resize(num_kf);
+					kf.bind_dual.resize(num_kf);
+					kf.bind_scale.resize(num_kf);
+					for (uint32_t k_index = 0; k_index < num_kf; ++ k_index)
+					{
+						ReadLEArray(decoded, &kf.frame_id[k_index], 1);
+						ReadLEArray(decoded, reinterpret_cast<float*>(&kf.bind_real[k_index]), 4);
+						ReadLEArray(decoded, reinterpret_cast<float*>(&kf.bind_dual[k_index]), 4);
+
+						float flip = MathLib::SignBit(kf.bind_real[k_index].w());
+
+						kf.bind_scale[k_index] = MathLib::length(kf.bind_real[k_index]);
+						kf.bind_real[k_index] /= kf.bind_scale[k_index];
+
+						kf.bind_scale[k_index] *= flip;
+					}
+				}
+
+				frame_pos_bbs.resize(num_meshes);
+				for (uint32_t mesh_index = 0; mesh_index < num_meshes; ++ mesh_index)
 				{
-					decoded->read(&frame_pos_bbs[mesh_index]->frame_id[bb_k_index], sizeof(frame_pos_bbs[mesh_index]->frame_id[bb_k_index]));
-					frame_pos_bbs[mesh_index]->frame_id[bb_k_index] = LE2Native(frame_pos_bbs[mesh_index]->frame_id[bb_k_index]);
-
-					float3 bb_min, bb_max;
-					decoded->read(&bb_min, sizeof(bb_min));
-					bb_min[0] = LE2Native(bb_min[0]);
-					bb_min[1] = LE2Native(bb_min[1]);
-					bb_min[2] = LE2Native(bb_min[2]);
-					decoded->read(&bb_max, sizeof(bb_max));
-					bb_max[0] = LE2Native(bb_max[0]);
-					bb_max[1] = LE2Native(bb_max[1]);
-					bb_max[2] = LE2Native(bb_max[2]);
-					frame_pos_bbs[mesh_index]->bb[bb_k_index] = AABBox(bb_min, bb_max);
+					uint32_t num_bb_kf;
+					decoded->read(&num_bb_kf, sizeof(num_bb_kf));
+					num_bb_kf = LE2Native(num_bb_kf);
+
+					frame_pos_bbs[mesh_index] = MakeSharedPtr<AABBKeyFrameSet>();
+					auto& bb_kf = *frame_pos_bbs[mesh_index];
+					bb_kf.frame_id.resize(num_bb_kf);
+					bb_kf.bb.resize(num_bb_kf);
+					for (uint32_t bb_k_index = 0; bb_k_index < num_bb_kf; ++ bb_k_index)
+					{
+						ReadLEArray(decoded, &bb_kf.frame_id[bb_k_index], 1);
+
+						float3 bb_min_max[2];
+						ReadLEArray(decoded, reinterpret_cast<float*>(bb_min_max), 6);
+						bb_kf.bb[bb_k_index] = AABBox(bb_min_max[0], bb_min_max[1]);
+					}
 				}
 			}
 
@@ -1710,19 +2229,16 @@ namespace KlayGE
 
 			int16_t joint_parent = Native2LE(joints[i].parent);
 			os.write(reinterpret_cast<char*>(&joint_parent), sizeof(joint_parent));
+		}
 
-			Quaternion bind_real;
-			bind_real.x() = Native2LE(joints[i].bind_real.x());
-			bind_real.y() = Native2LE(joints[i].bind_real.y());
-			bind_real.z() = Native2LE(joints[i].bind_real.z());
-			bind_real.w() = Native2LE(joints[i].bind_real.w());
-			os.write(reinterpret_cast<char*>(&bind_real), sizeof(bind_real));
-			Quaternion bind_dual;
-			bind_dual.x() = Native2LE(joints[i].bind_dual.x());
-			bind_dual.y() = Native2LE(joints[i].bind_dual.y());
-			bind_dual.z() = Native2LE(joints[i].bind_dual.z());
-			bind_dual.w() = Native2LE(joints[i].bind_dual.w());
-			os.write(reinterpret_cast<char*>(&bind_dual), sizeof(bind_dual));
+		WriteSectionPadding(os);
+		for (size_t i = 0; i < joints.size(); ++ i)
+		{
+			WriteLEArray(os, &joints[i].bind_real[0], 4);
+		}
+		for (size_t i = 0; i < joints.size(); ++ i)
+		{
+			WriteLEArray(os, &joints[i].bind_dual[0], 4);
 		}
 	}
 
@@ -1734,30 +2250,91 @@ namespace KlayGE
 		frame_rate = Native2LE(frame_rate);
 		os.write(reinterpret_cast<char*>(&frame_rate), sizeof(frame_rate));
 
+		// All sets share one format. Any quantized set makes the whole chunk quantized.
+		bool const quantized = std::any_of(kfs.begin(), kfs.end(),
+			[](KeyFrameSet const & kf)
+			{
+				return kf.Quantized();
+			});
+		uint32_t quantized_kfs = Native2LE(quantized ? 1U : 0U);
+		os.write(reinterpret_cast<char*>(&quantized_kfs), sizeof(quantized_kfs));
+
 		for (size_t i = 0; i < kfs.size(); ++ i)
 		{
 			uint32_t num_kf = Native2LE(static_cast<uint32_t>(kfs[i].frame_id.size()));
 			os.write(reinterpret_cast<char*>(&num_kf), sizeof(num_kf));
+		}
 
-			for (size_t j = 0; j < kfs[i].frame_id.size(); ++ j)
+		WriteSectionPadding(os);
+		for (size_t i = 0; i < kfs.size(); ++ i)
+		{
+			WriteLEArray(os, kfs[i].frame_id.data(), kfs[i].frame_id.size());
+		}
+		WriteSectionPadding(os);
+		if (quantized)
+		{
+			std::vector<KeyFrameSet> quantized_kf_copies(kfs.size());
+			std::vector<KeyFrameSet const *> quantized_kf_sets(kfs.size());
+			for (size_t i = 0; i < kfs.size(); ++ i)
 			{
-				Quaternion bind_real = kfs[i].bind_real[j];
-				Quaternion bind_dual = kfs[i].bind_dual[j];
-				float bind_scale = kfs[i].bind_scale[j];
+				if (kfs[i].Quantized())
+				{
+					quantized_kf_sets[i] = &kfs[i];
+				}
+				else
+				{
+					quantized_kf_copies[i] = kfs[i];
+					quantized_kf_copies[i].Quantize();
+					quantized_kf_sets[i] = &quantized_kf_copies[i];
+				}
+			}
 
-				uint32_t frame_id = Native2LE(kfs[i].frame_id[j]);
-				os.write(reinterpret_cast<char*>(&frame_id), sizeof(frame_id));
-				bind_real *= bind_scale;
-				bind_real.x() = Native2LE(bind_real.x());
-				bind_real.y() = Native2LE(bind_real.y());
-				bind_real.z() = Native2LE(bind_real.z());
-				bind_real.w() = Native2LE(bind_real.w());
-				os.write(reinterpret_cast<char*>(&bind_real), sizeof(bind_real));
-				bind_dual.x() = Native2LE(bind_dual.x());
-				bind_dual.y() = Native2LE(bind_dual.y());
-				bind_dual.z() = Native2LE(bind_dual.z());
-				bind_dual.w() = Native2LE(bind_dual.w());
-				os.write(reinterpret_cast<char*>(&bind_dual), sizeof(bind_dual));
+			for (size_t i = 0; i < kfs.size(); ++ i)
+			{
+				auto const & kf = *quantized_kf_sets[i];
+				float const ranges[] = { kf.trans_min.x(), kf.trans_min.y(), kf.trans_min.z(),
+					kf.trans_extent.x(), kf.trans_extent.y(), kf.trans_extent.z(), kf.scale_min, kf.scale_extent };
+				WriteLEArray(os, ranges, std::size(ranges));
+			}
+			for (size_t i = 0; i < kfs.size(); ++ i)
+			{
+				auto const & kf = *quantized_kf_sets[i];
+				WriteLEArray(os, kf.quantized_keys.data(), kf.quantized_keys.size());
+			}
+			WriteSectionPadding(os);
+		}
+		else
+		{
+			// Reals and scales are stored the way the old per-key loader rebuilt them from real * scale: the real
+			//  normalized, and the scale flipped by the sign of that product's w. So keys with negative scales
+			//  load the same as before.
+			std::vector<std::vector<Quaternion>> bind_reals(kfs.size());
+			std::vector<std::vector<float>> bind_scales(kfs.size());
+			for (size_t i = 0; i < kfs.size(); ++ i)
+			{
+				bind_reals[i].resize(kfs[i].bind_real.size());
+				bind_scales[i].resize(kfs[i].bind_scale.size());
+				for (size_t j = 0; j < kfs[i].bind_real.size(); ++ j)
+				{
+					Quaternion const bind_real = kfs[i].bind_real[j] * kfs[i].bind_scale[j];
+					float const flip = MathLib::SignBit(bind_real.w());
+					bind_scales[i][j] = MathLib::length(bind_real);
+					bind_reals[i][j] = bind_real / bind_scales[i][j];
+					bind_scales[i][j] *= flip;
+				}
+			}
+
+			for (size_t i = 0; i < kfs.size(); ++ i)
+			{
+				WriteLEArray(os, reinterpret_cast<float const *>(bind_reals[i].data()), bind_reals[i].size() * 4);
+			}
+			for (size_t i = 0; i < kfs.size(); ++ i)
+			{
+				WriteLEArray(os, reinterpret_cast<float const *>(kfs[i].bind_dual.data()), kfs[i].bind_dual.size() * 4);
+			}
+			for (size_t i = 0; i < kfs.size(); ++ i)
+			{
+				WriteLEArray(os, bind_scales[i].data(), bind_scales[i].size());
 			}
 		}
 	}
@@ -1766,25 +2343,24 @@ namespace KlayGE
 	{
 		for (size_t i = 0; i < frame_pos_bbs.size(); ++ i)
 		{
-			auto& bb_kf = *frame_pos_bbs[i];
-
-			uint32_t num_bb_kf = Native2LE(static_cast<uint32_t>(bb_kf.frame_id.size()));
+			uint32_t num_bb_kf = Native2LE(static_cast<uint32_t>(frame_pos_bbs[i]->frame_id.size()));
 			os.write(reinterpret_cast<char*>(&num_bb_kf), sizeof(num_bb_kf));
+		}
 
-			for (uint32_t j = 0; j < bb_kf.frame_id.size(); ++ j)
+		WriteSectionPadding(os);
+		for (size_t i = 0; i < frame_pos_bbs.size(); ++ i)
+		{
+			auto const & bb_kf = *frame_pos_bbs[i];
+			WriteLEArray(os, bb_kf.frame_id.data(), bb_kf.frame_id.size());
+		}
+		WriteSectionPadding(os);
+		for (size_t i = 0; i < frame_pos_bbs.size(); ++ i)
+		{
+			auto const & bb_kf = *frame_pos_bbs[i];
+			for (size_t j = 0; j < bb_kf.bb.size(); ++ j)
 			{
-				uint32_t frame_id = Native2LE(bb_kf.frame_id[j]);
-				os.write(reinterpret_cast<char*>(&frame_id), sizeof(frame_id));
-				float3 bb_min;
-				bb_min.x() = Native2LE(bb_kf.bb[j].Min().x());
-				bb_min.y() = Native2LE(bb_kf.bb[j].Min().y());
-				bb_min.z() = Native2LE(bb_kf.bb[j].Min().z());
-				os.write(reinterpret_cast<char*>(&bb_min), sizeof(bb_min));
-				float3 bb_max = bb_kf.bb[j].Max();
-				bb_max.x() = Native2LE(bb_kf.bb[j].Max().x());
-				bb_max.y() = Native2LE(bb_kf.bb[j].Max().y());
-				bb_max.z() = Native2LE(bb_kf.bb[j].Max().z());
-				os.write(reinterpret_cast<char*>(&bb_max), sizeof(bb_max));
+				WriteLEArray(os, &bb_kf.bb[j].Min()[0], 3);
+				WriteLEArray(os, &bb_kf.bb[j].Max()[0], 3);
 			}
 		}
 	}
@@ -1875,7 +2451,7 @@ namespace KlayGE
 		ofs.write(reinterpret_cast<char*>(&len), sizeof(len));
 
 		LZMACodec lzma;
-		len = lzma.Encode(ofs, ss.str().c_str(), ss.str().size());
+		len = lzma.EncodeChunked(ofs, ss.str().c_str(), ss.str().size());
 
 		ofs.seekp(p, std::ios_base::beg);
 		len = Native2LE(len);
@@ -41,6 +41,9 @@
 #include <KFL/XMLDom.hpp>
 #include <KlayGE/DeferredRenderingLayer.hpp>
 #include <KFL/Hash.hpp>
+#include <KFL/JobSystem.hpp>
+#include <KFL/RadixSort.hpp>
+#include <KFL/SIMDMath.hpp>
 
 #include <fstream>
 #include <string>
@@ -63,6 +66,55 @@ namespace
 
 	uint32_t const NUM_PARTICLES = 4096;
 
+	// Number of particles per job. A multiple of ParticleSoA::BATCH_SIZE.
+	uint32_t const PARTICLE_GRAIN_SIZE = 1024;
+
+	// A polyline as y0 + sum(dy[i] * clamp((t - x[i]) / width[i], 0, 1)), which evaluates without branches
+	//  on a batch of t. It's the same as a lerp in the segment t falls in. A zero width segment is a step.
+	class PolylineCurve
+	{
+	public:
+		explicit PolylineCurve(std::vector<float2> const & ctrl_points)
+			: y0_(ctrl_points.empty() ? 0.0f : ctrl_points[0].y())
+		{
+			for (size_t i = 1; i < ctrl_points.size(); ++ i)
+			{
+				float const width = ctrl_points[i].x() - ctrl_points[i - 1].x();
+				x_.push_back(ctrl_points[i - 1].x());
+				inv_width_.push_back((width > 0) ? 1 / width : std::numeric_limits<float>::max());
+				dy_.push_back(ctrl_points[i].y() - ctrl_points[i - 1].y());
+			}
+		}
+
+		float Evaluate(float t) const
+		{
+			float ret = y0_;
+			for (size_t i = 0; i < x_.size(); ++ i)
+			{
+				ret += MathLib::clamp((t - x_[i]) * inv_width_[i], 0.0f, 1.0f) * dy_[i];
+			}
+			return ret;
+		}
+
+		SIMDVectorF4 Evaluate(SIMDVectorF4 const & t) const
+		{
+			SIMDVectorF4 const zero = SIMDVectorF4::Zero();
+			SIMDVectorF4 const one = SIMDMathLib::SetVector(1.0f);
+			SIMDVectorF4 ret = SIMDMathLib::SetVector(y0_);
+			for (size_t i = 0; i < x_.size(); ++ i)
+			{
+				ret += SIMDMathLib::Minimize(SIMDMathLib::Maximize((t - x_[i]) * inv_width_[i], zero), one) * dy_[i];
+			}
+			return ret;
+		}
+
+	private:
+		float y0_;
+		std::vector<float> x_;
+		std::vector<float> inv_width_;
+		std::vector<float> dy_;
+	};
+
 	class ParticleSystemLoadingDesc : public ResLoadingDesc
 	{
 	private:
@@ -127,7 +179,7 @@ namespace
 				return;
 			}
 
-			ResIdentifierPtr psmm_input = ResLoader::Instance().Open(ps_desc_.res_name);
+			ResIdentifierPtr psmm_input = ResLoader::Instance().OpenXML(ps_desc_.res_name);
 
 			KlayGE::XMLDocument doc;
 			XMLNodePtr root = doc.Parse(psmm_input);
@@ -361,6 +413,11 @@ namespace
 			return false;
 		}
 
+		size_t Hash() const override
+		{
+			return HashRange(ps_desc_.res_name.begin(), ps_desc_.res_name.end());
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -558,6 +615,73 @@ namespace
 
 namespace KlayGE
 {
+	ParticleSoA::ParticleSoA(uint32_t capacity)
+		: capacity_(capacity), size_(0)
+	{
+		uint32_t const padded_capacity = (capacity + BATCH_SIZE - 1) & ~(BATCH_SIZE - 1);
+		for (auto& stream : streams_)
+		{
+			stream.assign(padded_capacity, 0.0f);
+		}
+		// Keeps the life factor of the padding finite
+		std::fill(streams_[PS_InitLife].begin(), streams_[PS_InitLife].end(), 1.0f);
+	}
+
+	Particle ParticleSoA::Get(uint32_t index) const
+	{
+		BOOST_ASSERT(index < capacity_);
+
+		Particle par;
+		par.pos = float3(streams_[PS_PosX][index], streams_[PS_PosY][index], streams_[PS_PosZ][index]);
+		par.vel = float3(streams_[PS_VelX][index], streams_[PS_VelY][index], streams_[PS_VelZ][index]);
+		par.life = streams_[PS_Life][index];
+		par.spin = streams_[PS_Spin][index];
+		par.size = streams_[PS_Size][index];
+		par.alpha = streams_[PS_Alpha][index];
+		par.init_life = streams_[PS_InitLife][index];
+		return par;
+	}
+
+	void ParticleSoA::Set(uint32_t index, Particle const & par)
+	{
+		BOOST_ASSERT(index < capacity_);
+
+		streams_[PS_PosX][index] = par.pos.x();
+		streams_[PS_PosY][index] = par.pos.y();
+		streams_[PS_PosZ][index] = par.pos.z();
+		streams_[PS_VelX][index] = par.vel.x();
+		streams_[PS_VelY][index] = par.vel.y();
+		streams_[PS_VelZ][index] = par.vel.z();
+		streams_[PS_Life][index] = par.life;
+		streams_[PS_Spin][index] = par.spin;
+		streams_[PS_Size][index] = par.size;
+		streams_[PS_Alpha][index] = par.alpha;
+		streams_[PS_InitLife][index] = par.init_life;
+	}
+
+	void ParticleSoA::PushBack(Particle const & par)
+	{
+		BOOST_ASSERT(size_ < capacity_);
+
+		this->Set(size_, par);
+		++ size_;
+	}
+
+	void ParticleSoA::SwapRemove(uint32_t index)
+	{
+		BOOST_ASSERT(index < size_);
+
+		-- size_;
+		if (index != size_)
+		{
+			for (auto& stream : streams_)
+			{
+				stream[index] = stream[size_];
+			}
+		}
+	}
+
+
 	ParticleEmitter::ParticleEmitter(SceneObjectPtr const & ps)
 			: ps_(checked_pointer_cast<ParticleSystem>(ps)),
 				model_mat_(float4x4::Identity()),
@@ -604,7 +728,7 @@ namespace KlayGE
 
 
 	ParticleSystem::ParticleSystem(uint32_t max_num_particles)
-		: SceneObjectHelper(SOA_Moveable | SOA_NotCastShadow),
+		: SceneObjectHelper(SOA_Moveable | SOA_NotCastShadow | SOA_ParallelUpdate),
 			particles_(max_num_particles),
 			gravity_(0.5f), force_(0, 0, 0), media_density_(0.0f)
 	{
@@ -720,90 +844,112 @@ namespace KlayGE
 	uint32_t ParticleSystem::GetActiveParticleIndex(uint32_t i) const
 	{
 		std::lock_guard<std::mutex> lock(actived_particles_mutex_);
-		return actived_particles_[i].first;
+		return actived_particles_[i].index;
 	}
 
 	void ParticleSystem::ClearParticles()
 	{
-		for (auto& particle : particles_)
-		{
-			particle.life = 0;
-		}
+		particles_.Clear();
 	}
 
-	void ParticleSystem::UpdateParticlesNoLock(float elapsed_time, std::vector<std::pair<uint32_t, float>>& actived_particles)
+	void ParticleSystem::UpdateParticlesNoLock(float elapsed_time, std::vector<ActiveParticle>& actived_particles)
 	{
-		auto emitter_iter = emitters_.begin();
-		uint32_t new_particle = (*emitter_iter)->Update(elapsed_time);
-
-		float4x4 const & view_mat = Context::Instance().AppInstance().ActiveCamera().ViewMatrix();
-
-		actived_particles.clear();
+		auto& job_system = Context::Instance().JobSystemInstance();
 
-		float3 min_bb(+1e10f, +1e10f, +1e10f);
-		float3 max_bb(-1e10f, -1e10f, -1e10f);
-
-		for (uint32_t i = 0; i < particles_.size(); ++ i)
+		auto update = [this, &job_system](uint32_t begin, uint32_t end, float elapsed_time)
 		{
-			Particle& particle = particles_[i];
-
-			if (particle.life > 0)
-			{
-				for (auto const & updater : updaters_)
+			job_system.ParallelFor(begin, end, PARTICLE_GRAIN_SIZE,
+				[this, elapsed_time](uint32_t chunk_begin, uint32_t chunk_end)
 				{
-					updater->Update(particle, elapsed_time);
-				}
-			}
-			else
-			{
-				if (new_particle > 0)
-				{
-					(*emitter_iter)->Emit(particle);
 					for (auto const & updater : updaters_)
 					{
-						updater->Update(particle, 0);
+						updater->Update(particles_, chunk_begin, chunk_end, elapsed_time);
 					}
-					-- new_particle;
-				}
-				else
+				});
+		};
+		// The last particles fill the holes, so the live ones stay packed
+		auto remove_dead = [this](uint32_t begin)
+		{
+			float const * life = particles_.Stream(ParticleSoA::PS_Life);
+			for (uint32_t i = particles_.Size(); i > begin; -- i)
+			{
+				if (life[i - 1] <= 0)
 				{
-					if (emitter_iter != emitters_.end())
-					{
-						++ emitter_iter;
-						if (emitter_iter != emitters_.end())
-						{
-							new_particle = (*emitter_iter)->Update(elapsed_time);
-						}
-					}
+					particles_.SwapRemove(i - 1);
 				}
 			}
+		};
 
-			if (particle.life > 0)
-			{
-				float3 const & pos = particle.pos;
-				float p_to_v = (pos.x() * view_mat(0, 2) + pos.y() * view_mat(1, 2) + pos.z() * view_mat(2, 2) + view_mat(3, 2))
-					/ (pos.x() * view_mat(0, 3) + pos.y() * view_mat(1, 3) + pos.z() * view_mat(2, 3) + view_mat(3, 3));
-
-				actived_particles.emplace_back(i, p_to_v);
+		update(0, particles_.Size(), elapsed_time);
+		remove_dead(0);
 
-				min_bb = MathLib::minimize(min_bb, pos);
-				max_bb = MathLib::maximize(min_bb, pos);
+		uint32_t const num_old_particles = particles_.Size();
+		for (auto const & emitter : emitters_)
+		{
+			uint32_t const new_particle = emitter->Update(elapsed_time);
+			for (uint32_t i = 0; (i < new_particle) && !particles_.Full(); ++ i)
+			{
+				Particle particle{};
+				emitter->Emit(particle);
+				particles_.PushBack(particle);
 			}
 		}
+		update(num_old_particles, particles_.Size(), 0);
+		remove_dead(num_old_particles);
+
+		float4x4 const & view_mat = Context::Instance().AppInstance().ActiveCamera().ViewMatrix();
+
+		uint32_t const num_particles = particles_.Size();
+		actived_particles.resize(num_particles);
+
+		AABBox const empty_bb(float3(+1e10f, +1e10f, +1e10f), float3(-1e10f, -1e10f, -1e10f));
+		AABBox const bb = job_system.ParallelReduce<AABBox>(0, num_particles, PARTICLE_GRAIN_SIZE, empty_bb,
+			[this, &view_mat, &actived_particles](uint32_t begin, uint32_t end)
+			{
+				float const * pos_x = particles_.Stream(ParticleSoA::PS_PosX);
+				float const * pos_y = particles_.Stream(ParticleSoA::PS_PosY);
+				float const * pos_z = particles_.Stream(ParticleSoA::PS_PosZ);
+
+				float3 min_bb(+1e10f, +1e10f, +1e10f);
+				float3 max_bb(-1e10f, -1e10f, -1e10f);
+				for (uint32_t i = begin; i < end; ++ i)
+				{
+					float3 const pos(pos_x[i], pos_y[i], pos_z[i]);
+					float p_to_v = (pos.x() * view_mat(0, 2) + pos.y() * view_mat(1, 2) + pos.z() * view_mat(2, 2) + view_mat(3, 2))
+						/ (pos.x() * view_mat(0, 3) + pos.y() * view_mat(1, 3) + pos.z() * view_mat(2, 3) + view_mat(3, 3));
+
+					// Flips the depth to an unsigned integer in reversed order, for sorting back to front
+					union FNU
+					{
+						float f;
+						uint32_t u;
+					} fnu;
+					fnu.f = p_to_v;
+					uint32_t const depth_bits = (fnu.u & 0x80000000U) ? fnu.u : ~(fnu.u | 0x80000000U);
+
+					actived_particles[i].key = depth_bits;
+					actived_particles[i].index = i;
+
+					min_bb = MathLib::minimize(min_bb, pos);
+					max_bb = MathLib::maximize(max_bb, pos);
+				}
+				return AABBox(min_bb, max_bb);
+			},
+			[](AABBox const & lhs, AABBox const & rhs)
+			{
+				return AABBox(MathLib::minimize(lhs.Min(), rhs.Min()), MathLib::maximize(lhs.Max(), rhs.Max()));
+			});
 
 		if (!actived_particles.empty())
 		{
-			std::sort(actived_particles.begin(), actived_particles.end(),
-				[](std::pair<uint32_t, float> const & lhs, std::pair<uint32_t, float> const & rhs)
-				{
-					return lhs.second > rhs.second;
-				});
+			actived_particles_scratch_.resize(num_particles);
+			RadixSort(actived_particles.data(), actived_particles_scratch_.data(), num_particles, &job_system);
 
-			checked_pointer_cast<RenderParticles>(renderable_)->PosBound(AABBox(min_bb, max_bb));
+			pos_bound_ = bb;
 		}
 	}
 
-	void ParticleSystem::UpdateParticleBufferNoLock(std::vector<std::pair<uint32_t, float>> const & actived_particles)
+	void ParticleSystem::UpdateParticleBufferNoLock(std::vector<ActiveParticle> const & actived_particles)
 	{
 		if (!actived_particles.empty())
 		{
@@ -850,17 +996,26 @@ namespace KlayGE
 			}
 
 			{
+				float const * pos_x = particles_.Stream(ParticleSoA::PS_PosX);
+				float const * pos_y = particles_.Stream(ParticleSoA::PS_PosY);
+				float const * pos_z = particles_.Stream(ParticleSoA::PS_PosZ);
+				float const * life = particles_.Stream(ParticleSoA::PS_Life);
+				float const * spin = particles_.Stream(ParticleSoA::PS_Spin);
+				float const * size = particles_.Stream(ParticleSoA::PS_Size);
+				float const * alpha = particles_.Stream(ParticleSoA::PS_Alpha);
+				float const * init_life = particles_.Stream(ParticleSoA::PS_InitLife);
+
 				GraphicsBuffer::Mapper mapper(*instance_gb, BA_Write_Only);
 				ParticleInstance* instance_data = mapper.Pointer<ParticleInstance>();
 				for (uint32_t i = 0; i < num_active_particles; ++ i, ++ instance_data)
 				{
-					Particle const & par = particles_[actived_particles[i].first];
-					instance_data->pos = par.pos;
-					instance_data->life = par.life;
-					instance_data->spin = par.spin;
-					instance_data->size = par.size;
-					instance_data->life_factor = (par.init_life - par.life) / par.init_life;
-					instance_data->alpha = par.alpha;
+					uint32_t const index = actived_particles[i].index;
+					instance_data->pos = float3(pos_x[index], pos_y[index], pos_z[index]);
+					instance_data->life = life[index];
+					instance_data->spin = spin[index];
+					instance_data->size = size[index];
+					instance_data->life_factor = (init_life[index] - life[index]) / init_life[index];
+					instance_data->alpha = alpha[index];
 				}
 			}
 		}
@@ -870,16 +1025,9 @@ namespace KlayGE
 	{
 		KFL_UNUSED(app_time);
 
+		// Runs outside the scene lock, while the renderable could be drawn. So the renderable is left to MainThreadUpdate.
 		std::lock_guard<std::mutex> lock(actived_particles_mutex_);
-
 		this->UpdateParticlesNoLock(elapsed_time, actived_particles_);
-
-		auto& rf = Context::Instance().RenderFactoryInstance();
-		auto const & caps = rf.RenderEngineInstance().DeviceCaps();
-		if (caps.arbitrary_multithread_rendering_support)
-		{
-			this->UpdateParticleBufferNoLock(actived_particles_);
-		}
 	}
 
 	bool ParticleSystem::MainThreadUpdate(float app_time, float elapsed_time)
@@ -887,13 +1035,12 @@ namespace KlayGE
 		KFL_UNUSED(app_time);
 		KFL_UNUSED(elapsed_time);
 
-		auto& rf = Context::Instance().RenderFactoryInstance();
-		auto const & caps = rf.RenderEngineInstance().DeviceCaps();
-		if (!caps.arbitrary_multithread_rendering_support)
+		std::lock_guard<std::mutex> lock(actived_particles_mutex_);
+		if (!actived_particles_.empty())
 		{
-			std::lock_guard<std::mutex> lock(actived_particles_mutex_);
-			this->UpdateParticleBufferNoLock(actived_particles_);
+			checked_pointer_cast<RenderParticles>(renderable_)->PosBound(pos_bound_);
 		}
+		this->UpdateParticleBufferNoLock(actived_particles_);
 
 		return false;
 	}
@@ -935,9 +1082,11 @@ namespace KlayGE
 		return ResLoader::Instance().SyncQueryT<ParticleSystem>(MakeSharedPtr<ParticleSystemLoadingDesc>(psml_name));
 	}
 
-	ParticleSystemPtr ASyncLoadParticleSystem(std::string_view psml_name)
+	ParticleSystemPtr ASyncLoadParticleSystem(std::string_view psml_name, ResLoader::LoadingPriority priority)
 	{
 		// TODO: Make it really async
+		KFL_UNUSED(priority);
+
 		return ResLoader::Instance().SyncQueryT<ParticleSystem>(MakeSharedPtr<ParticleSystemLoadingDesc>(psml_name));
 	}
 
@@ -1158,60 +1307,114 @@ namespace KlayGE
 		ret->size_over_life_ = size_over_life_;
 		ret->mass_over_life_ = mass_over_life_;
 		ret->opacity_over_life_ = opacity_over_life_;
+		ret->BuildCurvesNoLock();
 		return ret;
 	}
 
-	void PolylineParticleUpdater::Update(Particle& par, float elapse_time)
+	struct PolylineParticleUpdater::Curves
 	{
-		std::lock_guard<std::mutex> lock(update_mutex_);
+		Curves(std::vector<float2> const & size_over_life, std::vector<float2> const & mass_over_life,
+				std::vector<float2> const & opacity_over_life)
+			: size(size_over_life), mass(mass_over_life), opacity(opacity_over_life)
+		{
+		}
 
-		BOOST_ASSERT(!size_over_life_.empty());
-		BOOST_ASSERT(!mass_over_life_.empty());
-		BOOST_ASSERT(!opacity_over_life_.empty());
+		PolylineCurve size;
+		PolylineCurve mass;
+		PolylineCurve opacity;
+	};
 
-		float pos = (par.init_life - par.life) / par.init_life;
+	void PolylineParticleUpdater::BuildCurvesNoLock()
+	{
+		curves_ = MakeSharedPtr<Curves>(size_over_life_, mass_over_life_, opacity_over_life_);
+	}
 
-		float cur_size = size_over_life_.back().y();
-		for (auto iter = size_over_life_.begin(); iter != size_over_life_.end() - 1; ++ iter)
+	void PolylineParticleUpdater::Update(ParticleSoA& particles, uint32_t begin, uint32_t end, float elapse_time)
+	{
+		std::shared_ptr<Curves const> curves;
 		{
-			if ((iter + 1)->x() >= pos)
-			{
-				float const s = (pos - iter->x()) / ((iter + 1)->x() - iter->x());
-				cur_size = MathLib::lerp(iter->y(), (iter + 1)->y(), s);
-				break;
-			}
+			std::lock_guard<std::mutex> lock(update_mutex_);
+
+			BOOST_ASSERT(!size_over_life_.empty());
+			BOOST_ASSERT(!mass_over_life_.empty());
+			BOOST_ASSERT(!opacity_over_life_.empty());
+
+			curves = curves_;
 		}
 
-		float cur_mass = mass_over_life_.back().y();
-		for (auto iter = mass_over_life_.begin(); iter != mass_over_life_.end() - 1; ++ iter)
+		ParticleSystemPtr ps = ps_.lock();
+		float const buoyancy_scale = 4.0f / 3 * PI * ps->MediaDensity() * ps->Gravity();
+		float3 const force = ps->Force();
+		float const gravity = ps->Gravity();
+
+		float* pos_x = particles.Stream(ParticleSoA::PS_PosX);
+		float* pos_y = particles.Stream(ParticleSoA::PS_PosY);
+		float* pos_z = particles.Stream(ParticleSoA::PS_PosZ);
+		float* vel_x = particles.Stream(ParticleSoA::PS_VelX);
+		float* vel_y = particles.Stream(ParticleSoA::PS_VelY);
+		float* vel_z = particles.Stream(ParticleSoA::PS_VelZ);
+		float* life = particles.Stream(ParticleSoA::PS_Life);
+		float* spin = particles.Stream(ParticleSoA::PS_Spin);
+		float* size = particles.Stream(ParticleSoA::PS_Size);
+		float* alpha = particles.Stream(ParticleSoA::PS_Alpha);
+		float const * init_life = particles.Stream(ParticleSoA::PS_InitLife);
+
+		auto update_one = [&](uint32_t i)
 		{
-			if ((iter + 1)->x() >= pos)
-			{
-				float const s = (pos - iter->x()) / ((iter + 1)->x() - iter->x());
-				cur_mass = MathLib::lerp(iter->y(), (iter + 1)->y(), s);
-				break;
-			}
+			float const pos = (init_life[i] - life[i]) / init_life[i];
+			float const cur_size = curves->size.Evaluate(pos);
+			float const cur_mass = curves->mass.Evaluate(pos);
+			float const cur_alpha = curves->opacity.Evaluate(pos);
+
+			float const buoyancy = buoyancy_scale * MathLib::cube(cur_size);
+			vel_x[i] += force.x() / cur_mass * elapse_time;
+			vel_y[i] += ((force.y() + buoyancy) / cur_mass - gravity) * elapse_time;
+			vel_z[i] += force.z() / cur_mass * elapse_time;
+			pos_x[i] += vel_x[i] * elapse_time;
+			pos_y[i] += vel_y[i] * elapse_time;
+			pos_z[i] += vel_z[i] * elapse_time;
+			life[i] -= elapse_time;
+			spin[i] += 0.001f;
+			size[i] = cur_size;
+			alpha[i] = cur_alpha;
+		};
+
+		uint32_t i = begin;
+		for (; (i < end) && (i % ParticleSoA::BATCH_SIZE != 0); ++ i)
+		{
+			update_one(i);
 		}
 
-		float cur_alpha = opacity_over_life_.back().y();
-		for (auto iter = opacity_over_life_.begin(); iter != opacity_over_life_.end() - 1; ++ iter)
+		SIMDVectorF4 const force_x = SIMDMathLib::SetVector(force.x());
+		SIMDVectorF4 const force_z = SIMDMathLib::SetVector(force.z());
+		for (; i + ParticleSoA::BATCH_SIZE <= end; i += ParticleSoA::BATCH_SIZE)
 		{
-			if ((iter + 1)->x() >= pos)
-			{
-				float const s = (pos - iter->x()) / ((iter + 1)->x() - iter->x());
-				cur_alpha = MathLib::lerp(iter->y(), (iter + 1)->y(), s);
-				break;
-			}
+			SIMDVectorF4 const cur_life = SIMDMathLib::LoadVector4(life + i);
+			SIMDVectorF4 const cur_init_life = SIMDMathLib::LoadVector4(init_life + i);
+			SIMDVectorF4 const pos = (cur_init_life - cur_life) / cur_init_life;
+			SIMDVectorF4 const cur_size = curves->size.Evaluate(pos);
+			SIMDVectorF4 const cur_mass = curves->mass.Evaluate(pos);
+			SIMDVectorF4 const cur_alpha = curves->opacity.Evaluate(pos);
+
+			SIMDVectorF4 const buoyancy = SIMDMathLib::Cube(cur_size) * buoyancy_scale;
+			SIMDVectorF4 const vx = SIMDMathLib::LoadVector4(vel_x + i) + force_x / cur_mass * elapse_time;
+			SIMDVectorF4 const vy = SIMDMathLib::LoadVector4(vel_y + i) + ((buoyancy + force.y()) / cur_mass - gravity) * elapse_time;
+			SIMDVectorF4 const vz = SIMDMathLib::LoadVector4(vel_z + i) + force_z / cur_mass * elapse_time;
+			SIMDMathLib::StoreVector4(vel_x + i, vx);
+			SIMDMathLib::StoreVector4(vel_y + i, vy);
+			SIMDMathLib::StoreVector4(vel_z + i, vz);
+			SIMDMathLib::StoreVector4(pos_x + i, SIMDMathLib::LoadVector4(pos_x + i) + vx * elapse_time);
+			SIMDMathLib::StoreVector4(pos_y + i, SIMDMathLib::LoadVector4(pos_y + i) + vy * elapse_time);
+			SIMDMathLib::StoreVector4(pos_z + i, SIMDMathLib::LoadVector4(pos_z + i) + vz * elapse_time);
+			SIMDMathLib::StoreVector4(life + i, cur_life - elapse_time);
+			SIMDMathLib::StoreVector4(spin + i, SIMDMathLib::LoadVector4(spin + i) + 0.001f);
+			SIMDMathLib::StoreVector4(size + i, cur_size);
+			SIMDMathLib::StoreVector4(alpha + i, cur_alpha);
 		}
 
-		ParticleSystemPtr ps = ps_.lock();
-		float buoyancy = 4.0f / 3 * PI * MathLib::cube(cur_size) * ps->MediaDensity() * ps->Gravity();
-		float3 accel = (ps->Force() + float3(0, buoyancy, 0)) / cur_mass - float3(0, ps->Gravity(), 0);
-		par.vel += accel * elapse_time;
-		par.pos += par.vel * elapse_time;
-		par.life -= elapse_time;
-		par.spin += 0.001f;
-		par.size = cur_size;
-		par.alpha = cur_alpha;
+		for (; i < end; ++ i)
+		{
+			update_one(i);
+		}
 	}
 }
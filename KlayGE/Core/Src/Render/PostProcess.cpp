@@ -96,7 +96,7 @@ namespace
 				return;
 			}
 
-			ResIdentifierPtr ppmm_input = ResLoader::Instance().Open(pp_desc_.res_name);
+			ResIdentifierPtr ppmm_input = ResLoader::Instance().OpenXML(pp_desc_.res_name);
 
 			KlayGE::XMLDocument doc;
 			XMLNodePtr root = doc.Parse(ppmm_input);
@@ -201,6 +201,13 @@ namespace
 			return false;
 		}
 
+		size_t Hash() const override
+		{
+			size_t seed = HashRange(pp_desc_.res_name.begin(), pp_desc_.res_name.end());
+			HashRange(seed, pp_desc_.pp_name.begin(), pp_desc_.pp_name.end());
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -883,9 +890,12 @@ namespace KlayGE
 		return ResLoader::Instance().SyncQueryT<PostProcess>(MakeSharedPtr<PostProcessLoadingDesc>(ppml_name, pp_name));
 	}
 
-	PostProcessPtr ASyncLoadPostProcess(std::string_view ppml_name, std::string_view pp_name)
+	PostProcessPtr ASyncLoadPostProcess(std::string_view ppml_name, std::string_view pp_name,
+		ResLoader::LoadingPriority priority)
 	{
 		// TODO: Make it really async
+		KFL_UNUSED(priority);
+
 		return ResLoader::Instance().SyncQueryT<PostProcess>(MakeSharedPtr<PostProcessLoadingDesc>(ppml_name, pp_name));
 	}
 
@@ -59,6 +59,10 @@
 #include <KFL/CXX17/filesystem.hpp>
 
 #include <fstream>
+#include <functional>
+#include <iomanip>
+#include <random>
+#include <sstream>
 #include <string>
 
 #include <boost/assert.hpp>
@@ -86,9 +90,73 @@ namespace
 {
 	using namespace KlayGE;
 
-	uint32_t const KFX_VERSION = 0x0140;
+	uint32_t const KFX_VERSION = 0x0141;
 
 #if KLAYGE_IS_DEV_PLATFORM
+	uint64_t HashResource(ResIdentifier& res, uint64_t seed)
+	{
+		uint64_t hash = seed;
+		if (res.MappedData())
+		{
+			hash = HashMemory64(res.MappedData(), static_cast<size_t>(res.MappedSize()), hash);
+		}
+		else
+		{
+			char buf[4096];
+			for (;;)
+			{
+				res.read(buf, sizeof(buf));
+				size_t const size = static_cast<size_t>(res.gcount());
+				if (0 == size)
+				{
+					break;
+				}
+				hash = HashMemory64(buf, size, hash);
+			}
+		}
+
+		res.clear();
+		res.seekg(0, std::ios_base::beg);
+		return hash;
+	}
+
+	// Writes to a uniquely named file aside and renames it into place, so a reader never opens a partly written .kfx,
+	//  even when several processes fill the same effect_cache_dir.
+	bool WriteFileAside(std::string const & file_name, std::function<void(std::ostream& os)> const & write_func)
+	{
+		std::ostringstream ss;
+		ss << file_name << '.' << std::hex << std::random_device()() << ".tmp";
+		std::filesystem::path const tmp_path(ss.str());
+
+		bool written;
+		{
+			std::ofstream ofs(tmp_path.string().c_str(), std::ios_base::binary | std::ios_base::out);
+			if (ofs)
+			{
+				write_func(ofs);
+			}
+			ofs.close();
+			written = !ofs.fail();
+		}
+
+#if defined(KLAYGE_CXX17_LIBRARY_FILESYSTEM_SUPPORT) || defined(KLAYGE_TS_LIBRARY_FILESYSTEM_SUPPORT)
+		std::error_code ec;
+#else
+		boost::system::error_code ec;
+#endif
+		if (written)
+		{
+			std::filesystem::rename(tmp_path, std::filesystem::path(file_name), ec);
+			written = !ec;
+		}
+		if (!written)
+		{
+			std::filesystem::remove(tmp_path, ec);
+			LogWarn() << "Could NOT write " << file_name << '.' << std::endl;
+		}
+		return written;
+	}
+
 	ArrayRef<std::pair<char const *, size_t>> GetTypeDefines()
 	{
 #define NAME_AND_HASH(name) std::make_pair(name, CT_HASH(name))
@@ -2533,6 +2601,16 @@ namespace KlayGE
 			return false;
 		}
 
+		size_t Hash() const override
+		{
+			size_t seed = 0;
+			for (auto const & name : effect_desc_.res_name)
+			{
+				HashRange(seed, name.begin(), name.end());
+			}
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -3086,11 +3164,28 @@ namespace KlayGE
 
 		this->GenHLSLShaderText(effect);
 
-		uint32_t index = 0;
-		for (XMLNodePtr node = root.FirstNode("technique"); node; node = node->NextSibling("technique"), ++ index)
+		// Loads the techniques once to record the shaders to compile, compiles them in parallel, and loads the
+		//  techniques again with the compiled code
+		DXBCCompileBatch compile_batch;
+		size_t const num_shader_descs = shader_descs_.size();
+		size_t const num_shader_objs = effect.shader_objs_.size();
+		for (int round = 0; round < 2; ++ round)
 		{
-			techniques_.push_back(MakeUniquePtr<RenderTechnique>());
-			techniques_.back()->Load(effect, node, index);
+			uint32_t index = 0;
+			for (XMLNodePtr node = root.FirstNode("technique"); node; node = node->NextSibling("technique"), ++ index)
+			{
+				techniques_.push_back(MakeUniquePtr<RenderTechnique>());
+				techniques_.back()->Load(effect, node, index);
+			}
+
+			if (compile_batch.Recording())
+			{
+				techniques_.clear();
+				shader_descs_.resize(num_shader_descs);
+				effect.shader_objs_.resize(num_shader_objs);
+
+				compile_batch.Compile();
+			}
 		}
 	}
 #endif
@@ -3119,14 +3214,26 @@ namespace KlayGE
 		res_name_ = (last_fxml_directory / (connected_name + ".fxml")).string();
 		res_name_hash_ = HashRange(res_name_.begin(), res_name_.end());
 #if KLAYGE_IS_DEV_PLATFORM
-		for (auto const & name : names)
+		// The .kfx is keyed by the content of all the sources, not by their timestamps. Touching a file,
+		//  checking out a branch, or copying the tree doesn't invalidate it, and the key can be shared between
+		//  machines.
 		{
-			timestamp_ = 0;
+			RenderEngine const & re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+			uint32_t const shader_fourcc = re.NativeShaderFourCC();
+			uint32_t const shader_ver = re.NativeShaderVersion();
+			std::string_view const shader_platform_name = re.NativeShaderPlatformName();
 
+			content_hash_ = HashMemory64(&KFX_VERSION, sizeof(KFX_VERSION));
+			content_hash_ = HashMemory64(&shader_fourcc, sizeof(shader_fourcc), content_hash_);
+			content_hash_ = HashMemory64(&shader_ver, sizeof(shader_ver), content_hash_);
+			content_hash_ = HashMemory64(shader_platform_name.data(), shader_platform_name.size(), content_hash_);
+		}
+		for (auto const & name : names)
+		{
 			ResIdentifierPtr source = ResLoader::Instance().Open(name);
 			if (source)
 			{
-				timestamp_ = std::max(timestamp_, source->Timestamp());
+				content_hash_ = HashResource(*source, content_hash_);
 
 				std::unique_ptr<XMLDocument> doc = MakeUniquePtr<XMLDocument>();
 				XMLNodePtr root = doc->Parse(source);
@@ -3136,27 +3243,66 @@ namespace KlayGE
 
 				for (auto const & include_name : include_names)
 				{
-					timestamp_ = std::max(timestamp_, ResLoader::Instance().Timestamp(include_name));
+					ResIdentifierPtr include_source = ResLoader::Instance().Open(include_name);
+					if (include_source)
+					{
+						content_hash_ = HashResource(*include_source, content_hash_);
+					}
 				}
 			}
 		}
+
+		auto reset_effect = [this, &effect]
+			{
+				effect.params_.clear();
+				effect.cbuffers_.clear();
+				effect.shader_objs_.clear();
+
+				macros_.clear();
+				shader_frags_.clear();
+				hlsl_shader_.clear();
+				techniques_.clear();
+				shader_graph_nodes_.clear();
+
+				shader_descs_.resize(1);
+			};
+
+		// A .kfx shared by all effects with the same content, in a directory that can be shared between
+		//  trees and machines
+		std::string cache_kfx_name;
+		std::string const & effect_cache_dir = Context::Instance().Config().effect_cache_dir;
+		if (!effect_cache_dir.empty())
+		{
+			std::ostringstream ss;
+			ss << std::hex << std::setw(16) << std::setfill('0') << content_hash_ << ".kfx";
+			cache_kfx_name = (std::filesystem::path(effect_cache_dir) / ss.str()).string();
+		}
 #endif
 
 		ResIdentifierPtr kfx_source = ResLoader::Instance().Open(kfx_name);
-		if (!this->StreamIn(kfx_source, effect))
-		{
+		bool loaded = this->StreamIn(kfx_source, effect);
 #if KLAYGE_IS_DEV_PLATFORM
-			effect.params_.clear();
-			effect.cbuffers_.clear();
-			effect.shader_objs_.clear();
-
-			macros_.clear();
-			shader_frags_.clear();
-			hlsl_shader_.clear();
-			techniques_.clear();
-			shader_graph_nodes_.clear();
+		if (!loaded && !cache_kfx_name.empty())
+		{
+			reset_effect();
 
-			shader_descs_.resize(1);
+			ResIdentifierPtr cache_kfx_source = ResLoader::Instance().Open(cache_kfx_name);
+			loaded = this->StreamIn(cache_kfx_source, effect);
+			if (loaded)
+			{
+				std::ifstream ifs(cache_kfx_name.c_str(), std::ios_base::binary | std::ios_base::in);
+				WriteFileAside(kfx_name,
+					[&ifs](std::ostream& os)
+					{
+						os << ifs.rdbuf();
+					});
+			}
+		}
+#endif
+		if (!loaded)
+		{
+#if KLAYGE_IS_DEV_PLATFORM
+			reset_effect();
 
 			std::vector<std::unique_ptr<XMLDocument>> include_docs;
 			std::vector<std::unique_ptr<XMLDocument>> frag_docs(names.size());
@@ -3190,8 +3336,30 @@ namespace KlayGE
 				this->Load(*root, effect);
 			}
 
-			std::ofstream ofs(kfx_name.c_str(), std::ios_base::binary | std::ios_base::out);
-			this->StreamOut(ofs, effect);
+			auto stream_out = [this, &effect](std::ostream& os)
+				{
+					this->StreamOut(os, effect);
+				};
+
+			WriteFileAside(kfx_name, stream_out);
+
+			if (!cache_kfx_name.empty())
+			{
+#if defined(KLAYGE_CXX17_LIBRARY_FILESYSTEM_SUPPORT) || defined(KLAYGE_TS_LIBRARY_FILESYSTEM_SUPPORT)
+				std::error_code ec;
+#else
+				boost::system::error_code ec;
+#endif
+				std::filesystem::create_directories(std::filesystem::path(effect_cache_dir), ec);
+				if (ec)
+				{
+					LogWarn() << "Could NOT create " << effect_cache_dir << '.' << std::endl;
+				}
+				else
+				{
+					WriteFileAside(cache_kfx_name, stream_out);
+				}
+			}
 #endif
 		}
 	}
@@ -3229,11 +3397,11 @@ namespace KlayGE
 				if ((re.NativeShaderFourCC() == shader_fourcc) && (re.NativeShaderVersion() == shader_ver)
 					&& (re.NativeShaderPlatformName() == shader_platform_name))
 				{
-					uint64_t timestamp;
-					source->read(&timestamp, sizeof(timestamp));
+					uint64_t content_hash;
+					source->read(&content_hash, sizeof(content_hash));
 #if KLAYGE_IS_DEV_PLATFORM
-					timestamp = LE2Native(timestamp);
-					if (timestamp_ <= timestamp)
+					content_hash = LE2Native(content_hash);
+					if (content_hash_ == content_hash)
 #endif
 					{
 						shader_descs_.resize(1);
@@ -3369,8 +3537,8 @@ namespace KlayGE
 		os.write(reinterpret_cast<char const *>(&shader_platform_name_len), sizeof(shader_platform_name_len));
 		os.write(&re.NativeShaderPlatformName()[0], shader_platform_name_len);
 
-		uint64_t timestamp = Native2LE(timestamp_);
-		os.write(reinterpret_cast<char const *>(&timestamp), sizeof(timestamp));
+		uint64_t content_hash = Native2LE(content_hash_);
+		os.write(reinterpret_cast<char const *>(&content_hash), sizeof(content_hash));
 
 		{
 			uint16_t num_macros = 0;
@@ -4615,6 +4783,10 @@ namespace KlayGE
 
 		auto const & shader_obj = this->GetShaderObject(effect);
 
+		// In the recording round of a DXBCCompileBatch, only the compile requests are collected
+		DXBCCompileBatch const * batch = DXBCCompileBatch::Current();
+		bool const recording = batch && batch->Recording();
+
 		for (int type = 0; type < ShaderObject::ST_NumShaderTypes; ++ type)
 		{
 			ShaderDesc& sd = effect.GetShaderDesc(shader_desc_ids_[type]);
@@ -4622,22 +4794,34 @@ namespace KlayGE
 			{
 				if (sd.tech_pass_type != 0xFFFFFFFF)
 				{
-					auto const & tech = *effect.TechniqueByIndex(sd.tech_pass_type >> 16);
-					auto const & pass = tech.Pass((sd.tech_pass_type >> 8) & 0xFF);
-					shader_obj->AttachShader(static_cast<ShaderObject::ShaderType>(type),
-						effect, tech, pass, pass.GetShaderObject(effect));
+					if (!recording)
+					{
+						auto const & tech = *effect.TechniqueByIndex(sd.tech_pass_type >> 16);
+						auto const & pass = tech.Pass((sd.tech_pass_type >> 8) & 0xFF);
+						shader_obj->AttachShader(static_cast<ShaderObject::ShaderType>(type),
+							effect, tech, pass, pass.GetShaderObject(effect));
+					}
 				}
 				else
 				{
 					auto const & tech = *effect.TechniqueByIndex(tech_index);
-					shader_obj->AttachShader(static_cast<ShaderObject::ShaderType>(type),
-						effect, tech, *this, shader_desc_ids_);
+					try
+					{
+						shader_obj->AttachShader(static_cast<ShaderObject::ShaderType>(type),
+							effect, tech, *this, shader_desc_ids_);
+					}
+					catch (DXBCCompileBatch::Recorded const &)
+					{
+					}
 					sd.tech_pass_type = (tech_index << 16) + (pass_index << 8) + type;
 				}
 			}
 		}
 
-		shader_obj->LinkShaders(effect);
+		if (!recording)
+		{
+			shader_obj->LinkShaders(effect);
+		}
 
 		is_validate_ = shader_obj->Validate();
 	}
@@ -4678,6 +4862,9 @@ namespace KlayGE
 
 		render_state_obj_ = inherit_pass->render_state_obj_;
 
+		DXBCCompileBatch const * batch = DXBCCompileBatch::Current();
+		bool const recording = batch && batch->Recording();
+
 		for (int type = 0; type < ShaderObject::ST_NumShaderTypes; ++ type)
 		{
 			ShaderDesc sd = effect.GetShaderDesc(inherit_pass->shader_desc_ids_[type]);
@@ -4688,12 +4875,21 @@ namespace KlayGE
 				shader_desc_ids_[type] = effect.AddShaderDesc(sd);
 				
 				auto const & tech = *effect.TechniqueByIndex(tech_index);
-				shader_obj->AttachShader(static_cast<ShaderObject::ShaderType>(type),
-					effect, tech, *this, shader_desc_ids_);
+				try
+				{
+					shader_obj->AttachShader(static_cast<ShaderObject::ShaderType>(type),
+						effect, tech, *this, shader_desc_ids_);
+				}
+				catch (DXBCCompileBatch::Recorded const &)
+				{
+				}
 			}
 		}
 
-		shader_obj->LinkShaders(effect);
+		if (!recording)
+		{
+			shader_obj->LinkShaders(effect);
+		}
 
 		is_validate_ = shader_obj->Validate();
 	}
@@ -6178,15 +6374,19 @@ namespace KlayGE
 		return ResLoader::Instance().SyncQueryT<RenderEffect>(MakeSharedPtr<EffectLoadingDesc>(effect_names));
 	}
 
-	RenderEffectPtr ASyncLoadRenderEffect(std::string_view effect_name)
+	RenderEffectPtr ASyncLoadRenderEffect(std::string_view effect_name, ResLoader::LoadingPriority priority)
 	{
 		// TODO: Make it really async
+		KFL_UNUSED(priority);
+
 		return ResLoader::Instance().SyncQueryT<RenderEffect>(MakeSharedPtr<EffectLoadingDesc>(std::string(effect_name)));
 	}
 
-	RenderEffectPtr ASyncLoadRenderEffects(ArrayRef<std::string> effect_names)
+	RenderEffectPtr ASyncLoadRenderEffects(ArrayRef<std::string> effect_names, ResLoader::LoadingPriority priority)
 	{
 		// TODO: Make it really async
+		KFL_UNUSED(priority);
+
 		return ResLoader::Instance().SyncQueryT<RenderEffect>(MakeSharedPtr<EffectLoadingDesc>(effect_names));
 	}
 }
@@ -135,7 +135,7 @@ namespace
 				return;
 			}
 
-			ResIdentifierPtr mtl_input = ResLoader::Instance().Open(mtl_desc_.res_name);
+			ResIdentifierPtr mtl_input = ResLoader::Instance().OpenXML(mtl_desc_.res_name);
 
 			KlayGE::XMLDocument doc;
 			XMLNodePtr root = doc.Parse(mtl_input);
@@ -371,6 +371,11 @@ namespace
 			return false;
 		}
 
+		size_t Hash() const override
+		{
+			return HashRange(mtl_desc_.res_name.begin(), mtl_desc_.res_name.end());
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -431,9 +436,11 @@ namespace KlayGE
 		return ResLoader::Instance().SyncQueryT<RenderMaterial>(MakeSharedPtr<RenderMaterialLoadingDesc>(mtlml_name));
 	}
 
-	RenderMaterialPtr ASyncLoadRenderMaterial(std::string_view mtlml_name)
+	RenderMaterialPtr ASyncLoadRenderMaterial(std::string_view mtlml_name, ResLoader::LoadingPriority priority)
 	{
 		// TODO: Make it really async
+		KFL_UNUSED(priority);
+
 		return ResLoader::Instance().SyncQueryT<RenderMaterial>(MakeSharedPtr<RenderMaterialLoadingDesc>(mtlml_name));
 	}
 
@@ -20,10 +20,15 @@
 #include <KlayGE/RenderEngine.hpp>
 #include <KlayGE/ResLoader.hpp>
 #include <KFL/CustomizedStreamBuf.hpp>
+#include <KFL/Hash.hpp>
+#include <KFL/JobSystem.hpp>
 
 #include <string>
 #include <vector>
+#include <atomic>
+#include <cstring>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <fstream>
 
@@ -125,7 +130,10 @@ namespace
 			}
 			return hr;
 #else
-			std::string mark = std::to_string(reinterpret_cast<uint64_t>(src_data.c_str()));
+			// Shaders can be compiled on several threads, the temporary files need to be unique
+			static std::atomic<uint32_t> compile_count(0);
+			std::string mark = std::to_string(reinterpret_cast<uint64_t>(src_data.c_str()))
+				+ "_" + std::to_string(compile_count.fetch_add(1));
 			std::string compile_input_file = entry_point + mark + "Input.tmp";
 			std::string compile_output_file = entry_point + mark + "Output.tmp";
 
@@ -163,16 +171,15 @@ namespace
 #ifdef KLAYGE_PLATFORM_WINDOWS
 			ss << d3dcompiler_wrapper_name << ".exe";
 #else
-			static bool first = true;
-			if (first)
-			{
-				ss << KFL_STRINGIZE(WINE_PATH) << "wineserver -p";
-				int err = system(ss.str().c_str());
-				KFL_UNUSED(err);
-				// We should hold on a persistant wineserver, or XCode will lost connection after wineserver instance close and wine may not be able to find '.exe.so' file
-				first = false;
-				ss.str(std::string());
-			}
+			static std::once_flag wineserver_flag;
+			std::call_once(wineserver_flag, []
+				{
+					std::ostringstream wineserver_ss;
+					wineserver_ss << KFL_STRINGIZE(WINE_PATH) << "wineserver -p";
+					int err = system(wineserver_ss.str().c_str());
+					KFL_UNUSED(err);
+					// We should hold on a persistant wineserver, or XCode will lost connection after wineserver instance close and wine may not be able to find '.exe.so' file
+				});
 			d3dcompiler_wrapper_name += ".exe.so";
 			std::string wrapper_path = ResLoader::Instance().Locate(d3dcompiler_wrapper_name);
 			ss << KFL_STRINGIZE(WINE_PATH) << "wine " << wrapper_path;
@@ -286,6 +293,8 @@ namespace
 		D3DStripShaderFunc DynamicD3DStripShader_;
 #endif
 	};
+
+	thread_local DXBCCompileBatch* tls_dxbc_compile_batch = nullptr;
 }
 
 #endif
@@ -299,6 +308,87 @@ namespace KlayGE
 	}
 
 #if KLAYGE_IS_DEV_PLATFORM
+	DXBCCompileBatch::DXBCCompileBatch()
+		: recording_(true), prev_batch_(tls_dxbc_compile_batch)
+	{
+		tls_dxbc_compile_batch = this;
+	}
+
+	DXBCCompileBatch::~DXBCCompileBatch()
+	{
+		tls_dxbc_compile_batch = prev_batch_;
+	}
+
+	DXBCCompileBatch* DXBCCompileBatch::Current()
+	{
+		return tls_dxbc_compile_batch;
+	}
+
+	void DXBCCompileBatch::Record(uint64_t key, std::string const & hlsl,
+		std::vector<std::pair<std::string, std::string>> const & macros,
+		char const * func_name, char const * profile, uint32_t flags)
+	{
+		BOOST_ASSERT(recording_);
+
+		if (request_indices_.find(key) == request_indices_.end())
+		{
+			request_indices_.emplace(key, static_cast<uint32_t>(requests_.size()));
+
+			requests_.push_back(Request());
+			Request& request = requests_.back();
+			request.hlsl = &hlsl;
+			request.macros = macros;
+			request.func_name = func_name;
+			request.profile = profile;
+			request.flags = flags;
+		}
+	}
+
+	void DXBCCompileBatch::Compile()
+	{
+		recording_ = false;
+
+		D3DCompilerLoader const & compiler = D3DCompilerLoader::Instance();
+		Context::Instance().JobSystemInstance().ParallelFor(0, static_cast<uint32_t>(requests_.size()), 1,
+			[this, &compiler](uint32_t begin, uint32_t end)
+			{
+				std::vector<D3D_SHADER_MACRO> macros;
+				for (uint32_t i = begin; i < end; ++ i)
+				{
+					Request& request = requests_[i];
+
+					macros.clear();
+					for (auto const & macro : request.macros)
+					{
+						macros.push_back({ macro.first.c_str(), macro.second.c_str() });
+					}
+					macros.push_back({ nullptr, nullptr });
+
+					compiler.D3DCompile(*request.hlsl, &macros[0], request.func_name.c_str(), request.profile.c_str(),
+						request.flags, 0, request.code, request.err_msg);
+				}
+			});
+	}
+
+	bool DXBCCompileBatch::Fetch(uint64_t key, std::vector<uint8_t>& code, std::string& err_msg) const
+	{
+		BOOST_ASSERT(!recording_);
+
+		auto iter = request_indices_.find(key);
+		if (iter != request_indices_.end())
+		{
+			Request const & request = requests_[iter->second];
+			code = request.code;
+			err_msg = request.err_msg;
+			return true;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+
 	std::vector<uint8_t> ShaderObject::CompileToDXBC(ShaderType type, RenderEffect const & effect,
 			RenderTechnique const & tech, RenderPass const & pass,
 			std::vector<std::pair<char const *, char const *>> const & api_special_macros,
@@ -429,9 +519,40 @@ namespace KlayGE
 			macros.push_back(macro_end);
 		}
 
-		D3DCompilerLoader::Instance().D3DCompile(hlsl_shader_text, &macros[0],
-			func_name, shader_profile,
-			flags, 0, code, err_msg);
+		DXBCCompileBatch* batch = DXBCCompileBatch::Current();
+		uint64_t batch_key = 0;
+		if (batch)
+		{
+			// The HLSL text of an effect doesn't change during a batch, its address is enough
+			std::string const * hlsl_ptr = &hlsl_shader_text;
+			batch_key = HashMemory64(&hlsl_ptr, sizeof(hlsl_ptr));
+			std::vector<std::pair<std::string, std::string>> batch_macros;
+			for (auto const & macro : macros)
+			{
+				if (macro.Name != nullptr)
+				{
+					batch_key = HashMemory64(macro.Name, strlen(macro.Name) + 1, batch_key);
+					batch_key = HashMemory64(macro.Definition, strlen(macro.Definition) + 1, batch_key);
+					batch_macros.emplace_back(macro.Name, macro.Definition);
+				}
+			}
+			batch_key = HashMemory64(func_name, strlen(func_name) + 1, batch_key);
+			batch_key = HashMemory64(shader_profile, strlen(shader_profile) + 1, batch_key);
+			batch_key = HashMemory64(&flags, sizeof(flags), batch_key);
+
+			if (batch->Recording())
+			{
+				batch->Record(batch_key, hlsl_shader_text, batch_macros, func_name, shader_profile, flags);
+				throw DXBCCompileBatch::Recorded();
+			}
+		}
+
+		if (!batch || !batch->Fetch(batch_key, code, err_msg))
+		{
+			D3DCompilerLoader::Instance().D3DCompile(hlsl_shader_text, &macros[0],
+				func_name, shader_profile,
+				flags, 0, code, err_msg);
+		}
 		if (!err_msg.empty())
 		{
 			LogError() << "Error when compiling " << func_name << ":" << std::endl;
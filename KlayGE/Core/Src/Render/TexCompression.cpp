@@ -29,6 +29,7 @@
 */
 
 #include <KlayGE/KlayGE.hpp>
+#include <KFL/JobSystem.hpp>
 #include <KlayGE/Context.hpp>
 #include <KlayGE/RenderFactory.hpp>
 #include <KlayGE/Texture.hpp>
@@ -38,6 +39,14 @@
 
 #include <KlayGE/TexCompression.hpp>
 
+#if defined(KLAYGE_SSSE3_SUPPORT) || defined(KLAYGE_AVX_SUPPORT)
+	#define TEX_DECODE_SSSE3
+	#include <tmmintrin.h>
+#elif defined(KLAYGE_NEON_SUPPORT)
+	#define TEX_DECODE_NEON
+	#include <arm_neon.h>
+#endif
+
 namespace KlayGE
 {
 	uint32_t BlockWidth(ElementFormat format)
@@ -278,7 +287,7 @@ namespace KlayGE
 	void TexCompression::EncodeMem(uint32_t width, uint32_t height,
 		void* output, uint32_t out_row_pitch, uint32_t out_slice_pitch,
 		void const * input, uint32_t in_row_pitch, uint32_t in_slice_pitch,
-		TexCompressionMethod method)
+		TexCompressionMethod method, uint32_t num_threads)
 	{
 		KFL_UNUSED(out_slice_pitch);
 		KFL_UNUSED(in_slice_pitch);
@@ -290,35 +299,53 @@ namespace KlayGE
 
 		uint8_t const * src = static_cast<uint8_t const *>(input);
 
-		std::vector<uint8_t> uncompressed(block_width * block_height * elem_size);
-		for (uint32_t y_base = 0; y_base < height; y_base += block_height)
-		{
-			uint8_t* dst = static_cast<uint8_t*>(output) + (y_base / block_height) * out_row_pitch;
+		uint32_t const num_block_rows = (height + block_height - 1) / block_height;
+		// At most num_threads chunks, so no more than num_threads threads encode at a time
+		uint32_t const grain_size = (0 == num_threads) ? 0 : (num_block_rows + num_threads - 1) / num_threads;
 
-			for (uint32_t x_base = 0; x_base < width; x_base += block_width)
+		Context::Instance().JobSystemInstance().ParallelFor(0, num_block_rows, grain_size,
+			[this, width, height, output, out_row_pitch, src, in_row_pitch, method,
+				elem_size, block_width, block_height, block_bytes](uint32_t row_begin, uint32_t row_end)
 			{
-				for (uint32_t y = 0; y < block_height; ++ y)
+				// The first chunk runs on the calling thread, and reuses this codec
+				TexCompressionPtr cloned_codec;
+				TexCompression* codec = this;
+				if (row_begin != 0)
 				{
-					for (uint32_t x = 0; x < block_width; ++ x)
+					cloned_codec = this->Clone();
+					codec = cloned_codec.get();
+				}
+
+				std::vector<uint8_t> uncompressed(block_width * block_height * elem_size);
+				for (uint32_t y_base = row_begin * block_height; y_base < row_end * block_height; y_base += block_height)
+				{
+					uint8_t* dst = static_cast<uint8_t*>(output) + (y_base / block_height) * out_row_pitch;
+
+					for (uint32_t x_base = 0; x_base < width; x_base += block_width)
 					{
-						if ((x_base + x < width) && (y_base + y < height))
+						for (uint32_t y = 0; y < block_height; ++ y)
 						{
-							memcpy(&uncompressed[(y * block_width + x) * elem_size],
-								&src[(y_base + y) * in_row_pitch + (x_base + x) * elem_size],
-								elem_size);
-						}
-						else
-						{
-							memset(&uncompressed[(y * block_width + x) * elem_size],
-								0, elem_size);
+							for (uint32_t x = 0; x < block_width; ++ x)
+							{
+								if ((x_base + x < width) && (y_base + y < height))
+								{
+									memcpy(&uncompressed[(y * block_width + x) * elem_size],
+										&src[(y_base + y) * in_row_pitch + (x_base + x) * elem_size],
+										elem_size);
+								}
+								else
+								{
+									memset(&uncompressed[(y * block_width + x) * elem_size],
+										0, elem_size);
+								}
+							}
 						}
+
+						codec->EncodeBlock(dst, &uncompressed[0], method);
+						dst += block_bytes;
 					}
 				}
-
-				this->EncodeBlock(dst, &uncompressed[0], method);
-				dst += block_bytes;
-			}
-		}
+			});
 	}
 
 	void TexCompression::DecodeMem(uint32_t width, uint32_t height,
@@ -335,13 +362,23 @@ namespace KlayGE
 
 		uint8_t * dst = static_cast<uint8_t*>(output);
 
+		// Only the blocks crossing the right or bottom edge go through a temporary block
+		uint32_t const num_whole_blocks = width / block_width;
 		std::vector<uint8_t> uncompressed(block_width * block_height * elem_size);
 		for (uint32_t y_base = 0; y_base < height; y_base += block_height)
 		{
 			uint8_t const * src = static_cast<uint8_t const *>(input) + in_row_pitch * (y_base / block_height);
 
 			uint32_t const block_h = std::min(block_height, height - y_base);
-			for (uint32_t x_base = 0; x_base < width; x_base += block_width)
+			uint32_t x_base = 0;
+			if ((block_h == block_height) && (num_whole_blocks > 0))
+			{
+				this->DecodeBlockRow(&dst[y_base * out_row_pitch], out_row_pitch, src, num_whole_blocks);
+				src += num_whole_blocks * block_bytes;
+				x_base = num_whole_blocks * block_width;
+			}
+
+			for (; x_base < width; x_base += block_width)
 			{
 				uint32_t const block_w = std::min(block_width, width - x_base);
 
@@ -360,6 +397,118 @@ namespace KlayGE
 		}
 	}
 
+	void TexCompression::DecodeBlockRow(void* output, uint32_t out_row_pitch, void const * input, uint32_t num_blocks)
+	{
+		uint32_t const elem_size = NumFormatBytes(DecodedFormat(compression_format_));
+		uint32_t const block_width = BlockWidth(compression_format_);
+		uint32_t const block_height = BlockHeight(compression_format_);
+		uint32_t const block_bytes = BlockBytes(compression_format_);
+		uint32_t const block_row_bytes = block_width * elem_size;
+
+		uint8_t* dst = static_cast<uint8_t*>(output);
+		uint8_t const * src = static_cast<uint8_t const *>(input);
+
+		std::vector<uint8_t> uncompressed(block_width * block_height * elem_size);
+		for (uint32_t i = 0; i < num_blocks; ++ i)
+		{
+			this->DecodeBlock(&uncompressed[0], src);
+			src += block_bytes;
+
+			for (uint32_t y = 0; y < block_height; ++ y)
+			{
+				memcpy(&dst[y * out_row_pitch], &uncompressed[y * block_row_bytes], block_row_bytes);
+			}
+			dst += block_row_bytes;
+		}
+	}
+
+	void TexCompression::DecodePaletteBlock(void* output, uint32_t out_row_pitch, uint32_t const * palette, uint8_t const * indices,
+		uint8_t const * alpha_palette, uint8_t const * alpha_indices)
+	{
+		uint8_t* dst = static_cast<uint8_t*>(output);
+
+#if defined(TEX_DECODE_SSSE3)
+		// Each row of 4 texels is a shuffle of the palette. The palette takes two registers, so an offset of 16 or more
+		//  selects the upper one.
+		__m128i const pal_lo = _mm_loadu_si128(reinterpret_cast<__m128i const *>(palette));
+		__m128i const pal_hi = _mm_loadu_si128(reinterpret_cast<__m128i const *>(palette + 4));
+		__m128i const idx = _mm_loadu_si128(reinterpret_cast<__m128i const *>(indices));
+		__m128i const byte_offsets = _mm_setr_epi8(0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3);
+		__m128i const texel_spread = _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+		__m128i const fifteen = _mm_set1_epi8(15);
+		__m128i const alpha_mask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+		__m128i alpha_pal = _mm_setzero_si128();
+		__m128i alpha_idx = _mm_setzero_si128();
+		if (alpha_palette != nullptr)
+		{
+			alpha_pal = _mm_loadl_epi64(reinterpret_cast<__m128i const *>(alpha_palette));
+			alpha_idx = _mm_loadu_si128(reinterpret_cast<__m128i const *>(alpha_indices));
+		}
+
+		for (uint32_t y = 0; y < 4; ++ y)
+		{
+			__m128i const spread = _mm_add_epi8(texel_spread, _mm_set1_epi8(static_cast<char>(y * 4)));
+			__m128i const offsets = _mm_add_epi8(_mm_slli_epi16(_mm_shuffle_epi8(idx, spread), 2), byte_offsets);
+			__m128i const upper = _mm_cmpgt_epi8(offsets, fifteen);
+			__m128i row = _mm_or_si128(_mm_andnot_si128(upper, _mm_shuffle_epi8(pal_lo, offsets)),
+				_mm_and_si128(upper, _mm_shuffle_epi8(pal_hi, offsets)));
+			if (alpha_palette != nullptr)
+			{
+				__m128i const alpha = _mm_shuffle_epi8(alpha_pal, _mm_shuffle_epi8(alpha_idx, spread));
+				row = _mm_or_si128(_mm_andnot_si128(alpha_mask, row), _mm_and_si128(alpha_mask, alpha));
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&dst[y * out_row_pitch]), row);
+		}
+#elif defined(TEX_DECODE_NEON)
+		// Each half row of 2 texels is a table lookup in the 32-byte palette
+		uint8_t const * pal_bytes = reinterpret_cast<uint8_t const *>(palette);
+		uint8x8x4_t const pal = { { vld1_u8(pal_bytes + 0), vld1_u8(pal_bytes + 8), vld1_u8(pal_bytes + 16), vld1_u8(pal_bytes + 24) } };
+		uint8x16_t const idx = vld1q_u8(indices);
+		uint8x8_t const byte_offsets = vcreate_u8(0x0302010003020100ULL);
+		uint8x8_t const texel_spread = vcreate_u8(0x0101010100000000ULL);
+		uint8x8_t const alpha_mask = vcreate_u8(0xFF000000FF000000ULL);
+		uint8x8_t alpha_pal = vdup_n_u8(0);
+		uint8x16_t alpha_idx = vdupq_n_u8(0);
+		if (alpha_palette != nullptr)
+		{
+			alpha_pal = vld1_u8(alpha_palette);
+			alpha_idx = vld1q_u8(alpha_indices);
+		}
+
+		for (uint32_t y = 0; y < 4; ++ y)
+		{
+			uint8x8_t const row_idx = (y < 2) ? vget_low_u8(idx) : vget_high_u8(idx);
+			uint8x8_t const alpha_row_idx = (y < 2) ? vget_low_u8(alpha_idx) : vget_high_u8(alpha_idx);
+			for (uint32_t h = 0; h < 2; ++ h)
+			{
+				uint8x8_t const spread = vadd_u8(texel_spread, vdup_n_u8(static_cast<uint8_t>((y & 1) * 4 + h * 2)));
+				uint8x8_t const offsets = vadd_u8(vshl_n_u8(vtbl1_u8(row_idx, spread), 2), byte_offsets);
+				uint8x8_t texels = vtbl4_u8(pal, offsets);
+				if (alpha_palette != nullptr)
+				{
+					texels = vbsl_u8(alpha_mask, vtbl1_u8(alpha_pal, vtbl1_u8(alpha_row_idx, spread)), texels);
+				}
+				vst1_u8(&dst[y * out_row_pitch + h * 8], texels);
+			}
+		}
+#else
+		for (uint32_t y = 0; y < 4; ++ y)
+		{
+			uint32_t row[4];
+			for (uint32_t x = 0; x < 4; ++ x)
+			{
+				uint32_t const i = y * 4 + x;
+				row[x] = palette[indices[i]];
+				if (alpha_palette != nullptr)
+				{
+					row[x] = (row[x] & 0x00FFFFFF) | (alpha_palette[alpha_indices[i]] << 24);
+				}
+			}
+			memcpy(&dst[y * out_row_pitch], row, sizeof(row));
+		}
+#endif
+	}
+
 	void TexCompression::EncodeTex(TexturePtr const & out_tex, TexturePtr const & in_tex, TexCompressionMethod method)
 	{
 		uint32_t const width = in_tex->Width(0);
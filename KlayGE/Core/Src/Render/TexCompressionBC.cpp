@@ -48,6 +48,14 @@
 #include <KlayGE/TexCompressionBC.hpp>
 #include "../Base/TableGen/Tables.hpp"
 
+#if defined(KLAYGE_SSSE3_SUPPORT) || defined(KLAYGE_AVX_SUPPORT)
+	#define TEX_DECODE_SSSE3
+	#include <tmmintrin.h>
+#elif defined(KLAYGE_NEON_SUPPORT)
+	#define TEX_DECODE_NEON
+	#include <arm_neon.h>
+#endif
+
 namespace
 {
 	using namespace KlayGE;
@@ -880,11 +888,158 @@ namespace
 		}
 	}
 
+	// Reseeded at the beginning of every block, so the result doesn't depend on which thread encodes which block
+	thread_local std::mt19937 int_rand_gen;
+
 	int IntRand()
 	{
-		static thread_local std::mt19937 gen;
 		std::uniform_int_distribution<int> random_dis(0, RAND_MAX);
-		return random_dis(gen);
+		return random_dis(int_rand_gen);
+	}
+
+	// Spreads 16 2-bit indices, texel 0 in the lowest bits, to one byte per texel
+	void UnpackIndices2Bits(uint8_t* indices, uint32_t bits)
+	{
+		for (uint32_t i = 0; i < 2; ++ i)
+		{
+			uint64_t const half = (bits >> (i * 16)) & 0xFFFF;
+			uint64_t t = (half & 0xFF) | ((half & 0xFF00) << 24);
+			t = (t & 0x0000000F0000000FULL) | ((t & 0x000000F0000000F0ULL) << 12);
+			t = (t & 0x0003000300030003ULL) | ((t & 0x000C000C000C000CULL) << 6);
+			memcpy(&indices[i * 8], &t, sizeof(t));
+		}
+	}
+
+	// Spreads 16 3-bit indices packed in 6 bytes to one byte per texel
+	void UnpackIndices3Bits(uint8_t* indices, uint8_t const * bits)
+	{
+		for (uint32_t i = 0; i < 2; ++ i)
+		{
+			uint64_t const half = bits[i * 3 + 0] | (bits[i * 3 + 1] << 8) | (bits[i * 3 + 2] << 16);
+			uint64_t t = (half & 0xFFF) | ((half & 0xFFF000) << 20);
+			t = (t & 0x0000003F0000003FULL) | ((t & 0x00000FC000000FC0ULL) << 10);
+			t = (t & 0x0007000700070007ULL) | ((t & 0x0038003800380038ULL) << 5);
+			memcpy(&indices[i * 8], &t, sizeof(t));
+		}
+	}
+
+	// The 4 colors of TexCompressionBC1::DecodeBlock, as ARGB8
+	void BC1Palette(uint32_t* palette, BC1Block const & bc1)
+	{
+		uint32_t const r0 = TexCompressionLUT::EXPAND5[(bc1.clr_0 >> 11) & 0x1F];
+		uint32_t const g0 = TexCompressionLUT::EXPAND6[(bc1.clr_0 >> 5) & 0x3F];
+		uint32_t const b0 = TexCompressionLUT::EXPAND5[(bc1.clr_0 >> 0) & 0x1F];
+		uint32_t const r1 = TexCompressionLUT::EXPAND5[(bc1.clr_1 >> 11) & 0x1F];
+		uint32_t const g1 = TexCompressionLUT::EXPAND6[(bc1.clr_1 >> 5) & 0x3F];
+		uint32_t const b1 = TexCompressionLUT::EXPAND5[(bc1.clr_1 >> 0) & 0x1F];
+
+		palette[0] = 0xFF000000 | (r0 << 16) | (g0 << 8) | b0;
+		palette[1] = 0xFF000000 | (r1 << 16) | (g1 << 8) | b1;
+		if (bc1.clr_0 > bc1.clr_1)
+		{
+			palette[2] = 0xFF000000 | (((r0 * 2 + r1) / 3) << 16) | (((g0 * 2 + g1) / 3) << 8) | ((b0 * 2 + b1) / 3);
+			palette[3] = 0xFF000000 | (((r0 + r1 * 2) / 3) << 16) | (((g0 + g1 * 2) / 3) << 8) | ((b0 + b1 * 2) / 3);
+		}
+		else
+		{
+			palette[2] = 0xFF000000 | (((r0 + r1) / 2) << 16) | (((g0 + g1) / 2) << 8) | ((b0 + b1) / 2);
+			palette[3] = 0;
+		}
+	}
+
+	// Integer form of the lerps in TexCompressionBC4::DecodeBlock. They round the same way for all endpoint pairs.
+	void BC4Palette(uint8_t* palette, BC4Block const & bc4)
+	{
+		int const a0 = bc4.alpha_0;
+		int const a1 = bc4.alpha_1;
+
+		palette[0] = bc4.alpha_0;
+		palette[1] = bc4.alpha_1;
+		if (a0 > a1)
+		{
+			for (int i = 1; i < 7; ++ i)
+			{
+				palette[i + 1] = static_cast<uint8_t>((((7 - i) * a0 + i * a1) * 2 + 7) / 14);
+			}
+		}
+		else
+		{
+			for (int i = 1; i < 5; ++ i)
+			{
+				palette[i + 1] = static_cast<uint8_t>((((5 - i) * a0 + i * a1) * 2 + 5) / 10);
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	// Writes a 4x4 block of 8-bit texels, texel i being palette[indices[i]]
+	void DecodeBC4PaletteBlock(uint8_t* output, uint32_t out_row_pitch, uint8_t const * palette, uint8_t const * indices)
+	{
+#if defined(TEX_DECODE_SSSE3)
+		__m128i texels = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(palette)),
+			_mm_loadu_si128(reinterpret_cast<__m128i const *>(indices)));
+		for (uint32_t y = 0; y < 4; ++ y)
+		{
+			int const row = _mm_cvtsi128_si32(texels);
+			memcpy(&output[y * out_row_pitch], &row, sizeof(row));
+			texels = _mm_srli_si128(texels, 4);
+		}
+#elif defined(TEX_DECODE_NEON)
+		uint8x8_t const pal = vld1_u8(palette);
+		uint8_t texels[16];
+		vst1_u8(&texels[0], vtbl1_u8(pal, vld1_u8(&indices[0])));
+		vst1_u8(&texels[8], vtbl1_u8(pal, vld1_u8(&indices[8])));
+		for (uint32_t y = 0; y < 4; ++ y)
+		{
+			memcpy(&output[y * out_row_pitch], &texels[y * 4], 4);
+		}
+#else
+		for (uint32_t y = 0; y < 4; ++ y)
+		{
+			for (uint32_t x = 0; x < 4; ++ x)
+			{
+				output[y * out_row_pitch + x] = palette[indices[y * 4 + x]];
+			}
+		}
+#endif
+	}
+
+	// Writes a 4x4 block of 16-bit texels, red in the low byte and green in the high byte
+	void DecodeBC5PaletteBlock(uint8_t* output, uint32_t out_row_pitch, uint8_t const * red_palette, uint8_t const * red_indices,
+		uint8_t const * green_palette, uint8_t const * green_indices)
+	{
+#if defined(TEX_DECODE_SSSE3)
+		__m128i const red = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(red_palette)),
+			_mm_loadu_si128(reinterpret_cast<__m128i const *>(red_indices)));
+		__m128i const green = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(green_palette)),
+			_mm_loadu_si128(reinterpret_cast<__m128i const *>(green_indices)));
+		__m128i const rows_01 = _mm_unpacklo_epi8(red, green);
+		__m128i const rows_23 = _mm_unpackhi_epi8(red, green);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(&output[0 * out_row_pitch]), rows_01);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(&output[1 * out_row_pitch]), _mm_srli_si128(rows_01, 8));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(&output[2 * out_row_pitch]), rows_23);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(&output[3 * out_row_pitch]), _mm_srli_si128(rows_23, 8));
+#elif defined(TEX_DECODE_NEON)
+		uint8x8_t const red_pal = vld1_u8(red_palette);
+		uint8x8_t const green_pal = vld1_u8(green_palette);
+		for (uint32_t i = 0; i < 2; ++ i)
+		{
+			uint8x8x2_t const rows = vzip_u8(vtbl1_u8(red_pal, vld1_u8(&red_indices[i * 8])),
+				vtbl1_u8(green_pal, vld1_u8(&green_indices[i * 8])));
+			vst1_u8(&output[(i * 2 + 0) * out_row_pitch], rows.val[0]);
+			vst1_u8(&output[(i * 2 + 1) * out_row_pitch], rows.val[1]);
+		}
+#else
+		for (uint32_t y = 0; y < 4; ++ y)
+		{
+			for (uint32_t x = 0; x < 4; ++ x)
+			{
+				output[y * out_row_pitch + x * 2 + 0] = red_palette[red_indices[y * 4 + x]];
+				output[y * out_row_pitch + x * 2 + 1] = green_palette[green_indices[y * 4 + x]];
+			}
+		}
+#endif
 	}
 }
 
@@ -897,6 +1052,11 @@ namespace KlayGE
 		compression_format_ = EF_BC1;
 	}
 
+	TexCompressionPtr TexCompressionBC1::Clone() const
+	{
+		return MakeSharedPtr<TexCompressionBC1>();
+	}
+
 	void TexCompressionBC1::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		BOOST_ASSERT(output);
@@ -966,6 +1126,24 @@ namespace KlayGE
 		}
 	}
 
+	void TexCompressionBC1::DecodeBlockRow(void* output, uint32_t out_row_pitch, void const * input, uint32_t num_blocks)
+	{
+		BOOST_ASSERT(output);
+		BOOST_ASSERT(input);
+
+		uint8_t* dst = static_cast<uint8_t*>(output);
+		BC1Block const * bc1 = static_cast<BC1Block const *>(input);
+
+		uint32_t palette[8] = { 0 };
+		uint8_t indices[16];
+		for (uint32_t i = 0; i < num_blocks; ++ i)
+		{
+			BC1Palette(palette, bc1[i]);
+			UnpackIndices2Bits(indices, bc1[i].bitmap[0] | (static_cast<uint32_t>(bc1[i].bitmap[1]) << 16));
+			DecodePaletteBlock(&dst[i * 16], out_row_pitch, palette, indices);
+		}
+	}
+
 	ARGBColor32 TexCompressionBC1::RGB565To888(uint16_t rgb) const
 	{
 		return ARGBColor32(255, EXPAND5[(rgb >> 11) & 0x1F], EXPAND6[(rgb >> 5) & 0x3F],
@@ -1384,6 +1562,11 @@ namespace KlayGE
 		compression_format_ = EF_BC2;
 	}
 
+	TexCompressionPtr TexCompressionBC2::Clone() const
+	{
+		return MakeSharedPtr<TexCompressionBC2>();
+	}
+
 	void TexCompressionBC2::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		BOOST_ASSERT(output);
@@ -1435,6 +1618,11 @@ namespace KlayGE
 		compression_format_ = EF_BC3;
 	}
 
+	TexCompressionPtr TexCompressionBC3::Clone() const
+	{
+		return MakeSharedPtr<TexCompressionBC3>();
+	}
+
 	void TexCompressionBC3::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		BOOST_ASSERT(output);
@@ -1475,12 +1663,39 @@ namespace KlayGE
 		}
 	}
 
+	void TexCompressionBC3::DecodeBlockRow(void* output, uint32_t out_row_pitch, void const * input, uint32_t num_blocks)
+	{
+		BOOST_ASSERT(output);
+		BOOST_ASSERT(input);
+
+		uint8_t* dst = static_cast<uint8_t*>(output);
+		BC3Block const * bc3 = static_cast<BC3Block const *>(input);
+
+		uint32_t palette[8] = { 0 };
+		uint8_t indices[16];
+		uint8_t alpha_palette[8];
+		uint8_t alpha_indices[16];
+		for (uint32_t i = 0; i < num_blocks; ++ i)
+		{
+			BC1Palette(palette, bc3[i].bc1);
+			UnpackIndices2Bits(indices, bc3[i].bc1.bitmap[0] | (static_cast<uint32_t>(bc3[i].bc1.bitmap[1]) << 16));
+			BC4Palette(alpha_palette, bc3[i].alpha);
+			UnpackIndices3Bits(alpha_indices, bc3[i].alpha.bitmap);
+			DecodePaletteBlock(&dst[i * 16], out_row_pitch, palette, indices, alpha_palette, alpha_indices);
+		}
+	}
+
 
 	TexCompressionBC4::TexCompressionBC4()
 	{
 		compression_format_ = EF_BC4;
 	}
 
+	TexCompressionPtr TexCompressionBC4::Clone() const
+	{
+		return MakeSharedPtr<TexCompressionBC4>();
+	}
+
 	// Alpha block compression (this is easy for a change)
 	void TexCompressionBC4::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
@@ -1581,12 +1796,35 @@ namespace KlayGE
 		}
 	}
 
+	void TexCompressionBC4::DecodeBlockRow(void* output, uint32_t out_row_pitch, void const * input, uint32_t num_blocks)
+	{
+		BOOST_ASSERT(output);
+		BOOST_ASSERT(input);
+
+		uint8_t* dst = static_cast<uint8_t*>(output);
+		BC4Block const * bc4 = static_cast<BC4Block const *>(input);
+
+		uint8_t palette[8];
+		uint8_t indices[16];
+		for (uint32_t i = 0; i < num_blocks; ++ i)
+		{
+			BC4Palette(palette, bc4[i]);
+			UnpackIndices3Bits(indices, bc4[i].bitmap);
+			DecodeBC4PaletteBlock(&dst[i * 4], out_row_pitch, palette, indices);
+		}
+	}
+
 
 	TexCompressionBC5::TexCompressionBC5()
 	{
 		compression_format_ = EF_BC5;
 	}
 
+	TexCompressionPtr TexCompressionBC5::Clone() const
+	{
+		return MakeSharedPtr<TexCompressionBC5>();
+	}
+
 	void TexCompressionBC5::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		BOOST_ASSERT(output);
@@ -1626,6 +1864,28 @@ namespace KlayGE
 		}
 	}
 
+	void TexCompressionBC5::DecodeBlockRow(void* output, uint32_t out_row_pitch, void const * input, uint32_t num_blocks)
+	{
+		BOOST_ASSERT(output);
+		BOOST_ASSERT(input);
+
+		uint8_t* dst = static_cast<uint8_t*>(output);
+		BC5Block const * bc5 = static_cast<BC5Block const *>(input);
+
+		uint8_t red_palette[8];
+		uint8_t red_indices[16];
+		uint8_t green_palette[8];
+		uint8_t green_indices[16];
+		for (uint32_t i = 0; i < num_blocks; ++ i)
+		{
+			BC4Palette(red_palette, bc5[i].red);
+			UnpackIndices3Bits(red_indices, bc5[i].red.bitmap);
+			BC4Palette(green_palette, bc5[i].green);
+			UnpackIndices3Bits(green_indices, bc5[i].green.bitmap);
+			DecodeBC5PaletteBlock(&dst[i * 8], out_row_pitch, red_palette, red_indices, green_palette, green_indices);
+		}
+	}
+
 
 	// BC6H Compression
 	TexCompressionBC6U::ModeDescriptor const TexCompressionBC6U::mode_desc_[14][82] =
@@ -1887,6 +2147,11 @@ namespace KlayGE
 		compression_format_ = EF_BC6;
 	}
 
+	TexCompressionPtr TexCompressionBC6U::Clone() const
+	{
+		return MakeSharedPtr<TexCompressionBC6U>();
+	}
+
 	void TexCompressionBC6U::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		KFL_UNUSED(output);
@@ -2138,6 +2403,11 @@ namespace KlayGE
 		compression_format_ = EF_SIGNED_BC6;
 	}
 
+	TexCompressionPtr TexCompressionBC6S::Clone() const
+	{
+		return MakeSharedPtr<TexCompressionBC6S>();
+	}
+
 	void TexCompressionBC6S::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		KFL_UNUSED(output);
@@ -2180,6 +2450,11 @@ namespace KlayGE
 		compression_format_ = EF_BC7;
 	}
 
+	TexCompressionPtr TexCompressionBC7::Clone() const
+	{
+		return MakeSharedPtr<TexCompressionBC7>();
+	}
+
 	void TexCompressionBC7::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		BOOST_ASSERT(output);
@@ -2187,6 +2462,8 @@ namespace KlayGE
 		
 		// Based on FasTC: Accelerated Texture Encoding (http://gamma.cs.unc.edu/FasTC/)
 
+		int_rand_gen.seed(std::mt19937::default_seed);
+
 		ARGBColor32 const * argb = static_cast<ARGBColor32 const *>(input);
 
 		bool uniform_block = true;
@@ -501,6 +501,39 @@ namespace
 
 		return cur_ind;
 	}
+
+	// Spreads the 8 bits of a byte to the lowest bit of 8 bytes
+	uint64_t SpreadBits(uint32_t bits)
+	{
+		return ((((bits & 0xFF) * 0x0101010101010101ULL) & 0x8040201008040201ULL) + 0x7F7F7F7F7F7F7F7FULL) >> 7
+			& 0x0101010101010101ULL;
+	}
+
+	// The selector planes are big-endian and column major. Returns them little-endian and row major.
+	uint32_t TransposeSelectorBits(uint16_t bits)
+	{
+		uint32_t x = ((bits >> 8) | (bits << 8)) & 0xFFFF;
+		uint32_t t = (x ^ (x >> 3)) & 0x0A0A;
+		x ^= t ^ (t << 3);
+		t = (x ^ (x >> 6)) & 0x00CC;
+		x ^= t ^ (t << 6);
+		return x;
+	}
+
+	// Index of texel i in the palette of TexCompressionETC1::ETC1Palette
+	void UnpackETC1Indices(uint8_t* indices, ETC1Block const & etc1)
+	{
+		uint32_t const msb = TransposeSelectorBits(etc1.msb);
+		uint32_t const lsb = TransposeSelectorBits(etc1.lsb);
+		bool const flip = etc1.cw_diff_flip & 0x1;
+		for (uint32_t i = 0; i < 2; ++ i)
+		{
+			uint64_t t = (SpreadBits(msb >> (i * 8)) << 1) | SpreadBits(lsb >> (i * 8));
+			// Sub-block 1 is the right half, or the bottom half when flipped
+			t |= flip ? (i ? 0x0404040404040404ULL : 0) : 0x0404000004040000ULL;
+			memcpy(&indices[i * 8], &t, sizeof(t));
+		}
+	}
 }
 
 namespace KlayGE
@@ -650,6 +683,11 @@ namespace KlayGE
 		sorted_luma_indices_ = nullptr;
 	}
 
+	TexCompressionPtr TexCompressionETC1::Clone() const
+	{
+		return MakeSharedPtr<TexCompressionETC1>();
+	}
+
 	void TexCompressionETC1::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		BOOST_ASSERT(output);
@@ -956,6 +994,73 @@ namespace KlayGE
 		}
 	}
 
+	void TexCompressionETC1::DecodeBlockRow(void* output, uint32_t out_row_pitch, void const * input, uint32_t num_blocks)
+	{
+		BOOST_ASSERT(output);
+		BOOST_ASSERT(input);
+
+		uint8_t* dst = static_cast<uint8_t*>(output);
+		ETC1Block const * etc1 = static_cast<ETC1Block const *>(input);
+
+		uint32_t palette[8];
+		uint8_t indices[16];
+		for (uint32_t i = 0; i < num_blocks; ++ i)
+		{
+			this->ETC1Palette(palette, etc1[i], false);
+			UnpackETC1Indices(indices, etc1[i]);
+			DecodePaletteBlock(&dst[i * 16], out_row_pitch, palette, indices);
+		}
+	}
+
+	// Colors of both sub-blocks, the one of sub-block s and selector msb * 2 + lsb being palette[s * 4 + msb * 2 + lsb].
+	//  Punch-through alpha only exists in differential mode.
+	void TexCompressionETC1::ETC1Palette(uint32_t* palette, ETC1Block const & etc1, bool alpha) const
+	{
+		uint8_t base_clr[2][3];
+		if (alpha || (etc1.cw_diff_flip & 0x2))
+		{
+			int const r = etc1.r >> 3;
+			int const dr = etc1.r & 0x7;
+			int const g = etc1.g >> 3;
+			int const dg = etc1.g & 0x7;
+			int const b = etc1.b >> 3;
+			int const db = etc1.b & 0x7;
+
+			base_clr[0][0] = Extend5To8Bits(r);
+			base_clr[0][1] = Extend5To8Bits(g);
+			base_clr[0][2] = Extend5To8Bits(b);
+			base_clr[1][0] = Extend5To8Bits(r - (dr & 0x4) + (dr & 0x3));
+			base_clr[1][1] = Extend5To8Bits(g - (dg & 0x4) + (dg & 0x3));
+			base_clr[1][2] = Extend5To8Bits(b - (db & 0x4) + (db & 0x3));
+		}
+		else
+		{
+			base_clr[0][0] = Extend4To8Bits(etc1.r >> 4);
+			base_clr[0][1] = Extend4To8Bits(etc1.g >> 4);
+			base_clr[0][2] = Extend4To8Bits(etc1.b >> 4);
+			base_clr[1][0] = Extend4To8Bits(etc1.r & 0xF);
+			base_clr[1][1] = Extend4To8Bits(etc1.g & 0xF);
+			base_clr[1][2] = Extend4To8Bits(etc1.b & 0xF);
+		}
+
+		for (int sub = 0; sub < 2; ++ sub)
+		{
+			int const cw = (etc1.cw_diff_flip >> (2 + (!sub * 3))) & 0x7;
+			for (int mod = 0; mod < 4; ++ mod)
+			{
+				int const modifier = (alpha && !(mod & 0x1)) ? 0 : GetModifier(cw, mod);
+				palette[sub * 4 + selector_index_to_etc1[mod]] = From4Ints(255, base_clr[sub][0] + modifier,
+					base_clr[sub][1] + modifier, base_clr[sub][2] + modifier).ARGB();
+			}
+		}
+
+		if (alpha)
+		{
+			palette[2] = 0;
+			palette[6] = 0;
+		}
+	}
+
 	void TexCompressionETC1::DecodeETCIndividualModeInternal(ARGBColor32* argb, ETC1Block const & etc1) const
 	{
 		BOOST_ASSERT(argb);
@@ -1836,6 +1941,11 @@ namespace KlayGE
 		etc1_codec_ = MakeSharedPtr<TexCompressionETC1>();
 	}
 
+	TexCompressionPtr TexCompressionETC2RGB8::Clone() const
+	{
+		return MakeSharedPtr<TexCompressionETC2RGB8>();
+	}
+
 	void TexCompressionETC2RGB8::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		KFL_UNUSED(output);
@@ -1885,6 +1995,46 @@ namespace KlayGE
 		}
 	}
 
+	void TexCompressionETC2RGB8::DecodeBlockRow(void* output, uint32_t out_row_pitch, void const * input, uint32_t num_blocks)
+	{
+		BOOST_ASSERT(output);
+		BOOST_ASSERT(input);
+
+		uint8_t* dst = static_cast<uint8_t*>(output);
+		ETC2Block const * etc2 = static_cast<ETC2Block const *>(input);
+
+		uint32_t palette[8];
+		uint8_t indices[16];
+		for (uint32_t i = 0; i < num_blocks; ++ i)
+		{
+			ETC1Block const & etc1 = etc2[i].etc1;
+
+			int const dr = etc1.r & 0x7;
+			int const r = (etc1.r >> 3) - (dr & 0x4) + (dr & 0x3);
+			int const dg = etc1.g & 0x7;
+			int const g = (etc1.g >> 3) - (dg & 0x4) + (dg & 0x3);
+			int const db = etc1.b & 0x7;
+			int const b = (etc1.b >> 3) - (db & 0x4) + (db & 0x3);
+
+			if ((etc1.cw_diff_flip & 0x2) && ((r | g | b) & 0xFFE0))
+			{
+				// T, H, and planar modes
+				ARGBColor32 argb[16];
+				this->DecodeBlock(argb, &etc2[i]);
+				for (uint32_t y = 0; y < 4; ++ y)
+				{
+					memcpy(&dst[y * out_row_pitch + i * 16], &argb[y * 4], 4 * sizeof(ARGBColor32));
+				}
+			}
+			else
+			{
+				etc1_codec_->ETC1Palette(palette, etc1, false);
+				UnpackETC1Indices(indices, etc1);
+				DecodePaletteBlock(&dst[i * 16], out_row_pitch, palette, indices);
+			}
+		}
+	}
+
 	void TexCompressionETC2RGB8::DecodeETCTModeInternal(ARGBColor32* argb, ETC2TModeBlock const & etc2, bool alpha)
 	{
 		BOOST_ASSERT(argb);
@@ -2057,6 +2207,11 @@ namespace KlayGE
 		etc2_rgb8_codec_ = MakeSharedPtr<TexCompressionETC2RGB8>();
 	}
 
+	TexCompressionPtr TexCompressionETC2RGB8A1::Clone() const
+	{
+		return MakeSharedPtr<TexCompressionETC2RGB8A1>();
+	}
+
 	void TexCompressionETC2RGB8A1::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		KFL_UNUSED(output);
@@ -2099,4 +2254,44 @@ namespace KlayGE
 			etc1_codec_->DecodeETCDifferentialModeInternal(argb, etc2.etc1, !op);
 		}
 	}
+
+	void TexCompressionETC2RGB8A1::DecodeBlockRow(void* output, uint32_t out_row_pitch, void const * input, uint32_t num_blocks)
+	{
+		BOOST_ASSERT(output);
+		BOOST_ASSERT(input);
+
+		uint8_t* dst = static_cast<uint8_t*>(output);
+		ETC2Block const * etc2 = static_cast<ETC2Block const *>(input);
+
+		uint32_t palette[8];
+		uint8_t indices[16];
+		for (uint32_t i = 0; i < num_blocks; ++ i)
+		{
+			ETC1Block const & etc1 = etc2[i].etc1;
+
+			int const dr = etc1.r & 0x7;
+			int const r = (etc1.r >> 3) - (dr & 0x4) + (dr & 0x3);
+			int const dg = etc1.g & 0x7;
+			int const g = (etc1.g >> 3) - (dg & 0x4) + (dg & 0x3);
+			int const db = etc1.b & 0x7;
+			int const b = (etc1.b >> 3) - (db & 0x4) + (db & 0x3);
+
+			if ((r | g | b) & 0xFFE0)
+			{
+				// T, H, and planar modes
+				ARGBColor32 argb[16];
+				this->DecodeBlock(argb, &etc2[i]);
+				for (uint32_t y = 0; y < 4; ++ y)
+				{
+					memcpy(&dst[y * out_row_pitch + i * 16], &argb[y * 4], 4 * sizeof(ARGBColor32));
+				}
+			}
+			else
+			{
+				etc1_codec_->ETC1Palette(palette, etc1, !(etc1.cw_diff_flip & 0x2));
+				UnpackETC1Indices(indices, etc1);
+				DecodePaletteBlock(&dst[i * 16], out_row_pitch, palette, indices);
+			}
+		}
+	}
 }
@@ -815,7 +815,7 @@ namespace
 
 	void EncodeTexture(void* dst_data, uint32_t dst_row_pitch, uint32_t dst_slice_pitch, ElementFormat dst_format,
 		void const * src_data, uint32_t src_row_pitch, uint32_t src_slice_pitch, ElementFormat src_format,
-		uint32_t src_width, uint32_t src_height, uint32_t src_depth)
+		uint32_t src_width, uint32_t src_height, uint32_t src_depth, uint32_t num_threads)
 	{
 		BOOST_ASSERT(IsCompressedFormat(dst_format) && !IsCompressedFormat(src_format));
 		KFL_UNUSED(src_format);
@@ -907,7 +907,7 @@ namespace
 		for (uint32_t z = 0; z < src_depth; ++ z)
 		{
 			codec->EncodeMem(src_width, src_height, dst, dst_row_pitch, dst_slice_pitch,
-				src, src_row_pitch, src_slice_pitch, TCM_Quality);
+				src, src_row_pitch, src_slice_pitch, TCM_Quality, num_threads);
 
 			src += src_slice_pitch;
 			dst += dst_slice_pitch;
@@ -1309,6 +1309,13 @@ namespace
 			return false;
 		}
 
+		size_t Hash() const override
+		{
+			size_t seed = HashRange(tex_desc_.res_name.begin(), tex_desc_.res_name.end());
+			HashCombine(seed, tex_desc_.access_hint);
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -2148,12 +2155,27 @@ namespace KlayGE
 		}
 
 		std::vector<size_t> base;
+		std::vector<void const *> views;
+		// Memory mapped resources are referenced in place, SoftwareTexture makes the only copy
+		auto read_subres = [&tex_res, &data_block, &base, &views](size_t index, uint32_t size)
+		{
+			views[index] = tex_res->ReadView(size);
+			if (!views[index])
+			{
+				base[index] = data_block.size();
+				data_block.resize(base[index] + size);
+				tex_res->read(&data_block[base[index]], static_cast<std::streamsize>(size));
+				BOOST_ASSERT(tex_res->gcount() == static_cast<int>(size));
+			}
+		};
+
 		switch (type)
 		{
 		case Texture::TT_1D:
 			{
 				init_data.resize(array_size * num_mipmaps);
 				base.resize(array_size * num_mipmaps);
+				views.resize(array_size * num_mipmaps);
 				for (uint32_t array_index = 0; array_index < array_size; ++ array_index)
 				{
 					uint32_t the_width = width;
@@ -2171,13 +2193,10 @@ namespace KlayGE
 							image_size = (padding ? ((the_width + 3) & ~3) : the_width) * fmt_size;
 						}
 
-						base[index] = data_block.size();
-						data_block.resize(base[index] + image_size);
 						init_data[index].row_pitch = image_size;
 						init_data[index].slice_pitch = image_size;
 
-						tex_res->read(&data_block[base[index]], static_cast<std::streamsize>(image_size));
-						BOOST_ASSERT(tex_res->gcount() == static_cast<int>(image_size));
+						read_subres(index, image_size);
 
 						the_width = std::max<uint32_t>(the_width / 2, 1);
 					}
@@ -2189,6 +2208,7 @@ namespace KlayGE
 			{
 				init_data.resize(array_size * num_mipmaps);
 				base.resize(array_size * num_mipmaps);
+				views.resize(array_size * num_mipmaps);
 				for (uint32_t array_index = 0; array_index < array_size; ++ array_index)
 				{
 					uint32_t the_width = width;
@@ -2201,23 +2221,17 @@ namespace KlayGE
 							uint32_t const block_size = NumFormatBytes(format) * 4;
 							uint32_t image_size = ((the_width + 3) / 4) * ((the_height + 3) / 4) * block_size;
 
-							base[index] = data_block.size();
-							data_block.resize(base[index] + image_size);
 							init_data[index].row_pitch = (the_width + 3) / 4 * block_size;
 							init_data[index].slice_pitch = image_size;
 
-							tex_res->read(&data_block[base[index]], static_cast<std::streamsize>(image_size));
-							BOOST_ASSERT(tex_res->gcount() == static_cast<int>(image_size));
+							read_subres(index, image_size);
 						}
 						else
 						{
 							init_data[index].row_pitch = (padding ? ((the_width + 3) & ~3) : the_width) * fmt_size;
 							init_data[index].slice_pitch = init_data[index].row_pitch * the_height;
-							base[index] = data_block.size();
-							data_block.resize(base[index] + init_data[index].slice_pitch);
 
-							tex_res->read(&data_block[base[index]], static_cast<std::streamsize>(init_data[index].slice_pitch));
-							BOOST_ASSERT(tex_res->gcount() == static_cast<int>(init_data[index].slice_pitch));
+							read_subres(index, init_data[index].slice_pitch);
 						}
 
 						the_width = std::max<uint32_t>(the_width / 2, 1);
@@ -2231,6 +2245,7 @@ namespace KlayGE
 			{
 				init_data.resize(array_size * num_mipmaps);
 				base.resize(array_size * num_mipmaps);
+				views.resize(array_size * num_mipmaps);
 				for (uint32_t array_index = 0; array_index < array_size; ++ array_index)
 				{
 					uint32_t the_width = width;
@@ -2244,23 +2259,17 @@ namespace KlayGE
 							uint32_t const block_size = NumFormatBytes(format) * 4;
 							uint32_t image_size = ((the_width + 3) / 4) * ((the_height + 3) / 4) * the_depth * block_size;
 
-							base[index] = data_block.size();
-							data_block.resize(base[index] + image_size);
 							init_data[index].row_pitch = (the_width + 3) / 4 * block_size;
 							init_data[index].slice_pitch = ((the_width + 3) / 4) * ((the_height + 3) / 4) * block_size;
 
-							tex_res->read(&data_block[base[index]], static_cast<std::streamsize>(image_size));
-							BOOST_ASSERT(tex_res->gcount() == static_cast<int>(image_size));
+							read_subres(index, image_size);
 						}
 						else
 						{
 							init_data[index].row_pitch = (padding ? ((the_width + 3) & ~3) : the_width) * fmt_size;
 							init_data[index].slice_pitch = init_data[index].row_pitch * the_height;
-							base[index] = data_block.size();
-							data_block.resize(base[index] + init_data[index].slice_pitch * the_depth);
 
-							tex_res->read(&data_block[base[index]], static_cast<std::streamsize>(init_data[index].slice_pitch * the_depth));
-							BOOST_ASSERT(tex_res->gcount() == static_cast<int>(init_data[index].slice_pitch * the_depth));
+							read_subres(index, init_data[index].slice_pitch * the_depth);
 						}
 
 						the_width = std::max<uint32_t>(the_width / 2, 1);
@@ -2275,6 +2284,7 @@ namespace KlayGE
 			{
 				init_data.resize(array_size * 6 * num_mipmaps);
 				base.resize(array_size * 6 * num_mipmaps);
+				views.resize(array_size * 6 * num_mipmaps);
 				for (uint32_t array_index = 0; array_index < array_size; ++ array_index)
 				{
 					for (uint32_t face = Texture::CF_Positive_X; face <= Texture::CF_Negative_Z; ++ face)
@@ -2289,23 +2299,17 @@ namespace KlayGE
 								uint32_t const block_size = NumFormatBytes(format) * 4;
 								uint32_t image_size = ((the_width + 3) / 4) * ((the_height + 3) / 4) * block_size;
 
-								base[index] = data_block.size();
-								data_block.resize(base[index] + image_size);
 								init_data[index].row_pitch = (the_width + 3) / 4 * block_size;
 								init_data[index].slice_pitch = image_size;
 
-								tex_res->read(&data_block[base[index]], static_cast<std::streamsize>(image_size));
-								BOOST_ASSERT(tex_res->gcount() == static_cast<int>(image_size));
+								read_subres(index, image_size);
 							}
 							else
 							{
 								init_data[index].row_pitch = (padding ? ((the_width + 3) & ~3) : the_width) * fmt_size;
 								init_data[index].slice_pitch = init_data[index].row_pitch * the_width;
-								base[index] = data_block.size();
-								data_block.resize(base[index] + init_data[index].slice_pitch);
 
-								tex_res->read(&data_block[base[index]], static_cast<std::streamsize>(init_data[index].slice_pitch));
-								BOOST_ASSERT(tex_res->gcount() == static_cast<int>(init_data[index].slice_pitch));
+								read_subres(index, init_data[index].slice_pitch);
 							}
 
 							the_width = std::max<uint32_t>(the_width / 2, 1);
@@ -2319,7 +2323,7 @@ namespace KlayGE
 
 		for (size_t i = 0; i < base.size(); ++ i)
 		{
-			init_data[i].data = &data_block[base[i]];
+			init_data[i].data = views[i] ? views[i] : &data_block[base[i]];
 		}
 
 		auto ret = MakeSharedPtr<SoftwareTexture>(type, width, height, depth,
@@ -2333,9 +2337,9 @@ namespace KlayGE
 		return ResLoader::Instance().SyncQueryT<Texture>(MakeSharedPtr<TextureLoadingDesc>(tex_name, access_hint));
 	}
 
-	TexturePtr ASyncLoadTexture(std::string_view tex_name, uint32_t access_hint)
+	TexturePtr ASyncLoadTexture(std::string_view tex_name, uint32_t access_hint, ResLoader::LoadingPriority priority)
 	{
-		return ResLoader::Instance().ASyncQueryT<Texture>(MakeSharedPtr<TextureLoadingDesc>(tex_name, access_hint));
+		return ResLoader::Instance().ASyncQueryT<Texture>(MakeSharedPtr<TextureLoadingDesc>(tex_name, access_hint), priority);
 	}
 
 	void SaveTexture(std::string const & tex_name, Texture::TextureType type,
@@ -3468,7 +3472,7 @@ namespace KlayGE
 		uint32_t dst_width, uint32_t dst_height, uint32_t dst_depth,
 		void const * src_data, uint32_t src_row_pitch, uint32_t src_slice_pitch, ElementFormat src_format,
 		uint32_t src_width, uint32_t src_height, uint32_t src_depth,
-		bool linear)
+		bool linear, uint32_t num_threads)
 	{
 		std::vector<uint8_t> src_cpu_data_block;
 		void* src_cpu_data;
@@ -3694,7 +3698,7 @@ namespace KlayGE
 		{
 			EncodeTexture(dst_data, dst_row_pitch, dst_slice_pitch, dst_format,
 				dst_cpu_data, dst_cpu_row_pitch, dst_cpu_slice_pitch, dst_cpu_format,
-				dst_width, dst_height, dst_depth);
+				dst_width, dst_height, dst_depth, num_threads);
 		}
 	}
 
@@ -35,13 +35,17 @@
 #include <KlayGE/App3D.hpp>
 
 #include <cstring>
+#include <thread>
 
 #include <KlayGE/TransientBuffer.hpp>
 
 namespace KlayGE
 {
 	TransientBuffer::TransientBuffer(uint32_t size_in_byte, TransientBuffer::BindFlag bind_flag)
-		: bind_flag_(bind_flag)
+		: bind_flag_(bind_flag), capacity_(size_in_byte),
+			head_pos_(0), tail_pos_(0), upload_pos_(0),
+			first_fence_(0), num_fences_(1),
+			num_writers_(0), growing_(false)
 	{
 		RenderFactory& rf = Context::Instance().RenderFactoryInstance();
 		RenderEngine const & re = rf.RenderEngineInstance();
@@ -56,16 +60,11 @@ namespace KlayGE
 		else
 		{
 			num_pre_frames_ = 1;
-			simulate_buffer_.resize(buffer_->Size());
-			valid_min_ = 0;
-			valid_max_ = 0;
 		}
+		cpu_buffer_.resize(size_in_byte);
 
-		SubAlloc alloc(0, size_in_byte);
-		free_list_.push_back(alloc);
-
-		App3DFramework const & app = Context::Instance().AppInstance();
-		retired_frames_.push_back(RetiredFrame(app.TotalNumFrames() + 1));
+		fences_[0].begin_pos = 0;
+		fences_[0].frame_id = 0;
 	}
 
 	GraphicsBufferPtr TransientBuffer::DoCreateBuffer(TransientBuffer::BindFlag bind_flag, uint32_t size_in_byte)
@@ -90,205 +89,144 @@ namespace KlayGE
 
 	SubAlloc TransientBuffer::Alloc(uint32_t size_in_byte, void const * data)
 	{
-		SubAlloc ret;
-
-		// Use first fit method to find a free sub alloc
-		bool found = false;
-		auto iter = free_list_.begin();
-		auto first_fit_iter = iter;
-		for (; iter != free_list_.end(); ++ iter)
+		for (;;)
 		{
-			if (iter->length_ >= size_in_byte)
+			// A writer registers itself before checking growing_, and Grow sets growing_ before waiting for
+			//  the writers to leave. So capacity_ and cpu_buffer_ don't change under a registered writer.
+			++ num_writers_;
+			if (!growing_)
 			{
-				first_fit_iter = iter;
-				found = true;
-				break;
-			}
-		}
+				uint64_t pos = head_pos_.load(std::memory_order_relaxed);
+				uint64_t new_pos;
+				uint32_t offset;
+				bool fit;
+				do
+				{
+					fit = this->TryBump(size_in_byte, pos, new_pos, offset);
+				} while (fit && !head_pos_.compare_exchange_weak(pos, new_pos, std::memory_order_relaxed));
 
-		// If there is not enough space, reallocate a larger buffer.
-		if (!found)
-		{
-			uint32_t const old_buffer_size = buffer_->Size();
-			uint32_t larger_buffer_size = std::max(old_buffer_size * 2, old_buffer_size + size_in_byte);
-			GraphicsBufferPtr larger_buffer = this->DoCreateBuffer(bind_flag_, larger_buffer_size);
-			SubAlloc alloc(old_buffer_size, larger_buffer_size - old_buffer_size);
-			if (!free_list_.empty() && (free_list_.back().offset_ + free_list_.back().length_ == alloc.offset_))
-			{
-				free_list_.back().length_ += alloc.length_;
-			}
-			else
-			{
-				free_list_.push_back(alloc);
-			}
-			first_fit_iter = free_list_.end();
-			-- first_fit_iter;
-			if (use_no_overwrite_)
-			{
-				buffer_->CopyToBuffer(*larger_buffer);
-			}
-			else
-			{
-				simulate_buffer_.resize(larger_buffer_size);
+				if (fit)
+				{
+					memcpy(&cpu_buffer_[offset], data, size_in_byte);
+					-- num_writers_;
+					return SubAlloc(offset, size_in_byte);
+				}
 			}
-			buffer_ = larger_buffer;
-		}
+			-- num_writers_;
 
-		uint32_t left_size = first_fit_iter->length_ - size_in_byte;
-		ret.length_ = size_in_byte;
-		ret.offset_ = first_fit_iter->offset_;
-		if (0 == left_size)
-		{
-			free_list_.erase(first_fit_iter);
+			this->Grow(size_in_byte);
 		}
-		else
+	}
+
+	// Computes where an allocation starting at pos ends up. If it doesn't fit before the end of the buffer, the rest
+	//  of the buffer is skipped and the allocation starts at offset 0.
+	bool TransientBuffer::TryBump(uint32_t size_in_byte, uint64_t& pos, uint64_t& new_pos, uint32_t& offset) const
+	{
+		offset = static_cast<uint32_t>(pos % capacity_);
+		new_pos = pos + size_in_byte;
+		if (offset + size_in_byte > capacity_)
 		{
-			first_fit_iter->length_ = left_size;
-			first_fit_iter->offset_ += size_in_byte;
+			new_pos += capacity_ - offset;
+			offset = 0;
 		}
+		return new_pos - tail_pos_ <= capacity_;
+	}
 
-		if (use_no_overwrite_)
+	void TransientBuffer::Grow(uint32_t size_in_byte)
+	{
+		std::lock_guard<std::mutex> lock(grow_mutex_);
+
+		growing_ = true;
+		while (num_writers_ > 0)
 		{
-			GraphicsBuffer::Mapper mapper(*buffer_, BA_Write_No_Overwrite);
-			uint8_t* buffer_data = mapper.Pointer<uint8_t>();
-			memcpy(buffer_data + ret.offset_, data, ret.length_);
+			std::this_thread::yield();
 		}
-		else
+
+		// Another thread could have grown the buffer while this one was waiting for the lock
+		uint64_t pos = head_pos_;
+		uint64_t new_pos;
+		uint32_t offset;
+		if (!this->TryBump(size_in_byte, pos, new_pos, offset))
 		{
-			memcpy(&simulate_buffer_[ret.offset_], data, ret.length_);
-			valid_min_ = std::min(valid_min_, ret.offset_);
-			valid_max_ = std::max(valid_max_, ret.offset_ + ret.length_);
+			uint32_t const old_capacity = capacity_;
+			uint32_t const new_capacity = std::max(old_capacity * 2, old_capacity + size_in_byte);
+			buffer_ = this->DoCreateBuffer(bind_flag_, new_capacity);
+			cpu_buffer_.resize(new_capacity);
+			capacity_ = new_capacity;
+
+			// Previous frames keep rendering from the old buffer. Only the allocations of the current frame have
+			//  to be in the new one. They are all inside [0, old_capacity), so the ring restarts after them.
+			first_fence_ = 0;
+			num_fences_ = 1;
+			fences_[0].begin_pos = 0;
+			fences_[0].frame_id = 0;
+
+			tail_pos_ = 0;
+			upload_pos_ = 0;
+			head_pos_ = old_capacity;
 		}
 
-		return ret;
+		growing_ = false;
 	}
 
-	void TransientBuffer::Dealloc(SubAlloc const & alloc)
+	void TransientBuffer::CopyRange(uint8_t* dst, uint64_t begin_pos, uint64_t end_pos) const
 	{
-		if ((alloc.length_ > 0) && !retired_frames_.empty())
-		{
-			RetiredFrame& frame = retired_frames_.back();
-			frame.pending_frees_.push_back(alloc);
+		BOOST_ASSERT(end_pos - begin_pos <= capacity_);
 
-			if (!use_no_overwrite_)
-			{
-				if (alloc.offset_ == valid_min_)
-				{
-					valid_min_ += alloc.length_;
-				}
-				if (alloc.offset_ + alloc.length_ == valid_max_)
-				{
-					valid_max_ -= alloc.length_;
-				}
-			}
+		uint32_t const begin_offset = static_cast<uint32_t>(begin_pos % capacity_);
+		uint32_t const length = static_cast<uint32_t>(end_pos - begin_pos);
+		uint32_t const first_length = std::min(length, capacity_ - begin_offset);
+		memcpy(dst + begin_offset, &cpu_buffer_[begin_offset], first_length);
+		if (length > first_length)
+		{
+			memcpy(dst, &cpu_buffer_[0], length - first_length);
 		}
 	}
 
 	void TransientBuffer::OnPresent()
 	{
-		if (!retired_frames_.empty())
+		App3DFramework const & app = Context::Instance().AppInstance();
+		uint32_t const frame_id = app.TotalNumFrames();
+		uint64_t const head_pos = head_pos_;
+
+		// First, close the open fence if anything is allocated in it. When out of fences, the open one is kept and
+		//  its allocations are retired with the ones of a later frame.
+		FrameFence& open_fence = fences_[(first_fence_ + num_fences_ - 1) % MAX_FRAME_FENCES];
+		if ((head_pos != open_fence.begin_pos) && (num_fences_ < MAX_FRAME_FENCES))
 		{
-			App3DFramework const & app = Context::Instance().AppInstance();
-			uint32_t const frame_id = app.TotalNumFrames();
+			open_fence.frame_id = frame_id;
 
-			// First, deal with deletes from this frame
-			RetiredFrame& ret_frame = retired_frames_.back();
-			if (!ret_frame.pending_frees_.empty()) 
-			{
-				// Append a new (empty) RetiredFrame to retired_frames_
-				retired_frames_.push_back(RetiredFrame(frame_id + 1));
-			}
-			// Second, return pending frees to free_list
-			auto frame_iter = retired_frames_.begin();
-			for (; frame_iter != retired_frames_.end();)
-			{
-				if (frame_iter->frame_id + num_pre_frames_ <= frame_id)
-				{
-					auto iter = frame_iter->pending_frees_.begin();
-					for (; iter != frame_iter->pending_frees_.end(); ++ iter)
-					{
-						this->DoFree(*iter);
-					}
-					frame_iter = retired_frames_.erase(frame_iter);
-				}
-				else
-				{
-					++ frame_iter;
-				}
-			}
+			FrameFence& fence = fences_[(first_fence_ + num_fences_) % MAX_FRAME_FENCES];
+			fence.begin_pos = head_pos;
+			fence.frame_id = 0;
+			++ num_fences_;
 		}
-	}
 
-	void TransientBuffer::DoFree(SubAlloc const & alloc)
-	{
-		if (free_list_.empty())
+		// Second, return the space of the frames the GPU has finished with
+		while ((num_fences_ > 1) && (fences_[first_fence_].frame_id + num_pre_frames_ <= frame_id))
 		{
-			free_list_.push_back(alloc);
-		}
-		else
-		{
-			// Find where to insert the alloc
-			auto insert_position = free_list_.begin();
-			while (insert_position != free_list_.end())
-			{
-				if (insert_position->offset_ > alloc.offset_)
-				{
-					break;
-				}
-				++ insert_position;
-			}
-
-			bool left_merged = false;
-			// If the alloc is adjacent to previous alloc, merge them.
-			auto previous = insert_position;
-			if (insert_position != free_list_.begin())
-			{
-				-- previous;
-				if (previous->offset_ + previous->length_ == alloc.offset_)
-				{
-					previous->length_ += alloc.length_;
-					left_merged = true;
-				}
-			}
-
-			bool right_merged = false;
-			// If the alloc is adjecent to next alloc, merge them.
-			auto next = insert_position;
-			if (insert_position != free_list_.end())
-			{
-				if (left_merged)
-				{
-					if (previous->offset_ + previous->length_ == next->offset_)
-					{
-						previous->length_ += next->length_;
-						free_list_.erase(next);
-						right_merged = true;
-					}
-				}
-				else
-				{
-					if (alloc.offset_ + alloc.length_ == next->offset_)
-					{
-						next->offset_ -= alloc.length_;
-						next->length_ += alloc.length_;
-						right_merged = true;
-					}
-				}
-			}
-			if (!(left_merged || right_merged))
-			{
-				free_list_.emplace(insert_position, alloc);
-			}
+			first_fence_ = (first_fence_ + 1) % MAX_FRAME_FENCES;
+			-- num_fences_;
 		}
+		tail_pos_ = fences_[first_fence_].begin_pos;
 	}
 
 	void TransientBuffer::EnsureDataReady()
 	{
-		if (!use_no_overwrite_)
+		uint64_t const head_pos = head_pos_;
+		if (use_no_overwrite_)
+		{
+			if (upload_pos_ != head_pos)
+			{
+				GraphicsBuffer::Mapper mapper(*buffer_, BA_Write_No_Overwrite);
+				this->CopyRange(mapper.Pointer<uint8_t>(), upload_pos_, head_pos);
+				upload_pos_ = head_pos;
+			}
+		}
+		else
 		{
 			GraphicsBuffer::Mapper mapper(*buffer_, BA_Write_Only);
-			memcpy(mapper.Pointer<uint8_t>() + valid_min_, &simulate_buffer_[valid_min_],
-				valid_max_ - valid_min_);
+			this->CopyRange(mapper.Pointer<uint8_t>(), tail_pos_, head_pos);
 		}
 	}
 }
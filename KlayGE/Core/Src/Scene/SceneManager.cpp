@@ -53,7 +53,11 @@
 #include <KlayGE/InputFactory.hpp>
 #include <KlayGE/FrameBuffer.hpp>
 #include <KlayGE/DeferredRenderingLayer.hpp>
+#include <KlayGE/PerfProfiler.hpp>
 #include <KFL/Hash.hpp>
+#include <KFL/SIMDMath.hpp>
+#include <KFL/JobSystem.hpp>
+#include <KFL/RadixSort.hpp>
 
 #include <map>
 #include <algorithm>
@@ -125,9 +129,40 @@ namespace KlayGE
 			}
 		}
 
-		for (auto const & obj : scene_objs_)
+		// Tests the bounds of all cullable objects against the frustum in one go, instead of calling AABBVisible
+		//  one object at a time
+		uint32_t const num_objs = static_cast<uint32_t>(scene_objs_.size());
+		if (!camera.OmniDirectionalMode())
 		{
-			auto so = obj.get();
+			scene_obj_bounds_.Resize(num_objs);
+			for (uint32_t i = 0; i < num_objs; ++ i)
+			{
+				auto so = scene_objs_[i].get();
+				uint32_t const attr = so->Attrib();
+				if (attr & SceneObject::SOA_Cullable)
+				{
+					if ((attr & SceneObject::SOA_Moveable) && so->Visible())
+					{
+						so->UpdateAbsModelMatrix();
+					}
+					scene_obj_bounds_.Set(i, so->PosBoundWS());
+				}
+			}
+
+			scene_obj_overlaps_.resize(num_objs);
+			if (frustum_)
+			{
+				SIMDMathLib::IntersectAABBFrustum(scene_obj_overlaps_.data(), scene_obj_bounds_, *frustum_);
+			}
+			else
+			{
+				std::fill(scene_obj_overlaps_.begin(), scene_obj_overlaps_.end(), BO_Yes);
+			}
+		}
+
+		for (uint32_t i = 0; i < num_objs; ++ i)
+		{
+			auto so = scene_objs_[i].get();
 			BoundOverlap visible;
 			uint32_t const attr = so->Attrib();
 			if (so->Visible())
@@ -161,7 +196,7 @@ namespace KlayGE
 					if (!camera.OmniDirectionalMode() && (attr & SceneObject::SOA_Cullable)
 						&& (BO_Yes == visible))
 					{
-						visible = this->AABBVisible(so->PosBoundWS());
+						visible = scene_obj_overlaps_[i];
 					}
 				}
 			}
@@ -357,20 +392,12 @@ namespace KlayGE
 			{
 				RenderTechnique const * obj_tech = obj->GetRenderTechnique();
 				BOOST_ASSERT(obj_tech);
-				bool found = false;
-				for (auto& items : render_queue_)
+				auto iter = render_tech_indices_.emplace(obj_tech, static_cast<uint32_t>(render_techs_.size())).first;
+				if (iter->second == render_techs_.size())
 				{
-					if (items.first == obj_tech)
-					{
-						items.second.push_back(obj);
-						found = true;
-						break;
-					}
-				}
-				if (!found)
-				{
-					render_queue_.emplace_back(obj_tech, std::vector<Renderable*>(1, obj));
+					render_techs_.push_back(obj_tech);
 				}
+				render_queue_.push_back({ iter->second, obj });
 			}
 		}
 	}
@@ -459,6 +486,10 @@ namespace KlayGE
 	/////////////////////////////////////////////////////////////////////////////////
 	void SceneManager::Update()
 	{
+#ifndef KLAYGE_SHIP
+		PerfZone zone("SceneManager::Update");
+#endif
+
 		deferred_mode_ = !!Context::Instance().DeferredRenderingLayerInstance();
 
 		App3DFramework& app = Context::Instance().AppInstance();
@@ -635,66 +666,117 @@ namespace KlayGE
 			}
 		}
 
-		std::sort(render_queue_.begin(), render_queue_.end(),
-			[](std::pair<RenderTechnique const *, std::vector<Renderable*>> const & lhs,
-				std::pair<RenderTechnique const *, std::vector<Renderable*>> const & rhs)
-			{
-				BOOST_ASSERT(lhs.first);
-				BOOST_ASSERT(rhs.first);
+		this->BuildRenderQueueKeys(camera);
 
-				return lhs.first->Weight() < rhs.first->Weight();
-			});
+		render_queue_scratch_.resize(render_queue_.size());
+		RadixSort(render_queue_.data(), render_queue_scratch_.data(), static_cast<uint32_t>(render_queue_.size()),
+			&Context::Instance().JobSystemInstance());
 
-		float4 const & view_mat_z = camera.ViewMatrix().Col(2);
-		for (auto& items : render_queue_)
+		for (auto const & item : render_queue_)
 		{
-			if (!items.first->Transparent() && !items.first->HasDiscard() && (items.second.size() > 1))
-			{
-				std::vector<std::pair<float, uint32_t>> min_depths(items.second.size());
-				for (size_t j = 0; j < min_depths.size(); ++ j)
-				{
-					Renderable const * renderable = items.second[j];
-					AABBox const & box = renderable->PosBound();
-					uint32_t const num = renderable->NumInstances();
-					float md = 1e10f;
-					for (uint32_t i = 0; i < num; ++ i)
-					{
-						float4x4 const & mat = renderable->GetInstance(i)->ModelMatrix();
-						float4 const zvec(MathLib::dot(mat.Row(0), view_mat_z),
-							MathLib::dot(mat.Row(1), view_mat_z), MathLib::dot(mat.Row(2), view_mat_z),
-							MathLib::dot(mat.Row(3), view_mat_z));
-						for (int k = 0; k < 8; ++ k)
-						{
-							float3 const v = box.Corner(k);
-							md = std::min(md, v.x() * zvec.x() + v.y() * zvec.y() + v.z() * zvec.z() + zvec.w());
-						}
-					}
+			item.renderable->Render();
+		}
+		num_renderables_rendered_ += static_cast<uint32_t>(render_queue_.size());
 
-					min_depths[j] = std::make_pair(md, static_cast<uint32_t>(j));
-				}
+		render_queue_.resize(0);
+		render_techs_.resize(0);
+		render_tech_indices_.clear();
 
-				std::sort(min_depths.begin(), min_depths.end());
+		num_primitives_rendered_ += re.NumPrimitivesJustRendered();
+		num_vertices_rendered_ += re.NumVerticesJustRendered();
 
-				std::vector<Renderable*> sorted_items(min_depths.size());
-				for (size_t j = 0; j < min_depths.size(); ++ j)
-				{
-					sorted_items[j] = items.second[min_depths[j].second];
-				}
-				items.second.swap(sorted_items);
-			}
+		urt_ = 0;
+	}
 
-			for (auto const & item : items.second)
+	void SceneManager::BuildRenderQueueKeys(Camera const & camera)
+	{
+		uint32_t const num_techs = static_cast<uint32_t>(render_techs_.size());
+		BOOST_ASSERT(num_techs <= 0x10000);
+
+		std::vector<uint32_t> tech_ranks(num_techs);
+		{
+			std::vector<uint32_t> tech_order(num_techs);
+			for (uint32_t i = 0; i < num_techs; ++ i)
 			{
-				item->Render();
+				tech_order[i] = i;
+			}
+			std::stable_sort(tech_order.begin(), tech_order.end(),
+				[this](uint32_t lhs, uint32_t rhs)
+				{
+					return render_techs_[lhs]->Weight() < render_techs_[rhs]->Weight();
+				});
+			for (uint32_t i = 0; i < num_techs; ++ i)
+			{
+				tech_ranks[tech_order[i]] = i;
 			}
-			num_renderables_rendered_ += static_cast<uint32_t>(items.second.size());
 		}
-		render_queue_.resize(0);
 
-		num_primitives_rendered_ += re.NumPrimitivesJustRendered();
-		num_vertices_rendered_ += re.NumVerticesJustRendered();
+		// Floats as unsigned integers in the same order
+		auto depth_bits = [](float depth)
+		{
+			union FNU
+			{
+				float f;
+				uint32_t u;
+			} fnu;
+			fnu.f = depth;
+			return (fnu.u & 0x80000000U) ? ~fnu.u : (fnu.u | 0x80000000U);
+		};
+		// Only groups equal states together, so the ids don't need to be unique
+		auto state_bits = [](void const * state)
+		{
+			size_t const v = reinterpret_cast<size_t>(state);
+			return static_cast<uint32_t>((v >> 4) ^ (v >> 20)) & 0xFFFFU;
+		};
 
-		urt_ = 0;
+		float4 const & view_mat_z = camera.ViewMatrix().Col(2);
+		Context::Instance().JobSystemInstance().ParallelFor(0, static_cast<uint32_t>(render_queue_.size()), 0,
+			[this, &tech_ranks, &view_mat_z, &depth_bits, &state_bits](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++ i)
+				{
+					auto& item = render_queue_[i];
+					uint32_t const tech_index = static_cast<uint32_t>(item.key);
+					RenderTechnique const * tech = render_techs_[tech_index];
+					Renderable const * renderable = item.renderable;
+
+					uint64_t primary = 0;
+					uint64_t secondary = 0;
+					if (!tech->Transparent())
+					{
+						uint32_t const mtl_bits = state_bits(renderable->Material().get());
+						if (!tech->HasDiscard())
+						{
+							// Closest point of the box over all instances, to draw front to back
+							AABBox const & box = renderable->PosBound();
+							float3 const center = box.Center();
+							float3 const half_size = box.HalfSize();
+							uint32_t const num = renderable->NumInstances();
+							float md = 1e10f;
+							for (uint32_t j = 0; j < num; ++ j)
+							{
+								float4x4 const & mat = renderable->GetInstance(j)->ModelMatrix();
+								float4 const zvec(MathLib::dot(mat.Row(0), view_mat_z),
+									MathLib::dot(mat.Row(1), view_mat_z), MathLib::dot(mat.Row(2), view_mat_z),
+									MathLib::dot(mat.Row(3), view_mat_z));
+								md = std::min(md, center.x() * zvec.x() + center.y() * zvec.y() + center.z() * zvec.z() + zvec.w()
+									- (half_size.x() * MathLib::abs(zvec.x()) + half_size.y() * MathLib::abs(zvec.y())
+										+ half_size.z() * MathLib::abs(zvec.z())));
+							}
+
+							primary = depth_bits(md);
+							secondary = mtl_bits;
+						}
+						else
+						{
+							primary = mtl_bits;
+							secondary = state_bits(&renderable->GetRenderLayout());
+						}
+					}
+
+					item.key = (static_cast<uint64_t>(tech_ranks[tech_index]) << 48) | (primary << 16) | secondary;
+				}
+			});
 	}
 
 	// ȡȾ
@@ -737,6 +819,10 @@ namespace KlayGE
 
 	void SceneManager::FlushScene()
 	{
+#ifndef KLAYGE_SHIP
+		PerfZone zone("SceneManager::FlushScene");
+#endif
+
 		RenderEngine& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
 
 		visible_marks_map_.clear();
@@ -777,8 +863,58 @@ namespace KlayGE
 		num_dispatch_calls_ = re.NumDispatchesJustCalled();
 	}
 
+	void SceneManager::UpdateSceneObjects(float app_time, float frame_time)
+	{
+#ifndef KLAYGE_SHIP
+		PerfZone zone("SceneManager::SubThreadUpdate");
+#endif
+
+		{
+			std::lock_guard<std::mutex> lock(update_mutex_);
+
+			// Other objects are still updated in order under the lock, since they could change the scene
+			for (auto const & scene_obj : scene_objs_)
+			{
+				if (scene_obj->Attrib() & SceneObject::SOA_ParallelUpdate)
+				{
+					parallel_update_objs_.push_back(scene_obj);
+				}
+				else
+				{
+					scene_obj->SubThreadUpdate(app_time, frame_time);
+				}
+			}
+			for (auto const & scene_obj : overlay_scene_objs_)
+			{
+				if (scene_obj->Attrib() & SceneObject::SOA_ParallelUpdate)
+				{
+					parallel_update_objs_.push_back(scene_obj);
+				}
+				else
+				{
+					scene_obj->SubThreadUpdate(app_time, frame_time);
+				}
+			}
+		}
+
+		// The references in parallel_update_objs_ keep the objects alive even if they are removed from the scene meanwhile
+		Context::Instance().JobSystemInstance().ParallelFor(0, static_cast<uint32_t>(parallel_update_objs_.size()), 0,
+			[this, app_time, frame_time](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++ i)
+				{
+					parallel_update_objs_[i]->SubThreadUpdate(app_time, frame_time);
+				}
+			});
+		parallel_update_objs_.clear();
+	}
+
 	void SceneManager::UpdateThreadFunc()
 	{
+#ifndef KLAYGE_SHIP
+		PerfProfiler::Instance().SetThreadName("Scene update");
+#endif
+
 		Timer timer;
 		float app_time = 0;
 		while (!quit_)
@@ -792,16 +928,7 @@ namespace KlayGE
 				WindowPtr const & win = Context::Instance().AppInstance().MainWnd();
 				if (win && win->Active())
 				{
-					std::lock_guard<std::mutex> lock(update_mutex_);
-
-					for (auto const & scene_obj : scene_objs_)
-					{
-						scene_obj->SubThreadUpdate(app_time, frame_time);
-					}
-					for (auto const & scene_obj : overlay_scene_objs_)
-					{
-						scene_obj->SubThreadUpdate(app_time, frame_time);
-					}
+					this->UpdateSceneObjects(app_time, frame_time);
 				}
 
 				if (frame_time < update_elapse_)
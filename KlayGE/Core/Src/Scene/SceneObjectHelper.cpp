@@ -237,4 +237,27 @@ namespace KlayGE
 		return SyncLoadModel("camera_proxy.meshml", EAH_GPU_Read | EAH_Immutable,
 			CreateModelFactory<RenderModel>(), CreateMeshFactoryFunc);
 	}
+
+
+	SceneObjectSkinnedModel::SceneObjectSkinnedModel(SkinnedModelPtr const & model, uint32_t attrib)
+		: SceneObjectHelper(model, attrib | SOA_ParallelUpdate)
+	{
+	}
+
+	void SceneObjectSkinnedModel::SubThreadUpdate(float app_time, float elapsed_time)
+	{
+		SceneObjectHelper::SubThreadUpdate(app_time, elapsed_time);
+
+		auto& model = *checked_pointer_cast<SkinnedModel>(renderable_);
+		model.PrepareFrame(app_time * model.FrameRate());
+	}
+
+	bool SceneObjectSkinnedModel::MainThreadUpdate(float app_time, float elapsed_time)
+	{
+		bool const refreshed = SceneObjectHelper::MainThreadUpdate(app_time, elapsed_time);
+
+		checked_pointer_cast<SkinnedModel>(renderable_)->CommitFrame();
+
+		return refreshed;
+	}
 }
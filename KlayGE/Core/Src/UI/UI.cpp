@@ -195,12 +195,6 @@ namespace KlayGE
 				re.Render(*this->GetRenderEffect(), *this->GetRenderTechnique(), *rl_);
 			}
 
-			for (size_t i = 0; i < tb_vb_sub_allocs_.size(); ++ i)
-			{
-				tb_vb_->Dealloc(tb_vb_sub_allocs_[i]);
-				tb_ib_->Dealloc(tb_ib_sub_allocs_[i]);
-			}
-
 			this->OnRenderEnd();
 		}
 
@@ -429,7 +423,7 @@ namespace KlayGE
 			{
 				attr = node->Attrib("name");
 				include_docs.push_back(MakeUniquePtr<XMLDocument>());
-				XMLNodePtr include_root = include_docs.back()->Parse(ResLoader::Instance().Open(std::string(attr->ValueString())));
+				XMLNodePtr include_root = include_docs.back()->Parse(ResLoader::Instance().OpenXML(attr->ValueString()));
 
 				for (XMLNodePtr child_node = include_root->FirstNode(); child_node; child_node = child_node->NextSibling())
 				{
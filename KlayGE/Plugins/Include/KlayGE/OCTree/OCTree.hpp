@@ -28,7 +28,9 @@
 #include <KlayGE/SceneNode.hpp>
 #include <KlayGE/SceneManager.hpp>
 #include <KFL/AABBox.hpp>
+#include <KFL/AABBoxSoA.hpp>
 
+#include <unordered_map>
 #include <vector>
 
 namespace KlayGE
@@ -55,34 +57,55 @@ namespace KlayGE
 		virtual void DoSuspend() override;
 		virtual void DoResume() override;
 
-		void DivideNode(size_t index, uint32_t curr_depth);
+		static bool InTree(SceneObject const & so);
+
+		void InsertObj(SceneObject* so);
+		void RemoveObj(SceneObject* so);
+		void RefitObj(SceneObject* so);
+		void RebuildTree(AABBox const & root_bb);
+
+		void InitNode(size_t index, AABBox const & bb, int parent_index);
+		void AllocChildren(size_t index);
+		void ReleaseEmptyNodes(size_t index);
+
 		void NodeVisible(size_t index);
 		void MarkNodeObjs(size_t index, bool force);
 
 		BoundOverlap BoundVisible(size_t index, AABBox const & aabb) const;
-		BoundOverlap BoundVisible(size_t index, OBBox const & obb) const;
-		BoundOverlap BoundVisible(size_t index, Sphere const & sphere) const;
-		BoundOverlap BoundVisible(size_t index, Frustum const & frustum) const;
 
 	private:
 		OCTree(OCTree const & rhs);
 		OCTree& operator=(OCTree const & rhs);
 
 	private:
+		// A loose octree. Every object lives in exactly one node, the deepest one whose loose bound
+		//  (the cell expanded by half of its size on each side) encloses it.
 		struct octree_node_t
 		{
 			AABBox bb;
+			AABBox loose_bb;
+			int parent_index;
 			int first_child_index;
 			BoundOverlap visible;
 
 			std::vector<SceneObject*> obj_ptrs;
+			// World space bounds of obj_ptrs
+			AABBoxSoA obj_bounds;
+		};
+
+		struct obj_handle_t
+		{
+			uint32_t node_index;
+			uint32_t slot;
 		};
 
 		std::vector<octree_node_t> octree_;
+		std::vector<int> free_children_;
+		std::unordered_map<SceneObject*, obj_handle_t> obj_handles_;
 
-		uint32_t max_tree_depth_;
+		std::vector<BoundOverlap> node_obj_overlaps_;
 
-		bool rebuild_tree_;
+		uint32_t max_tree_depth_;
 
 #ifdef KLAYGE_DRAW_NODES
 		RenderablePtr node_renderable_;
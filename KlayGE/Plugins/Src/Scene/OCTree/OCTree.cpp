@@ -28,6 +28,7 @@
 #include <KFL/Vector.hpp>
 #include <KFL/Matrix.hpp>
 #include <KFL/Plane.hpp>
+#include <KFL/SIMDMath.hpp>
 #include <KlayGE/SceneObject.hpp>
 #include <KlayGE/RenderableHelper.hpp>
 #include <KlayGE/Camera.hpp>
@@ -98,13 +99,17 @@ namespace
 namespace KlayGE
 {
 	OCTree::OCTree()
-		: max_tree_depth_(4), rebuild_tree_(false)
+		: max_tree_depth_(4)
 	{
 	}
 
 	void OCTree::MaxTreeDepth(uint32_t max_tree_depth)
 	{
 		max_tree_depth_ = std::min<uint32_t>(max_tree_depth, 16UL);
+		if (!octree_.empty())
+		{
+			this->RebuildTree(octree_[0].bb);
+		}
 	}
 
 	uint32_t OCTree::MaxTreeDepth() const
@@ -114,31 +119,15 @@ namespace KlayGE
 
 	void OCTree::ClipScene()
 	{
-		if (rebuild_tree_)
+		// Moving objects stay in the tree. Most of the time they are still inside the loose bound of their node,
+		//  only the ones leaving it are reinserted.
+		for (auto const & obj : scene_objs_)
 		{
-			octree_.resize(1);
-			AABBox bb_root(float3(0, 0, 0), float3(0, 0, 0));
-			octree_[0].first_child_index = -1;
-			octree_[0].visible = BO_No;
-			for (auto const & obj : scene_objs_)
+			if ((obj->Attrib() & SceneObject::SOA_Moveable) && InTree(*obj))
 			{
-				uint32_t const attr = obj->Attrib();
-				if ((attr & SceneObject::SOA_Cullable)
-					&& !(attr & SceneObject::SOA_Moveable))
-				{
-					bb_root |= obj->PosBoundWS();
-					octree_[0].obj_ptrs.push_back(obj.get());
-				}
+				obj->UpdateAbsModelMatrix();
+				this->RefitObj(obj.get());
 			}
-			float3 const & center = bb_root.Center();
-			float3 const & extent = bb_root.HalfSize();
-			float longest_dim = std::max(std::max(extent.x(), extent.y()), extent.z());
-			float3 new_extent(longest_dim, longest_dim, longest_dim);
-			octree_[0].bb = AABBox(center - new_extent, center + new_extent);
-
-			this->DivideNode(0, 1);
-
-			rebuild_tree_ = false;
 		}
 
 #ifdef KLAYGE_DRAW_NODES
@@ -210,9 +199,10 @@ namespace KlayGE
 				this->MarkNodeObjs(0, false);
 			}
 
+			// Objects in the tree are marked by MarkNodeObjs
 			for (auto const & obj : scene_objs_)
 			{
-				if (obj->Visible())
+				if (obj->Visible() && !InTree(*obj))
 				{
 					BoundOverlap visible = this->VisibleTestFromParent(obj.get(), camera.ForwardVec(), camera.EyePos(), view_proj);
 					if (BO_Partial == visible)
@@ -257,16 +247,21 @@ namespace KlayGE
 		SceneManager::ClearObject();
 
 		octree_.clear();
-		rebuild_tree_ = true;
+		free_children_.clear();
+		obj_handles_.clear();
 	}
 
 	void OCTree::OnAddSceneObject(SceneObjectPtr const & obj)
 	{
-		uint32_t const attr = obj->Attrib();
-		if ((attr & SceneObject::SOA_Cullable)
-			&& !(attr & SceneObject::SOA_Moveable))
+		if (InTree(*obj))
 		{
-			rebuild_tree_ = true;
+			if (obj->Attrib() & SceneObject::SOA_Moveable)
+			{
+				obj->UpdateAbsModelMatrix();
+			}
+
+			// Called again when the renderable gets ready, InsertObj moves it in that case
+			this->InsertObj(obj.get());
 		}
 	}
 
@@ -274,12 +269,7 @@ namespace KlayGE
 	{
 		BOOST_ASSERT(iter != scene_objs_.end());
 
-		uint32_t const attr = (*iter)->Attrib();
-		if ((attr & SceneObject::SOA_Cullable)
-			&& !(attr & SceneObject::SOA_Moveable))
-		{
-			rebuild_tree_ = true;
-		}
+		this->RemoveObj(iter->get());
 	}
 
 	void OCTree::DoSuspend()
@@ -292,57 +282,214 @@ namespace KlayGE
 		// TODO
 	}
 
-	void OCTree::DivideNode(size_t index, uint32_t curr_depth)
+	// Children are culled through their parents, only the top level cullable objects are in the tree
+	bool OCTree::InTree(SceneObject const & so)
 	{
-		if (octree_[index].obj_ptrs.size() > 1)
-		{
-			size_t const this_size = octree_.size();
-			AABBox const parent_bb = octree_[index].bb;
-			float3 const parent_center = parent_bb.Center();
-			octree_[index].first_child_index = static_cast<int>(this_size);
-			octree_[index].visible = BO_No;
-
-			octree_.resize(this_size + 8);
-			for (auto so : octree_[index].obj_ptrs)
-			{
-				AABBox const & aabb = so->PosBoundWS();
-				int mark[6];
-				mark[0] = aabb.Min().x() >= parent_center.x() ? 1 : 0;
-				mark[1] = aabb.Min().y() >= parent_center.y() ? 2 : 0;
-				mark[2] = aabb.Min().z() >= parent_center.z() ? 4 : 0;
-				mark[3] = aabb.Max().x() >= parent_center.x() ? 1 : 0;
-				mark[4] = aabb.Max().y() >= parent_center.y() ? 2 : 0;
-				mark[5] = aabb.Max().z() >= parent_center.z() ? 4 : 0;
-				for (int j = 0; j < 8; ++ j)
-				{
-					if (j == ((j & 1) ? mark[3] : mark[0])
-						+ ((j & 2) ? mark[4] : mark[1])
-						+ ((j & 4) ? mark[5] : mark[2]))
-					{
-						octree_[this_size + j].obj_ptrs.push_back(so);
-					}
-				}
+		return (so.Attrib() & SceneObject::SOA_Cullable) && !so.Parent();
+	}
+
+	void OCTree::InsertObj(SceneObject* so)
+	{
+		if (obj_handles_.find(so) != obj_handles_.end())
+		{
+			this->RemoveObj(so);
+		}
+
+		AABBox const & aabb = so->PosBoundWS();
+		float3 const center = aabb.Center();
+		float3 const half_size = aabb.HalfSize();
+		float const extent = std::max(std::max(half_size.x(), half_size.y()), half_size.z());
+
+		if (octree_.empty())
+		{
+			float const root_half = std::max(extent, 1.0f);
+			octree_.resize(1);
+			this->InitNode(0, AABBox(center - root_half, center + root_half), -1);
+		}
+		else
+		{
+			AABBox const & root_bb = octree_[0].bb;
+			if (!MathLib::intersect_point_aabb(center, root_bb) || (extent > root_bb.HalfSize().x()))
+			{
+				// Doubles the root every time, so growing happens only a logarithmic number of times
+				AABBox const bb = root_bb | aabb;
+				float3 const bb_half_size = bb.HalfSize();
+				float const root_half = std::max(std::max(bb_half_size.x(), bb_half_size.y()), bb_half_size.z()) * 2;
+				float3 const bb_center = bb.Center();
+				this->RebuildTree(AABBox(bb_center - root_half, bb_center + root_half));
+			}
+		}
+
+		// An object fits in the loose bound of the child that contains its center as long as it is not bigger
+		//  than that child's cell
+		size_t index = 0;
+		for (uint32_t depth = 0; depth < max_tree_depth_; ++ depth)
+		{
+			float const child_half = octree_[index].bb.HalfSize().x() / 2;
+			if (extent > child_half)
+			{
+				break;
+			}
+
+			if (-1 == octree_[index].first_child_index)
+			{
+				this->AllocChildren(index);
+			}
+
+			float3 const node_center = octree_[index].bb.Center();
+			int const j = (center.x() >= node_center.x() ? 1 : 0)
+				+ (center.y() >= node_center.y() ? 2 : 0)
+				+ (center.z() >= node_center.z() ? 4 : 0);
+			index = octree_[index].first_child_index + j;
+		}
+
+		octree_node_t& node = octree_[index];
+		obj_handle_t handle;
+		handle.node_index = static_cast<uint32_t>(index);
+		handle.slot = static_cast<uint32_t>(node.obj_ptrs.size());
+		obj_handles_.emplace(so, handle);
+		node.obj_ptrs.push_back(so);
+		node.obj_bounds.PushBack(aabb);
+	}
+
+	void OCTree::RemoveObj(SceneObject* so)
+	{
+		auto iter = obj_handles_.find(so);
+		if (iter != obj_handles_.end())
+		{
+			obj_handle_t const handle = iter->second;
+			obj_handles_.erase(iter);
+
+			octree_node_t& node = octree_[handle.node_index];
+			auto& obj_ptrs = node.obj_ptrs;
+			BOOST_ASSERT(obj_ptrs[handle.slot] == so);
+			if (handle.slot + 1 != obj_ptrs.size())
+			{
+				obj_ptrs[handle.slot] = obj_ptrs.back();
+				obj_handles_[obj_ptrs[handle.slot]].slot = handle.slot;
 			}
+			obj_ptrs.pop_back();
+			node.obj_bounds.SwapRemove(handle.slot);
 
-			for (size_t j = 0; j < 8; ++ j)
+			this->ReleaseEmptyNodes(handle.node_index);
+		}
+	}
+
+	void OCTree::RefitObj(SceneObject* so)
+	{
+		auto iter = obj_handles_.find(so);
+		if (iter != obj_handles_.end())
+		{
+			AABBox const & aabb = so->PosBoundWS();
+			octree_node_t& node = octree_[iter->second.node_index];
+			AABBox const & loose_bb = node.loose_bb;
+			if ((aabb.Min().x() < loose_bb.Min().x()) || (aabb.Min().y() < loose_bb.Min().y())
+				|| (aabb.Min().z() < loose_bb.Min().z()) || (aabb.Max().x() > loose_bb.Max().x())
+				|| (aabb.Max().y() > loose_bb.Max().y()) || (aabb.Max().z() > loose_bb.Max().z()))
 			{
-				octree_node_t& new_node = octree_[this_size + j];
-				new_node.first_child_index = -1;
-				new_node.bb = AABBox(float3((j & 1) ? parent_center.x() : parent_bb.Min().x(),
+				this->InsertObj(so);
+			}
+			else
+			{
+				node.obj_bounds.Set(iter->second.slot, aabb);
+			}
+		}
+		else
+		{
+			this->InsertObj(so);
+		}
+	}
+
+	void OCTree::RebuildTree(AABBox const & root_bb)
+	{
+		std::vector<SceneObject*> objs;
+		objs.reserve(obj_handles_.size());
+		for (auto const & handle : obj_handles_)
+		{
+			objs.push_back(handle.first);
+		}
+
+		octree_.resize(1);
+		free_children_.clear();
+		obj_handles_.clear();
+		this->InitNode(0, root_bb, -1);
+
+		// When growing, the new root covers the loose bound of the old one, so no object triggers another growth
+		for (auto so : objs)
+		{
+			this->InsertObj(so);
+		}
+	}
+
+	void OCTree::InitNode(size_t index, AABBox const & bb, int parent_index)
+	{
+		octree_node_t& node = octree_[index];
+		node.bb = bb;
+		float3 const center = bb.Center();
+		float3 const loose_half_size = bb.HalfSize() * 2.0f;
+		node.loose_bb = AABBox(center - loose_half_size, center + loose_half_size);
+		node.parent_index = parent_index;
+		node.first_child_index = -1;
+		// New nodes could be queried before the next NodeVisible, so be conservative
+		node.visible = BO_Partial;
+		node.obj_ptrs.clear();
+		node.obj_bounds.Clear();
+	}
+
+	void OCTree::AllocChildren(size_t index)
+	{
+		int first_child_index;
+		if (free_children_.empty())
+		{
+			first_child_index = static_cast<int>(octree_.size());
+			octree_.resize(octree_.size() + 8);
+		}
+		else
+		{
+			first_child_index = free_children_.back();
+			free_children_.pop_back();
+		}
+
+		AABBox const parent_bb = octree_[index].bb;
+		float3 const parent_center = parent_bb.Center();
+		for (int j = 0; j < 8; ++ j)
+		{
+			this->InitNode(first_child_index + j,
+				AABBox(float3((j & 1) ? parent_center.x() : parent_bb.Min().x(),
 						(j & 2) ? parent_center.y() : parent_bb.Min().y(),
 						(j & 4) ? parent_center.z() : parent_bb.Min().z()),
 					float3((j & 1) ? parent_bb.Max().x() : parent_center.x(),
 						(j & 2) ? parent_bb.Max().y() : parent_center.y(),
-						(j & 4) ? parent_bb.Max().z() : parent_center.z()));
+						(j & 4) ? parent_bb.Max().z() : parent_center.z())),
+				static_cast<int>(index));
+		}
+		octree_[index].first_child_index = first_child_index;
+	}
 
-				if (curr_depth < max_tree_depth_)
+	// Walks up from a node that lost an object, and frees the groups of children that became empty leaves
+	void OCTree::ReleaseEmptyNodes(size_t index)
+	{
+		int parent_index = octree_[index].parent_index;
+		while (parent_index != -1)
+		{
+			octree_node_t& parent = octree_[parent_index];
+			for (int j = 0; j < 8; ++ j)
+			{
+				octree_node_t const & child = octree_[parent.first_child_index + j];
+				if (!child.obj_ptrs.empty() || (child.first_child_index != -1))
 				{
-					this->DivideNode(this_size + j, curr_depth + 1);
+					return;
 				}
 			}
 
-			octree_[index].obj_ptrs.clear();
-			octree_[index].obj_ptrs.shrink_to_fit();
+			free_children_.push_back(parent.first_child_index);
+			parent.first_child_index = -1;
+			if (!parent.obj_ptrs.empty())
+			{
+				break;
+			}
+
+			parent_index = parent.parent_index;
 		}
 	}
 
@@ -366,10 +513,10 @@ namespace KlayGE
 
 		octree_node_t& node = octree_[index];
 		if ((small_obj_threshold_ <= 0)
-			|| ((MathLib::ortho_area(camera.ForwardVec(), node.bb) > small_obj_threshold_)
-				&& (MathLib::perspective_area(camera.EyePos(), view_proj, node.bb) > small_obj_threshold_)))
+			|| ((MathLib::ortho_area(camera.ForwardVec(), node.loose_bb) > small_obj_threshold_)
+				&& (MathLib::perspective_area(camera.EyePos(), view_proj, node.loose_bb) > small_obj_threshold_)))
 		{
-			BoundOverlap const vis = frustum_->Intersect(node.bb);
+			BoundOverlap const vis = frustum_->Intersect(node.loose_bb);
 			node.visible = vis;
 			if (BO_Partial == vis)
 			{
@@ -390,11 +537,10 @@ namespace KlayGE
 #ifdef KLAYGE_DRAW_NODES
 		if ((vis != BO_No) && (-1 == node.first_child_index))
 		{
-			checked_pointer_cast<NodeRenderable>(node_renderable_)->AddInstance(MathLib::scaling(node.bb.HalfSize()) * MathLib::translation(node.bb.Center()));
+			checked_pointer_cast<NodeRenderable>(node_renderable_)->AddInstance(MathLib::scaling(node.loose_bb.HalfSize()) * MathLib::translation(node.loose_bb.Center()));
 		}
 #endif
 	}
-
 	void OCTree::MarkNodeObjs(size_t index, bool force)
 	{
 		BOOST_ASSERT(index < octree_.size());
@@ -416,8 +562,18 @@ namespace KlayGE
 		octree_node_t const & node = octree_[index];
 		if ((node.visible != BO_No) || force)
 		{
-			for (auto so : node.obj_ptrs)
+			// Objects are inside the loose bound of their node, so they are all visible when the node is.
+			//  Otherwise the whole node is culled in one batch.
+			bool const inside = (BO_Yes == node.visible) || force;
+			if (!inside && !node.obj_ptrs.empty())
 			{
+				node_obj_overlaps_.resize(node.obj_ptrs.size());
+				SIMDMathLib::IntersectAABBFrustum(node_obj_overlaps_.data(), node.obj_bounds, *frustum_);
+			}
+
+			for (size_t i = 0; i < node.obj_ptrs.size(); ++ i)
+			{
+				auto so = node.obj_ptrs[i];
 				if ((BO_No == so->VisibleMark()) && so->Visible())
 				{
 					BoundOverlap visible = this->VisibleTestFromParent(so, camera.ForwardVec(), camera.EyePos(), view_proj);
@@ -428,7 +584,7 @@ namespace KlayGE
 							|| ((MathLib::ortho_area(camera.ForwardVec(), node.bb) > small_obj_threshold_)
 								&& (MathLib::perspective_area(camera.EyePos(), view_proj, aabb_ws) > small_obj_threshold_)))
 						{
-							visible = frustum_->Intersect(aabb_ws);
+							visible = inside ? BO_Yes : node_obj_overlaps_[i];
 						}
 						else
 						{
@@ -443,7 +599,7 @@ namespace KlayGE
 			{
 				for (int i = 0; i < 8; ++ i)
 				{
-					this->MarkNodeObjs(node.first_child_index + i, (BO_Yes == node.visible) || force);
+					this->MarkNodeObjs(node.first_child_index + i, inside);
 				}
 			}
 		}
@@ -455,7 +611,7 @@ namespace KlayGE
 		BoundOverlap visible = BO_Yes;
 		if (!octree_.empty())
 		{
-			if (MathLib::intersect_aabb_aabb(octree_[0].bb, aabb))
+			if (MathLib::intersect_aabb_aabb(octree_[0].loose_bb, aabb))
 			{
 				visible = this->BoundVisible(0, aabb);
 			}
@@ -486,9 +642,9 @@ namespace KlayGE
 		BoundOverlap visible = BO_Yes;
 		if (!octree_.empty())
 		{
-			if (MathLib::intersect_aabb_obb(octree_[0].bb, obb))
+			if (MathLib::intersect_aabb_obb(octree_[0].loose_bb, obb))
 			{
-				visible = this->BoundVisible(0, obb);
+				visible = this->BoundVisible(0, MathLib::convert_to_aabbox(obb));
 			}
 			else
 			{
@@ -517,9 +673,10 @@ namespace KlayGE
 		BoundOverlap visible = BO_Yes;
 		if (!octree_.empty())
 		{
-			if (MathLib::intersect_aabb_sphere(octree_[0].bb, sphere))
+			if (MathLib::intersect_aabb_sphere(octree_[0].loose_bb, sphere))
 			{
-				visible = this->BoundVisible(0, sphere);
+				float3 const radius(sphere.Radius(), sphere.Radius(), sphere.Radius());
+				visible = this->BoundVisible(0, AABBox(sphere.Center() - radius, sphere.Center() + radius));
 			}
 			else
 			{
@@ -542,12 +699,14 @@ namespace KlayGE
 		return visible;
 	}
 
+	// Loose bounds of siblings overlap, so a partially visible node only descends into a child that fully
+	//  contains the bound. Otherwise the answer stays conservative.
 	BoundOverlap OCTree::BoundVisible(size_t index, AABBox const & aabb) const
 	{
 		BOOST_ASSERT(index < octree_.size());
 
 		octree_node_t const & node = octree_[index];
-		if ((node.visible != BO_No) && MathLib::intersect_aabb_aabb(node.bb, aabb))
+		if ((node.visible != BO_No) && MathLib::intersect_aabb_aabb(node.loose_bb, aabb))
 		{
 			if (BO_Yes == node.visible)
 			{
@@ -559,154 +718,19 @@ namespace KlayGE
 
 				if (node.first_child_index != -1)
 				{
-					float3 const center = node.bb.Center();
-					int mark[6];
-					mark[0] = aabb.Min().x() >= center.x() ? 1 : 0;
-					mark[1] = aabb.Min().y() >= center.y() ? 2 : 0;
-					mark[2] = aabb.Min().z() >= center.z() ? 4 : 0;
-					mark[3] = aabb.Max().x() >= center.x() ? 1 : 0;
-					mark[4] = aabb.Max().y() >= center.y() ? 2 : 0;
-					mark[5] = aabb.Max().z() >= center.z() ? 4 : 0;
 					for (int j = 0; j < 8; ++ j)
 					{
-						if (j == ((j & 1) ? mark[3] : mark[0])
-							+ ((j & 2) ? mark[4] : mark[1])
-							+ ((j & 4) ? mark[5] : mark[2]))
+						AABBox const & child_bb = octree_[node.first_child_index + j].loose_bb;
+						if ((aabb.Min().x() >= child_bb.Min().x()) && (aabb.Min().y() >= child_bb.Min().y())
+							&& (aabb.Min().z() >= child_bb.Min().z()) && (aabb.Max().x() <= child_bb.Max().x())
+							&& (aabb.Max().y() <= child_bb.Max().y()) && (aabb.Max().z() <= child_bb.Max().z()))
 						{
-							BoundOverlap const bo = this->BoundVisible(node.first_child_index + j, aabb);
-							if (bo != BO_No)
-							{
-								return bo;
-							}
+							return this->BoundVisible(node.first_child_index + j, aabb);
 						}
 					}
-
-					return BO_No;
 				}
-				else
-				{
-					return BO_Partial;
-				}
-			}
-		}
-		else
-		{
-			return BO_No;
-		}
-	}
-
-	BoundOverlap OCTree::BoundVisible(size_t index, OBBox const & obb) const
-	{
-		BOOST_ASSERT(index < octree_.size());
 
-		octree_node_t const & node = octree_[index];
-		if ((node.visible != BO_No) && MathLib::intersect_aabb_obb(node.bb, obb))
-		{
-			if (BO_Yes == node.visible)
-			{
-				return BO_Yes;
-			}
-			else
-			{
-				BOOST_ASSERT(BO_Partial == node.visible);
-
-				if (node.first_child_index != -1)
-				{
-					for (int i = 0; i < 8; ++ i)
-					{
-						BoundOverlap const bo = this->BoundVisible(node.first_child_index + i, obb);
-						if (bo != BO_No)
-						{
-							return bo;
-						}
-					}
-
-					return BO_No;
-				}
-				else
-				{
-					return BO_Partial;
-				}
-			}
-		}
-		else
-		{
-			return BO_No;
-		}
-	}
-
-	BoundOverlap OCTree::BoundVisible(size_t index, Sphere const & sphere) const
-	{
-		BOOST_ASSERT(index < octree_.size());
-
-		octree_node_t const & node = octree_[index];
-		if ((node.visible != BO_No) && MathLib::intersect_aabb_sphere(node.bb, sphere))
-		{
-			if (BO_Yes == node.visible)
-			{
-				return BO_Yes;
-			}
-			else
-			{
-				BOOST_ASSERT(BO_Partial == node.visible);
-
-				if (node.first_child_index != -1)
-				{
-					for (int i = 0; i < 8; ++ i)
-					{
-						BoundOverlap const bo = this->BoundVisible(node.first_child_index + i, sphere);
-						if (bo != BO_No)
-						{
-							return bo;
-						}
-					}
-
-					return BO_No;
-				}
-				else
-				{
-					return BO_Partial;
-				}
-			}
-		}
-		else
-		{
-			return BO_No;
-		}
-	}
-
-	BoundOverlap OCTree::BoundVisible(size_t index, Frustum const & frustum) const
-	{
-		BOOST_ASSERT(index < octree_.size());
-
-		octree_node_t const & node = octree_[index];
-		if ((node.visible != BO_No) && MathLib::intersect_aabb_frustum(node.bb, frustum))
-		{
-			if (BO_Yes == node.visible)
-			{
-				return BO_Yes;
-			}
-			else
-			{
-				BOOST_ASSERT(BO_Partial == node.visible);
-
-				if (node.first_child_index != -1)
-				{
-					for (int i = 0; i < 8; ++ i)
-					{
-						BoundOverlap const bo = this->BoundVisible(node.first_child_index + i, frustum);
-						if (bo != BO_No)
-						{
-							return bo;
-						}
-					}
-
-					return BO_No;
-				}
-				else
-				{
-					return BO_Partial;
-				}
+				return BO_Partial;
 			}
 		}
 		else
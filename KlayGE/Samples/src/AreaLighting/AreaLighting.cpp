@@ -175,7 +175,7 @@ void AreaLightingApp::OnCreate()
 		});
 	inputEngine.ActionMap(actionMap, input_handler);
 
-	UIManager::Instance().Load(ResLoader::Instance().Open("AreaLighting.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("AreaLighting.uiml"));
 	dialog_ = UIManager::Instance().GetDialogs()[0];
 
 	id_light_type_combo_ = dialog_->IDFromName("LightTypeCombo");
@@ -238,6 +238,7 @@ void AreaLightingApp::InputHandler(InputEngine const & /*sender*/, InputAction c
 	case Profile:
 #ifndef KLAYGE_SHIP
 		PerfProfiler::Instance().ExportToCSV("profile.csv");
+		PerfProfiler::Instance().ExportToChromeTrace("profile.json");
 #endif
 		break;
 	}
@@ -199,7 +199,7 @@ void AtmosphericScatteringApp::OnCreate()
 	atmosphere_ = MakeSharedPtr<SceneObjectHelper>(model_atmosphere->Subrenderable(0), SceneObjectHelper::SOA_Cullable);
 	atmosphere_->AddToSceneManager();
 
-	UIManager::Instance().Load(ResLoader::Instance().Open("AtmosphericScattering.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("AtmosphericScattering.uiml"));
 	dialog_param_ = UIManager::Instance().GetDialog("AtmosphericScattering");
 	id_atmosphere_top_ = dialog_param_->IDFromName("atmosphere_top");
 	id_density_ = dialog_param_->IDFromName("density");
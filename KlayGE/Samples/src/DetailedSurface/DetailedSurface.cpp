@@ -454,7 +454,7 @@ DetailedSurfaceApp::DetailedSurfaceApp()
 void DetailedSurfaceApp::OnCreate()
 {
 	font_ = SyncLoadFont("gkai00mp.kfont");
-	UIManager::Instance().Load(ResLoader::Instance().Open("DetailedSurface.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("DetailedSurface.uiml"));
 
 	RenderFactory& rf = Context::Instance().RenderFactoryInstance();
 	juda_tex_ = LoadJudaTexture("DetailedSurface.jdt");
@@ -862,7 +862,7 @@ void GPUParticleSystemApp::OnCreate()
 		checked_pointer_cast<ParticlesObject>(particles_)->PosVB(gpu_ps->PosVB());
 	}
 
-	UIManager::Instance().Load(ResLoader::Instance().Open("GPUParticleSystem.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("GPUParticleSystem.uiml"));
 }
 
 void GPUParticleSystemApp::OnResize(uint32_t width, uint32_t height)
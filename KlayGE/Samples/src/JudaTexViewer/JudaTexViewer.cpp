@@ -310,7 +310,7 @@ void JudaTexViewer::OnCreate()
 		});
 	inputEngine.ActionMap(actionMap, input_handler);
 
-	UIManager::Instance().Load(ResLoader::Instance().Open("JudaTexViewer.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("JudaTexViewer.uiml"));
 	dialog_ = UIManager::Instance().GetDialogs()[0];
 
 	id_open_ = dialog_->IDFromName("Open");
@@ -184,7 +184,7 @@ void ParticleEditorApp::OnCreate()
 
 	copy_pp_ = SyncLoadPostProcess("Copy.ppml", "Copy");
 
-	UIManager::Instance().Load(ResLoader::Instance().Open("ParticleEditor.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("ParticleEditor.uiml"));
 	dialog_ = UIManager::Instance().GetDialogs()[0];
 
 	id_open_ = dialog_->IDFromName("Open");
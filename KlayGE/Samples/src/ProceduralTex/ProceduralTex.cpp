@@ -188,7 +188,7 @@ ProceduralTexApp::ProceduralTexApp()
 void ProceduralTexApp::OnCreate()
 {
 	font_ = SyncLoadFont("gkai00mp.kfont");
-	UIManager::Instance().Load(ResLoader::Instance().Open("ProceduralTex.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("ProceduralTex.uiml"));
 }
 
 void ProceduralTexApp::OnResize(uint32_t width, uint32_t height)
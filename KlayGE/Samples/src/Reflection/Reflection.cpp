@@ -260,7 +260,7 @@ void ScreenSpaceReflectionApp::OnCreate()
 		});
 	inputEngine.ActionMap(actionMap, input_handler);
 
-	UIManager::Instance().Load(ResLoader::Instance().Open("Reflection.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("Reflection.uiml"));
 	parameter_dialog_ = UIManager::Instance().GetDialog("Reflection");
 
 	id_min_sample_num_static_ = parameter_dialog_->IDFromName("min_sample_num_static");
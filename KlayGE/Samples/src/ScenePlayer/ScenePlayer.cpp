@@ -357,18 +357,18 @@ void ScenePlayerApp::LoadScene(std::string const & name)
 			if (!ResLoader::Instance().Locate(skybox_name).empty())
 			{
 				checked_pointer_cast<SceneObjectSkyBox>(sky_box_)->CubeMap(ASyncLoadTexture(skybox_name,
-					EAH_GPU_Read | EAH_Immutable));
+					EAH_GPU_Read | EAH_Immutable, ResLoader::LP_High));
 			}
 			else if (!ResLoader::Instance().Locate(skybox_name + ".dds").empty())
 			{
 				checked_pointer_cast<SceneObjectSkyBox>(sky_box_)->CubeMap(ASyncLoadTexture(skybox_name + ".dds",
-					EAH_GPU_Read | EAH_Immutable));
+					EAH_GPU_Read | EAH_Immutable, ResLoader::LP_High));
 			}
 			else if (!ResLoader::Instance().Locate(skybox_name + "_y.dds").empty())
 			{
 				checked_pointer_cast<SceneObjectSkyBox>(sky_box_)->CompressedCubeMap(
-					ASyncLoadTexture(skybox_name + "_y.dds", EAH_GPU_Read | EAH_Immutable),
-					ASyncLoadTexture(skybox_name + "_c.dds", EAH_GPU_Read | EAH_Immutable));
+					ASyncLoadTexture(skybox_name + "_y.dds", EAH_GPU_Read | EAH_Immutable, ResLoader::LP_High),
+					ASyncLoadTexture(skybox_name + "_c.dds", EAH_GPU_Read | EAH_Immutable, ResLoader::LP_High));
 			}
 			else
 			{
@@ -764,7 +764,7 @@ void ScenePlayerApp::OnCreate()
 		});
 	inputEngine.ActionMap(actionMap, input_handler);
 
-	UIManager::Instance().Load(ResLoader::Instance().Open("ScenePlayer.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("ScenePlayer.uiml"));
 	dialog_ = UIManager::Instance().GetDialogs()[0];
 
 	id_open_ = dialog_->IDFromName("Open");
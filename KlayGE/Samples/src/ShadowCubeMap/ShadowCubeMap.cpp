@@ -485,7 +485,7 @@ void ShadowCubeMap::OnCreate()
 		});
 	inputEngine.ActionMap(actionMap, input_handler);
 
-	UIManager::Instance().Load(ResLoader::Instance().Open("ShadowCubeMap.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("ShadowCubeMap.uiml"));
 	dialog_ = UIManager::Instance().GetDialogs()[0];
 
 	id_scale_factor_static_ = dialog_->IDFromName("ScaleFactorStatic");
@@ -107,7 +107,7 @@ void TextApp::OnCreate()
 		});
 	inputEngine.ActionMap(actionMap, input_handler);
 
-	UIManager::Instance().Load(ResLoader::Instance().Open("Text.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("Text.uiml"));
 }
 
 void TextApp::OnResize(uint32_t width, uint32_t height)
@@ -141,7 +141,7 @@ void VectorTexApp::OnCreate()
 
 	checked_pointer_cast<TeapotObject>(object_)->VectorTexture(ASyncLoadTexture("Drawing.dds", EAH_GPU_Read | EAH_Immutable));
 
-	UIManager::Instance().Load(ResLoader::Instance().Open("VideoTexture.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("VideoTexture.uiml"));
 }
 
 void VectorTexApp::OnResize(uint32_t width, uint32_t height)
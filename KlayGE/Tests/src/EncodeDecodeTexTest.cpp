@@ -9,6 +9,7 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <random>
 
 #include "KlayGETests.hpp"
 
@@ -293,3 +294,132 @@ TEST(EncodeDecodeTexTest, EncodeDecodeETC1)
 {
 	TestEncodeDecodeTex("Lenna.dds", "", EF_ETC1, 4.8f);
 }
+
+TEST(EncodeDecodeTexTest, EncodeMemThreads)
+{
+	uint32_t const width = 70;
+	uint32_t const height = 70;
+	std::vector<uint32_t> input_argb(width * height);
+	for (uint32_t y = 0; y < height; ++ y)
+	{
+		for (uint32_t x = 0; x < width; ++ x)
+		{
+			input_argb[y * width + x] = ((x * 255 / width) << 16) | ((y * 255 / height) << 8) | ((x * y) & 0xFF)
+				| (((x + y) & 0x3F) << 26);
+		}
+	}
+
+	TexCompressionBC7 codec;
+	uint32_t const row_pitch = (width + 3) / 4 * BlockBytes(EF_BC7);
+	uint32_t const slice_pitch = (height + 3) / 4 * row_pitch;
+
+	std::vector<uint8_t> serial_blocks(slice_pitch);
+	codec.EncodeMem(width, height, serial_blocks.data(), row_pitch, slice_pitch,
+		input_argb.data(), width * sizeof(uint32_t), width * height * sizeof(uint32_t), TCM_Balanced, 1);
+
+	std::vector<uint8_t> parallel_blocks(slice_pitch);
+	codec.EncodeMem(width, height, parallel_blocks.data(), row_pitch, slice_pitch,
+		input_argb.data(), width * sizeof(uint32_t), width * height * sizeof(uint32_t), TCM_Balanced, 0);
+
+	std::vector<uint8_t> limited_blocks(slice_pitch);
+	codec.EncodeMem(width, height, limited_blocks.data(), row_pitch, slice_pitch,
+		input_argb.data(), width * sizeof(uint32_t), width * height * sizeof(uint32_t), TCM_Balanced, 3);
+
+	EXPECT_TRUE(serial_blocks == parallel_blocks);
+	EXPECT_TRUE(serial_blocks == limited_blocks);
+}
+
+namespace
+{
+	// Compares DecodeMem with the path it replaced, one DecodeBlock and one texel copy at a time
+	void TestDecodeMemBlockRows(TexCompression& codec, ElementFormat bc_fmt)
+	{
+		uint32_t const width = 130;
+		uint32_t const height = 130;
+		uint32_t const block_width = BlockWidth(bc_fmt);
+		uint32_t const block_height = BlockHeight(bc_fmt);
+		uint32_t const block_bytes = BlockBytes(bc_fmt);
+		uint32_t const pixel_size = NumFormatBytes(DecodedFormat(bc_fmt));
+		uint32_t const num_blocks_x = (width + block_width - 1) / block_width;
+		uint32_t const num_blocks_y = (height + block_height - 1) / block_height;
+		uint32_t const in_row_pitch = num_blocks_x * block_bytes;
+		uint32_t const out_row_pitch = width * pixel_size;
+
+		std::mt19937 gen(1);
+		std::vector<uint8_t> bc_blocks(in_row_pitch * num_blocks_y);
+		for (auto& b : bc_blocks)
+		{
+			b = static_cast<uint8_t>(gen());
+		}
+
+		std::vector<uint8_t> expected(out_row_pitch * height);
+		std::vector<uint8_t> uncompressed(block_width * block_height * pixel_size);
+		for (uint32_t y_base = 0; y_base < height; y_base += block_height)
+		{
+			uint8_t const * src = &bc_blocks[(y_base / block_height) * in_row_pitch];
+			for (uint32_t x_base = 0; x_base < width; x_base += block_width)
+			{
+				codec.DecodeBlock(&uncompressed[0], src);
+				src += block_bytes;
+
+				for (uint32_t y = 0; y < std::min(block_height, height - y_base); ++ y)
+				{
+					for (uint32_t x = 0; x < std::min(block_width, width - x_base); ++ x)
+					{
+						memcpy(&expected[(y_base + y) * out_row_pitch + (x_base + x) * pixel_size],
+							&uncompressed[(y * block_width + x) * pixel_size], pixel_size);
+					}
+				}
+			}
+		}
+
+		std::vector<uint8_t> decoded(out_row_pitch * height);
+		codec.DecodeMem(width, height, &decoded[0], out_row_pitch, out_row_pitch * height,
+			&bc_blocks[0], in_row_pitch, in_row_pitch * num_blocks_y);
+
+		EXPECT_TRUE(expected == decoded);
+
+	}
+}
+
+TEST(EncodeDecodeTexTest, DecodeMemBC1)
+{
+	TexCompressionBC1 codec;
+	TestDecodeMemBlockRows(codec, EF_BC1);
+}
+
+TEST(EncodeDecodeTexTest, DecodeMemBC3)
+{
+	TexCompressionBC3 codec;
+	TestDecodeMemBlockRows(codec, EF_BC3);
+}
+
+TEST(EncodeDecodeTexTest, DecodeMemBC4)
+{
+	TexCompressionBC4 codec;
+	TestDecodeMemBlockRows(codec, EF_BC4);
+}
+
+TEST(EncodeDecodeTexTest, DecodeMemBC5)
+{
+	TexCompressionBC5 codec;
+	TestDecodeMemBlockRows(codec, EF_BC5);
+}
+
+TEST(EncodeDecodeTexTest, DecodeMemETC1)
+{
+	TexCompressionETC1 codec;
+	TestDecodeMemBlockRows(codec, EF_ETC1);
+}
+
+TEST(EncodeDecodeTexTest, DecodeMemETC2RGB8)
+{
+	TexCompressionETC2RGB8 codec;
+	TestDecodeMemBlockRows(codec, EF_ETC2_BGR8);
+}
+
+TEST(EncodeDecodeTexTest, DecodeMemETC2RGB8A1)
+{
+	TexCompressionETC2RGB8A1 codec;
+	TestDecodeMemBlockRows(codec, EF_ETC2_A1BGR8);
+}
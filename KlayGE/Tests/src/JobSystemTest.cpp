@@ -0,0 +1,142 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/JobSystem.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+TEST(JobSystemTest, ParallelFor)
+{
+	JobSystem job_system(4);
+
+	std::vector<uint32_t> visited(100000, 0);
+	job_system.ParallelFor(0, static_cast<uint32_t>(visited.size()), 0,
+		[&visited](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; ++ i)
+			{
+				++ visited[i];
+			}
+		});
+
+	for (auto v : visited)
+	{
+		EXPECT_EQ(v, 1U);
+	}
+}
+
+TEST(JobSystemTest, ParallelReduce)
+{
+	JobSystem job_system(4);
+
+	uint64_t const sum = job_system.ParallelReduce<uint64_t>(0, 1000000, 1000, 0,
+		[](uint32_t begin, uint32_t end)
+		{
+			uint64_t s = 0;
+			for (uint32_t i = begin; i < end; ++ i)
+			{
+				s += i;
+			}
+			return s;
+		},
+		[](uint64_t lhs, uint64_t rhs)
+		{
+			return lhs + rhs;
+		});
+	EXPECT_EQ(sum, 1000000ULL * 999999ULL / 2);
+}
+
+TEST(JobSystemTest, Dependencies)
+{
+	JobSystem job_system(4);
+
+	std::mutex order_mutex;
+	std::vector<int> order;
+	auto record = [&order_mutex, &order](int id)
+	{
+		std::lock_guard<std::mutex> lock(order_mutex);
+		order.push_back(id);
+	};
+
+	JobPtr first = job_system.Schedule([&record] { record(0); });
+	JobPtr second = job_system.Then(first, [&record] { record(1); });
+	std::vector<JobPtr> deps = { first, second };
+	JobPtr third = job_system.Schedule([&record] { record(2); }, deps);
+	job_system.Wait(third);
+
+	ASSERT_EQ(order.size(), 3U);
+	EXPECT_EQ(order[0], 0);
+	EXPECT_EQ(order[1], 1);
+	EXPECT_EQ(order[2], 2);
+}
+
+TEST(JobSystemTest, NestedParallelFor)
+{
+	JobSystem job_system(4);
+
+	std::atomic<uint32_t> count(0);
+	job_system.ParallelFor(0, 64, 1,
+		[&job_system, &count](uint32_t, uint32_t)
+		{
+			job_system.ParallelFor(0, 64, 1,
+				[&count](uint32_t, uint32_t)
+				{
+					++ count;
+				});
+		});
+	EXPECT_EQ(count, 64U * 64U);
+}
+
+TEST(JobSystemTest, Exception)
+{
+	JobSystem job_system(2);
+
+	JobPtr job = job_system.Schedule([] { throw std::runtime_error("job failed"); });
+	EXPECT_THROW(job_system.Wait(job), std::runtime_error);
+}
+
+TEST(JobSystemTest, ParallelForException)
+{
+	JobSystem job_system(4);
+
+	// The first chunk runs inline, and fails before the others are done. They must all finish before the
+	//  exception leaves ParallelFor, since they refer to its func.
+	std::atomic<uint32_t> num_finished(0);
+	EXPECT_THROW(job_system.ParallelFor(0, 16, 1,
+		[&num_finished](uint32_t begin, uint32_t end)
+		{
+			if (0 == begin)
+			{
+				throw std::runtime_error("chunk failed");
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			num_finished += end - begin;
+		}), std::runtime_error);
+	EXPECT_EQ(num_finished, 15U);
+
+	num_finished = 0;
+	EXPECT_THROW(job_system.ParallelReduce(0, 16, 1, 0U,
+		[&num_finished](uint32_t begin, uint32_t end)
+		{
+			if (5 == begin)
+			{
+				throw std::runtime_error("map failed");
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			num_finished += end - begin;
+			return end - begin;
+		},
+		[](uint32_t lhs, uint32_t rhs)
+		{
+			return lhs + rhs;
+		}), std::runtime_error);
+	EXPECT_EQ(num_finished, 15U);
+}
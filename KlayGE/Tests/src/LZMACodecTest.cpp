@@ -0,0 +1,75 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/ResIdentifier.hpp>
+#include <KlayGE/LZMACodec.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	std::vector<uint8_t> GenerateData(size_t size)
+	{
+		std::vector<uint8_t> data(size);
+		for (size_t i = 0; i < size; ++ i)
+		{
+			data[i] = static_cast<uint8_t>(i * 7 + (i >> 9));
+		}
+		return data;
+	}
+}
+
+TEST(LZMACodecTest, ChunkedRoundTrip)
+{
+	std::vector<uint8_t> const data = GenerateData(300000);
+
+	LZMACodec lzma;
+	std::vector<uint8_t> encoded;
+	lzma.EncodeChunked(encoded, data.data(), data.size(), 64 * 1024);
+	EXPECT_TRUE(LZMACodec::IsChunked(encoded.data(), encoded.size()));
+
+	std::vector<uint8_t> decoded;
+	lzma.Decode(decoded, encoded.data(), encoded.size(), data.size());
+	EXPECT_TRUE(decoded == data);
+}
+
+TEST(LZMACodecTest, PlainIsNotChunked)
+{
+	std::vector<uint8_t> const data = GenerateData(1000);
+
+	LZMACodec lzma;
+	std::vector<uint8_t> encoded;
+	lzma.Encode(encoded, data.data(), data.size());
+	EXPECT_FALSE(LZMACodec::IsChunked(encoded.data(), encoded.size()));
+}
+
+TEST(LZMACodecTest, DecodeIncremental)
+{
+	std::vector<uint8_t> const data = GenerateData(300000);
+
+	LZMACodec lzma;
+	std::vector<uint8_t> encoded;
+	lzma.EncodeChunked(encoded, data.data(), data.size(), 64 * 1024);
+
+	auto encoded_stream = MakeSharedPtr<std::stringstream>(std::string(encoded.begin(), encoded.end()));
+	auto res = MakeSharedPtr<ResIdentifier>("Test", 0, encoded_stream);
+	auto decoded = lzma.DecodeIncremental(res, encoded.size(), data.size());
+
+	std::vector<uint8_t> head(100);
+	decoded->read(head.data(), head.size());
+	EXPECT_TRUE(std::equal(head.begin(), head.end(), data.begin()));
+
+	decoded->seekg(-10, std::ios_base::end);
+	EXPECT_EQ(decoded->tellg(), static_cast<int64_t>(data.size() - 10));
+
+	decoded->seekg(200000, std::ios_base::beg);
+	std::vector<uint8_t> tail(data.size() - 200000);
+	decoded->read(tail.data(), tail.size());
+	EXPECT_EQ(decoded->gcount(), static_cast<int64_t>(tail.size()));
+	EXPECT_TRUE(std::equal(tail.begin(), tail.end(), data.begin() + 200000));
+}
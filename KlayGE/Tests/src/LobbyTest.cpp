@@ -0,0 +1,529 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KlayGE/Lobby.hpp>
+#include <KlayGE/NetChannel.hpp>
+#include <KlayGE/NetMsg.hpp>
+#include <KlayGE/Socket.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifndef KLAYGE_PLATFORM_WINDOWS
+#include <sys/resource.h>
+#endif
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	// Thousands of players are in the lobby at the same time. The lobby is emptied between the waves.
+	uint32_t const NUM_WAVES = 2;
+	uint32_t const PLAYERS_PER_WAVE = 3000;
+	uint16_t const MAX_PLAYERS = 2500;
+	char const MSG_ECHO = 100;
+
+	class EchoProcessor : public Processor
+	{
+	public:
+		EchoProcessor()
+			: num_joins(0), num_quits(0), num_echoes(0)
+		{
+		}
+
+		void OnJoin(uint32_t /*ID*/) const override
+		{
+			++ num_joins;
+		}
+		void OnQuit(uint32_t /*ID*/) const override
+		{
+			++ num_quits;
+		}
+		void OnDefault(void* revBuf, int maxSize, void* sendBuf, int& numSend, sockaddr_in& /*from*/) const override
+		{
+			++ num_echoes;
+			std::memcpy(static_cast<char*>(sendBuf) + 1, static_cast<char*>(revBuf) + 1, maxSize - 1);
+			numSend = maxSize - 1;
+		}
+
+		mutable std::atomic<uint32_t> num_joins;
+		mutable std::atomic<uint32_t> num_quits;
+		mutable std::atomic<uint32_t> num_echoes;
+	};
+
+	// Drops packets at random, and delivers the others after a fixed latency
+	class LossyLink
+	{
+	public:
+		LossyLink(uint32_t loss_percent, std::chrono::milliseconds latency, uint32_t seed)
+			: loss_percent_(loss_percent), latency_(latency), rng_(seed)
+		{
+		}
+
+		void Send(char const * packet, uint32_t size, NetChannel::TimePoint now)
+		{
+			if (rng_() % 100 >= loss_percent_)
+			{
+				in_flight_.emplace_back(now + latency_, std::vector<char>(packet, packet + size));
+			}
+		}
+
+		void Deliver(NetChannel& channel, NetChannel::TimePoint now, NetChannel::DeliverFunc const & deliver)
+		{
+			while (!in_flight_.empty() && (in_flight_.front().first <= now))
+			{
+				std::vector<char> const & packet = in_flight_.front().second;
+				EXPECT_TRUE(channel.OnPacket(packet.data(), static_cast<uint32_t>(packet.size()), now, deliver));
+				in_flight_.pop_front();
+			}
+		}
+
+	private:
+		uint32_t loss_percent_;
+		std::chrono::milliseconds latency_;
+		std::mt19937 rng_;
+		std::deque<std::pair<NetChannel::TimePoint, std::vector<char>>> in_flight_;
+	};
+
+	class SimulatedPlayers
+	{
+	public:
+		explicit SimulatedPlayers(uint32_t num)
+			: sockets_(num), channels_(num)
+		{
+			for (auto& socket : sockets_)
+			{
+				socket = MakeUniquePtr<Socket>();
+				socket->Create(SOCK_DGRAM);
+				socket->Bind(TransAddr("127.0.0.1", 0));
+				socket->NonBlock(true);
+			}
+		}
+
+		// Sends make_request(player, buf) from every player to the lobby, and resends it every 50 ms until
+		//  on_reply(player, msg, size) returns true for all of them
+		template <typename RequestFunc, typename ReplyFunc>
+		bool RoundTrip(sockaddr_in const & lobby_addr, std::vector<uint32_t> const & players,
+			RequestFunc const & make_request, ReplyFunc const & on_reply)
+		{
+			std::vector<bool> done(sockets_.size(), true);
+			for (auto player : players)
+			{
+				done[player] = false;
+			}
+
+			size_t num_left = players.size();
+			for (int attempt = 0; (attempt < 100) && (num_left > 0); ++ attempt)
+			{
+				for (auto player : players)
+				{
+					if (!done[player])
+					{
+						char buf[Max_Buffer];
+						int const size = make_request(player, buf);
+						sockets_[player]->SendTo(buf, size, lobby_addr);
+					}
+				}
+
+				auto const until = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+				while ((num_left > 0) && (std::chrono::steady_clock::now() < until))
+				{
+					bool received = false;
+					for (auto player : players)
+					{
+						char buf[NET_MTU];
+						sockaddr_in from;
+						int size;
+						while ((size = sockets_[player]->ReceiveFrom(buf, sizeof(buf), from)) > 0)
+						{
+							received = true;
+							if (!done[player] && on_reply(player, buf, size))
+							{
+								done[player] = true;
+								-- num_left;
+							}
+						}
+					}
+
+					if (!received)
+					{
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					}
+				}
+			}
+
+			return 0 == num_left;
+		}
+
+		// Runs a channel for every player, with send(player, channel) called once at the start, until
+		//  on_message(player, msg, size) returns true for all of them and the lobby has acked everything
+		template <typename SendFunc, typename MessageFunc>
+		bool RunChannels(sockaddr_in const & lobby_addr, std::vector<uint32_t> const & players,
+			SendFunc const & send, MessageFunc const & on_message)
+		{
+			std::vector<bool> done(sockets_.size(), true);
+			for (auto player : players)
+			{
+				done[player] = false;
+				channels_[player] = MakeUniquePtr<NetChannel>();
+				send(player, *channels_[player]);
+			}
+
+			size_t num_left = players.size();
+			auto const until = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+			while (std::chrono::steady_clock::now() < until)
+			{
+				auto const now = std::chrono::steady_clock::now();
+
+				bool idle = true;
+				for (auto player : players)
+				{
+					channels_[player]->Flush(now, [this, player, &lobby_addr](char const * packet, uint32_t size)
+						{
+							sockets_[player]->SendTo(packet, size, lobby_addr);
+						});
+					idle &= channels_[player]->Idle();
+				}
+				if ((0 == num_left) && idle)
+				{
+					return true;
+				}
+
+				bool received = false;
+				for (auto player : players)
+				{
+					char buf[NET_MTU];
+					sockaddr_in from;
+					int size;
+					while ((size = sockets_[player]->ReceiveFrom(buf, sizeof(buf), from)) > 0)
+					{
+						received = true;
+						channels_[player]->OnPacket(buf, size, now,
+							[player, &done, &num_left, &on_message](char const * msg, uint32_t msg_size)
+							{
+								if (!done[player] && on_message(player, msg, msg_size))
+								{
+									done[player] = true;
+									-- num_left;
+								}
+							});
+					}
+				}
+
+				if (!received)
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+			}
+
+			return false;
+		}
+
+	private:
+		std::vector<std::unique_ptr<Socket>> sockets_;
+		std::vector<std::unique_ptr<NetChannel>> channels_;
+	};
+}
+
+TEST(LobbyTest, ChannelReliableUnderLoss)
+{
+	uint32_t const NUM_MSGS = 1000;
+	auto const tick = std::chrono::milliseconds(10);
+
+	NetChannel sender;
+	NetChannel receiver;
+	LossyLink to_receiver(20, std::chrono::milliseconds(20), 1);
+	LossyLink to_sender(20, std::chrono::milliseconds(20), 2);
+
+	std::vector<uint32_t> num_received(NUM_MSGS, 0);
+	uint32_t num_unique = 0;
+
+	NetChannel::TimePoint now;
+	uint32_t next_msg = 0;
+	for (uint32_t i = 0; (i < 10000) && ((num_unique < NUM_MSGS) || !sender.Idle()); ++ i)
+	{
+		while ((next_msg < NUM_MSGS) && sender.SendReliable(&next_msg, sizeof(next_msg)))
+		{
+			++ next_msg;
+		}
+
+		sender.Flush(now, [&to_receiver, now](char const * packet, uint32_t size)
+			{
+				EXPECT_LE(size, NET_MTU);
+				to_receiver.Send(packet, size, now);
+			});
+		receiver.Flush(now, [&to_sender, now](char const * packet, uint32_t size)
+			{
+				to_sender.Send(packet, size, now);
+			});
+
+		now += tick;
+		to_receiver.Deliver(receiver, now, [&num_received, &num_unique](char const * msg, uint32_t size)
+			{
+				ASSERT_EQ(size, sizeof(uint32_t));
+				uint32_t id;
+				std::memcpy(&id, msg, sizeof(id));
+				ASSERT_LT(id, num_received.size());
+				if (0 == num_received[id])
+				{
+					++ num_unique;
+				}
+				++ num_received[id];
+			});
+		to_sender.Deliver(sender, now, [](char const * /*msg*/, uint32_t /*size*/)
+			{
+				ADD_FAILURE();
+			});
+	}
+
+	for (uint32_t i = 0; i < NUM_MSGS; ++ i)
+	{
+		EXPECT_EQ(num_received[i], 1U);
+	}
+	EXPECT_TRUE(sender.Idle());
+
+	// 20 ms each way, plus up to a tick before the ack goes out
+	EXPECT_GE(sender.Rtt().count(), 35);
+	EXPECT_LE(sender.Rtt().count(), 65);
+
+	// Only the lost messages are retransmitted, not the whole window
+	EXPECT_LT(sender.Statistics().retransmits, NUM_MSGS / 2);
+}
+
+TEST(LobbyTest, ChannelCoalescing)
+{
+	uint32_t const NUM_MSGS = 300;
+
+	NetChannel sender;
+	NetChannel receiver;
+	NetChannel::TimePoint const now;
+
+	for (uint64_t i = 0; i < NUM_MSGS; ++ i)
+	{
+		EXPECT_TRUE(sender.SendUnreliable(&i, sizeof(i)));
+	}
+
+	std::vector<std::vector<char>> packets;
+	sender.Flush(now, [&packets](char const * packet, uint32_t size)
+		{
+			EXPECT_LE(size, NET_MTU);
+			packets.emplace_back(packet, packet + size);
+		});
+	// 11 bytes per record, so 108 fit in a packet
+	EXPECT_EQ(packets.size(), 3U);
+	EXPECT_EQ(sender.Statistics().packets_sent, 3U);
+
+	uint64_t expected = 0;
+	for (auto const & packet : packets)
+	{
+		EXPECT_TRUE(receiver.OnPacket(packet.data(), static_cast<uint32_t>(packet.size()), now,
+			[&expected](char const * msg, uint32_t size)
+			{
+				ASSERT_EQ(size, sizeof(uint64_t));
+				uint64_t value;
+				std::memcpy(&value, msg, sizeof(value));
+				EXPECT_EQ(value, expected);
+				++ expected;
+			}));
+	}
+	EXPECT_EQ(expected, NUM_MSGS);
+
+	// Nothing left but the ack, repeated once in case it's lost
+	uint32_t num_acks = 0;
+	for (int i = 0; i < 3; ++ i)
+	{
+		receiver.Flush(now, [&num_acks](char const * /*packet*/, uint32_t size)
+			{
+				EXPECT_EQ(size, NET_PACKET_HEADER_SIZE);
+				++ num_acks;
+			});
+	}
+	EXPECT_EQ(num_acks, 2U);
+	EXPECT_TRUE(receiver.Idle());
+}
+
+TEST(LobbyTest, ChannelStateDelta)
+{
+	NetChannel sender;
+	NetChannel receiver;
+	NetChannel::TimePoint const now;
+
+	std::vector<char> state(256);
+	for (size_t i = 0; i < state.size(); ++ i)
+	{
+		state[i] = static_cast<char>(i);
+	}
+
+	std::vector<char> received;
+	auto deliver = [&received](char const * msg, uint32_t size)
+	{
+		received.assign(msg, msg + size);
+	};
+	auto send_state = [&sender, &state, now]
+	{
+		EXPECT_TRUE(sender.SendState(3, state.data(), static_cast<uint32_t>(state.size())));
+
+		std::vector<char> packet;
+		sender.Flush(now, [&packet](char const * data, uint32_t size)
+			{
+				EXPECT_TRUE(packet.empty());
+				packet.assign(data, data + size);
+			});
+		return packet;
+	};
+	auto ack = [&sender, &receiver, now]
+	{
+		receiver.Flush(now, [&sender, now](char const * packet, uint32_t size)
+			{
+				EXPECT_TRUE(sender.OnPacket(packet, size, now, [](char const * /*msg*/, uint32_t /*size*/) {}));
+			});
+	};
+
+	// Nothing acked yet, the first value is sent in full
+	std::vector<char> packet = send_state();
+	EXPECT_GT(packet.size(), state.size());
+	EXPECT_TRUE(receiver.OnPacket(packet.data(), static_cast<uint32_t>(packet.size()), now, deliver));
+	EXPECT_EQ(received, state);
+	ack();
+
+	// Against the acked value, only the changed bytes are sent
+	state[10] = 100;
+	state[200] = 42;
+	packet = send_state();
+	EXPECT_LT(packet.size(), NET_PACKET_HEADER_SIZE + 20);
+	EXPECT_TRUE(receiver.OnPacket(packet.data(), static_cast<uint32_t>(packet.size()), now, deliver));
+	EXPECT_EQ(received, state);
+	ack();
+
+	// Reordered values. The older one is dropped.
+	state[11] = 1;
+	std::vector<char> const older_packet = send_state();
+	state[12] = 2;
+	packet = send_state();
+	EXPECT_TRUE(receiver.OnPacket(packet.data(), static_cast<uint32_t>(packet.size()), now, deliver));
+	EXPECT_EQ(received, state);
+	EXPECT_TRUE(receiver.OnPacket(older_packet.data(), static_cast<uint32_t>(older_packet.size()), now, deliver));
+	EXPECT_EQ(received, state);
+
+	EXPECT_FALSE(sender.SendState(NetChannel::NUM_STATE_SLOTS, state.data(), static_cast<uint32_t>(state.size())));
+}
+
+TEST(LobbyTest, SimulatedPlayers)
+{
+#ifndef KLAYGE_PLATFORM_WINDOWS
+	// Every player has its own socket, which is more than the default limit of open files on some systems
+	rlim_t const num_files = PLAYERS_PER_WAVE + 64;
+	rlimit limit;
+	ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &limit), 0);
+	if (limit.rlim_cur < num_files)
+	{
+		limit.rlim_cur = std::min(num_files, limit.rlim_max);
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+	ASSERT_GE(limit.rlim_cur, num_files) << "The hard limit of open files is too low for this test";
+#endif
+
+	EchoProcessor pro;
+	Lobby lobby;
+	lobby.Create("LobbyTest", MAX_PLAYERS, 0);
+	sockaddr_in const lobby_addr = TransAddr("127.0.0.1", ntohs(lobby.SockAddr().sin_port));
+
+	std::thread lobby_thread([&lobby, &pro]
+		{
+			lobby.Run(pro);
+		});
+
+	for (uint32_t wave = 0; wave < NUM_WAVES; ++ wave)
+	{
+		SimulatedPlayers players(PLAYERS_PER_WAVE);
+
+		std::vector<uint32_t> all_players(PLAYERS_PER_WAVE);
+		for (uint32_t i = 0; i < PLAYERS_PER_WAVE; ++ i)
+		{
+			all_players[i] = i;
+		}
+
+		// Exactly MAX_PLAYERS players get in, the others are told the lobby is full
+		std::vector<uint16_t> ids(PLAYERS_PER_WAVE, 0);
+		EXPECT_TRUE(players.RoundTrip(lobby_addr, all_players,
+			[](uint32_t player, char* buf)
+			{
+				std::memset(buf, 0, 17);
+				buf[0] = MSG_JOIN;
+				std::string const name = "Player" + std::to_string(player);
+				name.copy(&buf[1], name.size());
+				return 17;
+			},
+			[&ids](uint32_t player, char const * msg, int size)
+			{
+				if ((3 == size) && (MSG_JOIN == msg[0]))
+				{
+					uint16_t id;
+					std::memcpy(&id, &msg[1], sizeof(id));
+					ids[player] = LE2Native(id);
+					return true;
+				}
+				return false;
+			}));
+
+		std::vector<uint32_t> joined;
+		std::vector<bool> id_used(MAX_PLAYERS + 1, false);
+		for (uint32_t i = 0; i < PLAYERS_PER_WAVE; ++ i)
+		{
+			if (ids[i] != 0)
+			{
+				ASSERT_LE(ids[i], MAX_PLAYERS);
+				EXPECT_FALSE(id_used[ids[i]]);
+				id_used[ids[i]] = true;
+				joined.push_back(i);
+			}
+		}
+		EXPECT_EQ(joined.size(), static_cast<size_t>(MAX_PLAYERS));
+
+		// Reliable messages are delivered exactly once, and the echoes come back in the same channel
+		EXPECT_TRUE(players.RunChannels(lobby_addr, joined,
+			[](uint32_t player, NetChannel& channel)
+			{
+				char buf[1 + sizeof(player)];
+				buf[0] = MSG_ECHO;
+				std::memcpy(&buf[1], &player, sizeof(player));
+				EXPECT_TRUE(channel.SendReliable(buf, sizeof(buf)));
+			},
+			[](uint32_t player, char const * msg, uint32_t size)
+			{
+				uint32_t echo;
+				if ((1 + sizeof(echo) == size) && (MSG_ECHO == msg[0]))
+				{
+					std::memcpy(&echo, &msg[1], sizeof(echo));
+					return echo == player;
+				}
+				return false;
+			}));
+		EXPECT_EQ(pro.num_echoes.load(), (wave + 1) * MAX_PLAYERS);
+
+		EXPECT_TRUE(players.RoundTrip(lobby_addr, joined,
+			[](uint32_t /*player*/, char* buf)
+			{
+				buf[0] = MSG_QUIT;
+				return 1;
+			},
+			[](uint32_t /*player*/, char const * msg, int size)
+			{
+				return (2 == size) && (MSG_QUIT == msg[0]);
+			}));
+	}
+
+	EXPECT_EQ(pro.num_joins.load(), NUM_WAVES * MAX_PLAYERS);
+	EXPECT_EQ(pro.num_quits.load(), NUM_WAVES * MAX_PLAYERS);
+
+	lobby.Close();
+	lobby_thread.join();
+}
@@ -0,0 +1,148 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/Log.hpp>
+
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	// Redirects std::clog, the console sink, for the lifetime of the object
+	class CapturedLog
+	{
+	public:
+		CapturedLog()
+		{
+			LogFlush();
+			old_buff_ = std::clog.rdbuf(captured_.rdbuf());
+		}
+		~CapturedLog()
+		{
+			LogFlush();
+			std::clog.rdbuf(old_buff_);
+		}
+
+		std::vector<std::string> Lines()
+		{
+			LogFlush();
+
+			std::vector<std::string> lines;
+			std::istringstream iss(captured_.str());
+			std::string line;
+			while (std::getline(iss, line))
+			{
+				lines.push_back(line);
+			}
+			return lines;
+		}
+
+	private:
+		std::ostringstream captured_;
+		std::streambuf* old_buff_;
+	};
+
+	std::string Payload(uint32_t thread, uint32_t index)
+	{
+		// Some of the messages are longer than a slot of the queue
+		return "thread " + std::to_string(thread) + " message " + std::to_string(index) + " "
+			+ std::string((thread * 37 + index * 13) % 400, static_cast<char>('a' + thread));
+	}
+
+	std::string MessageOf(std::string const & line, std::string const & tag)
+	{
+		std::string const marker = "(" + tag + ") KlayGE: ";
+		auto const pos = line.find(marker);
+		return (pos == std::string::npos) ? std::string() : line.substr(pos + marker.size());
+	}
+}
+
+TEST(LogTest, ConcurrentMessagesStayWhole)
+{
+	uint32_t const NUM_THREADS = 8;
+	uint32_t const NUM_MESSAGES = 2000;
+
+	CapturedLog captured;
+
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < NUM_THREADS; ++ t)
+	{
+		threads.emplace_back([t]
+			{
+				for (uint32_t i = 0; i < NUM_MESSAGES; ++ i)
+				{
+					LogInfo() << Payload(t, i) << std::endl;
+				}
+			});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	auto const lines = captured.Lines();
+	ASSERT_EQ(lines.size(), NUM_THREADS * NUM_MESSAGES);
+
+	// Every message is intact, and the messages of a thread keep their order
+	std::vector<uint32_t> next_index(NUM_THREADS, 0);
+	for (auto const & line : lines)
+	{
+		std::string const msg = MessageOf(line, "INFO");
+		std::istringstream iss(msg);
+		std::string word;
+		uint32_t t = NUM_THREADS;
+		uint32_t i = 0;
+		iss >> word >> t >> word >> i;
+		ASSERT_LT(t, NUM_THREADS) << line;
+		EXPECT_EQ(i, next_index[t]);
+		EXPECT_EQ(msg, Payload(t, i));
+		next_index[t] = i + 1;
+	}
+}
+
+TEST(LogTest, LevelFilter)
+{
+	LogLevel const old_filter = LogLevelFilter();
+
+	std::vector<std::string> lines;
+	{
+		CapturedLog captured;
+
+		LogLevelFilter(LL_Warn);
+		LogInfo() << "dropped" << std::endl;
+		LogWarn() << "warn" << std::endl;
+		LogError() << "error" << std::endl;
+		LogLevelFilter(old_filter);
+
+		lines = captured.Lines();
+	}
+
+	ASSERT_EQ(lines.size(), 2U);
+	EXPECT_EQ(MessageOf(lines[0], "WARN"), "warn");
+	EXPECT_EQ(MessageOf(lines[1], "ERROR"), "error");
+}
+
+TEST(LogTest, MessageEndsAtNextLog)
+{
+	std::vector<std::string> lines;
+	{
+		CapturedLog captured;
+
+		LogInfo() << "no endl\n";
+		LogWarn() << 1 << ' ' << 2.5f << '\n';
+		LogFlush();
+
+		lines = captured.Lines();
+	}
+
+	ASSERT_EQ(lines.size(), 2U);
+	EXPECT_EQ(MessageOf(lines[0], "INFO"), "no endl");
+	EXPECT_EQ(MessageOf(lines[1], "WARN"), "1 2.5");
+}
@@ -37,6 +37,7 @@
 #include <KlayGE/Mesh.hpp>
 #include <KlayGE/MeshConverter.hpp>
 #include <KlayGE/MeshMetadata.hpp>
+#include <KlayGE/SceneObjectHelper.hpp>
 
 #include "KlayGETests.hpp"
 
@@ -751,3 +752,193 @@ TEST_F(MeshConverterTest, AnimationMeshML)
 {
 	RunTest("anim.meshml", "", "anim.meshml");
 }
+
+TEST_F(MeshConverterTest, NegativeScaleKeyRoundTrip)
+{
+	auto model = LoadSoftwareModel("anim.meshml");
+	ASSERT_TRUE(model->IsSkinned());
+	auto& skinned_model = *checked_cast<SkinnedModel*>(model.get());
+
+	// Mirror some keys, with both signs of real.w
+	auto kfs = MakeSharedPtr<std::vector<KeyFrameSet>>(*skinned_model.GetKeyFrameSets());
+	ASSERT_FALSE(kfs->empty());
+	auto& kf = kfs->front();
+	ASSERT_GE(kf.bind_real.size(), 2U);
+	kf.bind_scale[0] = -std::abs(kf.bind_scale[0]);
+	kf.bind_scale[1] = -std::abs(kf.bind_scale[1]);
+	kf.bind_real[1] = -kf.bind_real[1];
+	skinned_model.AttachKeyFrameSets(kfs);
+
+	std::string const round_trip_name = "anim_negative_scale.model_bin";
+	SaveModel(model, round_trip_name);
+	auto loaded_model = LoadSoftwareModel(round_trip_name);
+	std::filesystem::remove(round_trip_name);
+
+	auto const & loaded_kf = checked_cast<SkinnedModel*>(loaded_model.get())->GetKeyFrameSets()->front();
+	ASSERT_EQ(loaded_kf.bind_real.size(), kf.bind_real.size());
+	for (size_t i = 0; i < kf.bind_real.size(); ++ i)
+	{
+		// Same as the old loader, which rebuilt the key from real * scale
+		Quaternion const scaled_real = kf.bind_real[i] * kf.bind_scale[i];
+		float const expected_scale = MathLib::length(scaled_real) * MathLib::SignBit(scaled_real.w());
+		Quaternion const expected_real = scaled_real / MathLib::length(scaled_real);
+
+		for (uint32_t c = 0; c < 4; ++ c)
+		{
+			EXPECT_NEAR(loaded_kf.bind_real[i][c], expected_real[c], 1e-5f);
+			EXPECT_NEAR(loaded_kf.bind_dual[i][c], kf.bind_dual[i][c], 1e-5f);
+		}
+		EXPECT_NEAR(loaded_kf.bind_scale[i], expected_scale, 1e-5f);
+	}
+}
+
+namespace
+{
+	void ExpectSameBinds(SkinnedModel const & model, SkinnedModel const & sanity_model)
+	{
+		auto const & bind_reals = model.GetBindRealParts();
+		auto const & bind_duals = model.GetBindDualParts();
+		auto const & sanity_bind_reals = sanity_model.GetBindRealParts();
+		auto const & sanity_bind_duals = sanity_model.GetBindDualParts();
+		ASSERT_EQ(bind_reals.size(), sanity_bind_reals.size());
+		ASSERT_EQ(bind_duals.size(), sanity_bind_duals.size());
+		for (size_t i = 0; i < bind_reals.size(); ++ i)
+		{
+			EXPECT_EQ(bind_reals[i], sanity_bind_reals[i]);
+			EXPECT_EQ(bind_duals[i], sanity_bind_duals[i]);
+		}
+	}
+}
+
+TEST(SkinnedModelTest, SetFrames)
+{
+	std::vector<RenderModelPtr> models;
+	std::vector<SkinnedModel*> skinned_models;
+	std::vector<float> frames;
+	for (uint32_t i = 0; i < 8; ++ i)
+	{
+		models.push_back(LoadSoftwareModel("anim.meshml"));
+		ASSERT_TRUE(models.back()->IsSkinned());
+		skinned_models.push_back(checked_cast<SkinnedModel*>(models.back().get()));
+		frames.push_back(i * 1.7f);
+	}
+
+	SkinnedModel::SetFrames(skinned_models, frames);
+
+	auto sanity_model = LoadSoftwareModel("anim.meshml");
+	auto& sanity_skinned_model = *checked_cast<SkinnedModel*>(sanity_model.get());
+	for (size_t i = 0; i < skinned_models.size(); ++ i)
+	{
+		sanity_skinned_model.SetFrame(frames[i]);
+
+		EXPECT_EQ(skinned_models[i]->GetFrame(), frames[i]);
+		ExpectSameBinds(*skinned_models[i], sanity_skinned_model);
+	}
+}
+
+TEST(SkinnedModelTest, PrepareCommitFrame)
+{
+	auto model = LoadSoftwareModel("anim.meshml");
+	ASSERT_TRUE(model->IsSkinned());
+	auto& skinned_model = *checked_cast<SkinnedModel*>(model.get());
+	auto sanity_model = LoadSoftwareModel("anim.meshml");
+	auto& sanity_skinned_model = *checked_cast<SkinnedModel*>(sanity_model.get());
+
+	skinned_model.SetFrame(0);
+	sanity_skinned_model.SetFrame(0);
+
+	// The prepared pose stays invisible until it's committed
+	skinned_model.PrepareFrame(5.5f);
+	EXPECT_EQ(skinned_model.GetFrame(), 0.0f);
+	ExpectSameBinds(skinned_model, sanity_skinned_model);
+
+	skinned_model.CommitFrame();
+	sanity_skinned_model.SetFrame(5.5f);
+	EXPECT_EQ(skinned_model.GetFrame(), 5.5f);
+	ExpectSameBinds(skinned_model, sanity_skinned_model);
+
+	// Nothing new is prepared, so the pose is kept
+	skinned_model.CommitFrame();
+	EXPECT_EQ(skinned_model.GetFrame(), 5.5f);
+	ExpectSameBinds(skinned_model, sanity_skinned_model);
+}
+
+TEST(SkinnedModelTest, SceneObjectSkinnedModel)
+{
+	auto model = checked_pointer_cast<SkinnedModel>(LoadSoftwareModel("anim.meshml"));
+	auto scene_obj = MakeSharedPtr<SceneObjectSkinnedModel>(model, SceneObject::SOA_Cullable);
+	EXPECT_TRUE(scene_obj->Attrib() & SceneObject::SOA_ParallelUpdate);
+
+	float const app_time = 0.5f;
+	float const frame = app_time * model->FrameRate();
+	scene_obj->SubThreadUpdate(app_time, app_time);
+	EXPECT_NE(model->GetFrame(), frame);
+	scene_obj->MainThreadUpdate(app_time, app_time);
+	EXPECT_EQ(model->GetFrame(), frame);
+}
+
+namespace
+{
+	KeyFrameSet TestKeyFrameSet()
+	{
+		KeyFrameSet kf;
+		for (uint32_t i = 0; i < 10; ++ i)
+		{
+			Quaternion const real = MathLib::rotation_axis(float3(1, 2, 3), i * 0.3f);
+			kf.frame_id.push_back(i * 3);
+			kf.bind_real.push_back(real);
+			kf.bind_dual.push_back(MathLib::quat_trans_to_udq(real, float3(i * 0.5f, 1.0f, -0.25f * i)));
+			kf.bind_scale.push_back(1 + i * 0.1f);
+		}
+		return kf;
+	}
+}
+
+TEST(KeyFrameSetTest, Quantize)
+{
+	KeyFrameSet const kf = TestKeyFrameSet();
+	KeyFrameSet quantized_kf = kf;
+	quantized_kf.Quantize();
+	EXPECT_TRUE(quantized_kf.Quantized());
+	EXPECT_TRUE(quantized_kf.bind_real.empty());
+
+	for (float frame = 0; frame < 30; frame += 0.7f)
+	{
+		Quaternion real, dual, quantized_real, quantized_dual;
+		float scale, quantized_scale;
+		std::tie(real, dual, scale) = kf.Frame(frame);
+		std::tie(quantized_real, quantized_dual, quantized_scale) = quantized_kf.Frame(frame);
+
+		// q and -q are the same rotation
+		float const sign = (MathLib::dot(real, quantized_real) < 0) ? -1.0f : 1.0f;
+		for (uint32_t c = 0; c < 4; ++ c)
+		{
+			EXPECT_NEAR(real[c], sign * quantized_real[c], 1e-3f);
+			EXPECT_NEAR(dual[c], sign * quantized_dual[c], 1e-3f);
+		}
+		EXPECT_NEAR(scale, quantized_scale, 1e-3f);
+	}
+
+	quantized_kf.Dequantize();
+	EXPECT_FALSE(quantized_kf.Quantized());
+	EXPECT_EQ(quantized_kf.bind_real.size(), kf.bind_real.size());
+}
+
+TEST(KeyFrameSetTest, Cursor)
+{
+	KeyFrameSet const kf = TestKeyFrameSet();
+
+	// Forward, looping and backward playback all find the same keys as a search from scratch
+	uint32_t cursor = 0;
+	for (float frame : { 0.0f, 0.5f, 1.0f, 4.0f, 5.5f, 17.0f, 28.0f, 29.5f, 31.0f, 2.0f, 1.0f })
+	{
+		uint32_t key0, key1, cursor_key0, cursor_key1;
+		float factor, cursor_factor;
+		kf.FrameKeys(frame, key0, key1, factor);
+		kf.FrameKeys(frame, cursor, cursor_key0, cursor_key1, cursor_factor);
+		EXPECT_EQ(key0, cursor_key0);
+		EXPECT_EQ(key1, cursor_key1);
+		EXPECT_EQ(factor, cursor_factor);
+		EXPECT_EQ(cursor, key0);
+	}
+}
@@ -0,0 +1,183 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KlayGE/ParticleSystem.hpp>
+
+#include "KlayGETests.hpp"
+
+#include <algorithm>
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	Particle MakeParticle(float v)
+	{
+		Particle par;
+		par.pos = float3(v, v + 1, v + 2);
+		par.vel = float3(-v, -v - 1, -v - 2);
+		par.life = v;
+		par.spin = v * 2;
+		par.size = v * 3;
+		par.alpha = v * 4;
+		par.init_life = v + 10;
+		return par;
+	}
+
+	std::shared_ptr<PolylineParticleUpdater> MakePolylineUpdater(ParticleSystemPtr const & ps)
+	{
+		auto updater = checked_pointer_cast<PolylineParticleUpdater>(ps->MakeUpdater("polyline"));
+		updater->SizeOverLife({ float2(0, 1), float2(0.4f, 2), float2(1, 0.5f) });
+		updater->MassOverLife({ float2(0, 1), float2(1, 3) });
+		updater->OpacityOverLife({ float2(0, 1), float2(0.7f, 0.8f), float2(1, 0) });
+		return updater;
+	}
+
+	void ExpectNear(float actual, float expected)
+	{
+		EXPECT_NEAR(actual, expected, 1e-4f * std::max(1.0f, MathLib::abs(expected)));
+	}
+}
+
+TEST(ParticleSoATest, GetSet)
+{
+	ParticleSoA particles(5);
+	EXPECT_EQ(particles.Capacity(), 5U);
+	EXPECT_TRUE(particles.Empty());
+
+	for (uint32_t i = 0; i < 5; ++ i)
+	{
+		particles.PushBack(MakeParticle(static_cast<float>(i)));
+	}
+	EXPECT_TRUE(particles.Full());
+
+	for (uint32_t i = 0; i < 5; ++ i)
+	{
+		Particle const expected = MakeParticle(static_cast<float>(i));
+		Particle const par = particles.Get(i);
+		EXPECT_EQ(par.pos, expected.pos);
+		EXPECT_EQ(par.vel, expected.vel);
+		EXPECT_EQ(par.life, expected.life);
+		EXPECT_EQ(par.spin, expected.spin);
+		EXPECT_EQ(par.size, expected.size);
+		EXPECT_EQ(par.alpha, expected.alpha);
+		EXPECT_EQ(par.init_life, expected.init_life);
+
+		EXPECT_EQ(particles.Stream(ParticleSoA::PS_PosY)[i], expected.pos.y());
+	}
+
+	// Streams are aligned and padded to whole batches
+	for (int s = 0; s < ParticleSoA::PS_NumStreams; ++ s)
+	{
+		float const * stream = particles.Stream(static_cast<ParticleSoA::StreamType>(s));
+		EXPECT_EQ(reinterpret_cast<size_t>(stream) % (ParticleSoA::BATCH_SIZE * sizeof(float)), 0U);
+	}
+}
+
+TEST(ParticleSoATest, SwapRemove)
+{
+	ParticleSoA particles(4);
+	for (uint32_t i = 0; i < 4; ++ i)
+	{
+		particles.PushBack(MakeParticle(static_cast<float>(i)));
+	}
+
+	particles.SwapRemove(1);
+	ASSERT_EQ(particles.Size(), 3U);
+	EXPECT_EQ(particles.Get(0).life, 0.0f);
+	EXPECT_EQ(particles.Get(1).life, 3.0f);
+	EXPECT_EQ(particles.Get(2).life, 2.0f);
+
+	particles.SwapRemove(2);
+	ASSERT_EQ(particles.Size(), 2U);
+	EXPECT_EQ(particles.Get(1).life, 3.0f);
+
+	particles.PushBack(MakeParticle(7.0f));
+	EXPECT_EQ(particles.Get(2).pos, MakeParticle(7.0f).pos);
+
+	particles.Clear();
+	EXPECT_TRUE(particles.Empty());
+}
+
+TEST(ParticleSystemTest, PolylineUpdaterBatchesMatchScalar)
+{
+	auto ps = MakeSharedPtr<ParticleSystem>(64);
+	ps->Force(float3(0.3f, 0.1f, -0.2f));
+	ps->MediaDensity(0.5f);
+	auto updater = MakePolylineUpdater(ps);
+
+	// Not a multiple of the batch size, and updated from an unaligned begin, so the scalar head and tail run too
+	uint32_t const NUM_PARTICLES = 23;
+	ParticleSoA batched(NUM_PARTICLES);
+	ParticleSoA scalar(NUM_PARTICLES);
+	for (uint32_t i = 0; i < NUM_PARTICLES; ++ i)
+	{
+		Particle const par = MakeParticle(i * 0.37f);
+		batched.PushBack(par);
+		scalar.PushBack(par);
+	}
+
+	float const elapsed_time = 0.05f;
+	updater->Update(batched, 1, NUM_PARTICLES, elapsed_time);
+	// A range of one particle never fills a batch
+	for (uint32_t i = 1; i < NUM_PARTICLES; ++ i)
+	{
+		updater->Update(scalar, i, i + 1, elapsed_time);
+	}
+
+	for (uint32_t i = 0; i < NUM_PARTICLES; ++ i)
+	{
+		Particle const par = batched.Get(i);
+		Particle const expected = scalar.Get(i);
+		for (uint32_t c = 0; c < 3; ++ c)
+		{
+			ExpectNear(par.pos[c], expected.pos[c]);
+			ExpectNear(par.vel[c], expected.vel[c]);
+		}
+		ExpectNear(par.life, expected.life);
+		ExpectNear(par.spin, expected.spin);
+		ExpectNear(par.size, expected.size);
+		ExpectNear(par.alpha, expected.alpha);
+		EXPECT_EQ(par.init_life, expected.init_life);
+	}
+	EXPECT_EQ(batched.Get(0).pos, MakeParticle(0).pos);
+}
+
+TEST(ParticleSystemTest, ParallelPosBound)
+{
+	// Enough particles for the bound to be reduced from several chunks
+	uint32_t const NUM_PARTICLES = 5000;
+	float const elapsed_time = 0.1f;
+
+	auto ps = MakeSharedPtr<ParticleSystem>(NUM_PARTICLES);
+	auto emitter = ps->MakeEmitter("point");
+	emitter->Frequency(NUM_PARTICLES / elapsed_time);
+	emitter->EmitAngle(PI);
+	emitter->MinPosition(float3(-5, -2, -3));
+	emitter->MaxPosition(float3(4, 6, 2));
+	emitter->MinVelocity(0.5f);
+	emitter->MaxVelocity(2);
+	emitter->MinLife(10);
+	emitter->MaxLife(20);
+	ps->AddEmitter(emitter);
+	ps->AddUpdater(MakePolylineUpdater(ps));
+
+	ps->SubThreadUpdate(0, elapsed_time);
+	ps->SubThreadUpdate(elapsed_time, elapsed_time);
+	ps->MainThreadUpdate(elapsed_time * 2, elapsed_time);
+
+	uint32_t const num_active = ps->NumActiveParticles();
+	ASSERT_GT(num_active, NUM_PARTICLES / 2);
+
+	float3 min_bb(+1e10f, +1e10f, +1e10f);
+	float3 max_bb(-1e10f, -1e10f, -1e10f);
+	for (uint32_t i = 0; i < num_active; ++ i)
+	{
+		float3 const pos = ps->GetParticle(ps->GetActiveParticleIndex(i)).pos;
+		min_bb = MathLib::minimize(min_bb, pos);
+		max_bb = MathLib::maximize(max_bb, pos);
+	}
+
+	AABBox const & bound = ps->GetRenderable()->PosBound();
+	EXPECT_EQ(bound.Min(), min_bb);
+	EXPECT_EQ(bound.Max(), max_bb);
+}
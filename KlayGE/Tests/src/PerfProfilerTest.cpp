@@ -0,0 +1,116 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KlayGE/PerfProfiler.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	uint32_t const NUM_THREADS = 4;
+	uint32_t const NUM_ITERATIONS = 5000;
+
+	size_t CountOccurrences(std::string const & str, std::string const & pattern)
+	{
+		size_t count = 0;
+		for (size_t pos = str.find(pattern); pos != std::string::npos; pos = str.find(pattern, pos + pattern.size()))
+		{
+			++ count;
+		}
+		return count;
+	}
+}
+
+TEST(PerfProfilerTest, ChromeTrace)
+{
+	ContextCfg const old_cfg = Context::Instance().Config();
+	ContextCfg cfg = old_cfg;
+	cfg.perf_profiler = true;
+	Context::Instance().Config(cfg);
+
+	PerfProfiler::Destroy();
+	PerfProfiler& profiler = PerfProfiler::Instance();
+
+	std::vector<std::thread> threads;
+	for (uint32_t i = 0; i < NUM_THREADS; ++ i)
+	{
+		threads.emplace_back([&profiler, i]
+			{
+				profiler.SetThreadName("Worker \"" + std::to_string(i) + "\"");
+				for (uint32_t j = 0; j < NUM_ITERATIONS; ++ j)
+				{
+					PerfZone outer("Outer");
+					{
+						PerfZone inner("Inner");
+					}
+				}
+			});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	uint64_t const begin = profiler.Now();
+	uint64_t const end = profiler.Now();
+	EXPECT_LE(begin, end);
+	profiler.AddZone("Main", begin, end);
+
+	profiler.ExportToChromeTrace("perf_profiler_test.json");
+
+	std::ifstream ifs("perf_profiler_test.json");
+	std::string const trace((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+	EXPECT_EQ(trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0U);
+	EXPECT_EQ(CountOccurrences(trace, "\"ph\":\"M\""), NUM_THREADS + 1);
+	EXPECT_EQ(CountOccurrences(trace, "\"ph\":\"X\""), NUM_THREADS * NUM_ITERATIONS * 2 + 1);
+	EXPECT_EQ(CountOccurrences(trace, "\"name\":\"Inner\""), NUM_THREADS * NUM_ITERATIONS);
+	for (uint32_t i = 0; i < NUM_THREADS; ++ i)
+	{
+		EXPECT_NE(trace.find("\"name\":\"Worker \\\"" + std::to_string(i) + "\\\"\""), std::string::npos);
+	}
+
+	PerfProfiler::Destroy();
+	Context::Instance().Config(old_cfg);
+}
+
+TEST(PerfProfilerTest, BoundedEvents)
+{
+	ContextCfg const old_cfg = Context::Instance().Config();
+	ContextCfg cfg = old_cfg;
+	cfg.perf_profiler = true;
+	Context::Instance().Config(cfg);
+
+	PerfProfiler::Destroy();
+	PerfProfiler& profiler = PerfProfiler::Instance();
+
+	// Only the latest events of a thread are kept
+	uint32_t const num_events = PerfProfiler::MAX_EVENTS_PER_THREAD * 2 + 1000;
+	std::thread thread([&profiler, num_events]
+		{
+			for (uint32_t i = 0; i < num_events; ++ i)
+			{
+				profiler.AddZone(i + 1 == num_events ? "Last" : (i == 0 ? "First" : "Zone"), i * 1000ULL, i * 1000ULL + 500);
+			}
+		});
+	thread.join();
+
+	profiler.ExportToChromeTrace("perf_profiler_bounded_test.json");
+
+	std::ifstream ifs("perf_profiler_bounded_test.json");
+	std::string const trace((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+	size_t const num_exported = CountOccurrences(trace, "\"ph\":\"X\"");
+	EXPECT_LE(num_exported, PerfProfiler::MAX_EVENTS_PER_THREAD);
+	EXPECT_GT(num_exported, PerfProfiler::MAX_EVENTS_PER_THREAD / 2);
+	EXPECT_EQ(CountOccurrences(trace, "\"name\":\"First\""), 0U);
+	EXPECT_EQ(CountOccurrences(trace, "\"name\":\"Last\""), 1U);
+
+	PerfProfiler::Destroy();
+	Context::Instance().Config(old_cfg);
+}
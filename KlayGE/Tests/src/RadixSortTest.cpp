@@ -0,0 +1,73 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/JobSystem.hpp>
+#include <KFL/RadixSort.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	struct KeyValue
+	{
+		uint64_t key;
+		uint32_t value;
+	};
+
+	std::vector<KeyValue> RandomKeyValues(uint32_t num, uint64_t key_mask)
+	{
+		std::mt19937_64 gen(1);
+		std::vector<KeyValue> items(num);
+		for (uint32_t i = 0; i < num; ++ i)
+		{
+			items[i].key = gen() & key_mask;
+			items[i].value = i;
+		}
+		return items;
+	}
+
+	void CheckRadixSort(uint32_t num, uint64_t key_mask, JobSystem* job_system)
+	{
+		std::vector<KeyValue> items = RandomKeyValues(num, key_mask);
+		std::vector<KeyValue> expected = items;
+		std::stable_sort(expected.begin(), expected.end(),
+			[](KeyValue const & lhs, KeyValue const & rhs)
+			{
+				return lhs.key < rhs.key;
+			});
+
+		std::vector<KeyValue> scratch(num);
+		RadixSort(items.data(), scratch.data(), num, job_system);
+		for (uint32_t i = 0; i < num; ++ i)
+		{
+			EXPECT_EQ(items[i].key, expected[i].key);
+			EXPECT_EQ(items[i].value, expected[i].value);
+		}
+	}
+}
+
+TEST(RadixSortTest, Serial)
+{
+	for (uint32_t num : { 0, 1, 2, 100, 5000 })
+	{
+		CheckRadixSort(num, ~0ULL, nullptr);
+		// Few bits in use, lots of equal keys to check stability and skipped passes
+		CheckRadixSort(num, 0xF00000000000000FULL, nullptr);
+	}
+}
+
+TEST(RadixSortTest, Parallel)
+{
+	JobSystem job_system(4);
+
+	for (uint32_t num : { 100, 5000, 100000 })
+	{
+		CheckRadixSort(num, ~0ULL, &job_system);
+		CheckRadixSort(num, 0xF00000000000000FULL, &job_system);
+	}
+}
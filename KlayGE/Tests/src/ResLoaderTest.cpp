@@ -1,5 +1,11 @@
 #include <KlayGE/KlayGE.hpp>
 #include <KlayGE/ResLoader.hpp>
+#include <KFL/CXX17/filesystem.hpp>
+#include <KFL/XMLDom.hpp>
+
+#include <fstream>
+#include <thread>
+#include <vector>
 
 #include "KlayGETests.hpp"
 
@@ -95,3 +101,83 @@ TEST(ResLoaderTest, MountUnmountInsideEncrypt7zPath)
 	ResLoader::Instance().Unmount("ResLoaderTestData", "../../Tests/media/ResLoader/TestPassword.7z|1234/ResLoader");
 	EXPECT_TRUE(ResLoader::Instance().Locate("ResLoaderTestData/Test.txt").empty());
 }
+
+TEST(ResLoaderTest, ReadView)
+{
+	ResLoader::Instance().AddPath("../../Tests/media/ResLoader");
+
+	auto res = ResLoader::Instance().Open("Test.txt");
+	EXPECT_TRUE(res);
+	ASSERT_TRUE(res->MappedData() != nullptr);
+	EXPECT_EQ(res->MappedSize(), sanity_string.size());
+
+	char first;
+	res->read(&first, sizeof(first));
+	EXPECT_EQ(first, sanity_string[0]);
+
+	size_t const rest = sanity_string.size() - 1;
+	char const * view = static_cast<char const *>(res->ReadView(rest));
+	ASSERT_TRUE(view != nullptr);
+	EXPECT_EQ(std::string(view, rest), sanity_string.substr(1));
+	EXPECT_EQ(res->tellg(), static_cast<int64_t>(sanity_string.size()));
+	EXPECT_TRUE(res->ReadView(1) == nullptr);
+
+	ResLoader::Instance().DelPath("../../Tests/media/ResLoader");
+}
+
+TEST(ResLoaderTest, Reopen7zEntry)
+{
+	ResLoader::Instance().Mount("ResLoaderTestData", "../../Tests/media/ResLoader/Test.7z");
+
+	// The second open is served from the decoded entry cache, and the lookup is case insensitive
+	auto res0 = ResLoader::Instance().Open("ResLoaderTestData/Test.txt");
+	auto res1 = ResLoader::Instance().Open("ResLoaderTestData/TEST.TXT");
+	EXPECT_TRUE(res0);
+	EXPECT_TRUE(res1);
+	EXPECT_EQ(ReadWholeFile(res1), sanity_string);
+	EXPECT_EQ(ReadWholeFile(res0), sanity_string);
+	EXPECT_EQ(res0->MappedData(), res1->MappedData());
+
+	ResLoader::Instance().Unmount("ResLoaderTestData", "../../Tests/media/ResLoader/Test.7z");
+}
+
+TEST(ResLoaderTest, OpenXMLConcurrently)
+{
+	std::filesystem::path const dir = std::filesystem::temp_directory_path() / "ResLoaderXMLTest";
+	std::filesystem::create_directories(dir);
+	{
+		std::ofstream ofs((dir / "Test.xml").string().c_str());
+		ofs << "<?xml version='1.0'?>\n<test value=\"42\"/>\n";
+	}
+	ResLoader::Instance().AddPath(dir.string());
+
+	// Only one of the threads compiles the XML, and every one of them gets a whole document
+	uint32_t const NUM_THREADS = 8;
+	std::vector<int> values(NUM_THREADS, 0);
+	std::vector<std::thread> threads;
+	for (uint32_t i = 0; i < NUM_THREADS; ++ i)
+	{
+		threads.emplace_back([&values, i]
+			{
+				XMLDocument doc;
+				XMLNodePtr root = doc.Parse(ResLoader::Instance().OpenXML("Test.xml"));
+				values[i] = root ? root->AttribInt("value", 0) : -1;
+			});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	for (uint32_t i = 0; i < NUM_THREADS; ++ i)
+	{
+		EXPECT_EQ(values[i], 42);
+	}
+
+#if KLAYGE_IS_DEV_PLATFORM
+	EXPECT_TRUE(std::filesystem::exists(dir / "Test.xml.kxml"));
+	EXPECT_FALSE(std::filesystem::exists(dir / "Test.xml.kxml.tmp"));
+#endif
+
+	ResLoader::Instance().DelPath(dir.string());
+	std::filesystem::remove_all(dir);
+}
@@ -1,12 +1,15 @@
 #include <KlayGE/KlayGE.hpp>
 #include <KFL/Math.hpp>
 #include <KFL/SIMDMath.hpp>
+#include <KFL/AABBoxSoA.hpp>
+#include <KFL/DualQuaternionSoA.hpp>
 
 #include "KlayGETests.hpp"
 
 #include <vector>
 #include <string>
 #include <iostream>
+#include <random>
 
 using namespace std;
 using namespace KlayGE;
@@ -31,3 +34,116 @@ TEST(SIMDMathTest, NormalizeVector4)
 	v = SIMDMathLib::NormalizeVector4(v);
 	EXPECT_LT(MathLib::abs(SIMDMathLib::GetX(SIMDMathLib::LengthVector4(v)) - 1.0f), 1e-3f);
 }
+
+namespace
+{
+	Frustum TestFrustum()
+	{
+		float4x4 const view = MathLib::look_at_lh(float3(0, 0, -10), float3(0, 0, 0));
+		float4x4 const proj = MathLib::perspective_fov_lh(PI / 4, 1.0f, 1.0f, 100.0f);
+		float4x4 const view_proj = view * proj;
+
+		Frustum frustum;
+		frustum.ClipMatrix(view_proj, MathLib::inverse(view_proj));
+		return frustum;
+	}
+
+	void RandomAABBs(std::vector<AABBox>& aabbs, AABBoxSoA& aabbs_soa, uint32_t num)
+	{
+		std::mt19937 gen(1);
+		std::uniform_real_distribution<float> pos_dis(-60, 60);
+		std::uniform_real_distribution<float> size_dis(0.1f, 5);
+
+		aabbs.clear();
+		aabbs_soa.Clear();
+		for (uint32_t i = 0; i < num; ++ i)
+		{
+			float3 const center(pos_dis(gen), pos_dis(gen), pos_dis(gen) + 50);
+			float3 const half_size(size_dis(gen), size_dis(gen), size_dis(gen));
+			aabbs.emplace_back(center - half_size, center + half_size);
+			aabbs_soa.PushBack(aabbs.back());
+		}
+	}
+}
+
+TEST(SIMDMathTest, IntersectAABBFrustum)
+{
+	Frustum const frustum = TestFrustum();
+
+	std::vector<AABBox> aabbs;
+	AABBoxSoA aabbs_soa;
+	// Covers empty, partial and multiple batches
+	uint32_t num_overlaps[3] = { 0, 0, 0 };
+	for (uint32_t num : { 0, 1, 3, 8, 13, 1000 })
+	{
+		RandomAABBs(aabbs, aabbs_soa, num);
+
+		std::vector<BoundOverlap> results(num);
+		SIMDMathLib::IntersectAABBFrustum(results.data(), aabbs_soa, frustum);
+		for (uint32_t i = 0; i < num; ++ i)
+		{
+			EXPECT_EQ(results[i], frustum.Intersect(aabbs[i]));
+			++ num_overlaps[results[i]];
+		}
+	}
+
+	// Every outcome has to be compared against the scalar path
+	EXPECT_GT(num_overlaps[BO_Yes], 0U);
+	EXPECT_GT(num_overlaps[BO_No], 0U);
+	EXPECT_GT(num_overlaps[BO_Partial], 0U);
+
+	aabbs_soa.SwapRemove(5);
+	EXPECT_EQ(aabbs_soa.Size(), 999U);
+	EXPECT_TRUE(aabbs_soa.Get(5) == aabbs.back());
+}
+
+TEST(SIMDMathTest, Sclerp)
+{
+	std::mt19937 gen(1);
+	std::uniform_real_distribution<float> dis(-1, 1);
+	auto random_dq = [&gen, &dis]()
+	{
+		Quaternion const real = MathLib::normalize(Quaternion(dis(gen), dis(gen), dis(gen), dis(gen)));
+		float3 const trans(dis(gen) * 10, dis(gen) * 10, dis(gen) * 10);
+		return std::make_pair(real, MathLib::quat_trans_to_udq(real, trans));
+	};
+
+	// Covers empty, partial and multiple batches
+	for (uint32_t num : { 0, 1, 3, 8, 13, 100 })
+	{
+		DualQuaternionSoA lhs;
+		DualQuaternionSoA rhs;
+		lhs.Resize(num);
+		rhs.Resize(num);
+		std::vector<float> factors(num);
+		for (uint32_t i = 0; i < num; ++ i)
+		{
+			auto const l = random_dq();
+			auto const r = random_dq();
+			lhs.Set(i, l.first, l.second);
+			// Opposite hemisphere case
+			if (i % 3 == 1)
+			{
+				rhs.Set(i, -r.first, -r.second);
+			}
+			else
+			{
+				rhs.Set(i, r.first, r.second);
+			}
+			factors[i] = (dis(gen) + 1) / 2;
+		}
+
+		DualQuaternionSoA out;
+		SIMDMathLib::Sclerp(out, lhs, rhs, factors.data());
+		EXPECT_EQ(out.Size(), num);
+		for (uint32_t i = 0; i < num; ++ i)
+		{
+			auto const expected = MathLib::sclerp(lhs.GetReal(i), lhs.GetDual(i), rhs.GetReal(i), rhs.GetDual(i), factors[i]);
+			for (int c = 0; c < 4; ++ c)
+			{
+				EXPECT_NEAR(out.GetReal(i)[c], expected.first[c], 1e-4f);
+				EXPECT_NEAR(out.GetDual(i)[c], expected.second[c], 1e-3f);
+			}
+		}
+	}
+}
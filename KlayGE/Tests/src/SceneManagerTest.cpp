@@ -0,0 +1,122 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KlayGE/Context.hpp>
+#include <KlayGE/SceneManager.hpp>
+#include <KlayGE/SceneObjectHelper.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	class ParallelUpdateObject : public SceneObjectHelper
+	{
+	public:
+		explicit ParallelUpdateObject(SceneObjectPtr const & obj_to_add)
+			: SceneObjectHelper(SOA_ParallelUpdate),
+				obj_to_add_(obj_to_add), scene_changed_in_time_(false)
+		{
+		}
+
+		void SubThreadUpdate(float app_time, float elapsed_time) override
+		{
+			KFL_UNUSED(app_time);
+			KFL_UNUSED(elapsed_time);
+
+			if (obj_to_add_)
+			{
+				// Another thread changes the scene meanwhile, which would block if the scene lock were held here
+				auto& sm = Context::Instance().SceneManagerInstance();
+				SceneObjectPtr const obj_to_add = obj_to_add_;
+				auto added = std::async(std::launch::async, [&sm, obj_to_add] { sm.AddSceneObject(obj_to_add); });
+				scene_changed_in_time_ = (added.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+				obj_to_add_.reset();
+			}
+		}
+
+		bool SceneChangedInTime() const
+		{
+			return scene_changed_in_time_;
+		}
+
+	private:
+		SceneObjectPtr obj_to_add_;
+		bool scene_changed_in_time_;
+	};
+
+	class CountingObject : public SceneObjectHelper
+	{
+	public:
+		CountingObject()
+			: SceneObjectHelper(0), num_updates_(0)
+		{
+		}
+
+		void SubThreadUpdate(float app_time, float elapsed_time) override
+		{
+			KFL_UNUSED(app_time);
+			KFL_UNUSED(elapsed_time);
+
+			++ num_updates_;
+		}
+
+		uint32_t NumUpdates() const
+		{
+			return num_updates_;
+		}
+
+	private:
+		std::atomic<uint32_t> num_updates_;
+	};
+}
+
+TEST(SceneManagerTest, ParallelUpdateOutsideLock)
+{
+	auto& sm = Context::Instance().SceneManagerInstance();
+
+	auto serial_obj = MakeSharedPtr<CountingObject>();
+	std::vector<std::shared_ptr<CountingObject>> added_objs;
+	std::vector<std::shared_ptr<ParallelUpdateObject>> parallel_objs;
+	for (uint32_t i = 0; i < 4; ++ i)
+	{
+		added_objs.push_back(MakeSharedPtr<CountingObject>());
+		parallel_objs.push_back(MakeSharedPtr<ParallelUpdateObject>(added_objs.back()));
+	}
+
+	sm.AddSceneObject(serial_obj);
+	for (auto const & obj : parallel_objs)
+	{
+		sm.AddSceneObject(obj);
+	}
+
+	sm.UpdateSceneObjects(0, 0.01f);
+
+	EXPECT_EQ(serial_obj->NumUpdates(), 1U);
+	for (auto const & obj : parallel_objs)
+	{
+		EXPECT_TRUE(obj->SceneChangedInTime());
+	}
+
+	// The objects added during the update are updated from the next one on
+	sm.UpdateSceneObjects(0.01f, 0.01f);
+	EXPECT_EQ(serial_obj->NumUpdates(), 2U);
+	for (auto const & obj : added_objs)
+	{
+		EXPECT_EQ(obj->NumUpdates(), 1U);
+	}
+
+	sm.DelSceneObject(serial_obj);
+	for (auto const & obj : parallel_objs)
+	{
+		sm.DelSceneObject(obj);
+	}
+	for (auto const & obj : added_objs)
+	{
+		sm.DelSceneObject(obj);
+	}
+}
@@ -50,11 +50,13 @@ public:
 		ResLoader::Instance().AddPath("../../Tests/media/TexConverter");
 	}
 
-	void RunTest(std::string_view input_name, std::string_view metadata_name, std::string_view sanity_name, float tolerance)
+	void RunTest(std::string_view input_name, std::string_view metadata_name, std::string_view sanity_name, float tolerance,
+		uint32_t num_threads = 0)
 	{
 		TexMetadata metadata(metadata_name);
 
 		TexConverter tc;
+		tc.NumThreads(num_threads);
 		auto target = tc.Convert(input_name, metadata);
 		EXPECT_TRUE(target);
 
@@ -92,6 +94,16 @@ TEST_F(TexConverterTest, Compression)
 	RunTest("lion.jpg", "lion_bc1.kmeta", "lion_bc1.dds", 1.0f / 255);
 }
 
+TEST_F(TexConverterTest, CompressionThreads)
+{
+	// Every plane is split in num_threads regions, which are converted at the same time
+	for (uint32_t num_threads : { 1U, 2U, 5U })
+	{
+		RunTest("lion.jpg", "lion_bc1.kmeta", "lion_bc1.dds", 1.0f / 255, num_threads);
+		RunTest("lion.jpg", "array_mip.kmeta", "array_mip.dds", 1.0f / 255, num_threads);
+	}
+}
+
 TEST_F(TexConverterTest, CompressionSRGB)
 {
 	RunTest("lion.jpg", "lion_bc1_srgb.kmeta", "lion_bc1_srgb.dds", 1.0f / 255);
@@ -0,0 +1,190 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/CustomizedStreamBuf.hpp>
+#include <KFL/ResIdentifier.hpp>
+#include <KFL/XMLDom.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	char const TEST_XML[] =
+		"<?xml version='1.0'?>\n"
+		"<ui name=\"test\">\n"
+		"\t<dialog id=\"d0\" x=\"12\" y=\"-3\" alpha=\"0.5\">first</dialog>\n"
+		"\t<dialog id=\"d1\">second &amp; last</dialog>\n"
+		"</ui>\n";
+
+	ResIdentifierPtr MakeMemSource(char const * data, size_t size)
+	{
+		auto buf = MakeSharedPtr<MemInputStreamBuf>(data, static_cast<std::streamsize>(size));
+		return MakeSharedPtr<ResIdentifier>("test.xml", 0, MakeSharedPtr<std::istream>(buf.get()), buf);
+	}
+
+	ResIdentifierPtr MakeStreamSource(char const * data, size_t size)
+	{
+		return MakeSharedPtr<ResIdentifier>("test.xml", 0, MakeSharedPtr<std::istringstream>(std::string(data, size)));
+	}
+
+	void CheckTestDocument(XMLNodePtr const & root)
+	{
+		ASSERT_TRUE(root);
+		EXPECT_EQ(root->Name(), "ui");
+		EXPECT_EQ(root->AttribString("name", ""), "test");
+
+		XMLNodePtr d0 = root->FirstNode("dialog");
+		ASSERT_TRUE(d0);
+		EXPECT_EQ(d0->AttribString("id", ""), "d0");
+		EXPECT_EQ(d0->AttribInt("x", 0), 12);
+		EXPECT_EQ(d0->AttribInt("y", 0), -3);
+		EXPECT_FLOAT_EQ(d0->AttribFloat("alpha", 1), 0.5f);
+		EXPECT_EQ(d0->AttribInt("w", 7), 7);
+		EXPECT_EQ(d0->ValueString(), "first");
+
+		XMLNodePtr d1 = d0->NextSibling("dialog");
+		ASSERT_TRUE(d1);
+		EXPECT_EQ(d1->ValueString(), "second & last");
+		EXPECT_EQ(d1->Parent(), root);
+		EXPECT_EQ(root->LastNode("dialog"), d1);
+		EXPECT_EQ(d1->NextSibling("dialog"), nullptr);
+		EXPECT_FALSE(root->FirstNode("button"));
+	}
+}
+
+TEST(XMLDomTest, ParseMapped)
+{
+	XMLDocument doc;
+	CheckTestDocument(doc.Parse(MakeMemSource(TEST_XML, sizeof(TEST_XML) - 1)));
+}
+
+TEST(XMLDomTest, ParseStream)
+{
+	XMLDocument doc;
+	CheckTestDocument(doc.Parse(MakeStreamSource(TEST_XML, sizeof(TEST_XML) - 1)));
+}
+
+TEST(XMLDomTest, ParseDoesntTouchSource)
+{
+	std::string const src(TEST_XML);
+
+	XMLDocument doc;
+	CheckTestDocument(doc.Parse(MakeMemSource(src.data(), src.size())));
+	EXPECT_EQ(src, TEST_XML);
+}
+
+TEST(XMLDomTest, Modify)
+{
+	XMLDocument doc;
+	XMLNodePtr root = doc.Parse(MakeStreamSource(TEST_XML, sizeof(TEST_XML) - 1));
+	ASSERT_TRUE(root);
+
+	XMLNodePtr d0 = root->FirstNode("dialog");
+	XMLNodePtr d1 = root->LastNode("dialog");
+	XMLNodePtr button = doc.AllocNode(XNT_Element, "button");
+	button->AppendAttrib(doc.AllocAttribUInt("width", 64));
+	root->InsertNode(d1, button);
+	EXPECT_EQ(d0->NextSibling("button"), button);
+	EXPECT_EQ(button->NextSibling("dialog"), d1);
+	EXPECT_EQ(button->AttribUInt("width", 0), 64U);
+
+	d0->RemoveAttrib(d0->Attrib("x"));
+	EXPECT_FALSE(d0->Attrib("x"));
+	EXPECT_EQ(d0->FirstAttrib()->Name(), "id");
+
+	root->RemoveNode(d0);
+	EXPECT_EQ(root->FirstNode("dialog"), d1);
+
+	XMLNodePtr clone = doc.CloneNode(button);
+	ASSERT_TRUE(clone);
+	EXPECT_NE(clone, button);
+	EXPECT_EQ(clone->AttribUInt("width", 0), 64U);
+}
+
+TEST(XMLDomTest, CompiledIsRecognized)
+{
+	XMLDocument doc;
+	doc.Parse(MakeStreamSource(TEST_XML, sizeof(TEST_XML) - 1));
+	std::ostringstream oss;
+	doc.Compile(oss);
+	std::string const bin = oss.str();
+
+	EXPECT_TRUE(XMLDocument::IsCompiled(MakeMemSource(bin.data(), bin.size())));
+	EXPECT_TRUE(XMLDocument::IsCompiled(MakeStreamSource(bin.data(), bin.size())));
+	EXPECT_FALSE(XMLDocument::IsCompiled(MakeMemSource(TEST_XML, sizeof(TEST_XML) - 1)));
+	EXPECT_FALSE(XMLDocument::IsCompiled(MakeStreamSource(TEST_XML, sizeof(TEST_XML) - 1)));
+	EXPECT_FALSE(XMLDocument::IsCompiled(MakeStreamSource(bin.data(), 4)));
+
+	// The string table keeps one copy of the repeated names
+	EXPECT_EQ(bin.find("dialog"), bin.rfind("dialog"));
+}
+
+TEST(XMLDomTest, ParseCompiled)
+{
+	std::string bin;
+	{
+		XMLDocument doc;
+		doc.Parse(MakeStreamSource(TEST_XML, sizeof(TEST_XML) - 1));
+		std::ostringstream oss;
+		doc.Compile(oss);
+		bin = oss.str();
+	}
+
+	{
+		XMLDocument doc;
+		CheckTestDocument(doc.Parse(MakeMemSource(bin.data(), bin.size())));
+	}
+	{
+		XMLDocument doc;
+		CheckTestDocument(doc.Parse(MakeStreamSource(bin.data(), bin.size())));
+	}
+}
+
+TEST(XMLDomTest, CompileModified)
+{
+	std::string bin;
+	{
+		XMLDocument doc;
+		XMLNodePtr root = doc.Parse(MakeStreamSource(TEST_XML, sizeof(TEST_XML) - 1));
+		XMLNodePtr button = doc.AllocNode(XNT_Element, "button");
+		button->AppendAttrib(doc.AllocAttribInt("x", -8));
+		root->AppendNode(button);
+		std::ostringstream oss;
+		doc.Compile(oss);
+		bin = oss.str();
+	}
+
+	XMLDocument doc;
+	XMLNodePtr root = doc.Parse(MakeMemSource(bin.data(), bin.size()));
+	ASSERT_TRUE(root);
+	EXPECT_EQ(root->FirstNode("dialog")->AttribInt("x", 0), 12);
+	XMLNodePtr button = root->FirstNode("button");
+	ASSERT_TRUE(button);
+	EXPECT_EQ(button->AttribInt("x", 0), -8);
+	EXPECT_EQ(root->LastNode(), button);
+
+	// Modifying a compiled document only touches its arena, not the source
+	std::string const bin_copy = bin;
+	button->AppendAttrib(doc.AllocAttribString("caption", "ok"));
+	root->RemoveNode(root->FirstNode("dialog"));
+	EXPECT_EQ(button->AttribString("caption", ""), "ok");
+	EXPECT_EQ(bin, bin_copy);
+}
+
+TEST(XMLDomTest, ParseTruncatedCompiled)
+{
+	XMLDocument doc;
+	doc.Parse(MakeStreamSource(TEST_XML, sizeof(TEST_XML) - 1));
+	std::ostringstream oss;
+	doc.Compile(oss);
+	std::string const bin = oss.str();
+
+	XMLDocument truncated_doc;
+	EXPECT_THROW(truncated_doc.Parse(MakeMemSource(bin.data(), bin.size() - 8)), std::runtime_error);
+	EXPECT_THROW(truncated_doc.Parse(MakeStreamSource(bin.data(), 12)), std::runtime_error);
+}
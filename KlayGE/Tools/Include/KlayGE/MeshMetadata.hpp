@@ -103,6 +103,16 @@ namespace KlayGE
 			axis_mapping_[axis] = mapping;
 		}
 
+		// Stores key frames as quantized tracks in .model_bin. Smaller, with a little precision loss.
+		bool QuantizeKeyFrames() const
+		{
+			return quantize_key_frames_;
+		}
+		void QuantizeKeyFrames(bool quantize)
+		{
+			quantize_key_frames_ = quantize;
+		}
+
 		uint32_t NumLods() const;
 		void NumLods(uint32_t lods);
 		std::string_view LodFileName(uint32_t lod) const;
@@ -128,6 +138,7 @@ namespace KlayGE
 		float3 scale_ = float3(1, 1, 1);
 		uint8_t axis_mapping_[3] = { 0, 1, 2 };
 		std::vector<std::string> lod_file_names_;
+		bool quantize_key_frames_ = false;
 
 		float4x4 transform_ = float4x4::Identity();
 		float4x4 transform_it_ = float4x4::Identity();
@@ -49,6 +49,18 @@ namespace KlayGE
 	class KLAYGE_TOOL_API TexConverter
 	{
 	public:
+		TexConverter();
+
+		// Maximum number of threads used by Convert, including the calling one. 0 means all the workers of the job system.
+		void NumThreads(uint32_t num_threads)
+		{
+			num_threads_ = num_threads;
+		}
+		uint32_t NumThreads() const
+		{
+			return num_threads_;
+		}
+
 		TexturePtr Convert(std::string_view input_name, TexMetadata const & metadata);
 
 	private:
@@ -56,6 +68,8 @@ namespace KlayGE
 		TexturePtr Save();
 
 	private:
+		uint32_t num_threads_;
+
 		std::string input_name_;
 
 		TexMetadata metadata_;
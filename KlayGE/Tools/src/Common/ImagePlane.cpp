@@ -30,8 +30,8 @@
 
 #include <KlayGE/KlayGE.hpp>
 #include <KFL/CXX17/filesystem.hpp>
-#include <KFL/CpuInfo.hpp>
 #include <KFL/ErrorHandling.hpp>
+#include <KFL/JobSystem.hpp>
 #include <KlayGE/ResLoader.hpp>
 #include <KlayGE/TexCompression.hpp>
 #include <KlayGE/TexCompressionBC.hpp>
@@ -676,7 +676,7 @@ namespace KlayGE
 		}
 	}
 
-	void ImagePlane::FormatConversion(ElementFormat format)
+	void ImagePlane::FormatConversion(ElementFormat format, uint32_t num_threads)
 	{
 		uint32_t const tex_width = uncompressed_tex_->Width(0);
 		uint32_t const tex_height = uncompressed_tex_->Height(0);
@@ -690,35 +690,40 @@ namespace KlayGE
 
 		std::vector<uint8_t> new_tex_data(slice_pitch);
 
-		CPUInfo cpu;
-		uint32_t const num_threads = cpu.NumHWThreads();
-		thread_pool tp(1, num_threads);
-		std::vector<joiner<void>> joiners(num_threads);
+		JobSystem& job_system = Context::Instance().JobSystemInstance();
+		uint32_t const num_regions = (0 == num_threads) ? job_system.NumWorkers() + 1 : num_threads;
 
-		uint32_t const tex_region_height = ((tex_height + num_threads - 1) / num_threads + block_height - 1) & ~(block_height - 1);
-		std::vector<TexturePtr> new_tex_regions(num_threads);
-		for (uint32_t i = 0; i < num_threads; ++ i)
+		// Each region is converted straight into new_tex_data on one thread. The regions already take all the threads,
+		//  so the encoding inside a region doesn't split any further.
+		// A texture can only be mapped once at a time, so the source is mapped here, and the regions read from offsets
+		//  into that mapping.
+		uint32_t const tex_region_height = ((tex_height + num_regions - 1) / num_regions + block_height - 1) & ~(block_height - 1);
 		{
-			joiners[i] = tp(
-				[block_height, tex_width, tex_height, tex_region_height, i, format, row_pitch,
-					&new_tex_data, &new_tex_regions, this]
+			Texture::Mapper src_mapper(*uncompressed_tex_, 0, 0, TMA_Read_Only, 0, 0, tex_width, tex_height);
+			uint8_t const * src_data = src_mapper.Pointer<uint8_t>();
+			uint32_t const src_row_pitch = src_mapper.RowPitch();
+			ElementFormat const src_format = uncompressed_tex_->Format();
+			uint32_t const src_block_height = BlockHeight(src_format);
+			job_system.ParallelFor(0, num_regions, 1,
+				[block_height, tex_width, tex_height, tex_region_height, format, row_pitch, &new_tex_data,
+					src_data, src_row_pitch, src_format, src_block_height](uint32_t region_begin, uint32_t region_end)
 				{
-					uint32_t const this_tex_region_height = MathLib::clamp(static_cast<int>(tex_height - i * tex_region_height),
-						0, static_cast<int>(tex_region_height));
-					if (this_tex_region_height > 0)
+					for (uint32_t i = region_begin; i < region_end; ++ i)
 					{
-						new_tex_regions[i] = MakeSharedPtr<SoftwareTexture>(Texture::TT_2D, tex_width, this_tex_region_height,
-							1, 1, 1, format, true);
-
-						ElementInitData init_data;
-						init_data.data = new_tex_data.data() + i * tex_region_height / block_height * row_pitch;
-						init_data.row_pitch = row_pitch;
-						init_data.slice_pitch = (this_tex_region_height + block_height - 1) / block_height * row_pitch;
-
-						new_tex_regions[i]->CreateHWResource(init_data, nullptr);
-
-						uncompressed_tex_->CopyToSubTexture2D(*new_tex_regions[i], 0, 0, 0, 0, tex_width, this_tex_region_height,
-							0, 0, 0, i * tex_region_height, tex_width, this_tex_region_height);
+						uint32_t const this_tex_region_height = MathLib::clamp(static_cast<int>(tex_height - i * tex_region_height),
+							0, static_cast<int>(tex_region_height));
+						if (this_tex_region_height > 0)
+						{
+							uint32_t const region_slice_pitch = (this_tex_region_height + block_height - 1) / block_height * row_pitch;
+
+							uint32_t const src_region_slice_pitch
+								= (this_tex_region_height + src_block_height - 1) / src_block_height * src_row_pitch;
+							ResizeTexture(new_tex_data.data() + i * tex_region_height / block_height * row_pitch,
+								row_pitch, region_slice_pitch, format, tex_width, this_tex_region_height, 1,
+								src_data + i * tex_region_height / src_block_height * src_row_pitch, src_row_pitch, src_region_slice_pitch,
+								src_format, tex_width, this_tex_region_height, 1,
+								false, 1);
+						}
 					}
 				});
 		}
@@ -730,11 +735,6 @@ namespace KlayGE
 		init_data.row_pitch = row_pitch;
 		init_data.slice_pitch = slice_pitch;
 
-		for (uint32_t i = 0; i < num_threads; ++ i)
-		{
-			joiners[i]();
-		}
-
 		new_tex->CreateHWResource(init_data, nullptr);
 
 		if (IsCompressedFormat(format))
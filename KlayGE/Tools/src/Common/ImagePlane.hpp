@@ -51,7 +51,8 @@ namespace KlayGE
 		void BumpToNormal(float scale);
 		void NormalToHeight(float min_z);
 		void PrepareNormalCompression(ElementFormat normal_compression_format);
-		void FormatConversion(ElementFormat format);
+		// Runs on at most num_threads threads, 0 means all the workers of the job system
+		void FormatConversion(ElementFormat format, uint32_t num_threads);
 		ImagePlane ResizeTo(uint32_t width, uint32_t height, bool linear);
 
 		uint32_t Width() const
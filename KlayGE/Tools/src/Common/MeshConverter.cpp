@@ -3284,6 +3284,14 @@ namespace KlayGE
 			}
 			skinned_model.AssignJoints(joints_.begin(), joints_.end());
 
+			if (metadata.QuantizeKeyFrames() && skinned_model.GetKeyFrameSets())
+			{
+				for (auto& kf : *skinned_model.GetKeyFrameSets())
+				{
+					kf.Quantize();
+				}
+			}
+
 			// TODO: Run skinning on CPU to get the bounding box
 			uint32_t total_mesh_index = 0;
 			for (uint32_t node_index = 0; node_index < nodes_.size(); ++ node_index)
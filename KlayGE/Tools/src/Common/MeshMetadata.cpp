@@ -217,6 +217,13 @@ namespace KlayGE
 				}
 			}
 
+			if (document.HasMember("quantize_key_frames"))
+			{
+				auto const & quantize_key_frames_val = document["quantize_key_frames"];
+				BOOST_ASSERT(quantize_key_frames_val.IsBool());
+				new_metadata.quantize_key_frames_ = quantize_key_frames_val.GetBool();
+			}
+
 			new_metadata.UpdateTransforms();
 		}
 		else if(!name.empty())
@@ -320,6 +327,11 @@ namespace KlayGE
 			document.AddMember("lod", array_names_val, allocator);
 		}
 
+		if (quantize_key_frames_)
+		{
+			document.AddMember("quantize_key_frames", quantize_key_frames_, allocator);
+		}
+
 		rapidjson::StringBuffer sb;
 		rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(sb);
 		document.Accept(writer);
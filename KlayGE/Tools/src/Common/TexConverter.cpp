@@ -30,6 +30,7 @@
 
 #include <KlayGE/KlayGE.hpp>
 #include <KFL/CXX17/filesystem.hpp>
+#include <KFL/JobSystem.hpp>
 #include <KlayGE/ResLoader.hpp>
 
 #include <cstring>
@@ -39,6 +40,11 @@
 
 namespace KlayGE
 {
+	TexConverter::TexConverter()
+		: num_threads_(0)
+	{
+	}
+
 	TexturePtr TexConverter::Convert(std::string_view input_name, TexMetadata const & metadata)
 	{
 		TexturePtr ret;
@@ -257,13 +263,18 @@ namespace KlayGE
 
 		if (format_ != metadata_.PreferedFormat())
 		{
-			for (uint32_t arr = 0; arr < array_size_; ++ arr)
-			{
-				for (uint32_t m = 0; m < num_mipmaps_; ++ m)
+			// Without a limit, all the mipmaps and array planes go at once. Small mipmaps alone can't keep the workers busy.
+			//  With one, the planes go one after another, each split on num_threads_ threads, so the limit holds.
+			uint32_t const num_planes = array_size_ * num_mipmaps_;
+			uint32_t const grain_size = (0 == num_threads_) ? 1 : num_planes;
+			Context::Instance().JobSystemInstance().ParallelFor(0, num_planes, grain_size,
+				[this](uint32_t plane_begin, uint32_t plane_end)
 				{
-					planes_[arr][m]->FormatConversion(metadata_.PreferedFormat());
-				}
-			}
+					for (uint32_t i = plane_begin; i < plane_end; ++ i)
+					{
+						planes_[i / num_mipmaps_][i % num_mipmaps_]->FormatConversion(metadata_.PreferedFormat(), num_threads_);
+					}
+				});
 
 			format_ = metadata_.PreferedFormat();
 		}
@@ -118,7 +118,7 @@ MeshMetadata LoadMeshMetadata(std::string const & res_name, MeshMetadata const &
 }
 
 void Deploy(std::vector<std::string> const & res_names, std::string_view res_type,
-	RenderDeviceCaps const & caps, std::string_view platform)
+	RenderDeviceCaps const & caps, std::string_view platform, uint32_t num_threads)
 {
 	size_t const res_type_hash = HashRange(res_type.begin(), res_type.end());
 
@@ -133,6 +133,7 @@ void Deploy(std::vector<std::string> const & res_names, std::string_view res_typ
 		TexMetadata const default_metadata = DefaultTextureMetadata(res_type_hash, caps);
 
 		TexConverter tc;
+		tc.NumThreads(num_threads);
 		for (size_t i = 0; i < res_names.size(); ++ i)
 		{
 			std::cout << "Converting " << res_names[i] << " to " << res_type << std::endl;
@@ -164,6 +165,27 @@ void Deploy(std::vector<std::string> const & res_names, std::string_view res_typ
 			}
 		}
 	}
+	else if (CT_HASH("xml") == res_type_hash)
+	{
+		for (size_t i = 0; i < res_names.size(); ++ i)
+		{
+			std::cout << "Converting " << res_names[i] << " to " << res_type << std::endl;
+
+			ResIdentifierPtr source = ResLoader::Instance().Open(res_names[i]);
+			if (source)
+			{
+				XMLDocument doc;
+				doc.Parse(source);
+
+				std::ofstream ofs(res_names[i] + ".kxml", std::ios_base::binary | std::ios_base::out);
+				doc.Compile(ofs);
+			}
+			else
+			{
+				std::cout << "Could NOT open " << res_names[i] << std::endl;
+			}
+		}
+	}
 	else
 	{
 		std::ofstream ofs("convert.bat");
@@ -238,6 +260,7 @@ int main(int argc, char* argv[])
 	std::vector<std::string> res_names;
 	std::string res_type;
 	std::string platform;
+	uint32_t num_threads = 0;
 
 	boost::program_options::options_description desc("Allowed options");
 	desc.add_options()
@@ -245,6 +268,7 @@ int main(int argc, char* argv[])
 		("input-name,I", boost::program_options::value<std::string>(), "Input resource name.")
 		("type,T", boost::program_options::value<std::string>(), "Resource type.")
 		("platform,P", boost::program_options::value<std::string>(), "Platform name.")
+		("threads,J", boost::program_options::value<uint32_t>(), "Number of threads for converting textures. 0 means all cores.")
 		("version,v", "Version.");
 
 	boost::program_options::variables_map vm;
@@ -317,6 +341,10 @@ int main(int argc, char* argv[])
 		{
 			res_type = "model";
 		}
+		else if ((".uiml" == ext_name) || (".psml" == ext_name) || (".mtlml" == ext_name) || (".ppml" == ext_name))
+		{
+			res_type = "xml";
+		}
 		else
 		{
 			cout << "Need resource type name." << endl;
@@ -332,6 +360,10 @@ int main(int argc, char* argv[])
 	{
 		platform = "d3d_11_0";
 	}
+	if (vm.count("threads") > 0)
+	{
+		num_threads = vm["threads"].as<uint32_t>();
+	}
 
 	boost::algorithm::to_lower(res_type);
 	boost::algorithm::to_lower(platform);
@@ -379,7 +411,7 @@ int main(int argc, char* argv[])
 	}
 
 	PlatformDefinition platform_def("PlatConf/" + platform + ".plat");
-	Deploy(res_names, res_type, platform_def.device_caps, platform);
+	Deploy(res_names, res_type, platform_def.device_caps, platform, num_threads);
 
 	Context::Destroy();
 
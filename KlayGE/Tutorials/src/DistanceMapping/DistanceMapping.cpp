@@ -284,7 +284,7 @@ void DistanceMapping::OnCreate()
 		});
 	inputEngine.ActionMap(actionMap, input_handler);
 
-	UIManager::Instance().Load(ResLoader::Instance().Open("DistanceMapping.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("DistanceMapping.uiml"));
 }
 
 void DistanceMapping::OnResize(uint32_t width, uint32_t height)
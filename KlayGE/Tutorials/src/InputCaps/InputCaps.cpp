@@ -277,7 +277,7 @@ void InputCaps::OnCreate()
 		});
 	inputEngine.ActionMap(actionMap, input_handler);
 
-	UIManager::Instance().Load(ResLoader::Instance().Open("InputCaps.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("InputCaps.uiml"));
 }
 
 void InputCaps::OnResize(uint32_t width, uint32_t height)
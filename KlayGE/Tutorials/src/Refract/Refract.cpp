@@ -217,7 +217,7 @@ void Refract::OnCreate()
 		backface_depth_buffer_->GetViewport()->camera = screen_buffer->GetViewport()->camera;
 	}
 
-	UIManager::Instance().Load(ResLoader::Instance().Open("Refract.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("Refract.uiml"));
 }
 
 void Refract::OnResize(uint32_t width, uint32_t height)
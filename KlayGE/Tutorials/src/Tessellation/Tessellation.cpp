@@ -161,7 +161,7 @@ void TessellationApp::OnCreate()
 		});
 	inputEngine.ActionMap(actionMap, input_handler);
 
-	UIManager::Instance().Load(ResLoader::Instance().Open("Tessellation.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("Tessellation.uiml"));
 	dialog_ = UIManager::Instance().GetDialogs()[0];
 
 	id_tess_enabled_ = dialog_->IDFromName("Tessellation");
@@ -137,7 +137,7 @@ void VertexDisplacement::OnCreate()
 		});
 	inputEngine.ActionMap(actionMap, input_handler);
 
-	UIManager::Instance().Load(ResLoader::Instance().Open("VertexDisplacement.uiml"));
+	UIManager::Instance().Load(ResLoader::Instance().OpenXML("VertexDisplacement.uiml"));
 }
 
 void VertexDisplacement::OnResize(uint32_t width, uint32_t height)
@@ -35,6 +35,7 @@
 
 #include <vector>
 #include <istream>
+#include <mutex>
 #include <unordered_map>
 
 #ifndef KFONT_SOURCE
@@ -124,6 +125,8 @@ namespace KlayGE
 		std::vector<size_t> distances_addr_;
 		std::vector<uint8_t> distances_lzma_;
 		ResIdentifierPtr kfont_input_;
+		// GetDistanceData can be called from several threads, but they share the stream
+		mutable std::mutex kfont_input_mutex_;
 		int64_t distances_lzma_start_;
 	};
 }
@@ -371,6 +371,7 @@ namespace KlayGE
 		{
 			if (kfont_input_)
 			{
+				std::lock_guard<std::mutex> lock(kfont_input_mutex_);
 				kfont_input_->seekg(distances_lzma_start_ + (index + 1) * sizeof(uint64_t) + distances_addr_[index],
 					std::ios_base::beg);
 				kfont_input_->read(p, size);